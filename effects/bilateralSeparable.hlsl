@@ -0,0 +1,63 @@
+
+//--------------------------------------------------------------------------------------
+// Separable approximation of the bilateral filter in test.hlsl.
+// The wSize x wSize window is replaced by a horizontal and a vertical pass, so the cost
+// per pixel grows with wSize instead of wSize * wSize. The spatial kernel is computed
+// once on the CPU and passed in the constant buffer.
+//--------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+cbuffer BilateralPass : register( b0 )
+{
+    uint2  g_Direction;  // (1, 0) horizontal pass, (0, 1) vertical pass
+    uint   g_Radius;     // (wSize - 1) / 2
+    float  g_RangeScale; // 0.5 / (BSIGMA * BSIGMA)
+    float4 g_Spatial[5]; // spatial weights for offset 0 .. g_Radius
+};
+
+#define GROUP_SIZE 128
+#define MAX_RADIUS 19
+
+Texture2D<float4>   InputMap  : register(t0);
+RWTexture2D<float4> OutputMap : register(u0);
+
+groupshared float3 lineCache[GROUP_SIZE + 2 * MAX_RADIUS];
+
+float SpatialWeight(uint i)
+{
+    return g_Spatial[i >> 2][i & 3];
+}
+
+//! x of the dispatch runs along the filter direction, y selects the row / column.
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSMain( uint3 groupID : SV_GroupID, uint3 groupThreadID : SV_GroupThreadID, uint3 dispatchThreadID : SV_DispatchThreadID )
+{
+    int2 direction = int2(g_Direction);
+    int2 lineOrigin = int2(direction.y, direction.x) * int(dispatchThreadID.y);
+    int  start = int(groupID.x * GROUP_SIZE) - int(g_Radius);
+
+    // Load the pixels of this group plus the apron once, every tap reads from shared memory.
+    for (uint i = groupThreadID.x; i < GROUP_SIZE + 2 * g_Radius; i += GROUP_SIZE)
+    {
+        int2 p = lineOrigin + direction * (start + int(i));
+        lineCache[i] = InputMap.Load(int3(p, 0)).rgb;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    int center = int(groupThreadID.x + g_Radius);
+    float3 c = lineCache[center];
+    float3 final_colour = float3(0.0, 0.0, 0.0);
+    float Z = 0.0;
+    for (int j = -int(g_Radius); j <= int(g_Radius); ++j)
+    {
+        float3 cc = lineCache[center + j];
+        float3 d = cc - c;
+        float factor = SpatialWeight(abs(j)) * exp(-dot(d, d) * g_RangeScale);
+        Z += factor;
+        final_colour += factor * cc;
+    }
+
+    int2 pos = lineOrigin + direction * int(dispatchThreadID.x);
+    OutputMap[pos] = float4(final_colour / Z, 1.0);
+}
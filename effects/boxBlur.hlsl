@@ -0,0 +1,58 @@
+//--------------------------------------------------------------------------------------
+// One pass of a box blur along rows or columns, three of them in each direction make a
+// gaussian. Every thread walks a segment of SEGMENT pixels of a line with a running sum,
+// one add and one subtract per pixel whatever the radius. Segments start at multiples
+// of SEGMENT in the image, so a tile sums its pixels in the order the whole image does.
+// Pixels outside of the texture repeat the edge.
+//--------------------------------------------------------------------------------------
+cbuffer BoxPass : register( b0 )
+{
+    uint2 g_Direction; // (1, 0) horizontal pass, (0, 1) vertical pass
+    uint  g_Radius;    // the box is 2 g_Radius + 1 pixels wide
+    int   g_Origin;    // image position of texel 0 along the lines, not 0 when the image runs in tiles
+};
+
+#define GROUP_SIZE 64
+#define SEGMENT 64
+
+Texture2D<float4>   InputMap  : register(t0);
+RWTexture2D<float4> OutputMap : register(u0);
+
+float4 LinePixel(int2 lineOrigin, int2 direction, int i, int last)
+{
+    return InputMap.Load(int3(lineOrigin + direction * clamp(i, 0, last), 0));
+}
+
+//! x of the dispatch selects the row / column, y the segment from the one holding texel 0.
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSMain( uint3 dispatchThreadID : SV_DispatchThreadID )
+{
+    uint width, height;
+    InputMap.GetDimensions(width, height);
+    uint length = dot(g_Direction, uint2(width, height));
+    uint lines = dot(g_Direction.yx, uint2(width, height));
+    if (dispatchThreadID.x >= lines)
+        return;
+
+    int2 direction = int2(g_Direction);
+    int2 lineOrigin = int2(direction.y, direction.x) * int(dispatchThreadID.x);
+    int last = int(length) - 1;
+    int radius = int(g_Radius);
+    int start = (g_Origin / SEGMENT + int(dispatchThreadID.y)) * SEGMENT - g_Origin;
+    int end = min(start + SEGMENT, last + 1);
+    start = max(start, 0);
+    if (start >= end)
+        return;
+
+    float4 sum = float4(0.0, 0.0, 0.0, 0.0);
+    for (int i = -radius; i <= radius; ++i)
+    {
+        sum += LinePixel(lineOrigin, direction, start + i, last);
+    }
+    float scale = 1.0 / float(2 * radius + 1);
+    for (int x = start; x < end; ++x)
+    {
+        OutputMap[lineOrigin + direction * x] = sum * scale;
+        sum += LinePixel(lineOrigin, direction, x + radius + 1, last) - LinePixel(lineOrigin, direction, x - radius, last);
+    }
+}
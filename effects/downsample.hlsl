@@ -0,0 +1,23 @@
+//
+// One level of a mip pyramid : every texel of DstMap is the 2x2 box of SrcMap it covers.
+// MipPyramid binds a view of mip n as SrcMap and a view of mip n + 1 as DstMap.
+//
+
+Texture2D<float4>   SrcMap : register(t0);
+RWTexture2D<float4> DstMap : register(u0);
+
+[numthreads(8, 8, 1)]
+void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    uint srcWidth, srcHeight;
+    SrcMap.GetDimensions(srcWidth, srcHeight);
+    uint2 last = uint2(srcWidth, srcHeight) - 1;
+    uint2 src = dispatchThreadID.xy * 2;
+
+    // The last row / column of an odd sized level clamps, a 1 pixel wide level still halves the other side.
+    float4 sum = SrcMap.Load(int3(min(src, last), 0))
+               + SrcMap.Load(int3(min(src + uint2(1, 0), last), 0))
+               + SrcMap.Load(int3(min(src + uint2(0, 1), last), 0))
+               + SrcMap.Load(int3(min(src + uint2(1, 1), last), 0));
+    DstMap[dispatchThreadID.xy] = sum * 0.25f;
+}
@@ -0,0 +1,32 @@
+
+//--------------------------------------------------------------------------------------
+// Builds the fish eye remap table : the image coordinate fishEye.hlsl samples for
+// every output pixel. Applied with remap.hlsl.
+//--------------------------------------------------------------------------------------
+
+#include "warps.hlsli"
+
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+cbuffer CB : register(b0)
+{
+    unsigned int g_iWidth;   //< of the image
+    unsigned int g_iHeight;
+    int g_iOriginX;          //< image pixel of texel (0, 0), not 0 when the image runs in tiles
+    int g_iOriginY;
+    float g_fAperture;
+};
+
+RWTexture2D<float2> RemapTable : register(u0);
+
+[numthreads(32, 32, 1)]
+void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    uint width, height;
+    RemapTable.GetDimensions(width, height);
+    if (dispatchThreadID.x >= width || dispatchThreadID.y >= height)
+        return;
+    float2 pos = float2(dispatchThreadID.xy) + float2(g_iOriginX, g_iOriginY);
+    RemapTable[dispatchThreadID.xy] = fishEyeWarp( pos / float2(g_iWidth, g_iHeight), g_fAperture );
+}
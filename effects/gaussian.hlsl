@@ -0,0 +1,55 @@
+//--------------------------------------------------------------------------------------
+// One pass of a separable gaussian blur, the taps are read from shared memory. The
+// normalized weights are computed once on the CPU and passed in the constant buffer.
+// Pixels outside of the image repeat the edge, the border does not darken.
+//--------------------------------------------------------------------------------------
+cbuffer GaussianPass : register( b0 )
+{
+    uint2  g_Direction;  // (1, 0) horizontal pass, (0, 1) vertical pass
+    uint   g_Radius;     // taps on each side, at most MAX_RADIUS
+    uint   g_Pad;
+    float4 g_Weights[7]; // weights for offset 0 .. g_Radius
+};
+
+#define GROUP_SIZE 128
+#define MAX_RADIUS 24
+
+Texture2D<float4>   InputMap  : register(t0);
+RWTexture2D<float4> OutputMap : register(u0);
+
+groupshared float4 lineCache[GROUP_SIZE + 2 * MAX_RADIUS];
+
+float Weight(uint i)
+{
+    return g_Weights[i >> 2][i & 3];
+}
+
+//! x of the dispatch runs along the filter direction, y selects the row / column.
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSMain( uint3 groupID : SV_GroupID, uint3 groupThreadID : SV_GroupThreadID, uint3 dispatchThreadID : SV_DispatchThreadID )
+{
+    uint width, height;
+    InputMap.GetDimensions(width, height);
+    int last = int(dot(g_Direction, uint2(width, height))) - 1;
+
+    int2 direction = int2(g_Direction);
+    int2 lineOrigin = int2(direction.y, direction.x) * int(dispatchThreadID.y);
+    int  start = int(groupID.x * GROUP_SIZE) - int(g_Radius);
+
+    for (uint i = groupThreadID.x; i < GROUP_SIZE + 2 * g_Radius; i += GROUP_SIZE)
+    {
+        int2 p = lineOrigin + direction * clamp(start + int(i), 0, last);
+        lineCache[i] = InputMap.Load(int3(p, 0));
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    int center = int(groupThreadID.x + g_Radius);
+    float4 sum = lineCache[center] * Weight(0);
+    for (int j = 1; j <= int(g_Radius); ++j)
+    {
+        sum += (lineCache[center - j] + lineCache[center + j]) * Weight(j);
+    }
+
+    int2 pos = lineOrigin + direction * int(dispatchThreadID.x);
+    OutputMap[pos] = sum;
+}
@@ -0,0 +1,50 @@
+//--------------------------------------------------------------------------------------
+// Guided filter (He et al.), first step : the linear model q = a I + b of the window
+// around every pixel, fitted per channel from the window means of the guide I, the
+// input p, I^2 and I p read from summed-area tables. Self-guided runs bind the tables of
+// the input twice, I p is then p^2.
+//--------------------------------------------------------------------------------------
+cbuffer Guided : register( b0 )
+{
+    int   g_Radius;
+    float g_Epsilon; // regularization, the variance below which edges are smoothed
+};
+
+Texture2D<uint4>    GuideSums     : register(t0);
+Texture2D<uint4>    GuideSquares  : register(t1);
+Texture2D<uint4>    InputSums     : register(t2);
+Texture2D<uint4>    InputProducts : register(t3);
+RWTexture2D<float4> MapA          : register(u0);
+RWTexture2D<float4> MapB          : register(u1);
+
+//! Sum of the window [lo, hi], Load() returns 0 left of and above the table.
+uint4 WindowSum(Texture2D<uint4> table, int2 lo, int2 hi)
+{
+    return table.Load(int3(hi, 0)) - table.Load(int3(lo.x - 1, hi.y, 0))
+         - table.Load(int3(hi.x, lo.y - 1, 0)) + table.Load(int3(lo - 1, 0));
+}
+
+[numthreads(32, 32, 1)]
+void CSMain( uint3 dispatchThreadID : SV_DispatchThreadID )
+{
+    uint width, height;
+    GuideSums.GetDimensions(width, height);
+    if (dispatchThreadID.x >= width || dispatchThreadID.y >= height)
+        return;
+
+    int2 pos = int2(dispatchThreadID.xy);
+    int2 lo = max(pos - g_Radius, int2(0, 0));
+    int2 hi = min(pos + g_Radius, int2(width, height) - 1);
+    // The tables count texels as 8 bit integers, the means are brought back to [0, 1].
+    float scale = 1.0 / (float((hi.x - lo.x + 1) * (hi.y - lo.y + 1)) * 255.0);
+
+    float4 meanI = float4(WindowSum(GuideSums, lo, hi)) * scale;
+    float4 meanP = float4(WindowSum(InputSums, lo, hi)) * scale;
+    float4 meanII = float4(WindowSum(GuideSquares, lo, hi)) * (scale / 255.0);
+    float4 meanIP = float4(WindowSum(InputProducts, lo, hi)) * (scale / 255.0);
+
+    float4 varianceI = max(meanII - meanI * meanI, 0.0);
+    float4 a = (meanIP - meanI * meanP) / (varianceI + g_Epsilon);
+    MapA[pos] = a;
+    MapB[pos] = meanP - a * meanI;
+}
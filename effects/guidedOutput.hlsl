@@ -0,0 +1,18 @@
+//--------------------------------------------------------------------------------------
+// Guided filter, last step : q = mean(a) I + mean(b), the coefficients averaged over the
+// windows that cover the pixel (box passes of boxBlur.hlsl).
+//--------------------------------------------------------------------------------------
+Texture2D<float4>   GuideMap  : register(t0);
+Texture2D<float4>   MeanA     : register(t1);
+Texture2D<float4>   MeanB     : register(t2);
+Texture2D<float4>   InputMap  : register(t3);
+RWTexture2D<float4> OutputMap : register(u0);
+
+[numthreads(32, 32, 1)]
+void CSMain( uint3 dispatchThreadID : SV_DispatchThreadID )
+{
+    int3 pos = int3(dispatchThreadID.xy, 0);
+    float4 guide = GuideMap.Load(pos);
+    float4 q = MeanA.Load(pos) * guide + MeanB.Load(pos);
+    OutputMap[dispatchThreadID.xy] = float4(q.rgb, InputMap.Load(pos).a);
+}
@@ -0,0 +1,37 @@
+//--------------------------------------------------------------------------------------
+// Canny edges, hysteresis : a weak edge (0.5) next to a strong one (1) becomes strong.
+// Every pass grows the strong edges by a pixel along the weak ones; the final pass
+// also drops the weak edges left, the output is 0 or 1.
+//--------------------------------------------------------------------------------------
+cbuffer Hysteresis : register( b0 )
+{
+    uint g_Final;
+};
+
+Texture2D<float>    EdgeMap   : register(t0);
+RWTexture2D<float4> OutputMap : register(u0); // R8 between passes, the image after the last one
+
+[numthreads(32, 32, 1)]
+void CSMain( uint3 dispatchThreadID : SV_DispatchThreadID )
+{
+    uint width, height;
+    EdgeMap.GetDimensions(width, height);
+    if (dispatchThreadID.x >= width || dispatchThreadID.y >= height)
+        return;
+
+    int2 pos = int2(dispatchThreadID.xy);
+    float center = EdgeMap.Load(int3(pos, 0));
+    float strongest = 0.0;
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            strongest = max(strongest, EdgeMap.Load(int3(pos + int2(dx, dy), 0))); // 0 outside
+        }
+    }
+
+    float edge = center > 0.25 && strongest > 0.75 ? 1.0 : center;
+    if (g_Final)
+        edge = edge > 0.75 ? 1.0 : 0.0;
+    OutputMap[pos] = float4(edge, edge, edge, 1.0);
+}
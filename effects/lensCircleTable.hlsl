@@ -0,0 +1,33 @@
+
+//--------------------------------------------------------------------------------------
+// Builds the lens circle weight table : the vignette factor lensCircle.hlsl applies to
+// every output pixel. Applied with remapWeight.hlsl.
+//--------------------------------------------------------------------------------------
+
+#include "warps.hlsli"
+
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+cbuffer CB : register(b0)
+{
+    unsigned int g_iWidth;   //< of the image
+    unsigned int g_iHeight;
+    int g_iOriginX;          //< image pixel of texel (0, 0), not 0 when the image runs in tiles
+    int g_iOriginY;
+    float g_fInner;
+    float g_fOuter;
+};
+
+RWTexture2D<float> WeightTable : register(u0);
+
+[numthreads(32, 32, 1)]
+void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    uint width, height;
+    WeightTable.GetDimensions(width, height);
+    if (dispatchThreadID.x >= width || dispatchThreadID.y >= height)
+        return;
+    float2 uv = (float2(dispatchThreadID.xy) + float2(g_iOriginX, g_iOriginY)) / float2(g_iWidth, g_iHeight);
+    WeightTable[dispatchThreadID.xy] = lensCircleWeight(uv, g_fInner, g_fOuter);
+}
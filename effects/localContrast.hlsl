@@ -0,0 +1,32 @@
+//
+// Local contrast : the detail of a pixel is its difference to a coarse level of the mip
+// pyramid of the image, scaled up. Level n averages 2^n x 2^n pixels, the bilinear sample
+// between its texels keeps the base smooth.
+//
+
+SamplerState samLinear : register(s0);
+
+cbuffer CB : register(b0)
+{
+    uint  g_uMip;      //< of Pyramid, its mip 0 is level 1 of the image
+    float g_fAmount;   //< 0 returns the image, 1 doubles the detail
+    float g_fInvScale; //< 1 / 2^level
+};
+
+Texture2D<float4>   InputMap  : register(t0);
+Texture2D<float4>   Pyramid   : register(t1);
+RWTexture2D<float4> OutputMap : register(u0);
+
+[numthreads(32, 32, 1)]
+void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    // Odd sizes round the mips down, uv is relative to the mip so that texel i still covers
+    // pixels [i * 2^level, (i + 1) * 2^level) and tiles aligned on 2^level see the same texels.
+    uint width, height, levels;
+    Pyramid.GetDimensions(g_uMip, width, height, levels);
+    float2 uv = (float2(dispatchThreadID.xy) + 0.5f) * g_fInvScale / float2(width, height);
+
+    float4 data = InputMap.Load(int3(dispatchThreadID.xy, 0));
+    float3 base = Pyramid.SampleLevel(samLinear, uv, g_uMip).rgb;
+    OutputMap[dispatchThreadID.xy] = float4(base + (data.rgb - base) * (1.f + g_fAmount), data.a);
+}
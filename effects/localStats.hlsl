@@ -0,0 +1,45 @@
+//--------------------------------------------------------------------------------------
+// Mean or standard deviation of the (2 g_Radius + 1)^2 window around every pixel, read
+// from the summed-area tables in four loads whatever the radius. The window is clipped
+// to the image, the statistics are those of the pixels inside.
+//--------------------------------------------------------------------------------------
+cbuffer LocalStats : register( b0 )
+{
+    int   g_Radius;
+    uint  g_Mode;  // 0 : mean (box filter), 1 : standard deviation
+    float g_Gain;  // scales the standard deviation
+};
+
+Texture2D<uint4>    SumMap    : register(t0);
+Texture2D<uint4>    SquareMap : register(t1);
+RWTexture2D<float4> OutputMap : register(u0);
+
+//! Sum of the window [lo, hi], Load() returns 0 left of and above the table.
+uint4 WindowSum(Texture2D<uint4> table, int2 lo, int2 hi)
+{
+    return table.Load(int3(hi, 0)) - table.Load(int3(lo.x - 1, hi.y, 0))
+         - table.Load(int3(hi.x, lo.y - 1, 0)) + table.Load(int3(lo - 1, 0));
+}
+
+[numthreads(32, 32, 1)]
+void CSMain( uint3 dispatchThreadID : SV_DispatchThreadID )
+{
+    uint width, height;
+    SumMap.GetDimensions(width, height);
+    if (dispatchThreadID.x >= width || dispatchThreadID.y >= height)
+        return;
+
+    int2 pos = int2(dispatchThreadID.xy);
+    int2 lo = max(pos - g_Radius, int2(0, 0));
+    int2 hi = min(pos + g_Radius, int2(width, height) - 1);
+    float count = float((hi.x - lo.x + 1) * (hi.y - lo.y + 1));
+
+    float4 mean = float4(WindowSum(SumMap, lo, hi)) / count;
+    if (g_Mode == 0)
+    {
+        OutputMap[pos] = mean / 255.0;
+        return;
+    }
+    float4 variance = max(float4(WindowSum(SquareMap, lo, hi)) / count - mean * mean, 0.0);
+    OutputMap[pos] = float4(saturate(sqrt(variance.rgb) / 255.0 * g_Gain), 1.0);
+}
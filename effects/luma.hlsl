@@ -0,0 +1,13 @@
+//--------------------------------------------------------------------------------------
+// Luma (Rec. 601 weights) of the image into a single channel plane, the first pass of
+// the edge detector; an R8 target keeps the next passes at a byte per pixel.
+//--------------------------------------------------------------------------------------
+Texture2D<float4>  InputMap : register(t0);
+RWTexture2D<float> LumaMap  : register(u0);
+
+[numthreads(32, 32, 1)]
+void CSMain( uint3 dispatchThreadID : SV_DispatchThreadID )
+{
+    float3 rgb = saturate(InputMap.Load(int3(dispatchThreadID.xy, 0)).rgb);
+    LumaMap[dispatchThreadID.xy] = dot(rgb, float3(0.299, 0.587, 0.114));
+}
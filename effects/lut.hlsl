@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------------------
+// Colour transform through a lookup table, see ColorLUT.h for the layouts. A 1D table is
+// interpolated per channel, alpha included; a cube maps rgb, trilinearly from the eight
+// entries around the colour or tetrahedrally from four of them, and keeps alpha.
+//--------------------------------------------------------------------------------------
+#define LUT_1D          0
+#define LUT_TRILINEAR   1
+#define LUT_TETRAHEDRAL 2
+
+cbuffer ColorLUT : register( b0 )
+{
+    uint   g_Size;        // entries per axis
+    uint   g_Mode;        // LUT_
+    float2 g_Pad;
+    float4 g_DomainMin;   // .w 0 : the domain of alpha is [0, 1]
+    float4 g_DomainScale; // (g_Size - 1) / (max - min), .w g_Size - 1
+};
+
+Texture2D<float4>   InputMap  : register(t0);
+Texture2D<float4>   LUTMap    : register(t1);
+RWTexture2D<float4> OutputMap : register(u0);
+
+float4 Entry(uint3 i)
+{
+    return LUTMap.Load(int3(i.r + g_Size * i.g, i.b, 0));
+}
+
+//! The tetrahedron of the cell holding f is walked from entry i along the axes by
+//! decreasing fraction : 4 entries instead of 8, and neutral greys stay neutral.
+float3 Tetrahedral(uint3 i, float3 f)
+{
+    uint3 first, second;
+    float3 w;
+    if (f.r > f.g)
+    {
+        if (f.g > f.b)      { first = uint3(1, 0, 0); second = uint3(1, 1, 0); w = f.rgb; }
+        else if (f.r > f.b) { first = uint3(1, 0, 0); second = uint3(1, 0, 1); w = f.rbg; }
+        else                { first = uint3(0, 0, 1); second = uint3(1, 0, 1); w = f.brg; }
+    }
+    else
+    {
+        if (f.b > f.g)      { first = uint3(0, 0, 1); second = uint3(0, 1, 1); w = f.bgr; }
+        else if (f.b > f.r) { first = uint3(0, 1, 0); second = uint3(0, 1, 1); w = f.gbr; }
+        else                { first = uint3(0, 1, 0); second = uint3(1, 1, 0); w = f.grb; }
+    }
+    float3 c0 = Entry(i).rgb;
+    float3 c1 = Entry(i + first).rgb;
+    float3 c2 = Entry(i + second).rgb;
+    float3 c3 = Entry(i + 1).rgb;
+    return c0 + (c1 - c0) * w.x + (c2 - c1) * w.y + (c3 - c2) * w.z;
+}
+
+float3 Trilinear(uint3 i, float3 f)
+{
+    float3 c00 = Entry(i).rgb + (Entry(i + uint3(1, 0, 0)).rgb - Entry(i).rgb) * f.r;
+    float3 c10 = Entry(i + uint3(0, 1, 0)).rgb + (Entry(i + uint3(1, 1, 0)).rgb - Entry(i + uint3(0, 1, 0)).rgb) * f.r;
+    float3 c01 = Entry(i + uint3(0, 0, 1)).rgb + (Entry(i + uint3(1, 0, 1)).rgb - Entry(i + uint3(0, 0, 1)).rgb) * f.r;
+    float3 c11 = Entry(i + uint3(0, 1, 1)).rgb + (Entry(i + 1).rgb - Entry(i + uint3(0, 1, 1)).rgb) * f.r;
+    float3 c0 = c00 + (c10 - c00) * f.g;
+    float3 c1 = c01 + (c11 - c01) * f.g;
+    return c0 + (c1 - c0) * f.b;
+}
+
+[numthreads(32, 32, 1)]
+void CSMain( uint3 dispatchThreadID : SV_DispatchThreadID )
+{
+    float4 data = InputMap.Load(int3(dispatchThreadID.xy, 0));
+
+    // Lattice coordinates, the last cell takes the colours at the top of the domain.
+    float4 p = clamp((data - g_DomainMin) * g_DomainScale, 0.0, float(g_Size - 1));
+    uint4 i = min(uint4(p), g_Size - 2);
+    float4 f = p - float4(i);
+
+    float4 result;
+    if (g_Mode == LUT_1D)
+    {
+        [unroll]
+        for (int c = 0; c < 4; ++c)
+        {
+            float a = LUTMap.Load(int3(i[c], 0, 0))[c];
+            float b = LUTMap.Load(int3(i[c] + 1, 0, 0))[c];
+            result[c] = a + (b - a) * f[c];
+        }
+    }
+    else
+    {
+        result.rgb = g_Mode == LUT_TETRAHEDRAL ? Tetrahedral(i.rgb, f.rgb) : Trilinear(i.rgb, f.rgb);
+        result.a = data.a;
+    }
+    OutputMap[dispatchThreadID.xy] = result;
+}
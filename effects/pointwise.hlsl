@@ -0,0 +1,41 @@
+//
+// Runs of per-pixel filters fused into one pass, see FusedPointwiseFilter.
+// STAGE0 .. STAGE3 are the PW_ ops of the stages in order, one permutation per run.
+//
+
+#include "pointwise.hlsli"
+
+cbuffer CB : register(b0)
+{
+    unsigned int g_iWidth;   //< of the image
+    unsigned int g_iHeight;
+    int g_iOriginX;          //< image pixel of texel (0, 0), not 0 when the image runs in tiles
+    int g_iOriginY;
+    unsigned int g_iStageCount;
+    uint3 g_iPad;
+    uint4 g_Ops;            //< the STAGE defines, for the CPU backend
+    float4 g_Params[4];
+};
+
+Texture2D<float4>   InputMap  : register(t0);
+RWTexture2D<float4> OutputMap : register(u0);
+
+[numthreads(32, 32, 1)]
+void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    float2 uv = (float2(dispatchThreadID.xy) + float2(g_iOriginX, g_iOriginY)) / float2(g_iWidth, g_iHeight);
+    float4 data = InputMap.Load(dispatchThreadID);
+#ifdef STAGE0
+    data = applyPointwise(STAGE0, data, uv, g_Params[0]);
+#endif
+#ifdef STAGE1
+    data = applyPointwise(STAGE1, data, uv, g_Params[1]);
+#endif
+#ifdef STAGE2
+    data = applyPointwise(STAGE2, data, uv, g_Params[2]);
+#endif
+#ifdef STAGE3
+    data = applyPointwise(STAGE3, data, uv, g_Params[3]);
+#endif
+    OutputMap[dispatchThreadID.xy] = data;
+}
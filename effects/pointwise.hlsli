@@ -0,0 +1,35 @@
+//--------------------------------------------------------------------------------------
+// Per-pixel operations, shared by the single filters and the fused kernel pointwise.hlsl.
+// Each one only reads the pixel it writes, so any run of them can be chained in registers.
+//--------------------------------------------------------------------------------------
+
+#include "warps.hlsli"
+
+#define PW_NONE         0
+#define PW_POSTERIZE    1
+#define PW_LENS_CIRCLE  2
+
+//! denoise.hlsl, posterizes in a gamma space to flatten noise in smooth areas.
+float4 posterize(float4 data)
+{
+    const float gamma = 0.6f;
+    const float numColors = 8.0f;
+    float3 c = pow(data.rgb, float3(gamma, gamma, gamma));
+    c = floor(c * numColors) / numColors;
+    c = pow(c, float3(1.0 / gamma, 1.0 / gamma, 1.0 / gamma));
+    return float4(c, 1.0);
+}
+
+//! op is a literal in the fused kernel, the branches fold at compile time.
+float4 applyPointwise(uint op, float4 data, float2 uv, float4 params)
+{
+    if (op == PW_POSTERIZE)
+    {
+        data = posterize(data);
+    }
+    else if (op == PW_LENS_CIRCLE)
+    {
+        data.rgb *= lensCircleWeight(uv, params.x, params.y);
+    }
+    return data;
+}
@@ -0,0 +1,32 @@
+
+//--------------------------------------------------------------------------------------
+// Applies a coordinate remap table built by fishEyeTable.hlsl / swirlTable.hlsl.
+// Every output pixel is a single table read plus one filtered gather, no trigonometry.
+//--------------------------------------------------------------------------------------
+
+#include "warps.hlsli"
+
+SamplerState samLinear: register(s0);
+
+//--------------------------------------------------------------------------------------
+// The head of the constant buffer of the filter that built the table
+//--------------------------------------------------------------------------------------
+cbuffer CB : register(b0)
+{
+    unsigned int g_iWidth;   //< of the image
+    unsigned int g_iHeight;
+    int g_iOriginX;          //< image pixel of texel (0, 0), not 0 when the image runs in tiles
+    int g_iOriginY;
+};
+
+Texture2D<float4>   InputMap   : register(t0);
+Texture2D<float2>   RemapTable : register(t1);
+RWTexture2D<float4> OutputMap  : register(u0);
+
+[numthreads(32, 32, 1)]
+void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    float2 uv = RemapTable.Load(int3(dispatchThreadID.xy, 0));
+    uv = imageToTexture(uv, float2(g_iWidth, g_iHeight), float2(g_iOriginX, g_iOriginY), InputMap);
+    OutputMap[dispatchThreadID.xy] = InputMap.SampleLevel(samLinear, uv, 0);
+}
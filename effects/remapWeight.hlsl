@@ -0,0 +1,16 @@
+
+//--------------------------------------------------------------------------------------
+// Applies a per pixel weight table built by lensCircleTable.hlsl to the color channels.
+//--------------------------------------------------------------------------------------
+
+Texture2D<float4>   InputMap    : register(t0);
+Texture2D<float>    WeightTable : register(t1);
+RWTexture2D<float4> OutputMap   : register(u0);
+
+[numthreads(32, 32, 1)]
+void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    float4 data = InputMap.Load(dispatchThreadID);
+    data.rgb *= WeightTable.Load(int3(dispatchThreadID.xy, 0));
+    OutputMap[dispatchThreadID.xy] = data;
+}
@@ -0,0 +1,40 @@
+//--------------------------------------------------------------------------------------
+// Second pass of a summed-area table : the row sums of satRows.hlsl summed down every
+// column. Entry (x, y) is the sum of the texels [0, x] x [0, y], modulo 2^32.
+//--------------------------------------------------------------------------------------
+cbuffer SATPass : register( b0 )
+{
+    uint g_Squares; // also sum the squared texels into SquareMap
+    uint g_Factor;  // satRows.hlsl only
+};
+
+#define GROUP_SIZE 64
+
+Texture2D<uint4>   RowSumMap    : register(t0);
+Texture2D<uint4>   RowSquareMap : register(t1);
+RWTexture2D<uint4> SumMap       : register(u0);
+RWTexture2D<uint4> SquareMap    : register(u1);
+
+//! x of the dispatch selects the column.
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSMain( uint3 dispatchThreadID : SV_DispatchThreadID )
+{
+    uint width, height;
+    RowSumMap.GetDimensions(width, height);
+    uint x = dispatchThreadID.x;
+    if (x >= width)
+        return;
+
+    uint4 sum = uint4(0, 0, 0, 0);
+    uint4 squares = uint4(0, 0, 0, 0);
+    for (uint y = 0; y < height; ++y)
+    {
+        sum += RowSumMap.Load(int3(x, y, 0));
+        SumMap[uint2(x, y)] = sum;
+        if (g_Squares)
+        {
+            squares += RowSquareMap.Load(int3(x, y, 0));
+            SquareMap[uint2(x, y)] = squares;
+        }
+    }
+}
@@ -0,0 +1,45 @@
+//--------------------------------------------------------------------------------------
+// First pass of a summed-area table : the running sum of every row. The texels are
+// counted as 8 bit integers, the sums are uint and wrap around modulo 2^32, the
+// differences of four table entries are still exact as long as the window sums fit.
+// satColumns.hlsl then sums these rows down the columns. The second table sums the
+// squared texels, or their products with the texels of FactorMap.
+//--------------------------------------------------------------------------------------
+cbuffer SATPass : register( b0 )
+{
+    uint g_Squares; // also sum the squared texels into SquareMap
+    uint g_Factor;  // multiply by the texels of FactorMap instead of squaring
+};
+
+#define GROUP_SIZE 64
+
+Texture2D<float4>  InputMap  : register(t0);
+Texture2D<float4>  FactorMap : register(t1);
+RWTexture2D<uint4> SumMap    : register(u0);
+RWTexture2D<uint4> SquareMap : register(u1);
+
+//! x of the dispatch selects the row.
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSMain( uint3 dispatchThreadID : SV_DispatchThreadID )
+{
+    uint width, height;
+    InputMap.GetDimensions(width, height);
+    uint y = dispatchThreadID.x;
+    if (y >= height)
+        return;
+
+    uint4 sum = uint4(0, 0, 0, 0);
+    uint4 squares = uint4(0, 0, 0, 0);
+    for (uint x = 0; x < width; ++x)
+    {
+        uint4 texel = uint4(saturate(InputMap.Load(int3(x, y, 0))) * 255.0 + 0.5);
+        sum += texel;
+        SumMap[uint2(x, y)] = sum;
+        if (g_Squares)
+        {
+            uint4 factor = g_Factor ? uint4(saturate(FactorMap.Load(int3(x, y, 0))) * 255.0 + 0.5) : texel;
+            squares += texel * factor;
+            SquareMap[uint2(x, y)] = squares;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+//--------------------------------------------------------------------------------------
+// Canny edges, second pass : 3x3 Sobel gradient of the luma, non-maximum suppression
+// across the gradient direction and the double threshold. Output 1 is a strong edge,
+// 0.5 a weak one that hysteresis.hlsl keeps if it touches a strong one.
+// The luma is counted in 8 bit steps, gradients and squared magnitudes are integers and
+// compare the same on every backend. Pixels outside of the image repeat the edge.
+//--------------------------------------------------------------------------------------
+cbuffer EdgeThresholds : register( b0 )
+{
+    float g_LowSq;  // squared gradient magnitudes, in 8 bit luma steps
+    float g_HighSq;
+};
+
+#define GROUP_X 32
+#define GROUP_Y 8
+
+Texture2D<float>   LumaMap : register(t0);
+RWTexture2D<float> EdgeMap : register(u0);
+
+groupshared float  lumaTile[GROUP_Y + 4][GROUP_X + 4];
+groupshared float2 gradientTile[GROUP_Y + 2][GROUP_X + 2];
+
+float MagnitudeSq(int2 t)
+{
+    float2 g = gradientTile[t.y][t.x];
+    return dot(g, g);
+}
+
+[numthreads(GROUP_X, GROUP_Y, 1)]
+void CSMain( uint3 groupID : SV_GroupID, uint3 groupThreadID : SV_GroupThreadID, uint3 dispatchThreadID : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex )
+{
+    uint width, height;
+    LumaMap.GetDimensions(width, height);
+    int2 last = int2(width, height) - 1;
+    int2 origin = int2(groupID.xy) * int2(GROUP_X, GROUP_Y) - 2;
+
+    for (uint i = groupIndex; i < (GROUP_X + 4) * (GROUP_Y + 4); i += GROUP_X * GROUP_Y)
+    {
+        int2 t = int2(i % (GROUP_X + 4), i / (GROUP_X + 4));
+        lumaTile[t.y][t.x] = round(LumaMap.Load(int3(clamp(origin + t, 0, last), 0)) * 255.0);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint j = groupIndex; j < (GROUP_X + 2) * (GROUP_Y + 2); j += GROUP_X * GROUP_Y)
+    {
+        int2 t = int2(j % (GROUP_X + 2), j / (GROUP_X + 2));
+        float gx = (lumaTile[t.y][t.x + 2] - lumaTile[t.y][t.x])
+                 + 2.0 * (lumaTile[t.y + 1][t.x + 2] - lumaTile[t.y + 1][t.x])
+                 + (lumaTile[t.y + 2][t.x + 2] - lumaTile[t.y + 2][t.x]);
+        float gy = (lumaTile[t.y + 2][t.x] + 2.0 * lumaTile[t.y + 2][t.x + 1] + lumaTile[t.y + 2][t.x + 2])
+                 - (lumaTile[t.y][t.x] + 2.0 * lumaTile[t.y][t.x + 1] + lumaTile[t.y][t.x + 2]);
+        gradientTile[t.y][t.x] = float2(gx, gy);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (dispatchThreadID.x >= width || dispatchThreadID.y >= height)
+        return;
+
+    int2 t = int2(groupThreadID.xy) + 1;
+    float2 g = gradientTile[t.y][t.x];
+    float magnitudeSq = dot(g, g);
+    if (magnitudeSq < g_LowSq)
+    {
+        EdgeMap[dispatchThreadID.xy] = 0.0;
+        return;
+    }
+
+    // The two neighbours along the gradient, its direction rounded to 45 degrees
+    // (tan 22.5 ~ 2 / 5).
+    float ax = abs(g.x), ay = abs(g.y);
+    int2 step = ay * 5.0 <= ax * 2.0 ? int2(1, 0) : (ay * 2.0 >= ax * 5.0 ? int2(0, 1) : (g.x * g.y > 0.0 ? int2(1, 1) : int2(1, -1)));
+    bool maximum = magnitudeSq >= MagnitudeSq(t + step) && magnitudeSq > MagnitudeSq(t - step);
+    EdgeMap[dispatchThreadID.xy] = !maximum ? 0.0 : (magnitudeSq >= g_HighSq ? 1.0 : 0.5);
+}
@@ -0,0 +1,72 @@
+
+//--------------------------------------------------------------------------------------
+// Coordinate warps shared by the direct filters and the remap table builders.
+// They only depend on the pixel position, image size and the filter constants, so a
+// table built from them once per resolution can replace the per-pixel math.
+//--------------------------------------------------------------------------------------
+
+static const float PI = 3.1415926535;
+
+//! Tiled runs : texel (0, 0) of map is pixel origin of an imageSize image. Turns a
+//! normalized image coordinate into the normalized coordinate of map. The position is
+//! snapped to the 1/256 texel grid of the bilinear weights in image pixels first, so a
+//! tile samples with the weights of the whole image despite the rounding of the divide.
+float2 imageToTexture(float2 uv, float2 imageSize, float2 origin, Texture2D<float4> map)
+{
+    float width, height;
+    map.GetDimensions(width, height);
+    float2 pos = round(uv * imageSize * 256.0) / 256.0;
+    return (pos - origin) / float2(width, height);
+}
+
+//! https://www.geeks3d.com/20140213/glsl-shader-library-fish-eye-and-dome-and-barrel-distortion-post-processing-filters/
+float2 fishEyeWarp(float2 uvCoord, float aperture)
+{
+    float apertureHalf = 0.5 * aperture * (PI / 180.0);
+    float maxFactor = sin(apertureHalf);
+
+    float2 uv;
+    float2 xy = 2.0 * uvCoord.xy - 1.0;
+    float d = length(xy);
+    if (d < (2.0 - maxFactor))
+    {
+        d = length(xy * maxFactor);
+        float z = sqrt(1.0 - d * d);
+        float r = atan2(d, z) / PI;
+        float phi = atan2(xy.y, xy.x);
+
+        uv.x = r * cos(phi) + 0.5;
+        uv.y = r * sin(phi) + 0.5;
+    }
+    else
+    {
+        uv = uvCoord.xy;
+    }
+    return uv;
+}
+
+//! https://www.geeks3d.com/20110428/shader-library-swirl-post-processing-filter-in-glsl
+//! pos is in pixels, the result is a normalized texture coordinate.
+float2 swirlWarp(float2 pos, float2 size, float radius, float angle)
+{
+    float2 center = size * .5f;
+    float2 uv = pos - center;
+    float r = length(uv);
+    if (r < radius)
+    {
+        float percent = (radius - r) / radius;
+        float theta = percent * percent * angle * 8.0;
+        float s = sin(theta);
+        float c = cos(theta);
+        uv = float2(dot(uv, float2(c, -s)), dot(uv, float2(s, c)));
+    }
+    uv += center;
+    return uv / size;
+}
+
+//! https://www.geeks3d.com/20091020/shader-library-lens-circle-post-processing-effect-glsl/
+float lensCircleWeight(float2 uv, float inner, float outer)
+{
+    float dist = distance(uv, float2(0.5, 0.5));
+    return smoothstep(outer, inner, dist);
+}
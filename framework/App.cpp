@@ -217,6 +217,7 @@ namespace GHI
 
 	void App::EndFrame_private()
 	{
+		commandContext->ResolveProfile();
 		imgui::EndFrame();
 		swapchain.D3DSwapChain()->Present(0,0);
 	}
@@ -238,6 +239,15 @@ namespace GHI
 
 	void App::CalculateFPS()
 	{
+		timeDeltaBuffer[currentTimeDeltaSample] = timer.DeltaSecondsF();
+		currentTimeDeltaSample = (currentTimeDeltaSample + 1) % NumTimeDeltaSamples;
+
+		float averageDelta = 0;
+		for (uint32 i = 0; i < NumTimeDeltaSamples; ++i)
+			averageDelta += timeDeltaBuffer[i];
+		averageDelta /= NumTimeDeltaSamples;
+
+		fps = averageDelta > 0.f ? uint32(1.f / averageDelta + 0.5f) : 0;
 	}
 
 	void App::OnWindowResized(void* context, HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
@@ -278,12 +288,12 @@ namespace GHI
 
     void App::DrawFullScreenTriangle(GHIViewport viewport, GHITexture *tex)
     {
-        commandContext->SetShader((*shaderCache)["VS"]);
+        commandContext->SetShader(fullScreenVS);
 		commandContext->setPrimitiveTopology(PrimitiveTopology::TOPOLOGY_TRIANGLESTRIP);
 		commandContext->SetViewport(viewport);
         commandContext->SetShaderResource(tex, 0, GHISRVParam(), EShaderStage::PS);
         commandContext->SetSampler(linearSampler, 0, EShaderStage::PS);
-        commandContext->SetShader((*shaderCache)["PS"]);
+        commandContext->SetShader(fullScreenPS);
 		commandContext->Draw(3, 0);
     }
 
@@ -298,13 +308,15 @@ namespace GHI
 			std::vector<std::string> symbols = Split(str);
 			if (symbols[1] == "VS")
 			{
-				GHIVertexShader* vs = commandContext->CreateVertexShader(file, symbols[2]);
-				shaderCache->AddGraphicShader(symbols[2], vs);
+				GHIShader* vs = shaderCache->Insert(ShaderKey(file, symbols[2], EShaderStage::VS), commandContext->CreateVertexShader(file, symbols[2]));
+				if (symbols[2] == "VS")
+					fullScreenVS = vs;
 			}
 			else if (symbols[1] == "PS")
 			{
-				GHIPixelShader* ps = commandContext->CreatePixelShader(file, symbols[2]);
-				shaderCache->AddGraphicShader(symbols[2], ps);
+				GHIShader* ps = shaderCache->Insert(ShaderKey(file, symbols[2], EShaderStage::PS), commandContext->CreatePixelShader(file, symbols[2]));
+				if (symbols[2] == "PS")
+					fullScreenPS = ps;
 			}
 		}
 		in.close();
@@ -80,6 +80,8 @@ protected:
 	GHISampler *linearSampler = nullptr;
     //std::unique_ptr<GHISampler> linearSampler;
 	ShaderCache *shaderCache = nullptr;
+	GHIShader *fullScreenVS = nullptr; //< "VS" / "PS" entries of the loaded shader program
+	GHIShader *fullScreenPS = nullptr;
 
     inline std::wstring ToWstr(const std::string &str) const
     {
@@ -7,27 +7,39 @@
 
 #pragma once
 
+#include <filesystem>
 #include "GHICommandContext.h" 
 #include "ShaderCache.h" 
-#include "Utility.h" 
+#if defined(_WIN32)
+#include "Utility.h"
+#else
+// Utility.h is the Win32 side of the framework, its logging is debug output only.
+#define DLOG(fmt, ...)
+#define ELOG(fmt, ...)
+#endif
 
 namespace GHI
 {
 
 	ShaderCache *gShaderCache = nullptr;
 
-	GHIShader* IGHIComputeCommandCotext::GetComputeShader(std::string file)
+	GHIShader* IGHIComputeCommandCotext::GetComputeShader(const ShaderKey &key)
 	{
-        if ( FileExtension(file.c_str()) != "hlsl")
+        if (std::filesystem::path(key.File()).extension() != ".hlsl")
         {
             ELOG("shader file extension is NOT qualified.");
         }
-		GHIShader *ret = gShaderCache ? gShaderCache->GetComputerShader(file) : nullptr;
-		if (ret == nullptr)
-		{
-			ret = this->CreateComputeShader(file);
-			gShaderCache->AddComputeShader(ret);
-		}
-		return ret;
+		return gShaderCache ? gShaderCache->GetOrCreate(key) : this->CreateComputeShader(key);
+	}
+
+	void IGHIComputeCommandCotext::DestroyTexture(GHITexture *texture)
+	{
+		if (!texture)
+			return;
+		mStateShadow.ForgetResource(EBindKind::SRV, texture);
+		mStateShadow.ForgetResource(EBindKind::UAV, texture);
+		texture->release();
+		GHIResource::list.remove(texture);
+		delete texture;
 	}
 }
\ No newline at end of file
@@ -8,6 +8,10 @@
 #pragma once
 
 #include "GHIResources.h" 
+#include "GHIProfiler.h" 
+#include "GHIReadback.h" 
+#include "GHIStateShadow.h" 
+#include "GHITexturePool.h" 
 
 namespace GHI
 {
@@ -34,9 +38,23 @@ namespace GHI
 	class IGHIComputeCommandCotext
 	{
 	public:
+        virtual ~IGHIComputeCommandCotext()
+        {
+        }
+
         virtual GHIBuffer*  CreateConstBuffer(int size, const void* initData) = 0;
         virtual GHITexture* CreateTexture(std::string filename) = 0;
+        virtual GHITexture* CreateTexture(const TextureDesc2D &desc, const void* initData = nullptr) = 0;
         virtual GHITexture* CreateTextureByAnother(GHITexture * tex) = 0;
+        //! Releases the API objects and deletes the texture, nothing may use it afterwards.
+        virtual void DestroyTexture(GHITexture *texture);
+
+        //! Recycles textures by description, prefer it over CreateTexture for anything
+        //! that is created and dropped repeatedly.
+        GHITexturePool& TexturePool()
+        {
+            return mTexturePool;
+        }
 
 		virtual void UpdateBuffer(GHIBuffer*buffer, void* data, int size) = 0;
         virtual void SetShaderResource(GHITexture *resource, int slot, GHISRVParam view,EShaderStage stage = EShaderStage::CS) = 0;
@@ -46,6 +64,23 @@ namespace GHI
         virtual void SetSampler(GHISampler *resource, int slot, EShaderStage stage) = 0;
 
 		virtual void CopyTexture(GHITexture *dst, GHITexture *src) = 0;
+        //! Queues a copy of the texture into a pooled staging buffer and returns at once, 0 on failure.
+        //! Work submitted after the call does not affect the copied pixels.
+        virtual GHIReadbackTicket ReadTextureAsync(GHITexture *tex) = 0;
+        //! Pending while the copy is in flight (or blocks when wait is set). On Ready, data gets the
+        //! pixels and the ticket is consumed, its staging buffer is reused by later readbacks.
+        virtual EReadbackStatus PollReadback(GHIReadbackTicket ticket, GHIReadbackData &data, bool wait = false) = 0;
+
+        //! Blocking readback, rows tightly packed (Width * BytesPerPixel).
+        bool ReadTexture(GHITexture *tex, void *data)
+        {
+            GHIReadbackData result;
+            GHIReadbackTicket ticket = ReadTextureAsync(tex);
+            if (!ticket || PollReadback(ticket, result, true) != EReadbackStatus::Ready)
+                return false;
+            memcpy(data, result.pixels.data(), result.pixels.size());
+            return true;
+        }
 		virtual void Dispatch(int nX, int nY, int nZ) = 0;
 		virtual void SetViewport(GHIViewport viewport) = 0;
 		virtual void Draw(int count, int offset) = 0;
@@ -54,11 +89,49 @@ namespace GHI
 
         virtual GHIVertexShader*  CreateVertexShader(std::string file, std::string entrypoint) = 0;
         virtual GHIPixelShader*   CreatePixelShader(std::string file, std::string entrypoint) = 0;
-        virtual GHIShader* CreateComputeShader(std::string file) = 0;
+        //! Compiles one permutation, the key's defines are passed to the preprocessor.
+        virtual GHIShader* CreateComputeShader(const ShaderKey &key) = 0;
+        GHIShader* CreateComputeShader(std::string file)
+        {
+            return CreateComputeShader(ShaderKey(file));
+        }
         virtual GHIShader* CreateShader(std::string file) = 0;
         virtual void SetShader(GHIShader* shader) = 0;
 
-        GHIShader* GetComputeShader(std::string file);
+        //! Shared through the global ShaderCache, each permutation is created once.
+        GHIShader* GetComputeShader(const ShaderKey &key);
+        GHIShader* GetComputeShader(std::string file)
+        {
+            return GetComputeShader(ShaderKey(file));
+        }
+
+        //! Dispatch / CopyTexture issued between BeginProfile and EndProfile are timed and
+        //! reported to Profiler() as one sample of scope, pixels is used for the throughput.
+        virtual void BeginProfile(const std::string &scope, uint64_t pixels) = 0;
+        virtual void EndProfile() = 0;
+        //! Once per frame, hands finished timings over to Profiler().
+        virtual void ResolveProfile() {}
+
+        GHIProfiler& Profiler()
+        {
+            return mProfiler;
+        }
+
+        //! Binds are filtered against the shadowed state, Counters() tells how many were elided.
+        GHIStateShadow& StateShadow()
+        {
+            return mStateShadow;
+        }
+        //! Forgets the shadowed bindings, call after code bound state behind the context's back.
+        virtual void InvalidateState()
+        {
+            mStateShadow.Invalidate();
+        }
+
+    protected:
+        GHIProfiler mProfiler;
+        GHIStateShadow mStateShadow;
+        GHITexturePool mTexturePool { this };
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include "GHIPixelBuffer.h"
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+namespace GHI
+{
+    GHIPixelBuffer::GHIPixelBuffer(GHIPixelBuffer &&other) noexcept
+        : mData(other.mData)
+        , mSize(other.mSize)
+        , mCapacity(other.mCapacity)
+        , mPool(other.mPool)
+    {
+        other.mData = nullptr;
+        other.mSize = other.mCapacity = 0;
+        other.mPool = nullptr;
+    }
+
+    GHIPixelBuffer& GHIPixelBuffer::operator=(GHIPixelBuffer &&other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            std::swap(mData, other.mData);
+            std::swap(mSize, other.mSize);
+            std::swap(mCapacity, other.mCapacity);
+            std::swap(mPool, other.mPool);
+        }
+        return *this;
+    }
+
+    void GHIPixelBuffer::Reset()
+    {
+        if (mData)
+        {
+            if (mPool)
+                mPool->Release(mData, mCapacity);
+            else
+                GHIPixelBufferPool::Free(mData);
+        }
+        mData = nullptr;
+        mSize = mCapacity = 0;
+        mPool = nullptr;
+    }
+
+    uint8_t* GHIPixelBufferPool::Allocate(size_t bytes)
+    {
+        bytes = (bytes + GHIPixelBuffer::Alignment - 1) & ~(GHIPixelBuffer::Alignment - 1);
+#if defined(_MSC_VER)
+        void *data = _aligned_malloc(bytes, GHIPixelBuffer::Alignment);
+#else
+        void *data = std::aligned_alloc(GHIPixelBuffer::Alignment, bytes);
+#endif
+        if (!data)
+            throw std::bad_alloc();
+        return static_cast<uint8_t*>(data);
+    }
+
+    void GHIPixelBufferPool::Free(uint8_t *data)
+    {
+#if defined(_MSC_VER)
+        _aligned_free(data);
+#else
+        std::free(data);
+#endif
+    }
+
+    GHIPixelBufferPool::~GHIPixelBufferPool()
+    {
+        for (const FreeBuffer &f : mFree)
+            Free(f.data);
+    }
+
+    GHIPixelBufferPool& GHIPixelBufferPool::Global()
+    {
+        static GHIPixelBufferPool pool;
+        return pool;
+    }
+
+    GHIPixelBuffer GHIPixelBufferPool::Acquire(size_t size)
+    {
+        GHIPixelBuffer buffer;
+        buffer.mPool = this;
+        buffer.mSize = size;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            ++mStats.acquires;
+            auto best = mFree.end();
+            for (auto it = mFree.begin(); it != mFree.end(); ++it)
+            {
+                if (it->capacity >= size && it->capacity / 2 <= size && (best == mFree.end() || it->capacity < best->capacity))
+                    best = it;
+            }
+            if (best != mFree.end())
+            {
+                buffer.mData = best->data;
+                buffer.mCapacity = best->capacity;
+                mFree.erase(best);
+                --mStats.freeBuffers;
+                mStats.freeBytes -= buffer.mCapacity;
+                ++mStats.reuses;
+                return buffer;
+            }
+        }
+
+        buffer.mCapacity = std::max<size_t>(size, 1);
+        buffer.mData = Allocate(buffer.mCapacity);
+        std::lock_guard<std::mutex> lock(mMutex);
+        mHeldBytes += buffer.mCapacity;
+        mStats.highWaterBytes = std::max(mStats.highWaterBytes, mHeldBytes);
+        return buffer;
+    }
+
+    void GHIPixelBufferPool::Release(uint8_t *data, size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFree.push_back({ data, capacity });
+        ++mStats.freeBuffers;
+        mStats.freeBytes += capacity;
+        Trim();
+    }
+
+    void GHIPixelBufferPool::SetFreeBudget(uint64_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFreeBudget = bytes;
+        Trim();
+    }
+
+    // Called with the lock held.
+    void GHIPixelBufferPool::Trim()
+    {
+        while (mStats.freeBytes > mFreeBudget)
+        {
+            auto largest = std::max_element(mFree.begin(), mFree.end(),
+                [](const FreeBuffer &a, const FreeBuffer &b) { return a.capacity < b.capacity; });
+            Free(largest->data);
+            mHeldBytes -= largest->capacity;
+            mStats.freeBytes -= largest->capacity;
+            --mStats.freeBuffers;
+            mFree.erase(largest);
+        }
+    }
+
+    GHIPixelBufferPoolStats GHIPixelBufferPool::Stats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+}
@@ -0,0 +1,121 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace GHI
+{
+    class GHIPixelBufferPool;
+
+    struct GHIPixelBufferPoolStats
+    {
+        uint64_t acquires = 0;
+        uint64_t reuses = 0;         //< acquires served from the free list
+        uint32_t freeBuffers = 0;
+        uint64_t freeBytes = 0;
+        uint64_t highWaterBytes = 0; //< most bytes held at once, handed out + free
+    };
+
+    // CPU pixel memory aligned to a cache line (64 bytes), so decoders and the CPU backend
+    // can use aligned vector loads on every row start of a width * 4 pitch. Move only; the
+    // destructor hands the memory back to the pool it came from.
+    class GHIPixelBuffer
+    {
+    public:
+        static constexpr size_t Alignment = 64;
+
+        GHIPixelBuffer() = default;
+        GHIPixelBuffer(GHIPixelBuffer &&other) noexcept;
+        GHIPixelBuffer& operator=(GHIPixelBuffer &&other) noexcept;
+        GHIPixelBuffer(const GHIPixelBuffer&) = delete;
+        GHIPixelBuffer& operator=(const GHIPixelBuffer&) = delete;
+        ~GHIPixelBuffer()
+        {
+            Reset();
+        }
+
+        uint8_t* Data() const
+        {
+            return mData;
+        }
+        size_t Size() const
+        {
+            return mSize;
+        }
+        size_t Capacity() const
+        {
+            return mCapacity;
+        }
+        bool Empty() const
+        {
+            return mSize == 0;
+        }
+
+        //! Back to the pool, or freed when the buffer has none.
+        void Reset();
+
+    private:
+        friend class GHIPixelBufferPool;
+
+        uint8_t *mData = nullptr;
+        size_t mSize = 0;
+        size_t mCapacity = 0;
+        GHIPixelBufferPool *mPool = nullptr;
+    };
+
+    // Recycles pixel buffers between images. Acquire() returns the smallest free buffer
+    // that holds size bytes when it is not more than twice as large, released buffers
+    // beyond the free budget are freed, largest first. Thread safe, decode workers
+    // acquire while the filter thread releases.
+    class GHIPixelBufferPool
+    {
+    public:
+        explicit GHIPixelBufferPool(uint64_t freeBudget = 256ull << 20)
+            : mFreeBudget(freeBudget)
+        {
+        }
+        GHIPixelBufferPool(const GHIPixelBufferPool&) = delete;
+        GHIPixelBufferPool& operator=(const GHIPixelBufferPool&) = delete;
+        ~GHIPixelBufferPool();
+
+        //! The content of a recycled buffer is undefined.
+        GHIPixelBuffer Acquire(size_t size);
+
+        void SetFreeBudget(uint64_t bytes);
+
+        GHIPixelBufferPoolStats Stats() const;
+
+        //! Shared pool used when a caller does not own one.
+        static GHIPixelBufferPool& Global();
+
+        static uint8_t* Allocate(size_t bytes);
+        static void Free(uint8_t *data);
+
+    private:
+        friend class GHIPixelBuffer;
+
+        struct FreeBuffer
+        {
+            uint8_t *data;
+            size_t capacity;
+        };
+
+        void Release(uint8_t *data, size_t capacity);
+        void Trim();
+
+        mutable std::mutex mMutex;
+        std::vector<FreeBuffer> mFree;
+        uint64_t mFreeBudget;
+        uint64_t mHeldBytes = 0;
+        GHIPixelBufferPoolStats mStats;
+    };
+}
@@ -0,0 +1,122 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include "GHIProfiler.h"
+
+namespace GHI
+{
+    void GHIProfiler::AddSample(const std::string &scope, double ms, uint64_t pixels)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Series &s = mSeries[scope];
+        if (s.window.size() < WindowSize)
+        {
+            s.window.push_back(ms);
+        }
+        else
+        {
+            s.window[s.next] = ms;
+        }
+        s.next = (s.next + 1) % WindowSize;
+        s.count++;
+        s.pixels = pixels;
+        s.lastMs = ms;
+    }
+
+    // Nearest rank percentile of a sorted sample set.
+    static double Percentile(const std::vector<double> &sorted, double p)
+    {
+        size_t rank = size_t(std::ceil(p * sorted.size()));
+        rank = rank > 0 ? rank - 1 : 0;
+        return sorted[std::min(rank, sorted.size() - 1)];
+    }
+
+    std::vector<GHIProfileStats> GHIProfiler::Stats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::vector<GHIProfileStats> result;
+        for (auto it = mSeries.begin(); it != mSeries.end(); ++it)
+        {
+            const Series &s = it->second;
+            if (s.window.empty())
+                continue;
+
+            std::vector<double> sorted(s.window);
+            std::sort(sorted.begin(), sorted.end());
+            double total = 0.;
+            for (double ms : sorted)
+                total += ms;
+
+            GHIProfileStats stats;
+            stats.scope = it->first;
+            stats.samples = s.count;
+            stats.pixels = s.pixels;
+            stats.lastMs = s.lastMs;
+            stats.minMs = sorted.front();
+            stats.meanMs = total / sorted.size();
+            stats.p95Ms = Percentile(sorted, 0.95);
+            stats.p99Ms = Percentile(sorted, 0.99);
+            stats.megaPixelsPerSecond = stats.meanMs > 0. ? double(s.pixels) / (stats.meanMs * 1000.) : 0.;
+            result.push_back(stats);
+        }
+        return result;
+    }
+
+    void GHIProfiler::Reset()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSeries.clear();
+    }
+
+    bool GHIProfiler::ExportCSV(const std::string &filename) const
+    {
+        std::ofstream out(filename);
+        if (!out)
+            return false;
+        out << "scope,samples,pixels,last_ms,min_ms,mean_ms,p95_ms,p99_ms,mpix_per_s\n";
+        for (const GHIProfileStats &s : Stats())
+        {
+            out << '"' << s.scope << "\"," << s.samples << ',' << s.pixels << ',' << s.lastMs << ',' << s.minMs << ','
+                << s.meanMs << ',' << s.p95Ms << ',' << s.p99Ms << ',' << s.megaPixelsPerSecond << '\n';
+        }
+        return bool(out);
+    }
+
+    static std::string JSONEscape(const std::string &str)
+    {
+        std::string ret;
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+                ret += '\\';
+            ret += c;
+        }
+        return ret;
+    }
+
+    bool GHIProfiler::ExportJSON(const std::string &filename) const
+    {
+        std::ofstream out(filename);
+        if (!out)
+            return false;
+        std::vector<GHIProfileStats> stats = Stats();
+        out << "[\n";
+        for (size_t i = 0; i < stats.size(); ++i)
+        {
+            const GHIProfileStats &s = stats[i];
+            out << "  { \"scope\": \"" << JSONEscape(s.scope) << "\", \"samples\": " << s.samples << ", \"pixels\": " << s.pixels
+                << ", \"last_ms\": " << s.lastMs << ", \"min_ms\": " << s.minMs << ", \"mean_ms\": " << s.meanMs
+                << ", \"p95_ms\": " << s.p95Ms << ", \"p99_ms\": " << s.p99Ms << ", \"mpix_per_s\": " << s.megaPixelsPerSecond
+                << " }" << (i + 1 < stats.size() ? ",\n" : "\n");
+        }
+        out << "]\n";
+        return bool(out);
+    }
+}
@@ -0,0 +1,59 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace GHI
+{
+    // Aggregated timings of one profile scope, times in milliseconds.
+    struct GHIProfileStats
+    {
+        std::string scope;
+        uint64_t samples = 0;   // samples recorded since the last Reset()
+        uint64_t pixels = 0;    // work size of the last sample
+        double lastMs = 0.;
+        double minMs = 0.;
+        double meanMs = 0.;
+        double p95Ms = 0.;
+        double p99Ms = 0.;
+        double megaPixelsPerSecond = 0.; // pixels / meanMs
+    };
+
+    // Collects one sample per scope execution (GPU timestamps or wall clock, depending on the
+    // backend) and reduces them to min/mean/percentiles over a sliding window of samples.
+    class GHIProfiler
+    {
+    public:
+        static const uint32_t WindowSize = 1024;
+
+        void AddSample(const std::string &scope, double ms, uint64_t pixels);
+        std::vector<GHIProfileStats> Stats() const;
+        void Reset();
+
+        bool ExportCSV(const std::string &filename) const;
+        bool ExportJSON(const std::string &filename) const;
+
+    private:
+        struct Series
+        {
+            std::vector<double> window; // ring buffer of the last WindowSize samples
+            uint32_t next = 0;
+            uint64_t count = 0;
+            uint64_t pixels = 0;
+            double lastMs = 0.;
+        };
+
+        mutable std::mutex mMutex;
+        std::map<std::string, Series> mSeries;
+    };
+}
@@ -0,0 +1,177 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+#include "GHIResources.h"
+
+namespace GHI
+{
+    typedef uint64_t GHIReadbackTicket;
+
+    enum class EReadbackStatus
+    {
+        Pending, //< the copy is still in flight, poll again later
+        Ready,   //< data is filled in, the ticket is consumed
+        Invalid, //< unknown or already consumed ticket
+    };
+
+    // Pixels of a finished readback, rows tightly packed.
+    struct GHIReadbackData
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        EPixelFormat format = PixelFormat_R8G8B8A8_UNORM;
+        uint32_t rowPitch = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    // Size and format of a staging buffer, buffers are only reused for the same key.
+    struct GHIStagingKey
+    {
+        uint32_t width;
+        uint32_t height;
+        EPixelFormat format;
+
+        bool operator<(const GHIStagingKey &other) const
+        {
+            if (width != other.width)
+                return width < other.width;
+            if (height != other.height)
+                return height < other.height;
+            return format < other.format;
+        }
+    };
+
+    // Copies rows from a pitched staging buffer into GHIReadbackData.
+    inline void CopyReadbackRows(GHIReadbackData &data, const GHIStagingKey &key, const uint8_t *src, uint32_t srcPitch)
+    {
+        data.width = key.width;
+        data.height = key.height;
+        data.format = key.format;
+        data.rowPitch = key.width * BytesPerPixel(key.format);
+        data.pixels.resize(size_t(data.rowPitch) * key.height);
+        for (uint32_t y = 0; y < key.height; ++y)
+        {
+            memcpy(data.pixels.data() + size_t(y) * data.rowPitch, src + size_t(y) * srcPitch, data.rowPitch);
+        }
+    }
+
+    // Converts the pixels of a readback of any format to RGBA8 in place, for encoders.
+    inline void ConvertReadbackToRGBA8(GHIReadbackData &data)
+    {
+        if (data.format == PixelFormat_R8G8B8A8_UNORM)
+            return;
+        const uint32_t bytes = BytesPerPixel(data.format);
+        std::vector<uint8_t> rgba(size_t(data.width) * data.height * 4);
+        for (uint32_t y = 0; y < data.height; ++y)
+        {
+            const uint8_t *src = data.pixels.data() + size_t(y) * data.rowPitch;
+            uint8_t *dst = rgba.data() + size_t(y) * data.width * 4;
+            for (uint32_t x = 0; x < data.width; ++x)
+            {
+                float c[4];
+                DecodePixel(data.format, src + size_t(x) * bytes, c);
+                if (data.format == PixelFormat_R8_UNORM || data.format == PixelFormat_R16_FLOAT || data.format == PixelFormat_R32_FLOAT)
+                    c[1] = c[2] = c[0]; // single channel images are gray
+                EncodePixel(PixelFormat_R8G8B8A8_UNORM, c, dst + size_t(x) * 4);
+            }
+        }
+        data.pixels.swap(rgba);
+        data.format = PixelFormat_R8G8B8A8_UNORM;
+        data.rowPitch = data.width * 4;
+    }
+
+    // Book keeping shared by the backends : reusable staging buffers per size and the
+    // tickets in flight. TStaging is the backend staging object, it must be copyable.
+    template <class TStaging>
+    class TGHIStagingPool
+    {
+    public:
+        struct InFlight
+        {
+            GHIStagingKey key;
+            TStaging staging;
+        };
+
+        //! A free staging buffer of this size, false when the caller has to create one.
+        bool Acquire(const GHIStagingKey &key, TStaging &staging)
+        {
+            std::vector<TStaging> &free = mFree[key];
+            if (free.empty())
+            {
+                ++mCreated;
+                return false;
+            }
+            staging = free.back();
+            free.pop_back();
+            ++mReused;
+            return true;
+        }
+
+        GHIReadbackTicket Track(const GHIStagingKey &key, const TStaging &staging)
+        {
+            GHIReadbackTicket ticket = mNextTicket++;
+            mInFlight[ticket] = { key, staging };
+            return ticket;
+        }
+
+        InFlight* Find(GHIReadbackTicket ticket)
+        {
+            auto it = mInFlight.find(ticket);
+            return it == mInFlight.end() ? nullptr : &it->second;
+        }
+
+        //! The ticket is consumed, its staging buffer goes back to the free list.
+        void Complete(GHIReadbackTicket ticket)
+        {
+            auto it = mInFlight.find(ticket);
+            if (it != mInFlight.end())
+            {
+                mFree[it->second.key].push_back(it->second.staging);
+                mInFlight.erase(it);
+            }
+        }
+
+        //! destroy(staging) for every buffer, free or in flight.
+        template <class F>
+        void Clear(F destroy)
+        {
+            for (auto &it : mFree)
+                for (TStaging &staging : it.second)
+                    destroy(staging);
+            for (auto &it : mInFlight)
+                destroy(it.second.staging);
+            mFree.clear();
+            mInFlight.clear();
+        }
+
+        size_t InFlightCount() const
+        {
+            return mInFlight.size();
+        }
+        uint64_t Created() const
+        {
+            return mCreated;
+        }
+        uint64_t Reused() const
+        {
+            return mReused;
+        }
+
+    private:
+        std::map<GHIStagingKey, std::vector<TStaging>> mFree;
+        std::map<GHIReadbackTicket, InFlight> mInFlight;
+        GHIReadbackTicket mNextTicket = 1; //< 0 is never a valid ticket
+        uint64_t mCreated = 0;
+        uint64_t mReused = 0;
+    };
+}
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <list>
@@ -37,7 +39,204 @@ namespace GHI
 	enum EPixelFormat
 	{
 		PixelFormat_R8G8B8A8_UNORM,
+		PixelFormat_R32G32_FLOAT,
+		PixelFormat_R32_FLOAT,
+		PixelFormat_R8_UNORM,
+		PixelFormat_R16_FLOAT,
+		PixelFormat_R16G16B16A16_FLOAT,
+		PixelFormat_R32G32B32A32_UINT,
+		PixelFormat_R32G32B32A32_FLOAT,
+		PixelFormat_UNKNOWN, //< in a view param : the format the texture was created with
+	};
+
+	inline uint32_t BytesPerPixel(EPixelFormat format)
+	{
+		switch (format)
+		{
+		case PixelFormat_R8_UNORM:
+			return 1;
+		case PixelFormat_R16_FLOAT:
+			return 2;
+		case PixelFormat_R32G32_FLOAT:
+		case PixelFormat_R16G16B16A16_FLOAT:
+			return 8;
+		case PixelFormat_R32G32B32A32_UINT:
+		case PixelFormat_R32G32B32A32_FLOAT:
+			return 16;
+		case PixelFormat_R32_FLOAT:
+		case PixelFormat_R8G8B8A8_UNORM:
+		default:
+			return 4;
+		}
+	}
+
+	//! Size of mip level of a size texels wide side, never below one texel.
+	inline uint32_t MipSize(uint32_t size, uint32_t level)
+	{
+		size = level < 32 ? size >> level : 0;
+		return size ? size : 1;
+	}
+
+	//! Levels of the full chain of a width x height texture, down to 1 x 1.
+	inline uint32_t MaxMipLevels(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (uint32_t size = width > height ? width : height; size > 1; size >>= 1)
+			++levels;
+		return levels;
+	}
+
+	//! IEEE 754 binary16, rounded to nearest even like the GPU converts on a typed store.
+	inline uint16_t FloatToHalf(float value)
+	{
+		uint32_t f;
+		memcpy(&f, &value, 4);
+		const uint32_t sign = (f >> 16) & 0x8000;
+		f &= 0x7FFFFFFF;
+		if (f > 0x7F800000)
+			return uint16_t(sign | 0x7E00); // nan
+		if (f >= 0x47800000)
+			return uint16_t(sign | 0x7C00); // 65536 and up, inf
+		uint32_t h, rest, halfway;
+		if (f < 0x38800000)
+		{
+			// Below the smallest normal half, 2^-14 : a denormal of 2^-24 steps.
+			if (f < 0x33000000)
+				return uint16_t(sign);
+			const uint32_t shift = 126 - (f >> 23);
+			const uint32_t m = (f & 0x7FFFFF) | 0x800000;
+			h = m >> shift;
+			rest = m & ((1u << shift) - 1);
+			halfway = 1u << (shift - 1);
+		}
+		else
+		{
+			h = (f >> 13) - (112u << 10); // rebias the exponent from 127 to 15
+			rest = f & 0x1FFF;
+			halfway = 0x1000;
+		}
+		if (rest > halfway || (rest == halfway && (h & 1)))
+			++h; // a carry into the exponent is still the right encoding
+		return uint16_t(sign | h);
+	}
+
+	inline float HalfToFloat(uint16_t h)
+	{
+		const uint32_t sign = uint32_t(h & 0x8000) << 16;
+		const uint32_t exponent = (h >> 10) & 0x1F;
+		const uint32_t mantissa = h & 0x3FF;
+		float value;
+		if (exponent == 0)
+		{
+			value = float(mantissa) * (1.f / 16777216.f); // denormal, 2^-24 steps
+			uint32_t f;
+			memcpy(&f, &value, 4);
+			f |= sign;
+			memcpy(&value, &f, 4);
+			return value;
+		}
+		const uint32_t f = sign | (exponent == 0x1F ? 0x7F800000 | (mantissa << 13) : ((exponent + 112) << 23) | (mantissa << 13));
+		memcpy(&value, &f, 4);
+		return value;
+	}
+
+	//! Reads one texel the way Texture2D.Load() returns it : missing channels are 0, alpha 1.
+	inline void DecodePixel(EPixelFormat format, const uint8_t *texel, float rgba[4])
+	{
+		rgba[1] = rgba[2] = 0.f;
+		rgba[3] = 1.f;
+		switch (format)
+		{
+		case PixelFormat_R8_UNORM:
+			rgba[0] = texel[0] * (1.f / 255.f);
+			break;
+		case PixelFormat_R16_FLOAT:
+		{
+			uint16_t r;
+			memcpy(&r, texel, 2);
+			rgba[0] = HalfToFloat(r);
+			break;
+		}
+		case PixelFormat_R32_FLOAT:
+			memcpy(rgba, texel, 4);
+			break;
+		case PixelFormat_R32G32_FLOAT:
+			memcpy(rgba, texel, 8);
+			break;
+		case PixelFormat_R16G16B16A16_FLOAT:
+		{
+			uint16_t c[4];
+			memcpy(c, texel, 8);
+			for (int i = 0; i < 4; ++i)
+				rgba[i] = HalfToFloat(c[i]);
+			break;
+		}
+		case PixelFormat_R32G32B32A32_UINT:
+			memcpy(rgba, texel, 16); // the bits, as asfloat() of the uint4 Load() returns
+			break;
+		case PixelFormat_R32G32B32A32_FLOAT:
+			memcpy(rgba, texel, 16);
+			break;
+		case PixelFormat_R8G8B8A8_UNORM:
+		default:
+			for (int i = 0; i < 4; ++i)
+				rgba[i] = texel[i] * (1.f / 255.f);
+			break;
+		}
+	}
+
+	inline uint8_t FloatToUNorm8(float v)
+	{
+		v = v < 0.f ? 0.f : (v > 1.f ? 1.f : v);
+		return uint8_t(v * 255.f + 0.5f);
+	}
 
+	//! Writes one texel the way a RWTexture2D store converts it, extra channels are dropped.
+	inline void EncodePixel(EPixelFormat format, const float rgba[4], uint8_t *texel)
+	{
+		switch (format)
+		{
+		case PixelFormat_R8_UNORM:
+			texel[0] = FloatToUNorm8(rgba[0]);
+			break;
+		case PixelFormat_R16_FLOAT:
+		{
+			const uint16_t r = FloatToHalf(rgba[0]);
+			memcpy(texel, &r, 2);
+			break;
+		}
+		case PixelFormat_R32_FLOAT:
+			memcpy(texel, rgba, 4);
+			break;
+		case PixelFormat_R32G32_FLOAT:
+			memcpy(texel, rgba, 8);
+			break;
+		case PixelFormat_R16G16B16A16_FLOAT:
+		{
+			uint16_t c[4];
+			for (int i = 0; i < 4; ++i)
+				c[i] = FloatToHalf(rgba[i]);
+			memcpy(texel, c, 8);
+			break;
+		}
+		case PixelFormat_R32G32B32A32_UINT:
+		case PixelFormat_R32G32B32A32_FLOAT:
+			memcpy(texel, rgba, 16);
+			break;
+		case PixelFormat_R8G8B8A8_UNORM:
+		default:
+			for (int i = 0; i < 4; ++i)
+				texel[i] = FloatToUNorm8(rgba[i]);
+			break;
+		}
+	}
+
+	//! Same values as D3D11_BIND_FLAG
+	enum EBindFlag
+	{
+		BindFlag_SHADER_RESOURCE = 0x8L,
+		BindFlag_RENDER_TARGET = 0x20L,
+		BindFlag_UNORDERED_ACCESS = 0x80L,
 	};
 
 	enum EViewDemension
@@ -110,27 +309,39 @@ namespace GHI
 		TextureAddressMode AddressW = TextureAddressMode::WRAP;
 		float MipLODBias = 0;
 		uint32_t MaxAnisotropy = 0;
-		ComparisonFunc ComparisonFunc = ComparisonFunc::COMPARISON_NEVER;
+		GHI::ComparisonFunc ComparisonFunc = GHI::ComparisonFunc::COMPARISON_NEVER;
 		float BorderColor[4] = {0, 0, 0, 0};
 		float MinLOD = 0.f;
 		float MaxLOD = 1e20f;
 	};
 
+    // Views default to the whole texture in the format it was created with. Another
+    // Format must be one the texture's format can be viewed as.
     struct GHIUAVParam
     {
-        EPixelFormat Format = EPixelFormat::PixelFormat_R8G8B8A8_UNORM;
+        EPixelFormat Format = EPixelFormat::PixelFormat_UNKNOWN;
         EViewDemension ViewDimension = EViewDemension::EViewDimension_TEXTURE2D;
-		uint32_t MostDetailedMip = 0;
+		uint32_t MostDetailedMip = 0; //< the mip written
 		uint32_t MipLevels = 1;
+
+        bool operator==(const GHIUAVParam &other) const
+        {
+            return Format == other.Format && ViewDimension == other.ViewDimension && MostDetailedMip == other.MostDetailedMip;
+        }
     };
     class GHISRVParam
     {
 	public:
-        EPixelFormat Format = PixelFormat_R8G8B8A8_UNORM;
+        EPixelFormat Format = PixelFormat_UNKNOWN;
         EViewDemension ViewDimension = EViewDimension_TEXTURE2D;
 		uint32_t MostDetailedMip = 0;
-		uint32_t MipLevels = 1;
+		uint32_t MipLevels = uint32_t(-1); //< -1 : every mip from MostDetailedMip on
 
+        bool operator==(const GHISRVParam &other) const
+        {
+            return Format == other.Format && ViewDimension == other.ViewDimension
+                && MostDetailedMip == other.MostDetailedMip && MipLevels == other.MipLevels;
+        }
     };
     struct GHIRTVParam
     {
@@ -188,10 +399,81 @@ namespace GHI
 		uint32_t textureSizeInBytes = 0;
 		uint32_t width= 0;
 		uint32_t height = 0;
+		EPixelFormat format = PixelFormat_R8G8B8A8_UNORM;
+		uint32_t bindFlags = 0; //< EBindFlag bits the texture was created with
+		uint32_t mipLevels = 1;
 
 		IGHIResourceView *view = nullptr;
 	};
 
+    // Textures are only recycled or aliased for one another when all of these match.
+    struct GHITextureKey
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        EPixelFormat format = PixelFormat_R8G8B8A8_UNORM;
+        uint32_t bindFlags = 0;
+        uint32_t mipLevels = 1;
+
+        //! Key of an intermediate written like tex, bound as SRV and UAV.
+        static GHITextureKey Like(const GHITexture *tex)
+        {
+            GHITextureKey key;
+            key.width = tex->width;
+            key.height = tex->height;
+            key.format = tex->format;
+            key.bindFlags = tex->bindFlags | BindFlag_SHADER_RESOURCE | BindFlag_UNORDERED_ACCESS;
+            key.mipLevels = tex->mipLevels;
+            return key;
+        }
+
+        //! Key of a texture created from desc, BindFlags 0 stands for SRV + UAV like in CreateTexture.
+        static GHITextureKey FromDesc(const TextureDesc2D &desc)
+        {
+            GHITextureKey key;
+            key.width = desc.Width;
+            key.height = desc.Height;
+            key.format = desc.Format;
+            key.bindFlags = desc.BindFlags ? desc.BindFlags : (BindFlag_SHADER_RESOURCE | BindFlag_UNORDERED_ACCESS);
+            key.mipLevels = desc.MipLevels ? desc.MipLevels : 1;
+            return key;
+        }
+
+        TextureDesc2D Desc() const
+        {
+            TextureDesc2D desc;
+            desc.Width = width;
+            desc.Height = height;
+            desc.Format = format;
+            desc.BindFlags = bindFlags;
+            desc.MipLevels = mipLevels;
+            return desc;
+        }
+
+        uint64_t Bytes() const
+        {
+            uint64_t bytes = 0;
+            for (uint32_t level = 0; level < mipLevels; ++level)
+                bytes += uint64_t(MipSize(width, level)) * MipSize(height, level) * BytesPerPixel(format);
+            return bytes;
+        }
+
+        bool operator==(const GHITextureKey &other) const
+        {
+            return width == other.width && height == other.height && format == other.format && bindFlags == other.bindFlags
+                && mipLevels == other.mipLevels;
+        }
+
+        struct Hasher
+        {
+            size_t operator()(const GHITextureKey &key) const
+            {
+                uint64_t h = (uint64_t(key.width) << 32) ^ (uint64_t(key.height) << 8) ^ (uint64_t(key.format) << 4) ^ key.bindFlags ^ (uint64_t(key.mipLevels) << 56);
+                return size_t(h * 0x9E3779B97F4A7C15ull);
+            }
+        };
+    };
+
 	class GHIBuffer :public GHIResource
 	{
 	public:
@@ -212,14 +494,146 @@ namespace GHI
         ShaderStageNum
     };
 
+    struct ShaderVariableInfo
+    {
+        std::string name;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    struct ShaderConstantBufferInfo
+    {
+        std::string name;
+        uint32_t size = 0;
+        std::vector<ShaderVariableInfo> variables;
+    };
+
+    struct ShaderBindingInfo
+    {
+        std::string name;
+        uint32_t type = 0;      //< D3D_SHADER_INPUT_TYPE
+        uint32_t bindPoint = 0;
+        uint32_t bindCount = 0;
+    };
+
+    // What the backend reflected from the bytecode, cached on disk next to it.
+    struct ShaderReflectionInfo
+    {
+        uint32_t threadGroupSize[3] = { 0, 0, 0 };
+        std::vector<ShaderBindingInfo> bindings;
+        std::vector<ShaderConstantBufferInfo> constantBuffers;
+    };
+
+    struct ShaderDefine
+    {
+        std::string name;
+        std::string value;
+
+        bool operator==(const ShaderDefine &other) const
+        {
+            return name == other.name && value == other.value;
+        }
+    };
+
 	struct ShaderInfo
 	{
         EShaderStage shaderstage;
         std::string shaderfile;
         std::string entrypoint;
+        std::vector<ShaderDefine> defines;
 		std::string bytecode;
+        ShaderReflectionInfo reflection;
 	};
 
+    // Identifies one shader permutation : file, entry point, stage and preprocessor defines.
+    // Defines are kept sorted by name so the order they are added in does not matter, and
+    // the hash is computed when the key changes, not on every lookup.
+    class ShaderKey
+    {
+    public:
+        explicit ShaderKey(const std::string &file, const std::string &entrypoint = "CSMain", EShaderStage stage = EShaderStage::CS)
+            : mFile(file)
+            , mEntrypoint(entrypoint)
+            , mStage(stage)
+        {
+            Rehash();
+        }
+
+        explicit ShaderKey(const ShaderInfo &info)
+            : ShaderKey(info.shaderfile, info.entrypoint, info.shaderstage)
+        {
+            for (const ShaderDefine &define : info.defines)
+                Define(define.name, define.value);
+        }
+
+        //! Adds or replaces a define, returns *this so permutations can be chained.
+        ShaderKey& Define(const std::string &name, const std::string &value = "1")
+        {
+            auto it = mDefines.begin();
+            while (it != mDefines.end() && it->name < name)
+                ++it;
+            if (it != mDefines.end() && it->name == name)
+                it->value = value;
+            else
+                mDefines.insert(it, ShaderDefine{ name, value });
+            Rehash();
+            return *this;
+        }
+
+        const std::string& File() const { return mFile; }
+        const std::string& Entrypoint() const { return mEntrypoint; }
+        EShaderStage Stage() const { return mStage; }
+        const std::vector<ShaderDefine>& Defines() const { return mDefines; }
+        uint64_t Hash() const { return mHash; }
+
+        bool operator==(const ShaderKey &other) const
+        {
+            return mHash == other.mHash && mStage == other.mStage && mFile == other.mFile
+                && mEntrypoint == other.mEntrypoint && mDefines == other.mDefines;
+        }
+
+        struct Hasher
+        {
+            size_t operator()(const ShaderKey &key) const
+            {
+                return size_t(key.mHash);
+            }
+        };
+
+    private:
+        static void Mix(uint64_t &h, const std::string &s)
+        {
+            for (unsigned char c : s)
+            {
+                h ^= c;
+                h *= 1099511628211ull;
+            }
+            h ^= 0xFF; // separator, "ab"+"c" and "a"+"bc" differ
+            h *= 1099511628211ull;
+        }
+
+        void Rehash()
+        {
+            uint64_t h = 14695981039346656037ull;
+            Mix(h, mFile);
+            Mix(h, mEntrypoint);
+            h ^= uint64_t(mStage);
+            h *= 1099511628211ull;
+            for (const ShaderDefine &define : mDefines)
+            {
+                Mix(h, define.name);
+                Mix(h, define.value);
+            }
+            mHash = h;
+        }
+
+        std::string mFile;
+        std::string mEntrypoint;
+        EShaderStage mStage;
+        std::vector<ShaderDefine> mDefines;
+        uint64_t mHash = 0;
+    };
+
 	class GHIShader :public GHIResource
 	{
     public:
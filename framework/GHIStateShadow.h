@@ -0,0 +1,132 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include "GHIResources.h"
+
+namespace GHI
+{
+    enum class EBindKind
+    {
+        Shader,
+        SRV,
+        UAV,
+        ConstBuffer,
+        Sampler,
+        Count
+    };
+
+    struct GHIStateCounters
+    {
+        uint64_t issued = 0;  //< binds that reached the API
+        uint64_t skipped = 0; //< binds elided because the slot already held the object
+    };
+
+    // Shadow copy of what is bound per stage, kind and slot, so the command context only
+    // talks to the API when a slot changes. object is the API object the slot holds (view,
+    // shader, buffer ..), resource the GHI resource it belongs to, used to follow the
+    // SRV / UAV hazard rules of the API. Slots past MaxSlots are never shadowed.
+    class GHIStateShadow
+    {
+    public:
+        static const int MaxSlots = 16;
+
+        //! true when the bind has to be issued, the slot then records object.
+        bool Bind(EShaderStage stage, EBindKind kind, int slot, const void *object, const void *resource = nullptr)
+        {
+            Slot *s = Find(stage, kind, slot);
+            if (s && s->object == object && object != nullptr)
+            {
+                ++mCounters.skipped;
+                return false;
+            }
+            if (s)
+            {
+                s->object = object;
+                s->resource = resource;
+            }
+            ++mCounters.issued;
+            return true;
+        }
+
+        //! First slot from first on of this stage and kind holding resource, -1 if it is not bound.
+        int FindResource(EShaderStage stage, EBindKind kind, const void *resource, int first = 0) const
+        {
+            if (!resource || stage >= ShaderStageNum)
+                return -1;
+            for (int slot = first < 0 ? 0 : first; slot < MaxSlots; ++slot)
+            {
+                if (mSlots[stage][int(kind)][slot].resource == resource)
+                    return slot;
+            }
+            return -1;
+        }
+
+        //! Object a slot holds, nullptr when it is empty or not shadowed.
+        const void* Object(EShaderStage stage, EBindKind kind, int slot) const
+        {
+            if (stage >= ShaderStageNum || slot < 0 || slot >= MaxSlots)
+                return nullptr;
+            return mSlots[stage][int(kind)][slot].object;
+        }
+
+        //! Records that the API dropped the binding by itself (hazard auto unbind).
+        void Forget(EShaderStage stage, EBindKind kind, int slot)
+        {
+            Slot *s = Find(stage, kind, slot);
+            if (s)
+                *s = Slot();
+        }
+
+        //! Forgets resource in every stage for this kind.
+        void ForgetResource(EBindKind kind, const void *resource)
+        {
+            for (int stage = 0; stage < ShaderStageNum; ++stage)
+            {
+                for (int slot = -1; (slot = FindResource(EShaderStage(stage), kind, resource)) >= 0;)
+                    Forget(EShaderStage(stage), kind, slot);
+            }
+        }
+
+        //! Call when something outside the command context may have changed the bindings.
+        void Invalidate()
+        {
+            for (auto &stage : mSlots)
+                for (auto &kind : stage)
+                    for (Slot &slot : kind)
+                        slot = Slot();
+        }
+
+        const GHIStateCounters& Counters() const
+        {
+            return mCounters;
+        }
+        void ResetCounters()
+        {
+            mCounters = GHIStateCounters();
+        }
+
+    private:
+        struct Slot
+        {
+            const void *object = nullptr;
+            const void *resource = nullptr;
+        };
+
+        Slot* Find(EShaderStage stage, EBindKind kind, int slot)
+        {
+            if (stage >= ShaderStageNum || slot < 0 || slot >= MaxSlots)
+                return nullptr;
+            return &mSlots[stage][int(kind)][slot];
+        }
+
+        Slot mSlots[ShaderStageNum][int(EBindKind::Count)][MaxSlots];
+        GHIStateCounters mCounters;
+    };
+}
@@ -0,0 +1,107 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <algorithm>
+#include "GHITexturePool.h"
+#include "GHICommandContext.h"
+
+namespace GHI
+{
+    GHITexture* GHITexturePool::Acquire(const TextureDesc2D &desc)
+    {
+        const GHITextureKey key = GHITextureKey::FromDesc(desc);
+        ++mStats.acquires;
+
+        // Most recently released first, it is the most likely to still be resident.
+        for (auto it = mFree.rbegin(); it != mFree.rend(); ++it)
+        {
+            if (it->key == key)
+            {
+                GHITexture *texture = it->texture;
+                mFree.erase(std::next(it).base());
+                --mStats.freeTextures;
+                mStats.freeBytes -= key.Bytes();
+                ++mStats.reuses;
+                Track(texture, key);
+                return texture;
+            }
+        }
+
+        TextureDesc2D create = desc;
+        create.BindFlags = key.bindFlags;
+        GHITexture *texture = mOwner->CreateTexture(create);
+        if (texture)
+            Track(texture, key);
+        return texture;
+    }
+
+    GHITexture* GHITexturePool::AcquireLike(const GHITexture *like)
+    {
+        return like ? Acquire(GHITextureKey::Like(like).Desc()) : nullptr;
+    }
+
+    GHITexture* GHITexturePool::Adopt(GHITexture *texture)
+    {
+        if (texture && mLive.find(texture) == mLive.end())
+        {
+            GHITextureKey key;
+            key.width = texture->width;
+            key.height = texture->height;
+            key.format = texture->format;
+            key.bindFlags = texture->bindFlags;
+            key.mipLevels = texture->mipLevels;
+            Track(texture, key);
+        }
+        return texture;
+    }
+
+    void GHITexturePool::Track(GHITexture *texture, const GHITextureKey &key)
+    {
+        Entry &entry = mLive[texture];
+        entry.key = key;
+        entry.refs = 1;
+        ++mStats.liveTextures;
+        mStats.liveBytes += key.Bytes();
+        mStats.highWaterBytes = std::max(mStats.highWaterBytes, mStats.liveBytes + mStats.freeBytes);
+    }
+
+    void GHITexturePool::AddRef(GHITexture *texture)
+    {
+        auto it = mLive.find(texture);
+        if (it != mLive.end())
+            ++it->second.refs;
+    }
+
+    void GHITexturePool::Release(GHITexture *texture)
+    {
+        auto it = mLive.find(texture);
+        if (it == mLive.end() || --it->second.refs > 0)
+            return;
+
+        const GHITextureKey key = it->second.key;
+        mLive.erase(it);
+        --mStats.liveTextures;
+        mStats.liveBytes -= key.Bytes();
+        mFree.push_back({ key, texture });
+        ++mStats.freeTextures;
+        mStats.freeBytes += key.Bytes();
+        Trim(mFreeBudget);
+    }
+
+    void GHITexturePool::Trim(uint64_t bytes)
+    {
+        while (!mFree.empty() && mStats.freeBytes > bytes)
+        {
+            Free oldest = mFree.front();
+            mFree.pop_front();
+            --mStats.freeTextures;
+            mStats.freeBytes -= oldest.key.Bytes();
+            ++mStats.destroyed;
+            mOwner->DestroyTexture(oldest.texture);
+        }
+    }
+}
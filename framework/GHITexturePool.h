@@ -0,0 +1,95 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include "GHIResources.h"
+
+namespace GHI
+{
+    class IGHIComputeCommandCotext;
+
+    struct GHITexturePoolStats
+    {
+        uint32_t liveTextures = 0;   //< referenced by someone
+        uint32_t freeTextures = 0;   //< released, kept for recycling
+        uint64_t liveBytes = 0;
+        uint64_t freeBytes = 0;
+        uint64_t highWaterBytes = 0; //< most live + free bytes held at once
+        uint64_t acquires = 0;
+        uint64_t reuses = 0;         //< acquires served from the free list
+        uint64_t destroyed = 0;      //< textures handed back to the API
+    };
+
+    // Reference counted textures of the command context. Acquire() returns a released
+    // texture of the same GHITextureKey when there is one, the last Release() puts it on
+    // the free list. The free list is bounded by a byte budget, the oldest free textures
+    // are destroyed first, so switching between images of any size keeps the memory flat.
+    // Textures created outside the pool (loaded from files) join it through Adopt().
+    class GHITexturePool
+    {
+    public:
+        explicit GHITexturePool(IGHIComputeCommandCotext *owner)
+            : mOwner(owner)
+        {
+        }
+        GHITexturePool(const GHITexturePool&) = delete;
+        GHITexturePool& operator=(const GHITexturePool&) = delete;
+        ~GHITexturePool()
+        {
+            Trim(0);
+        }
+
+        //! One reference, the content of a recycled texture is undefined.
+        GHITexture* Acquire(const TextureDesc2D &desc);
+        //! Same size and format as like, bound as SRV and UAV, see CreateTextureByAnother.
+        GHITexture* AcquireLike(const GHITexture *like);
+        //! Counts a texture the pool did not create, nullptr passes through.
+        GHITexture* Adopt(GHITexture *texture);
+
+        void AddRef(GHITexture *texture);
+        //! Drops one reference. Unknown textures and nullptr are ignored.
+        void Release(GHITexture *texture);
+
+        //! Bytes of released textures kept for recycling.
+        void SetFreeBudget(uint64_t bytes)
+        {
+            mFreeBudget = bytes;
+            Trim(mFreeBudget);
+        }
+        //! Destroys free textures, oldest first, until at most bytes are kept.
+        void Trim(uint64_t bytes = 0);
+
+        const GHITexturePoolStats& Stats() const
+        {
+            return mStats;
+        }
+
+    private:
+        struct Entry
+        {
+            GHITextureKey key;
+            uint32_t refs = 0;
+        };
+        struct Free
+        {
+            GHITextureKey key;
+            GHITexture *texture;
+        };
+
+        void Track(GHITexture *texture, const GHITextureKey &key);
+
+        IGHIComputeCommandCotext *mOwner;
+        std::unordered_map<GHITexture*, Entry> mLive;
+        std::deque<Free> mFree; //< oldest release first
+        uint64_t mFreeBudget = 64ull << 20;
+        GHITexturePoolStats mStats;
+    };
+}
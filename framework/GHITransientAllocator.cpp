@@ -0,0 +1,107 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <algorithm>
+#include <map>
+#include "GHITransientAllocator.h"
+#include "GHICommandContext.h"
+
+namespace GHI
+{
+    void GHITransientAllocator::Reset()
+    {
+        mRequests.clear();
+    }
+
+    int GHITransientAllocator::Declare(const GHITextureKey &key, int firstStep, int lastStep)
+    {
+        Request request;
+        request.key = key;
+        request.first = firstStep;
+        request.last = std::max(firstStep, lastStep);
+        mRequests.push_back(request);
+        return int(mRequests.size()) - 1;
+    }
+
+    void GHITransientAllocator::Compile(IGHIComputeCommandCotext *commandContext)
+    {
+        // Greedy interval colouring in order of first use : a request takes the slot of
+        // its key that became free the earliest, which is optimal for interval graphs.
+        struct Slot
+        {
+            GHITextureKey key;
+            int busyUntil;
+        };
+        std::vector<int> byFirst(mRequests.size());
+        for (size_t i = 0; i < byFirst.size(); ++i)
+            byFirst[i] = int(i);
+        std::stable_sort(byFirst.begin(), byFirst.end(), [this](int a, int b)
+        {
+            return mRequests[a].first < mRequests[b].first;
+        });
+
+        std::vector<Slot> slots;
+        std::vector<int> slotOf(mRequests.size(), -1);
+        for (int r : byFirst)
+        {
+            const Request &request = mRequests[r];
+            int best = -1;
+            for (size_t s = 0; s < slots.size(); ++s)
+            {
+                if (slots[s].key == request.key && slots[s].busyUntil < request.first &&
+                    (best < 0 || slots[s].busyUntil < slots[best].busyUntil))
+                    best = int(s);
+            }
+            if (best < 0)
+            {
+                best = int(slots.size());
+                slots.push_back({ request.key, 0 });
+            }
+            slots[best].busyUntil = request.last;
+            slotOf[r] = best;
+        }
+
+        // Hand the previous plan back first, the context's pool gives the same textures
+        // to slots of the same key and destroys what is left over its budget.
+        ReleaseAll();
+        mContext = commandContext;
+        for (const Slot &slot : slots)
+            mTextures.push_back(commandContext->TexturePool().Acquire(slot.key.Desc()));
+
+        mStats = GHITransientStats();
+        mStats.requests = uint32_t(mRequests.size());
+        mStats.textures = uint32_t(slots.size());
+        std::map<int, int64_t> deltas; //< bytes becoming live / dead per step
+        for (size_t r = 0; r < mRequests.size(); ++r)
+        {
+            Request &request = mRequests[r];
+            request.texture = mTextures[slotOf[r]];
+            mStats.naiveBytes += request.key.Bytes();
+            deltas[request.first] += int64_t(request.key.Bytes());
+            deltas[request.last + 1] -= int64_t(request.key.Bytes());
+        }
+        for (const Slot &slot : slots)
+            mStats.pooledBytes += slot.key.Bytes();
+        int64_t live = 0;
+        for (const auto &delta : deltas)
+        {
+            live += delta.second;
+            mStats.peakLiveBytes = std::max(mStats.peakLiveBytes, uint64_t(live));
+        }
+    }
+
+    void GHITransientAllocator::ReleaseAll()
+    {
+        for (GHITexture *texture : mTextures)
+            mContext->TexturePool().Release(texture);
+        mTextures.clear();
+        for (Request &request : mRequests)
+            request.texture = nullptr;
+        mStats.textures = 0;
+        mStats.pooledBytes = 0;
+    }
+}
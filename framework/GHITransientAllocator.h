@@ -0,0 +1,81 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "GHIResources.h"
+
+namespace GHI
+{
+    class IGHIComputeCommandCotext;
+
+    struct GHITransientStats
+    {
+        uint32_t requests = 0;     //< intermediates declared for the plan
+        uint32_t textures = 0;     //< textures they were aliased into
+        uint64_t naiveBytes = 0;   //< one texture per intermediate
+        uint64_t pooledBytes = 0;  //< what the aliased plan allocates
+        uint64_t peakLiveBytes = 0; //< most bytes alive at one step, the bound any plan has
+    };
+
+    // Lifetime based aliasing of the intermediates of a pass sequence. Declare() every
+    // texture with the step that writes it and the last step that reads it, Compile()
+    // then maps them onto textures of the context's GHITexturePool : two intermediates
+    // of the same GHITextureKey share a texture when their lifetimes do not overlap. A
+    // texture read and written by the same step never aliases, so a pass never reads its
+    // own output. Recompiling the same plan gets the same textures back from the pool.
+    class GHITransientAllocator
+    {
+    public:
+        GHITransientAllocator() = default;
+        GHITransientAllocator(const GHITransientAllocator&) = delete;
+        GHITransientAllocator& operator=(const GHITransientAllocator&) = delete;
+        ~GHITransientAllocator()
+        {
+            ReleaseAll();
+        }
+
+        //! Forgets the declarations, the textures stay until the next Compile().
+        void Reset();
+
+        //! Returns the handle of the intermediate, valid after Compile().
+        int Declare(const GHITextureKey &key, int firstStep, int lastStep);
+
+        //! Assigns a texture to every declaration, the textures of the previous plan go
+        //! back to the pool.
+        void Compile(IGHIComputeCommandCotext *commandContext);
+
+        GHITexture* Get(int handle) const
+        {
+            return handle >= 0 && handle < int(mRequests.size()) ? mRequests[handle].texture : nullptr;
+        }
+
+        const GHITransientStats& Stats() const
+        {
+            return mStats;
+        }
+
+        //! Returns every texture to the pool.
+        void ReleaseAll();
+
+    private:
+        struct Request
+        {
+            GHITextureKey key;
+            int first = 0;
+            int last = 0;
+            GHITexture *texture = nullptr;
+        };
+
+        std::vector<Request> mRequests;
+        std::vector<GHITexture*> mTextures; //< one per slot of the plan
+        IGHIComputeCommandCotext *mContext = nullptr;
+        GHITransientStats mStats;
+    };
+}
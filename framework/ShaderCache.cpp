@@ -8,7 +8,13 @@
 #pragma once
 
 #include "ShaderCache.h"
+#if defined(_WIN32)
 #include "Utility.h"
+#else
+// Utility.h is the Win32 side of the framework, its logging is debug output only.
+#define DLOG(fmt, ...)
+#define ELOG(fmt, ...)
+#endif
 
 namespace GHI
 {
@@ -17,41 +23,57 @@ namespace GHI
 	{
 		for (auto it = files.begin(); it != files.end(); ++it)
 		{
-			std::string filename = *it;
-			GHIShader *shader = commandContext->CreateShader(filename);
-            mComputeShaders.push_back(shader);
+			GetOrCreate(ShaderKey(*it));
 		}
-		mCurIt = mComputeShaders.begin();
+		std::unique_lock<std::shared_mutex> lock(mMutex);
+		mCurIndex = 0;
 	}
 
 	void ShaderCache::buildCache()
 	{
-		for (auto it = mShaderFiles.begin(); it != mShaderFiles.end(); ++it)
+		InitComputeCache(mShaderFiles);
+	}
+
+	GHIShader* ShaderCache::Insert(const ShaderKey &key, GHIShader *shader)
+	{
+		if (!shader)
+			return nullptr;
+
+		std::unique_lock<std::shared_mutex> lock(mMutex);
+		auto ret = mShaders.emplace(key, shader);
+		if (!ret.second)
 		{
-			std::string filename = *it;
-			GHIShader *shader = commandContext->CreateShader(filename);
-#if 0
-			auto ret = mShaders.insert( std::pair<std::string, GHIShader*>(filename, shader) );
-			if (ret.second == false)
+			if (ret.first->second != shader)
 			{
-				DLOG("- Shader already cached:", filename.c_str());
+				// Lost a race with another thread creating the same permutation, keep theirs.
+				DLOG("- Shader already cached: %s", key.File().c_str());
+				shader->release();
+				GHIResource::list.remove(shader);
+				delete shader;
 			}
-#endif
-            mComputeShaders.push_back(shader);
+			return ret.first->second;
 		}
-		mCurIt = mComputeShaders.begin();
+		if (key.Stage() == EShaderStage::CS)
+			mComputeShaders.push_back(shader);
+		return shader;
 	}
 
-	void ShaderCache::AddGraphicShader(std::string name, GHIShader* shader)
+	GHIShader* ShaderCache::GetOrCreate(const ShaderKey &key)
 	{
-		mShaders[name] = shader;
+		GHIShader *shader = Find(key);
+		if (shader)
+			return shader;
+
+		// Created outside the lock, compiling may take long and other lookups must not wait.
+		return Insert(key, commandContext->CreateComputeShader(key));
 	}
 
 	void ShaderCache::EnumCache()
 	{
+		std::shared_lock<std::shared_mutex> lock(mMutex);
 		for (auto it = mShaders.begin(); it != mShaders.end(); ++it)
 		{
-			DLOG("%s --> %s",it->first.c_str(), it->second->str().c_str());
+			DLOG("%s --> %s", it->first.Entrypoint().c_str(), it->second->str().c_str());
 		}
 
 		for (auto it = mComputeShaders.begin(); it != mComputeShaders.end(); ++it)
@@ -61,4 +83,4 @@ namespace GHI
 	}
 
 
-}
\ No newline at end of file
+}
@@ -10,19 +10,24 @@
 #include "GHIResources.h"
 #include "GHICommandContext.h"
 
+#include <shared_mutex>
 #include <unordered_map>
 
 namespace GHI
 {
 
+    // Registry of every shader permutation, keyed by ShaderKey (file, entry point, stage and
+    // defines). Lookups take a shared lock and hash the key once, so they stay O(1) with
+    // hundreds of permutations; insertion is safe from several threads.
     class ShaderCache
 	{
         IGHIComputeCommandCotext *commandContext = nullptr;
 
 		std::vector<std::string> mShaderFiles;
-        std::unordered_map<std::string, GHIShader*> mShaders;
-        std::vector< GHIShader*> mComputeShaders;
-        std::vector< GHIShader*>::iterator  mCurIt;
+        mutable std::shared_mutex mMutex;
+        std::unordered_map<ShaderKey, GHIShader*, ShaderKey::Hasher> mShaders;
+        std::vector< GHIShader*> mComputeShaders; //< in insertion order, for Next() / Prev()
+        size_t mCurIndex = 0;
 
     public:
 
@@ -45,52 +50,58 @@ namespace GHI
 
 		GHIShader* Current() const
 		{
-			return *mCurIt;
+            std::shared_lock<std::shared_mutex> lock(mMutex);
+			return mComputeShaders.empty() ? nullptr : mComputeShaders[mCurIndex];
 		}
 
 		void Next()
 		{
-			mCurIt + 1 == mComputeShaders.end() ?  mCurIt = mComputeShaders.begin() : ++mCurIt;
+            std::unique_lock<std::shared_mutex> lock(mMutex);
+            if (!mComputeShaders.empty())
+                mCurIndex = (mCurIndex + 1) % mComputeShaders.size();
 		}
 
 		void Prev()
 		{
-			mCurIt == mComputeShaders.begin() ?  mCurIt = mComputeShaders.end() - 1 : --mCurIt;
+            std::unique_lock<std::shared_mutex> lock(mMutex);
+            if (!mComputeShaders.empty())
+                mCurIndex = (mCurIndex + mComputeShaders.size() - 1) % mComputeShaders.size();
 		}
 
 		void InitComputeCache(const std::vector<std::string> &files);
-		void AddGraphicShader(std::string name, GHIShader* shader);
         void EnumCache();
 
-		GHIShader* operator[](std::string name)
-		{
-			return mShaders[name];
-		}
+        //! nullptr when the permutation was never created.
+        GHIShader* Find(const ShaderKey &key) const
+        {
+            std::shared_lock<std::shared_mutex> lock(mMutex);
+            auto it = mShaders.find(key);
+            return it == mShaders.end() ? nullptr : it->second;
+        }
 
-		GHIShader* GetComputerShader(std::string file)
-		{
+        //! Registers shader under key. When another thread registered the same key first,
+        //! shader is released and the registered one is returned.
+        GHIShader* Insert(const ShaderKey &key, GHIShader *shader);
 
-			for (auto it = mComputeShaders.begin(); it != mComputeShaders.end(); ++it)
-			{
-			
-				if ((*it)->info.shaderfile == file)
-					return *it;
-			}
-			return nullptr;
-		}
+        //! Find(), or create the compute shader and Insert() it.
+        GHIShader* GetOrCreate(const ShaderKey &key);
 
-		void AddComputeShader(GHIShader* shader)
-		{
-			mComputeShaders.push_back(shader);
-		}
+        size_t Size() const
+        {
+            std::shared_lock<std::shared_mutex> lock(mMutex);
+            return mShaders.size();
+        }
 
     private:
         void buildCache();
 
         void release(void)
         {
+            std::unique_lock<std::shared_mutex> lock(mMutex);
             mShaders.clear();
+            mComputeShaders.clear();
+            mCurIndex = 0;
         }
     };
 
-}
\ No newline at end of file
+}
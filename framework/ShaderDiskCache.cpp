@@ -0,0 +1,329 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include "ShaderDiskCache.h"
+
+namespace fs = std::filesystem;
+
+namespace GHI
+{
+    // Bump when the file layout or the key changes, old files then simply miss.
+    static const uint32_t CacheMagic = 0x31435347; // "GSC1"
+    static const uint32_t CacheVersion = 1;
+
+    static void Hash(uint64_t &h, const void *data, size_t size)
+    {
+        const uint8_t *p = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    }
+
+    static void Hash(uint64_t &h, const std::string &s)
+    {
+        uint64_t size = s.size();
+        Hash(h, &size, sizeof(size));
+        Hash(h, s.data(), s.size());
+    }
+
+    static bool ReadText(const fs::path &path, std::string &text)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        std::stringstream ss;
+        ss << file.rdbuf();
+        text = ss.str();
+        return true;
+    }
+
+    // Hashes the file and, depth first, every file it includes with #include "name".
+    static bool HashSource(uint64_t &h, const fs::path &path, std::set<fs::path> &visited)
+    {
+        std::error_code ec;
+        fs::path canonical = fs::weakly_canonical(path, ec);
+        if (ec)
+            canonical = path;
+        if (!visited.insert(canonical).second)
+            return true;
+
+        std::string text;
+        if (!ReadText(path, text))
+            return false;
+        Hash(h, path.filename().string());
+        Hash(h, text);
+
+        std::istringstream lines(text);
+        std::string line;
+        while (std::getline(lines, line))
+        {
+            size_t pos = line.find_first_not_of(" \t");
+            if (pos == std::string::npos || line.compare(pos, 8, "#include") != 0)
+                continue;
+            size_t open = line.find('"', pos + 8);
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos)
+                continue; // <system> includes are not resolved by the standard handler either
+            fs::path include = path.parent_path() / line.substr(open + 1, close - open - 1);
+            if (!HashSource(h, include, visited))
+                Hash(h, "missing:" + include.string()); // still deterministic, the compiler reports it
+        }
+        return true;
+    }
+
+    class CacheWriter
+    {
+    public:
+        std::string data;
+
+        void U32(uint32_t v)
+        {
+            data.append(reinterpret_cast<const char*>(&v), sizeof(v));
+        }
+        void U64(uint64_t v)
+        {
+            data.append(reinterpret_cast<const char*>(&v), sizeof(v));
+        }
+        void Str(const std::string &s)
+        {
+            U32(uint32_t(s.size()));
+            data += s;
+        }
+    };
+
+    class CacheReader
+    {
+        const std::string &mData;
+        size_t mPos = 0;
+        bool mOk = true;
+
+    public:
+        explicit CacheReader(const std::string &data)
+            : mData(data)
+        {
+        }
+
+        bool Ok() const
+        {
+            return mOk && mPos == mData.size();
+        }
+        uint32_t U32()
+        {
+            uint32_t v = 0;
+            Bytes(&v, sizeof(v));
+            return v;
+        }
+        uint64_t U64()
+        {
+            uint64_t v = 0;
+            Bytes(&v, sizeof(v));
+            return v;
+        }
+        std::string Str()
+        {
+            uint32_t size = U32();
+            if (!mOk || size > mData.size() - mPos)
+            {
+                mOk = false;
+                return std::string();
+            }
+            std::string s = mData.substr(mPos, size);
+            mPos += size;
+            return s;
+        }
+        //! Element count of a list, rejects counts the remaining bytes can not hold.
+        uint32_t Count()
+        {
+            uint32_t n = U32();
+            if (n > mData.size() - mPos)
+                mOk = false;
+            return mOk ? n : 0;
+        }
+
+    private:
+        void Bytes(void *dst, size_t size)
+        {
+            if (!mOk || size > mData.size() - mPos)
+            {
+                mOk = false;
+                return;
+            }
+            memcpy(dst, mData.data() + mPos, size);
+            mPos += size;
+        }
+    };
+
+    ShaderDiskCache::ShaderDiskCache(const std::string &directory)
+        : mDirectory(directory)
+    {
+    }
+
+    ShaderDiskCache& ShaderDiskCache::Global()
+    {
+        static ShaderDiskCache cache;
+        return cache;
+    }
+
+    std::string ShaderDiskCache::Path(uint64_t key) const
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.cso", (unsigned long long)key);
+        return (fs::path(mDirectory) / name).string();
+    }
+
+    uint64_t ShaderDiskCache::Key(const ShaderKey &shader, const std::string &target, uint32_t flags) const
+    {
+        uint64_t h = 14695981039346656037ull;
+        Hash(h, &CacheVersion, sizeof(CacheVersion));
+        std::set<fs::path> visited;
+        if (!HashSource(h, fs::path(shader.File()), visited))
+            return 0;
+        Hash(h, shader.Entrypoint());
+        for (const ShaderDefine &define : shader.Defines())
+        {
+            Hash(h, define.name);
+            Hash(h, define.value);
+        }
+        Hash(h, target);
+        Hash(h, &flags, sizeof(flags));
+        return h != 0 ? h : 1;
+    }
+
+    bool ShaderDiskCache::Load(uint64_t key, ShaderInfo &info)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::string data;
+        if (!mEnabled || key == 0 || !ReadText(Path(key), data))
+        {
+            ++mMisses;
+            return false;
+        }
+
+        CacheReader r(data);
+        ShaderInfo loaded;
+        bool ok = r.U32() == CacheMagic && r.U32() == CacheVersion && r.U64() == key;
+        if (ok)
+        {
+            loaded.shaderstage = EShaderStage(r.U32());
+            loaded.entrypoint = r.Str();
+            loaded.bytecode = r.Str();
+            ShaderReflectionInfo &reflection = loaded.reflection;
+            for (uint32_t &size : reflection.threadGroupSize)
+                size = r.U32();
+            reflection.bindings.resize(r.Count());
+            for (ShaderBindingInfo &binding : reflection.bindings)
+            {
+                binding.name = r.Str();
+                binding.type = r.U32();
+                binding.bindPoint = r.U32();
+                binding.bindCount = r.U32();
+            }
+            reflection.constantBuffers.resize(r.Count());
+            for (ShaderConstantBufferInfo &cb : reflection.constantBuffers)
+            {
+                cb.name = r.Str();
+                cb.size = r.U32();
+                cb.variables.resize(r.Count());
+                for (ShaderVariableInfo &variable : cb.variables)
+                {
+                    variable.name = r.Str();
+                    variable.offset = r.U32();
+                    variable.size = r.U32();
+                }
+            }
+            ok = r.Ok() && !loaded.bytecode.empty();
+        }
+        if (!ok)
+        {
+            ++mMisses; // truncated or from another version, it is rewritten after compiling
+            return false;
+        }
+
+        ++mHits;
+        info.shaderstage = loaded.shaderstage;
+        info.entrypoint = loaded.entrypoint;
+        info.bytecode.swap(loaded.bytecode);
+        info.reflection = loaded.reflection;
+        return true;
+    }
+
+    bool ShaderDiskCache::Store(uint64_t key, const ShaderInfo &info)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mEnabled || key == 0 || info.bytecode.empty())
+            return false;
+
+        CacheWriter w;
+        w.U32(CacheMagic);
+        w.U32(CacheVersion);
+        w.U64(key);
+        w.U32(uint32_t(info.shaderstage));
+        w.Str(info.entrypoint);
+        w.Str(info.bytecode);
+        const ShaderReflectionInfo &reflection = info.reflection;
+        for (uint32_t size : reflection.threadGroupSize)
+            w.U32(size);
+        w.U32(uint32_t(reflection.bindings.size()));
+        for (const ShaderBindingInfo &binding : reflection.bindings)
+        {
+            w.Str(binding.name);
+            w.U32(binding.type);
+            w.U32(binding.bindPoint);
+            w.U32(binding.bindCount);
+        }
+        w.U32(uint32_t(reflection.constantBuffers.size()));
+        for (const ShaderConstantBufferInfo &cb : reflection.constantBuffers)
+        {
+            w.Str(cb.name);
+            w.U32(cb.size);
+            w.U32(uint32_t(cb.variables.size()));
+            for (const ShaderVariableInfo &variable : cb.variables)
+            {
+                w.Str(variable.name);
+                w.U32(variable.offset);
+                w.U32(variable.size);
+            }
+        }
+
+        // Write a temporary file and rename it, a crash never leaves a torn entry behind.
+        std::error_code ec;
+        fs::create_directories(mDirectory, ec);
+        const std::string path = Path(key);
+        const std::string temp = path + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            if (!file.write(w.data.data(), std::streamsize(w.data.size())))
+                return false;
+        }
+        fs::rename(temp, path, ec);
+        if (ec)
+        {
+            fs::remove(temp, ec);
+            return false;
+        }
+        return true;
+    }
+
+    void ShaderDiskCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::error_code ec;
+        for (fs::directory_iterator it(mDirectory, ec), end; !ec && it != end; it.increment(ec))
+        {
+            if (it->path().extension() == ".cso")
+                fs::remove(it->path(), ec);
+        }
+    }
+}
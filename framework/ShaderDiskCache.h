@@ -0,0 +1,69 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "GHIResources.h"
+
+namespace GHI
+{
+    // Compiled shader bytecode and its reflection, stored on disk so a cold start does not
+    // run the compiler again. The key hashes the source text, the text of every file it
+    // includes (quoted includes, resolved like D3D_COMPILE_STANDARD_FILE_INCLUDE does),
+    // the entry point, the defines, the target and the compile flags, so editing any of
+    // them misses.
+    class ShaderDiskCache
+    {
+    public:
+        explicit ShaderDiskCache(const std::string &directory = "shadercache");
+
+        //! 0 when the source can not be read, such shaders are never cached.
+        uint64_t Key(const ShaderKey &shader, const std::string &target, uint32_t flags) const;
+
+        //! Fills info.bytecode and info.reflection, counts a hit or a miss.
+        bool Load(uint64_t key, ShaderInfo &info);
+        bool Store(uint64_t key, const ShaderInfo &info);
+
+        //! Deletes every cached file, the next start compiles everything.
+        void Clear();
+
+        void SetEnabled(bool enabled)
+        {
+            mEnabled = enabled;
+        }
+        bool Enabled() const
+        {
+            return mEnabled;
+        }
+        uint32_t Hits() const
+        {
+            return mHits;
+        }
+        uint32_t Misses() const
+        {
+            return mMisses;
+        }
+        void ResetCounters()
+        {
+            mHits = mMisses = 0;
+        }
+
+        static ShaderDiskCache& Global();
+
+    private:
+        std::string Path(uint64_t key) const;
+
+        std::string mDirectory;
+        std::mutex mMutex;
+        bool mEnabled = true;
+        uint32_t mHits = 0;
+        uint32_t mMisses = 0;
+    };
+}
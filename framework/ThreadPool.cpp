@@ -0,0 +1,120 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "ThreadPool.h"
+
+namespace GHI
+{
+    ThreadPool::ThreadPool(uint32_t numThreads)
+    {
+        if (numThreads == 0)
+        {
+            numThreads = std::thread::hardware_concurrency();
+            numThreads = numThreads > 0 ? numThreads : 1;
+        }
+        for (uint32_t i = 0; i < numThreads; ++i)
+        {
+            mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mCondition.notify_all();
+        for (auto it = mWorkers.begin(); it != mWorkers.end(); ++it)
+        {
+            it->join();
+        }
+    }
+
+    ThreadPool& ThreadPool::Global()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    void ThreadPool::Enqueue(std::function<void()> task)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTasks.push_back(std::move(task));
+        }
+        mCondition.notify_one();
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]() { return mStop || !mTasks.empty(); });
+                if (mStop && mTasks.empty())
+                    return;
+                task = std::move(mTasks.front());
+                mTasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t index)>& fn)
+    {
+        if (count == 0)
+            return;
+        if (count == 1)
+        {
+            fn(0);
+            return;
+        }
+
+        // Shared with the helper tasks, which may start after this call has returned.
+        struct Job
+        {
+            std::atomic<uint32_t> next{ 0 };
+            std::atomic<uint32_t> done{ 0 };
+            uint32_t count = 0;
+            const std::function<void(uint32_t)>* fn = nullptr;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto job = std::make_shared<Job>();
+        job->count = count;
+        job->fn = &fn;
+
+        auto drain = [](Job *job)
+        {
+            for (;;)
+            {
+                uint32_t index = job->next.fetch_add(1);
+                if (index >= job->count)
+                    return;
+                (*job->fn)(index);
+                if (job->done.fetch_add(1) + 1 == job->count)
+                {
+                    std::unique_lock<std::mutex> lock(job->mutex);
+                    job->finished.notify_all();
+                }
+            }
+        };
+
+        uint32_t helpers = std::min<uint32_t>(NumThreads(), count - 1);
+        for (uint32_t i = 0; i < helpers; ++i)
+        {
+            Enqueue([job, drain]() { drain(job.get()); });
+        }
+        drain(job.get());
+
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->finished.wait(lock, [&job]() { return job->done.load() == job->count; });
+    }
+}
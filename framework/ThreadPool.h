@@ -0,0 +1,69 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GHI
+{
+    // Fixed size worker pool. Only depends on the C++ standard library so it can be
+    // shared by the CPU backend and the tools that run without a window.
+    class ThreadPool
+    {
+    public:
+        // numThreads == 0 uses one worker per hardware thread.
+        explicit ThreadPool(uint32_t numThreads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        uint32_t NumThreads() const
+        {
+            return uint32_t(mWorkers.size());
+        }
+
+        // Queue a task, the returned future holds its result.
+        template<class F>
+        auto Submit(F&& func) -> std::future<decltype(func())>
+        {
+            typedef decltype(func()) R;
+            auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+            std::future<R> ret = task->get_future();
+            Enqueue([task]() { (*task)(); });
+            return ret;
+        }
+
+        // Run fn(0) .. fn(count-1) on the pool and block until all of them finished.
+        // The calling thread takes part in the work, so nested calls from a worker do not dead lock.
+        void ParallelFor(uint32_t count, const std::function<void(uint32_t index)>& fn);
+
+        // Shared pool used when a caller does not own one.
+        static ThreadPool& Global();
+
+    private:
+        void Enqueue(std::function<void()> task);
+        void WorkerLoop();
+
+        std::vector<std::thread> mWorkers;
+        std::deque<std::function<void()>> mTasks;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        bool mStop = false;
+    };
+}
@@ -0,0 +1,107 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include "FCPUGHIResources.h"
+
+namespace GHI
+{
+    // Resources currently bound to the CPU command context, the software equivalent of
+    // the t#, u#, b# and s# registers of a compute shader.
+    struct FCPUBindings
+    {
+        static const int MaxSRV = 8;
+        static const int MaxUAV = 8;
+        static const int MaxCB = 4;
+        static const int MaxSampler = 4;
+
+        FCPUGHITexture *srv[MaxSRV] = {};
+        FCPUGHITexture *uav[MaxUAV] = {};
+        FCPUGHIBuffer  *cb[MaxCB] = {};
+        FCPUGHISampler *sampler[MaxSampler] = {};
+
+        template<class T>
+        const T& Constants(int slot) const
+        {
+            return *reinterpret_cast<const T*>(cb[slot]->data.data());
+        }
+    };
+
+    // One thread group of a Dispatch() call. [x0, x1) x [y0, y1) is the range of SV_DispatchThreadID
+    // covered by the group, it is NOT clipped to the texture size, the same as on the GPU.
+    struct FCPUThreadGroup
+    {
+        uint32_t groupX = 0;
+        uint32_t groupY = 0;
+        uint32_t groupZ = 0;
+        uint32_t x0 = 0, y0 = 0;
+        uint32_t x1 = 0, y1 = 0;
+    };
+
+    typedef std::function<void(const FCPUBindings &bindings, const FCPUThreadGroup &group)> FCPUKernelFunc;
+
+    // C++ replacement of a compute shader, threadsX/threadsY mirror [numthreads(X, Y, 1)].
+    struct FCPUKernel
+    {
+        FCPUKernelFunc func;
+        uint32_t threadsX = 32;
+        uint32_t threadsY = 32;
+    };
+
+    // Kernels are registered under the file name of the shader they replace (e.g. "fishEye.hlsl"),
+    // so filters can keep passing their shader path to GetComputeShader().
+    class CPUKernelRegistry
+    {
+    public:
+        static void Register(const std::string &shaderFile, FCPUKernelFunc func, uint32_t threadsX = 32, uint32_t threadsY = 32)
+        {
+            FCPUKernel kernel;
+            kernel.func = func;
+            kernel.threadsX = threadsX;
+            kernel.threadsY = threadsY;
+            Kernels()[Key(shaderFile)] = kernel;
+        }
+
+        static const FCPUKernel* Find(const std::string &shaderFile)
+        {
+            auto it = Kernels().find(Key(shaderFile));
+            return it == Kernels().end() ? nullptr : &(it->second);
+        }
+
+        static std::string Key(const std::string &shaderFile)
+        {
+            size_t idx = shaderFile.find_last_of("\\/");
+            return idx == std::string::npos ? shaderFile : shaderFile.substr(idx + 1);
+        }
+
+    private:
+        static std::unordered_map<std::string, FCPUKernel>& Kernels()
+        {
+            static std::unordered_map<std::string, FCPUKernel> kernels;
+            return kernels;
+        }
+    };
+
+    // Visit every thread of a group which maps onto a texel of the target.
+    template<class F>
+    inline void ForEachThread(const FCPUThreadGroup &group, uint32_t width, uint32_t height, F func)
+    {
+        uint32_t x1 = group.x1 < width ? group.x1 : width;
+        uint32_t y1 = group.y1 < height ? group.y1 : height;
+        for (uint32_t y = group.y0; y < y1; ++y)
+        {
+            for (uint32_t x = group.x0; x < x1; ++x)
+            {
+                func(x, y);
+            }
+        }
+    }
+}
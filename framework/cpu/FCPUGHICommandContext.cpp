@@ -0,0 +1,242 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "FCPUGHICommandContext.h"
+
+namespace GHI
+{
+    // Adds the duration of one Dispatch / CopyTexture to the open profile scope.
+    struct FCPUIGHIComputeCommandCotext::ProfileEvent
+    {
+        FCPUIGHIComputeCommandCotext *context;
+        std::chrono::steady_clock::time_point start;
+
+        explicit ProfileEvent(FCPUIGHIComputeCommandCotext *ctx)
+            : context(ctx)
+            , start(std::chrono::steady_clock::now())
+        {
+        }
+        ~ProfileEvent()
+        {
+            if (context->mProfiling)
+                context->mProfileMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+	GHITexture* FCPUIGHIComputeCommandCotext::CreateTexture(std::string filename)
+	{
+		return new FCPUGHITexture(filename);
+	}
+
+	GHITexture* FCPUIGHIComputeCommandCotext::CreateTexture(const TextureDesc2D &desc, const void* initData)
+	{
+		FCPUGHITexture *tex = new FCPUGHITexture(desc);
+		if (initData)
+			memcpy(tex->pixels.data(), initData, tex->pixels.size());
+		return tex;
+	}
+
+	GHITexture* FCPUIGHIComputeCommandCotext::CreateTextureByAnother(GHITexture * tex)
+	{
+        FCPUGHITexture *res = CPUResourceCast(tex);
+        if (res)
+        {
+            return new FCPUGHITexture(res->desc);
+        }
+        else
+        {
+            return nullptr;
+        }
+	}
+
+    void FCPUIGHIComputeCommandCotext::DestroyTexture(GHITexture *texture)
+    {
+        WaitPendingCopies(); // a readback may still be copying from it
+        for (FCPUGHITexture *&bound : mBindings.srv)
+            bound = bound == texture ? nullptr : bound;
+        for (FCPUGHITexture *&bound : mBindings.uav)
+            bound = bound == texture ? nullptr : bound;
+        IGHIComputeCommandCotext::DestroyTexture(texture);
+    }
+
+	void FCPUIGHIComputeCommandCotext::CopyTexture(GHITexture *dst, GHITexture *src)
+	{
+        WaitPendingCopies(); // a readback of dst may still be reading it
+        ProfileEvent event(this);
+        FCPUGHITexture *dtex = CPUResourceCast(dst);
+        FCPUGHITexture *stex = CPUResourceCast(src);
+		if (dtex && stex && dtex->width == stex->width && dtex->height == stex->height && dtex->format == stex->format && dtex->pixels.size() == stex->pixels.size())
+		{
+            // Rows are independent, split the copy so large images use the whole memory bandwidth.
+            const uint32_t rowsPerTask = 64;
+            uint32_t tasks = (stex->height + rowsPerTask - 1) / rowsPerTask;
+            mPool.ParallelFor(tasks, [dtex, stex, rowsPerTask](uint32_t task)
+            {
+                uint32_t y0 = task * rowsPerTask;
+                uint32_t y1 = std::min(y0 + rowsPerTask, stex->height);
+                memcpy(dtex->Row(y0), stex->Row(y0), size_t(y1 - y0) * stex->rowPitch);
+            });
+            // Like CopyResource, the mips the two textures have in common too.
+            for (size_t level = 0; level < dtex->mips.size() && level < stex->mips.size(); ++level)
+                dtex->mips[level]->pixels = stex->mips[level]->pixels;
+		}
+	}
+
+    void FCPUIGHIComputeCommandCotext::WaitPendingCopies()
+    {
+        for (std::shared_future<void> &copy : mPendingCopies)
+            copy.wait();
+        mPendingCopies.clear();
+    }
+
+    GHIReadbackTicket FCPUIGHIComputeCommandCotext::ReadTextureAsync(GHITexture *tex)
+    {
+        FCPUGHITexture *res = CPUResourceCast(tex);
+        if (!res || res->pixels.empty())
+            return 0;
+
+        GHIStagingKey key = { res->width, res->height, res->desc.Format };
+        FCPUStaging staging;
+        if (!mReadbacks.Acquire(key, staging))
+        {
+            staging.rowPitch = (res->rowPitch + StagingPitchAlignment - 1) / StagingPitchAlignment * StagingPitchAlignment;
+            staging.buffer = std::make_shared<std::vector<uint8_t>>(size_t(staging.rowPitch) * res->height);
+        }
+
+        std::shared_ptr<std::vector<uint8_t>> buffer = staging.buffer;
+        const uint32_t pitch = staging.rowPitch;
+        staging.copy = mPool.Submit([res, buffer, pitch]()
+        {
+            for (uint32_t y = 0; y < res->height; ++y)
+                memcpy(buffer->data() + size_t(y) * pitch, res->Row(y), res->rowPitch);
+        }).share();
+
+        mPendingCopies.erase(std::remove_if(mPendingCopies.begin(), mPendingCopies.end(), [](const std::shared_future<void> &copy)
+        {
+            return copy.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }), mPendingCopies.end());
+        mPendingCopies.push_back(staging.copy);
+        return mReadbacks.Track(key, staging);
+    }
+
+    EReadbackStatus FCPUIGHIComputeCommandCotext::PollReadback(GHIReadbackTicket ticket, GHIReadbackData &data, bool wait)
+    {
+        TGHIStagingPool<FCPUStaging>::InFlight *readback = mReadbacks.Find(ticket);
+        if (!readback)
+            return EReadbackStatus::Invalid;
+        if (!wait && readback->staging.copy.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return EReadbackStatus::Pending;
+
+        readback->staging.copy.wait();
+        CopyReadbackRows(data, readback->key, readback->staging.buffer->data(), readback->staging.rowPitch);
+        mReadbacks.Complete(ticket);
+        return EReadbackStatus::Ready;
+    }
+
+    void FCPUIGHIComputeCommandCotext::Dispatch(int nX, int nY, int nZ)
+    {
+        if (!mComputeShader || !mComputeShader->kernel || nX <= 0 || nY <= 0 || nZ <= 0)
+        {
+            return;
+        }
+
+        WaitPendingCopies();
+        ProfileEvent event(this);
+        const FCPUKernel *kernel = mComputeShader->kernel;
+        const FCPUBindings bindings = mBindings; // snapshot, the kernel must not see later binds
+        const uint32_t groupsX = uint32_t(nX);
+        const uint32_t groupsY = uint32_t(nY);
+        const uint32_t groupsZ = uint32_t(nZ);
+
+        mPool.ParallelFor(groupsX * groupsY * groupsZ, [&](uint32_t index)
+        {
+            FCPUThreadGroup group;
+            group.groupX = index % groupsX;
+            group.groupY = (index / groupsX) % groupsY;
+            group.groupZ = index / (groupsX * groupsY);
+            group.x0 = group.groupX * kernel->threadsX;
+            group.y0 = group.groupY * kernel->threadsY;
+            group.x1 = group.x0 + kernel->threadsX;
+            group.y1 = group.y0 + kernel->threadsY;
+            kernel->func(bindings, group);
+        });
+    }
+
+    GHIVertexShader*  FCPUIGHIComputeCommandCotext::CreateVertexShader(std::string file, std::string entrypoint)
+    {
+        GHIVertexShader *shader = new FCPUGHIVertexShader;
+		shader->info.shaderfile = file;
+		shader->info.entrypoint = entrypoint;
+        shader->info.shaderstage = EShaderStage::VS;
+		return shader;
+    }
+
+    GHIPixelShader*   FCPUIGHIComputeCommandCotext::CreatePixelShader(std::string file, std::string entrypoint)
+    {
+        GHIPixelShader *shader = new FCPUGHIPixelShader;
+		shader->info.shaderfile = file;
+		shader->info.entrypoint = entrypoint;
+        shader->info.shaderstage = EShaderStage::PS;
+		return shader;
+    }
+
+    // Kernels read their options from the constant buffer, defines only tell permutations apart.
+    GHIShader* FCPUIGHIComputeCommandCotext::CreateComputeShader(const ShaderKey &key)
+    {
+        const FCPUKernel *kernel = CPUKernelRegistry::Find(key.File());
+        if (!kernel)
+        {
+            std::fprintf(stderr, "- [Error] no CPU kernel registered for shader '%s'\n", key.File().c_str());
+            return nullptr;
+        }
+        GHIShader *shader = new FCPUGHIComputeShader(kernel);
+		shader->info.shaderfile = key.File();
+		shader->info.entrypoint = key.Entrypoint();
+        shader->info.shaderstage = EShaderStage::CS;
+        shader->info.defines = key.Defines();
+		return shader;
+    }
+
+	GHIShader* FCPUIGHIComputeCommandCotext::CreateShader(std::string file)
+	{
+        return CreateComputeShader(file);
+	}
+
+    void FCPUIGHIComputeCommandCotext::SetShader(GHIShader* shader)
+    {
+        if (shader && shader->info.shaderstage == EShaderStage::CS)
+        {
+            FCPUGHIComputeShader *cs = dynamic_cast<FCPUGHIComputeShader *>(shader);
+            if (!cs)
+            {
+                return;
+            }
+            if (mStateShadow.Bind(EShaderStage::CS, EBindKind::Shader, 0, cs))
+                mComputeShader = cs;
+        }
+    }
+
+    void FCPUIGHIComputeCommandCotext::BeginProfile(const std::string &scope, uint64_t pixels)
+    {
+        mProfiling = true;
+        mProfileScope = scope;
+        mProfilePixels = pixels;
+        mProfileMs = 0.;
+    }
+
+    void FCPUIGHIComputeCommandCotext::EndProfile()
+    {
+        if (mProfiling)
+        {
+            mProfiler.AddSample(mProfileScope, mProfileMs, mProfilePixels);
+            mProfiling = false;
+        }
+    }
+}
@@ -0,0 +1,145 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "GHIResources.h"
+#include "GHICommandContext.h"
+#include "FCPUGHIResources.h"
+#include "CPUKernel.h"
+#include "ThreadPool.h"
+#include "GHIReadback.h"
+
+namespace GHI
+{
+    // Software implementation of the compute command context. Compute shaders are replaced by
+    // C++ kernels found in CPUKernelRegistry, Dispatch() runs one task per thread group on a pool.
+	class FCPUIGHIComputeCommandCotext: public IGHIComputeCommandCotext
+	{
+        ThreadPool &mPool;
+        FCPUBindings mBindings;
+        FCPUGHIComputeShader *mComputeShader = nullptr;
+
+        // Work is synchronous, the profile scope is timed with the wall clock.
+        bool mProfiling = false;
+        std::string mProfileScope;
+        uint64_t mProfilePixels = 0;
+        double mProfileMs = 0.;
+        struct ProfileEvent;
+
+        // Readbacks copy on the pool into buffers with a GPU like row pitch, so the pooling,
+        // pitch and completion paths behave as on a GPU backend. Later writes wait for them.
+        struct FCPUStaging
+        {
+            std::shared_ptr<std::vector<uint8_t>> buffer;
+            uint32_t rowPitch = 0;
+            std::shared_future<void> copy;
+        };
+        static const uint32_t StagingPitchAlignment = 256;
+        TGHIStagingPool<FCPUStaging> mReadbacks;
+        std::vector<std::shared_future<void>> mPendingCopies;
+        void WaitPendingCopies();
+
+	public:
+        explicit FCPUIGHIComputeCommandCotext(ThreadPool &pool = ThreadPool::Global())
+            : mPool(pool)
+        {
+        }
+        virtual ~FCPUIGHIComputeCommandCotext()
+        {
+            WaitPendingCopies();
+        }
+
+        ThreadPool& Pool()
+        {
+            return mPool;
+        }
+
+		virtual void SetShaderResource(GHITexture *resource, int slot, GHISRVParam view, EShaderStage stage = EShaderStage::CS) override
+		{
+            // A view of mip n binds that mip, the kernels only see one level.
+            FCPUGHITexture *mip = resource ? CPUResourceCast(resource)->Mip(view.MostDetailedMip) : nullptr;
+            if (stage == EShaderStage::CS && slot >= 0 && slot < FCPUBindings::MaxSRV
+                && mStateShadow.Bind(stage, EBindKind::SRV, slot, mip, resource))
+                mBindings.srv[slot] = mip;
+		}
+
+        virtual void SetShaderResource(GHITexture *resource, int slot, GHIUAVParam view,EShaderStage stage = EShaderStage::CS) override
+		{
+            FCPUGHITexture *mip = resource ? CPUResourceCast(resource)->Mip(view.MostDetailedMip) : nullptr;
+            if (stage == EShaderStage::CS && slot >= 0 && slot < FCPUBindings::MaxUAV
+                && mStateShadow.Bind(stage, EBindKind::UAV, slot, mip, resource))
+                mBindings.uav[slot] = mip;
+		}
+
+        virtual void SetConstBuffer(GHIBuffer *resource, int slot) override
+        {
+            if (slot >= 0 && slot < FCPUBindings::MaxCB
+                && mStateShadow.Bind(EShaderStage::CS, EBindKind::ConstBuffer, slot, resource))
+                mBindings.cb[slot] = CPUResourceCast(resource);
+        }
+
+        virtual GHIBuffer* CreateConstBuffer(int size, const void* initData) override
+        {
+            return new FCPUGHIBuffer(size, initData);
+        }
+
+        virtual void UpdateBuffer(GHIBuffer*buffer, void* data, int size) override
+        {
+            FCPUGHIBuffer *res = CPUResourceCast(buffer);
+            if (res)
+            {
+                res->Update(data, size);
+            }
+        }
+
+		virtual GHISampler* CreateSampler(const GHISamplerDesc  &desc) override
+		{
+			return new FCPUGHISampler(desc);
+		}
+		virtual void SetSampler(GHISampler *resource, int slot, EShaderStage stage) override
+		{
+            if (stage == EShaderStage::CS && slot >= 0 && slot < FCPUBindings::MaxSampler
+                && mStateShadow.Bind(stage, EBindKind::Sampler, slot, resource))
+                mBindings.sampler[slot] = CPUResourceCast(resource);
+		}
+
+        virtual GHITexture* CreateTexture(std::string filename) override;
+        virtual GHITexture* CreateTexture(const TextureDesc2D &desc, const void* initData = nullptr) override;
+        virtual GHITexture* CreateTextureByAnother(GHITexture * tex) override;
+        virtual void DestroyTexture(GHITexture *texture) override;
+		virtual void CopyTexture(GHITexture *dst, GHITexture *src) override;
+        virtual GHIReadbackTicket ReadTextureAsync(GHITexture *tex) override;
+        virtual EReadbackStatus PollReadback(GHIReadbackTicket ticket, GHIReadbackData &data, bool wait = false) override;
+
+        const TGHIStagingPool<FCPUStaging>& Readbacks() const
+        {
+            return mReadbacks;
+        }
+        virtual void Dispatch(int nX, int nY, int nZ) override;
+
+		virtual void setPrimitiveTopology(PrimitiveTopology /*topology*/) override
+        {
+        }
+        virtual void SetViewport(GHIViewport /*viewport*/) override
+        {
+        }
+        virtual void Draw(int /*count*/, int /*offset*/) override
+        {
+        }
+
+        virtual GHIVertexShader*  CreateVertexShader(std::string file, std::string entrypoint) override;
+        virtual GHIPixelShader*   CreatePixelShader(std::string file, std::string entrypoint) override;
+        virtual GHIShader* CreateComputeShader(const ShaderKey &key) override;
+        using IGHIComputeCommandCotext::CreateComputeShader;
+        virtual GHIShader* CreateShader(std::string file) override;
+        virtual void SetShader(GHIShader* shader) override;
+
+        virtual void BeginProfile(const std::string &scope, uint64_t pixels) override;
+        virtual void EndProfile() override;
+	};
+}
@@ -0,0 +1,214 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include "FCPUGHIResources.h"
+
+namespace GHI
+{
+    static FCPUImageDecoder sImageDecoder = DecodeBMP;
+
+    void SetCPUImageDecoder(FCPUImageDecoder decoder)
+    {
+        sImageDecoder = decoder ? decoder : FCPUImageDecoder(DecodeBMP);
+    }
+
+    template<class T>
+    static T ReadLE(const uint8_t *p)
+    {
+        T v = 0;
+        for (size_t i = 0; i < sizeof(T); ++i)
+            v |= T(p[i]) << (8 * i);
+        return v;
+    }
+
+    // Uncompressed 24/32 bit BMP only, enough for the CPU backend to run without any image library.
+    bool DecodeBMP(const std::string &filename, uint32_t &width, uint32_t &height, std::vector<uint8_t> &pixels)
+    {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in)
+            return false;
+        uint8_t header[54];
+        if (!in.read((char*)header, sizeof(header)) || header[0] != 'B' || header[1] != 'M')
+            return false;
+
+        uint32_t dataOffset = ReadLE<uint32_t>(header + 10);
+        int32_t  w = int32_t(ReadLE<uint32_t>(header + 18));
+        int32_t  h = int32_t(ReadLE<uint32_t>(header + 22));
+        uint16_t bpp = ReadLE<uint16_t>(header + 28);
+        uint32_t compression = ReadLE<uint32_t>(header + 30);
+        if (w <= 0 || h == 0 || (bpp != 24 && bpp != 32) || (compression != 0 && compression != 3))
+            return false;
+
+        bool bottomUp = h > 0;
+        width = uint32_t(w);
+        height = uint32_t(bottomUp ? h : -h);
+        const uint32_t bytesPerPixel = bpp / 8;
+        const uint32_t srcPitch = (width * bytesPerPixel + 3) & ~3u;
+
+        std::vector<uint8_t> row(srcPitch);
+        pixels.resize(size_t(width) * height * 4);
+        in.seekg(dataOffset);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            if (!in.read((char*)row.data(), srcPitch))
+                return false;
+            uint8_t *dst = pixels.data() + size_t(bottomUp ? height - 1 - y : y) * width * 4;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const uint8_t *src = row.data() + x * bytesPerPixel;
+                dst[x * 4 + 0] = src[2];
+                dst[x * 4 + 1] = src[1];
+                dst[x * 4 + 2] = src[0];
+                dst[x * 4 + 3] = bytesPerPixel == 4 ? src[3] : 255;
+            }
+        }
+        return true;
+    }
+
+    void FCPUGHITexture::Allocate(const TextureDesc2D &texDesc)
+    {
+        desc = texDesc;
+        width = desc.Width;
+        height = desc.Height;
+        format = desc.Format;
+        bindFlags = desc.BindFlags ? desc.BindFlags : (BindFlag_SHADER_RESOURCE | BindFlag_UNORDERED_ACCESS); // the DX11 default
+        aspect = height > 0 ? float(width) / float(height) : 0.f;
+        rowPitch = width * BytesPerPixel(desc.Format);
+        textureSizeInBytes = rowPitch * height;
+        pixels.assign(textureSizeInBytes, 0);
+        mipLevels = desc.MipLevels ? desc.MipLevels : 1;
+        mips.clear();
+        for (uint32_t level = 1; level < mipLevels; ++level)
+        {
+            TextureDesc2D mipDesc = desc;
+            mipDesc.Width = MipSize(desc.Width, level);
+            mipDesc.Height = MipSize(desc.Height, level);
+            mipDesc.MipLevels = 1;
+            mips.emplace_back(new FCPUGHITexture(mipDesc, MipTag()));
+        }
+    }
+
+    void FCPUGHITexture::LoadFromFile(std::string filename)
+    {
+        uint32_t w = 0, h = 0;
+        std::vector<uint8_t> data;
+        if (!sImageDecoder(filename, w, h, data) || data.size() != size_t(w) * h * 4)
+        {
+            std::fprintf(stderr, "- [Error] CPU backend can not decode '%s'\n", filename.c_str());
+            width = height = textureSizeInBytes = 0;
+            aspect = 0.;
+            return;
+        }
+        TextureDesc2D texDesc;
+        texDesc.Width = w;
+        texDesc.Height = h;
+        desc = texDesc;
+        width = w;
+        height = h;
+        format = desc.Format;
+        bindFlags = BindFlag_SHADER_RESOURCE;
+        aspect = float(width) / float(height);
+        rowPitch = width * 4;
+        textureSizeInBytes = rowPitch * height;
+        pixels.swap(data);
+    }
+
+    // Resolve a texel coordinate according to the sampler address mode, returns false for border texels.
+    static bool AddressTexel(int &i, int size, TextureAddressMode mode)
+    {
+        if (i >= 0 && i < size)
+            return true;
+        switch (mode)
+        {
+        case TextureAddressMode::WRAP:
+            i %= size;
+            i = i < 0 ? i + size : i;
+            return true;
+        case TextureAddressMode::MIRROR:
+        {
+            int period = 2 * size;
+            int m = i % period;
+            m = m < 0 ? m + period : m;
+            i = m < size ? m : period - 1 - m;
+            return true;
+        }
+        case TextureAddressMode::MIRROR_ONCE:
+            i = i < 0 ? -i - 1 : i;
+            i = i < size ? i : size - 1;
+            return true;
+        case TextureAddressMode::BORDER:
+            return false;
+        case TextureAddressMode::CLAMP:
+        default:
+            i = i < 0 ? 0 : size - 1;
+            return true;
+        }
+    }
+
+    CPUFloat4 FCPUGHITexture::SampleLevel(const FCPUGHISampler *sampler, float u, float v) const
+    {
+        if (width == 0 || height == 0)
+            return CPUFloat4();
+
+        GHISamplerDesc defaultDesc;
+        const GHISamplerDesc &sd = sampler ? sampler->desc : defaultDesc;
+        CPUFloat4 border(sd.BorderColor[0], sd.BorderColor[1], sd.BorderColor[2], sd.BorderColor[3]);
+
+        auto fetch = [&](int x, int y) -> CPUFloat4
+        {
+            if (!AddressTexel(x, int(width), sd.AddressU) || !AddressTexel(y, int(height), sd.AddressV))
+                return border;
+            return Load(x, y);
+        };
+
+        // Texel centers are at (i + 0.5) / size, as in D3D.
+        float fx = u * width - 0.5f;
+        float fy = v * height - 0.5f;
+        bool pointMag = (sd.Filter & 0x4) == 0;
+        if (pointMag)
+        {
+            return fetch(int(std::floor(fx + 0.5f)), int(std::floor(fy + 0.5f)));
+        }
+
+        // The weights have the 8 bits of subtexel precision of D3D hardware : coordinates
+        // a rounding error apart blend the same texels alike.
+        float x0f = std::floor(fx);
+        float y0f = std::floor(fy);
+        float ax = std::nearbyint((fx - x0f) * 256.f) / 256.f;
+        float ay = std::nearbyint((fy - y0f) * 256.f) / 256.f;
+        int x0 = int(x0f);
+        int y0 = int(y0f);
+
+        CPUFloat4 c00 = fetch(x0, y0);
+        CPUFloat4 c10 = fetch(x0 + 1, y0);
+        CPUFloat4 c01 = fetch(x0, y0 + 1);
+        CPUFloat4 c11 = fetch(x0 + 1, y0 + 1);
+        CPUFloat4 top = c00 * (1.f - ax) + c10 * ax;
+        CPUFloat4 bottom = c01 * (1.f - ax) + c11 * ax;
+        return top * (1.f - ay) + bottom * ay;
+    }
+
+    CPUFloat4 FCPUGHITexture::SampleLevel(const FCPUGHISampler *sampler, float u, float v, float lod) const
+    {
+        const float maxLod = float(mips.size());
+        lod = lod > 0.f ? (lod < maxLod ? lod : maxLod) : 0.f;
+        GHISamplerDesc defaultDesc;
+        const GHISamplerDesc &sd = sampler ? sampler->desc : defaultDesc;
+        if ((sd.Filter & 0x1) == 0)
+            return Mip(uint32_t(lod + 0.5f))->SampleLevel(sampler, u, v); // MIP_POINT
+
+        const uint32_t level = uint32_t(lod);
+        const float t = lod - float(level);
+        CPUFloat4 c = Mip(level)->SampleLevel(sampler, u, v);
+        if (t > 0.f)
+            c = c * (1.f - t) + Mip(level + 1)->SampleLevel(sampler, u, v) * t;
+        return c;
+    }
+}
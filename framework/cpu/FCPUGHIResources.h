@@ -0,0 +1,307 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "GHIResources.h"
+
+namespace GHI
+{
+    struct CPUFloat4
+    {
+        float x = 0.f;
+        float y = 0.f;
+        float z = 0.f;
+        float w = 0.f;
+
+        CPUFloat4() {}
+        CPUFloat4(float vx, float vy, float vz, float vw) : x(vx), y(vy), z(vz), w(vw) {}
+
+        CPUFloat4 operator+(const CPUFloat4 &o) const { return CPUFloat4(x + o.x, y + o.y, z + o.z, w + o.w); }
+        CPUFloat4 operator-(const CPUFloat4 &o) const { return CPUFloat4(x - o.x, y - o.y, z - o.z, w - o.w); }
+        CPUFloat4 operator*(float s) const { return CPUFloat4(x * s, y * s, z * s, w * s); }
+        CPUFloat4& operator+=(const CPUFloat4 &o) { x += o.x; y += o.y; z += o.z; w += o.w; return *this; }
+    };
+
+    // uint4 of the kernels, sums wrap around modulo 2^32 as on the GPU.
+    struct CPUUint4
+    {
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t z = 0;
+        uint32_t w = 0;
+
+        CPUUint4() {}
+        CPUUint4(uint32_t vx, uint32_t vy, uint32_t vz, uint32_t vw) : x(vx), y(vy), z(vz), w(vw) {}
+
+        CPUUint4 operator+(const CPUUint4 &o) const { return CPUUint4(x + o.x, y + o.y, z + o.z, w + o.w); }
+        CPUUint4 operator-(const CPUUint4 &o) const { return CPUUint4(x - o.x, y - o.y, z - o.z, w - o.w); }
+        CPUUint4 operator*(const CPUUint4 &o) const { return CPUUint4(x * o.x, y * o.y, z * o.z, w * o.w); }
+        CPUUint4& operator+=(const CPUUint4 &o) { x += o.x; y += o.y; z += o.z; w += o.w; return *this; }
+    };
+
+    // Decodes an image file into tightly packed R8G8B8A8 pixels.
+    typedef std::function<bool(const std::string &filename, uint32_t &width, uint32_t &height, std::vector<uint8_t> &pixels)> FCPUImageDecoder;
+
+    // Used by FCPUGHITexture::LoadFromFile, defaults to the built-in uncompressed BMP reader.
+    void SetCPUImageDecoder(FCPUImageDecoder decoder);
+    bool DecodeBMP(const std::string &filename, uint32_t &width, uint32_t &height, std::vector<uint8_t> &pixels);
+
+	class FCPUGHIResourceView: public IGHIResourceView
+	{
+	public:
+        // Views are implicit on the CPU, kernels read the texture storage directly.
+        virtual void CreateRTV(const GHIRTVParam &) override {}
+        virtual void CreateSRV(const GHISRVParam &) override {}
+        virtual void CreateUAV(const GHIUAVParam &) override {}
+	};
+
+	class FCPUGHISampler : public GHISampler
+	{
+	public:
+		GHISamplerDesc desc;
+		FCPUGHISampler(const GHISamplerDesc &samplerDesc)
+			: desc(samplerDesc)
+		{
+            list.push_back(this);
+		}
+        virtual void release() override
+        {
+        }
+	};
+
+	class FCPUGHITexture: public GHITexture
+	{
+	public:
+		TextureDesc2D desc;
+		uint32_t rowPitch = 0;
+		std::vector<uint8_t> pixels;
+		std::vector<std::unique_ptr<FCPUGHITexture>> mips; //< levels 1 .. mipLevels - 1, one texture each
+
+		FCPUGHITexture(const TextureDesc2D &texDesc)
+		{
+			Allocate(texDesc);
+			view = new FCPUGHIResourceView;
+            list.push_back(this);
+		}
+		FCPUGHITexture(std::string filename)
+		{
+			LoadFromFile(filename);
+			view = new FCPUGHIResourceView;
+            list.push_back(this);
+		}
+        virtual void release() override
+        {
+            std::vector<uint8_t>().swap(pixels);
+            mips.clear();
+        }
+
+		void Allocate(const TextureDesc2D &texDesc);
+
+		//! Level of the texture, kernels bound to a view of a mip see it as a texture of its own.
+		FCPUGHITexture* Mip(uint32_t level)
+		{
+			return level == 0 ? this : (level - 1 < mips.size() ? mips[level - 1].get() : nullptr);
+		}
+		const FCPUGHITexture* Mip(uint32_t level) const
+		{
+			return level == 0 ? this : (level - 1 < mips.size() ? mips[level - 1].get() : nullptr);
+		}
+		void LoadFromFile(std::string filename);
+
+		uint8_t* Row(uint32_t y)
+		{
+			return pixels.data() + size_t(y) * rowPitch;
+		}
+		const uint8_t* Row(uint32_t y) const
+		{
+			return pixels.data() + size_t(y) * rowPitch;
+		}
+
+        // Same semantic as Texture2D.Load() : out of range reads return zero.
+		CPUFloat4 Load(int x, int y) const
+		{
+			if (x < 0 || y < 0 || uint32_t(x) >= width || uint32_t(y) >= height)
+				return CPUFloat4();
+			if (desc.Format == PixelFormat_R8G8B8A8_UNORM)
+			{
+				const uint8_t *p = Row(y) + x * 4;
+				const float s = 1.f / 255.f;
+				return CPUFloat4(p[0] * s, p[1] * s, p[2] * s, p[3] * s);
+			}
+			float c[4];
+			DecodePixel(desc.Format, Row(y) + size_t(x) * BytesPerPixel(desc.Format), c);
+			return CPUFloat4(c[0], c[1], c[2], c[3]);
+		}
+
+        // Same semantic as RWTexture2D writes : out of range writes are dropped.
+		void Store(int x, int y, const CPUFloat4 &c)
+		{
+			if (x < 0 || y < 0 || uint32_t(x) >= width || uint32_t(y) >= height)
+				return;
+			if (desc.Format == PixelFormat_R8G8B8A8_UNORM)
+			{
+				uint8_t *p = Row(y) + x * 4;
+				p[0] = ToUNorm8(c.x);
+				p[1] = ToUNorm8(c.y);
+				p[2] = ToUNorm8(c.z);
+				p[3] = ToUNorm8(c.w);
+				return;
+			}
+			const float rgba[4] = { c.x, c.y, c.z, c.w };
+			EncodePixel(desc.Format, rgba, Row(y) + size_t(x) * BytesPerPixel(desc.Format));
+		}
+
+        // Texture2D<uint4>.Load() and RWTexture2D<uint4> writes of a R32G32B32A32_UINT texture.
+		CPUUint4 LoadUint(int x, int y) const
+		{
+			CPUUint4 c;
+			if (x >= 0 && y >= 0 && uint32_t(x) < width && uint32_t(y) < height)
+				memcpy(&c.x, Row(y) + size_t(x) * 16, 16);
+			return c;
+		}
+		void StoreUint(int x, int y, const CPUUint4 &c)
+		{
+			if (x >= 0 && y >= 0 && uint32_t(x) < width && uint32_t(y) < height)
+				memcpy(Row(y) + size_t(x) * 16, &c.x, 16);
+		}
+
+        // Texture2D.SampleLevel(sampler, uv, 0) for point and bilinear filters.
+		CPUFloat4 SampleLevel(const FCPUGHISampler *sampler, float u, float v) const;
+
+        // Texture2D.SampleLevel(sampler, uv, lod) : the two mips around lod, linearly blended.
+		CPUFloat4 SampleLevel(const FCPUGHISampler *sampler, float u, float v, float lod) const;
+
+		static uint8_t ToUNorm8(float v)
+		{
+			return FloatToUNorm8(v);
+		}
+
+	private:
+		struct MipTag {};
+		//! A mip, owned by its texture and not listed in GHIResource::list.
+		FCPUGHITexture(const TextureDesc2D &texDesc, MipTag)
+		{
+			Allocate(texDesc);
+		}
+	};
+
+	class FCPUGHIBuffer: public GHIBuffer
+	{
+	public:
+		std::vector<uint8_t> data;
+		FCPUGHIBuffer(int size, const void *initData)
+            : data(((size + 15) / 16) * 16, 0)
+		{
+            if (initData)
+                memcpy(data.data(), initData, size);
+            list.push_back(this);
+		}
+        virtual void release() override
+        {
+            std::vector<uint8_t>().swap(data);
+        }
+		virtual void Update(void* src, int size) override
+        {
+            if (size > int(data.size()))
+                data.resize(((size + 15) / 16) * 16, 0);
+            memcpy(data.data(), src, size);
+        }
+	};
+
+    struct FCPUKernel;
+
+    class FCPUGHIComputeShader : public GHIComputeShader
+    {
+    public:
+        const FCPUKernel *kernel = nullptr;
+    public:
+        FCPUGHIComputeShader(const FCPUKernel *k)
+            :kernel(k)
+        {
+            list.push_back(this);
+        }
+
+        virtual void release() override
+        {
+        }
+
+		virtual std::string str() override
+		{
+			return info.shaderfile;
+		}
+    };
+
+    // Graphic shaders only exist so the interface can be satisfied, the CPU backend does not rasterize.
+    class FCPUGHIVertexShader : public GHIVertexShader
+    {
+    public:
+        FCPUGHIVertexShader()
+        {
+            list.push_back(this);
+        }
+        virtual void release() override
+        {
+        }
+		virtual std::string str() override
+		{
+			return info.shaderfile;
+		}
+    };
+    class FCPUGHIPixelShader : public GHIPixelShader
+    {
+    public:
+        FCPUGHIPixelShader()
+        {
+            list.push_back(this);
+        }
+        virtual void release() override
+        {
+        }
+		virtual std::string str() override
+		{
+			return info.shaderfile;
+		}
+    };
+
+    // Cast
+    template<class T>
+    struct TCPUResourceTraits
+    {
+    };
+
+    template<>
+    struct TCPUResourceTraits<GHITexture>
+    {
+        typedef FCPUGHITexture  TConcreteType;
+    };
+
+    template<>
+    struct TCPUResourceTraits<GHIBuffer>
+    {
+        typedef FCPUGHIBuffer TConcreteType;
+    };
+
+    template<>
+    struct TCPUResourceTraits<GHISampler>
+    {
+        typedef FCPUGHISampler TConcreteType;
+    };
+
+    template<typename TRHIType>
+    inline typename TCPUResourceTraits<TRHIType>::TConcreteType* CPUResourceCast(TRHIType* Resource)
+    {
+        return static_cast<typename TCPUResourceTraits<TRHIType>::TConcreteType*>(Resource);
+    }
+
+}
@@ -10,6 +10,7 @@
 #include "GHICommandContext.h" 
 #include "FDX11GHICommandContext.h" 
 #include "FDX11GHIResources.h" 
+#include "ShaderDiskCache.h"
 
 namespace GHI
 {
@@ -25,7 +26,9 @@ namespace GHI
         FDX11GHITexture *stex = ResourceCast(src);
 		if (dtex && stex)
 		{
+			mQueries.BeginEvent();
 			DX11::ImmediateContext()->CopyResource(dtex->rawTexture, stex->rawTexture);
+			mQueries.EndEvent();
 		}
 		else
 		{
@@ -39,6 +42,36 @@ namespace GHI
 		return tex;
 	}
 
+	GHITexture* FDX11IGHIComputeCommandCotext::CreateTexture(const TextureDesc2D &desc, const void* initData)
+	{
+		D3D11_TEXTURE2D_DESC dx11desc;
+		ZeroMemory(&dx11desc, sizeof(dx11desc));
+		dx11desc.Width = desc.Width;
+		dx11desc.Height = desc.Height;
+		dx11desc.MipLevels = desc.MipLevels;
+		dx11desc.ArraySize = desc.ArraySize;
+		dx11desc.Format = DX11FormatCast(desc.Format);
+		dx11desc.SampleDesc.Count = desc.SampleCountPixel;
+		dx11desc.SampleDesc.Quality = desc.ImageQualityLevel;
+		dx11desc.Usage = (D3D11_USAGE)desc.Usage;
+		dx11desc.BindFlags = desc.BindFlags ? desc.BindFlags : (D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE);
+		dx11desc.CPUAccessFlags = desc.CPUAccessFlags;
+		dx11desc.MiscFlags = desc.MiscFlags;
+
+		D3D11_SUBRESOURCE_DATA data;
+		data.pSysMem = initData;
+		data.SysMemPitch = desc.Width * BytesPerPixel(desc.Format);
+		data.SysMemSlicePitch = 0;
+
+		// Initial data is for every mip, the pixels of mip 0 only go in afterwards.
+		ID3D11Texture2D *temp = nullptr;
+		const bool mip0Only = initData && desc.MipLevels != 1;
+		DXCall(DX11::Device()->CreateTexture2D(&dx11desc, initData && !mip0Only ? &data : NULL, &temp));
+		if (mip0Only)
+			DX11::ImmediateContext()->UpdateSubresource(temp, 0, nullptr, initData, data.SysMemPitch, 0);
+		return new FDX11GHITexture(temp);
+	}
+
 	GHITexture* FDX11IGHIComputeCommandCotext::CreateTextureByAnother(GHITexture * tex)
 	{
             FDX11GHITexture *res = ResourceCast(tex);
@@ -59,6 +92,56 @@ namespace GHI
 			}
 	}
 
+	// Resources usage. https://msdn.microsoft.com/en-us/library/windows/desktop/ff476259(v=vs.85).aspx
+	GHIReadbackTicket FDX11IGHIComputeCommandCotext::ReadTextureAsync(GHITexture *tex)
+	{
+		FDX11GHITexture *res = ResourceCast(tex);
+		if (!res || !res->rawTexture)
+			return 0;
+
+		D3D11_TEXTURE2D_DESC desc;
+		res->rawTexture->GetDesc(&desc);
+		GHIStagingKey key = { desc.Width, desc.Height, res->format };
+		ID3D11Texture2D *staging = nullptr;
+		if (!mReadbacks.Acquire(key, staging))
+		{
+			desc.MipLevels = 1;
+			desc.Usage = D3D11_USAGE_STAGING; // Support data copy from GPU to CPU.
+			desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+			desc.BindFlags = 0;
+			desc.MiscFlags = 0;
+			DXCall(DX11::Device()->CreateTexture2D(&desc, NULL, &staging));
+		}
+
+		// Only queued here, Map() in PollReadback is where the CPU would wait for it.
+		mQueries.BeginEvent();
+		DX11::ImmediateContext()->CopySubresourceRegion(staging, 0, 0, 0, 0, res->rawTexture, 0, nullptr);
+		mQueries.EndEvent();
+		return mReadbacks.Track(key, staging);
+	}
+
+	EReadbackStatus FDX11IGHIComputeCommandCotext::PollReadback(GHIReadbackTicket ticket, GHIReadbackData &data, bool wait)
+	{
+		TGHIStagingPool<ID3D11Texture2D*>::InFlight *readback = mReadbacks.Find(ticket);
+		if (!readback)
+			return EReadbackStatus::Invalid;
+
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		HRESULT hr = DX11::ImmediateContext()->Map(readback->staging, 0, D3D11_MAP_READ, wait ? 0 : D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+		if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+			return EReadbackStatus::Pending;
+		if (FAILED(hr))
+		{
+			mReadbacks.Complete(ticket);
+			return EReadbackStatus::Invalid;
+		}
+
+		CopyReadbackRows(data, readback->key, (const uint8_t*)mapped.pData, mapped.RowPitch);
+		DX11::ImmediateContext()->Unmap(readback->staging, 0);
+		mReadbacks.Complete(ticket);
+		return EReadbackStatus::Ready;
+	}
+
     void FDX11IGHIComputeCommandCotext::SetViewport(GHIViewport viewport)
     {
         D3D11_VIEWPORT vp;
@@ -73,19 +156,33 @@ namespace GHI
     }
 
 
-    static bool BuildComputeShader(LPCWSTR filename, LPCSTR entrypoint, ID3D11ComputeShader** computeShader,ID3DBlob** pBlob,ID3DBlob** pErrorBlob )
+    static DWORD ComputeShaderFlags()
     {
         DWORD dwShaderFlags = D3DCOMPILE_ENABLE_STRICTNESS;
     #if defined( _DEBUG )
         dwShaderFlags |= D3DCOMPILE_DEBUG;
     #endif
+        return dwShaderFlags;
+    }
+
+    static LPCSTR ComputeShaderTarget()
+    {
+        return (DX11::Device()->GetFeatureLevel() >= D3D_FEATURE_LEVEL_11_0) ? "cs_5_0" : "cs_4_0";
+    }
 
-        LPCSTR pTarget = (DX11::Device()->GetFeatureLevel() >= D3D_FEATURE_LEVEL_11_0) ? "cs_5_0" : "cs_4_0";
-		if (!SUCCEEDED(D3DCompileFromFile(filename, NULL, NULL, entrypoint, pTarget, dwShaderFlags, NULL, pBlob, pErrorBlob)))
+    static bool CompileComputeShader(LPCWSTR filename, LPCSTR entrypoint, const std::vector<ShaderDefine> &defines, ID3DBlob** pBlob, ID3DBlob** pErrorBlob)
+    {
+        std::vector<D3D_SHADER_MACRO> macros;
+        for (const ShaderDefine &define : defines)
+        {
+            macros.push_back({ define.name.c_str(), define.value.c_str() });
+        }
+        macros.push_back({ nullptr, nullptr });
+		if (!SUCCEEDED(D3DCompileFromFile(filename, macros.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE, entrypoint, ComputeShaderTarget(), ComputeShaderFlags(), NULL, pBlob, pErrorBlob)))
 		{
-			DLOG("Shader Compile Error: %s", (char*)((*pErrorBlob)->GetBufferPointer()) );
+			DLOG("Shader Compile Error: %s", *pErrorBlob ? (char*)((*pErrorBlob)->GetBufferPointer()) : "file not found");
+			return false;
 		}
-	    DXCall(DX11::Device()->CreateComputeShader((*pBlob)->GetBufferPointer(), (*pBlob)->GetBufferSize(), NULL, computeShader));
 	    return true;
     }
 
@@ -119,52 +216,73 @@ namespace GHI
         return true;
     }
 
-    static void EnumRelection(GHIShader *shader)
+    static void ReflectShader(ShaderInfo &info)
     {
         ID3D11ShaderReflection* reflection = nullptr;
-        D3DReflect(shader->info.bytecode.data(), shader->info.bytecode.size(), IID_ID3D11ShaderReflection, (void**)&reflection);
+        if (FAILED(D3DReflect(info.bytecode.data(), info.bytecode.size(), IID_ID3D11ShaderReflection, (void**)&reflection)))
+        {
+            return;
+        }
 
         D3D11_SHADER_DESC desc;
         reflection->GetDesc(&desc);
+        reflection->GetThreadGroupSize(&info.reflection.threadGroupSize[0], &info.reflection.threadGroupSize[1], &info.reflection.threadGroupSize[2]);
+
+        for (unsigned int k = 0; k < desc.BoundResources; ++k)
+        {
+            D3D11_SHADER_INPUT_BIND_DESC ibdesc;
+            reflection->GetResourceBindingDesc(k, &ibdesc);
+            ShaderBindingInfo binding;
+            binding.name = ibdesc.Name;
+            binding.type = ibdesc.Type;
+            binding.bindPoint = ibdesc.BindPoint;
+            binding.bindCount = ibdesc.BindCount;
+            info.reflection.bindings.push_back(binding);
+        }
 
-        DLOG("Shader file:%s",shader->info.shaderfile.c_str());
         for (unsigned int i = 0; i < desc.ConstantBuffers; ++i)
         {
-            unsigned int register_index = 0;
             ID3D11ShaderReflectionConstantBuffer* cb = reflection->GetConstantBufferByIndex(i);
             D3D11_SHADER_BUFFER_DESC cbDesc;
             cb->GetDesc(&cbDesc);
+            ShaderConstantBufferInfo cbInfo;
+            cbInfo.name = cbDesc.Name;
+            cbInfo.size = cbDesc.Size;
+            for (unsigned int j = 0; j < cbDesc.Variables; ++j)
+            {
+                ID3D11ShaderReflectionVariable* variable = cb->GetVariableByIndex(j);
+                D3D11_SHADER_VARIABLE_DESC vdesc;
+                variable->GetDesc(&vdesc);
+                ShaderVariableInfo vInfo;
+                vInfo.name = vdesc.Name;
+                vInfo.offset = vdesc.StartOffset;
+                vInfo.size = vdesc.Size;
+                cbInfo.variables.push_back(vInfo);
+            }
+            info.reflection.constantBuffers.push_back(cbInfo);
+        }
+        reflection->Release();
+    }
 
-            for (unsigned int k = 0; k < desc.BoundResources; ++k)
+    static void EnumRelection(GHIShader *shader)
+    {
+        const ShaderReflectionInfo &reflection = shader->info.reflection;
+        DLOG("Shader file:%s",shader->info.shaderfile.c_str());
+        DLOG("\tthread group:%u %u %u", reflection.threadGroupSize[0], reflection.threadGroupSize[1], reflection.threadGroupSize[2]);
+        for (const ShaderBindingInfo &binding : reflection.bindings)
+        {
+            DLOG("\tparam name:%s",binding.name.c_str());
+            DLOG("\tbind point:%d",binding.bindPoint);
+            DLOG("\tbind count:%d",binding.bindCount);
+            DLOG("\tparam type:%d",binding.type);
+        }
+        for (const ShaderConstantBufferInfo &cb : reflection.constantBuffers)
+        {
+            for (const ShaderVariableInfo &variable : cb.variables)
             {
-                D3D11_SHADER_INPUT_BIND_DESC ibdesc;
-                reflection->GetResourceBindingDesc(k, &ibdesc);
-
-                DLOG("\tparam name:%s",ibdesc.Name);
-                DLOG("\tbind point:%d",ibdesc.BindPoint);
-                DLOG("\tbind count:%d",ibdesc.BindCount);
-                DLOG("\tparam type:%d",ibdesc.Type);
-                if (!strcmp(ibdesc.Name, cbDesc.Name))
-                {
-                    register_index = ibdesc.BindPoint;
-                    for (unsigned int j = 0; j < cbDesc.Variables; ++j)
-                    {
-                        ID3D11ShaderReflectionVariable* variable = cb->GetVariableByIndex(j);
-                        D3D11_SHADER_VARIABLE_DESC vdesc;
-                        variable->GetDesc(&vdesc);
-                        DLOG("\tvariable name:%s", vdesc.Name);
-                        DLOG("\tstart offset:%d", vdesc.StartOffset);
-                        DLOG("\tvariable size:%d", vdesc.Size);
-#if 0
-                        ShaderVariable* shadervariable = new ShaderVariable();
-                        shadervariable->name = Engine::String.ConvertToWideStr(vdesc.Name);
-                        shadervariable->length = vdesc.Size;
-                        shadervariable->offset = vdesc.StartOffset;
-                        mSize += vdesc.Size;
-                        mVariables.push_back(shadervariable);
-#endif
-                    }
-                }
+                DLOG("\tvariable name:%s", variable.name.c_str());
+                DLOG("\tstart offset:%d", variable.offset);
+                DLOG("\tvariable size:%d", variable.size);
             }
         }
     }
@@ -198,38 +316,42 @@ namespace GHI
 		return shader;
     }
 
-    GHIShader* FDX11IGHIComputeCommandCotext::CreateComputeShader(std::string file)
+    GHIShader* FDX11IGHIComputeCommandCotext::CreateComputeShader(const ShaderKey &key)
     {
-        std::wstring wfile = StrToWstr(file.c_str());
-		std::string entrypoint = "CSMain";
+        ShaderInfo info;
+        info.shaderfile = key.File();
+        info.entrypoint = key.Entrypoint();
+        info.shaderstage = EShaderStage::CS;
+        info.defines = key.Defines();
+
+        // Cold start compiles and stores, later starts only read the bytecode back.
+        ShaderDiskCache &diskCache = *mDiskCache;
+        uint64_t diskKey = diskCache.Key(key, ComputeShaderTarget(), ComputeShaderFlags());
+        if (!diskCache.Load(diskKey, info))
+        {
+            std::wstring wfile = StrToWstr(info.shaderfile.c_str());
+            ID3DBlob* pErrorBlob = nullptr;
+            ID3DBlob* pBlob = nullptr;
+            bool compiled = CompileComputeShader(wfile.c_str(), info.entrypoint.c_str(), info.defines, &pBlob, &pErrorBlob);
+            if (pErrorBlob) pErrorBlob->Release();
+            if (!compiled) return nullptr;
+            info.bytecode = std::string((char*)(pBlob->GetBufferPointer()), pBlob->GetBufferSize());
+            pBlob->Release();
+            ReflectShader(info);
+            diskCache.Store(diskKey, info);
+        }
+
         ID3D11ComputeShader *csPtr = nullptr;
-        ID3DBlob* pErrorBlob = nullptr;
-        ID3DBlob* pBlob = nullptr;
-        if (!BuildComputeShader(wfile.c_str(), entrypoint.c_str(), &csPtr, &pBlob, &pErrorBlob)) return nullptr;
+        DXCall(DX11::Device()->CreateComputeShader(info.bytecode.data(), info.bytecode.size(), NULL, &csPtr));
         GHIShader *shader = new FDX11GHIComputeShader(csPtr);
-		shader->info.shaderfile = file;
-		shader->info.entrypoint = entrypoint;
-        shader->info.shaderstage = EShaderStage::CS;
-		shader->info.bytecode += std::string((char*)(pBlob->GetBufferPointer()), pBlob->GetBufferSize());
+		shader->info = info;
         EnumRelection(shader);
 		return shader;
     }
 
 	GHIShader* FDX11IGHIComputeCommandCotext::CreateShader(std::string file)
 	{
-        std::wstring wfile = StrToWstr(file.c_str());
-		std::string entrypoint = "CSMain";
-        ID3D11ComputeShader *csPtr = nullptr;
-        ID3DBlob* pErrorBlob = nullptr;
-        ID3DBlob* pBlob = nullptr;
-        BuildComputeShader(wfile.c_str(), entrypoint.c_str(), &csPtr, &pBlob, &pErrorBlob);
-        GHIShader *shader = new FDX11GHIComputeShader(csPtr);
-		shader->info.shaderfile = file;
-		shader->info.entrypoint = entrypoint;
-        shader->info.shaderstage = EShaderStage::CS;
-		shader->info.bytecode += std::string((char*)(pBlob->GetBufferPointer()), pBlob->GetBufferSize());
-        EnumRelection(shader);
-		return shader;
+        return CreateComputeShader(file);
 	}
 
     void FDX11IGHIComputeCommandCotext::SetShader(GHIShader* shader)
@@ -242,7 +364,8 @@ namespace GHI
                 return;
             }
 
-            DX11::ImmediateContext()->CSSetShader(cs->rawPtr, nullptr, 0);
+            if (mStateShadow.Bind(EShaderStage::CS, EBindKind::Shader, 0, cs->rawPtr))
+                DX11::ImmediateContext()->CSSetShader(cs->rawPtr, nullptr, 0);
         }
         else if (shader && shader->info.shaderstage == EShaderStage::VS)
         {
@@ -252,7 +375,8 @@ namespace GHI
                 return;
             }
 
-            DX11::ImmediateContext()->VSSetShader(vs->rawPtr, nullptr, 0);
+            if (mStateShadow.Bind(EShaderStage::VS, EBindKind::Shader, 0, vs->rawPtr))
+                DX11::ImmediateContext()->VSSetShader(vs->rawPtr, nullptr, 0);
         }
         else if (shader && shader->info.shaderstage == EShaderStage::PS)
         {
@@ -262,7 +386,8 @@ namespace GHI
                 return;
             }
 
-            DX11::ImmediateContext()->PSSetShader(ps->rawPtr, nullptr, 0);
+            if (mStateShadow.Bind(EShaderStage::PS, EBindKind::Shader, 0, ps->rawPtr))
+                DX11::ImmediateContext()->PSSetShader(ps->rawPtr, nullptr, 0);
         }
 
     }
@@ -10,8 +10,10 @@
 #include "GHIResources.h" 
 #include "GHICommandContext.h" 
 #include "FDX11GHIResources.h" 
+#include "FDX11GHIProfiler.h" 
 #include "Exceptions.h" 
 #include "DX11.h" 
+#include "ShaderDiskCache.h" 
 
 namespace GHI
 {
@@ -37,18 +39,57 @@ namespace GHI
 
 	class FDX11IGHIComputeCommandCotext: public IGHIComputeCommandCotext
 	{
+		FDX11GHIQueryProfiler mQueries;
+		TGHIStagingPool<ID3D11Texture2D*> mReadbacks;
+		ShaderDiskCache *mDiskCache = &ShaderDiskCache::Global();
 
 	public:
+		FDX11IGHIComputeCommandCotext()
+			: mQueries(mProfiler)
+		{
+		}
+		virtual ~FDX11IGHIComputeCommandCotext()
+		{
+			mReadbacks.Clear([](ID3D11Texture2D *staging) { staging->Release(); });
+		}
+
+		//! Compiled shaders are read from and stored into cache, ShaderDiskCache::Global() by default.
+		void SetShaderDiskCache(ShaderDiskCache *cache)
+		{
+			mDiskCache = cache ? cache : &ShaderDiskCache::Global();
+		}
+
 		virtual void SetShaderResource(GHITexture *resource, int slot, GHISRVParam view, EShaderStage stage = EShaderStage::CS) override
 		{
 			FDX11GHITexture *res = ResourceCast(resource);
 			if (res)
 			{
                 res->view->CreateSRV(view);
+                if (stage != EShaderStage::CS && stage != EShaderStage::PS)
+                    return;
+
+                // Still bound for output, the API would force the SRV to null instead of unbinding the UAV.
+                // Mips are separate subresources : a UAV of a mip the SRV does not read stays.
+                ID3D11ShaderResourceView *srv = res->SRV(view);
+                uint32_t srvFirst, srvEnd;
+                res->ViewMips(srv, srvFirst, srvEnd);
+                for (int uavSlot = -1; (uavSlot = mStateShadow.FindResource(EShaderStage::CS, EBindKind::UAV, res, uavSlot + 1)) >= 0;)
+                {
+                    uint32_t uavMip, uavEnd;
+                    res->ViewMips(mStateShadow.Object(EShaderStage::CS, EBindKind::UAV, uavSlot), uavMip, uavEnd);
+                    if (uavMip < srvFirst || uavMip >= srvEnd)
+                        continue;
+                    ID3D11UnorderedAccessView *nullUAV = nullptr;
+                    mStateShadow.Bind(EShaderStage::CS, EBindKind::UAV, uavSlot, nullptr);
+                    DX11::ImmediateContext()->CSSetUnorderedAccessViews(uavSlot, 1, &nullUAV, nullptr);
+                }
+
+                if (!mStateShadow.Bind(stage, EBindKind::SRV, slot, srv, res))
+                    return;
                 if (stage==EShaderStage::CS)
-                    DX11::ImmediateContext()->CSSetShaderResources(slot, 1, &res->rawSRV);
+                    DX11::ImmediateContext()->CSSetShaderResources(slot, 1, &srv);
                 else if (stage==EShaderStage::PS) 
-                    DX11::ImmediateContext()->PSSetShaderResources(slot, 1, &res->rawSRV);
+                    DX11::ImmediateContext()->PSSetShaderResources(slot, 1, &srv);
 
 			}
             else
@@ -64,8 +105,24 @@ namespace GHI
 			if (res)
 			{
                 res->view->CreateUAV(view);
-                if (stage==EShaderStage::CS)
-                    DX11::ImmediateContext()->CSSetUnorderedAccessViews(slot, 1, &(res->rawUAV), nullptr);
+                ID3D11UnorderedAccessView *uav = res->UAV(view);
+                if (stage==EShaderStage::CS && mStateShadow.Bind(stage, EBindKind::UAV, slot, uav, res))
+                {
+                    DX11::ImmediateContext()->CSSetUnorderedAccessViews(slot, 1, &uav, nullptr);
+                    // The API unbinds the resource from every SRV slot that read the mip written.
+                    const uint32_t mip = view.MostDetailedMip;
+                    for (int stageIndex = 0; stageIndex < ShaderStageNum; ++stageIndex)
+                    {
+                        const EShaderStage srvStage = EShaderStage(stageIndex);
+                        for (int srvSlot = -1; (srvSlot = mStateShadow.FindResource(srvStage, EBindKind::SRV, res, srvSlot + 1)) >= 0;)
+                        {
+                            uint32_t first, end;
+                            res->ViewMips(mStateShadow.Object(srvStage, EBindKind::SRV, srvSlot), first, end);
+                            if (mip >= first && mip < end)
+                                mStateShadow.Forget(srvStage, EBindKind::SRV, srvSlot);
+                        }
+                    }
+                }
 			}
             else
             {
@@ -79,7 +136,8 @@ namespace GHI
 			FDX11GHIBuffer *res = ResourceCast(resource);
 			if (res)
 			{
-                DX11::ImmediateContext()->CSSetConstantBuffers(slot, 1, &res->rawBuffer);
+                if (mStateShadow.Bind(EShaderStage::CS, EBindKind::ConstBuffer, slot, res->rawBuffer))
+                    DX11::ImmediateContext()->CSSetConstantBuffers(slot, 1, &res->rawBuffer);
 			}
             else
             {
@@ -134,6 +192,8 @@ namespace GHI
             FDX11GHISampler *res = ResourceCast(resource);
             if (res)
             {
+                if (!mStateShadow.Bind(stage, EBindKind::Sampler, slot, res->rawSampler))
+                    return;
 				if (EShaderStage::CS == stage)
 					DX11::ImmediateContext()->CSSetSamplers(slot, 1, &(res->rawSampler) );
 				else if (EShaderStage::PS == stage)
@@ -147,12 +207,17 @@ namespace GHI
 		}
 
         virtual GHITexture* CreateTexture(std::string filename) override;
+        virtual GHITexture* CreateTexture(const TextureDesc2D &desc, const void* initData = nullptr) override;
         virtual GHITexture* CreateTextureByAnother(GHITexture * tex) override;
 		virtual void CopyTexture(GHITexture *dst, GHITexture *src) override;
+		virtual GHIReadbackTicket ReadTextureAsync(GHITexture *tex) override;
+		virtual EReadbackStatus PollReadback(GHIReadbackTicket ticket, GHIReadbackData &data, bool wait = false) override;
 
         virtual void Dispatch(int nX, int nY, int nZ) override
         {
+            mQueries.BeginEvent();
             DX11::ImmediateContext()->Dispatch( nX, nY, nZ);
+            mQueries.EndEvent();
         }
 
 		virtual void setPrimitiveTopology(PrimitiveTopology topology) override;
@@ -161,8 +226,22 @@ namespace GHI
 
         virtual GHIVertexShader*  CreateVertexShader(std::string file, std::string entrypoint) override;
         virtual GHIPixelShader*   CreatePixelShader(std::string file, std::string entrypoint) override;
-        virtual GHIShader* CreateComputeShader(std::string file) override;
+        virtual GHIShader* CreateComputeShader(const ShaderKey &key) override;
+        using IGHIComputeCommandCotext::CreateComputeShader;
         virtual GHIShader* CreateShader(std::string file) override;
         virtual void SetShader(GHIShader* shader) override;
+
+        virtual void BeginProfile(const std::string &scope, uint64_t pixels) override
+        {
+            mQueries.BeginScope(scope, pixels);
+        }
+        virtual void EndProfile() override
+        {
+            mQueries.EndScope();
+        }
+        virtual void ResolveProfile() override
+        {
+            mQueries.EndFrame();
+        }
 	};
 }
\ No newline at end of file
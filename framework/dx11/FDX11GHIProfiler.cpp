@@ -0,0 +1,132 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "FDX11GHIProfiler.h"
+#include "Exceptions.h"
+
+namespace GHI
+{
+    FDX11GHIQueryProfiler::~FDX11GHIQueryProfiler()
+    {
+        for (Frame &frame : mFrames)
+        {
+            if (frame.disjoint)
+                frame.disjoint->Release();
+            for (ID3D11Query *query : frame.timestamps)
+                query->Release();
+        }
+    }
+
+    ID3D11Query* FDX11GHIQueryProfiler::NextTimestamp(Frame &frame)
+    {
+        if (frame.used == frame.timestamps.size())
+        {
+            D3D11_QUERY_DESC desc = { D3D11_QUERY_TIMESTAMP, 0 };
+            ID3D11Query *query = nullptr;
+            DXCall(DX11::Device()->CreateQuery(&desc, &query));
+            frame.timestamps.push_back(query);
+        }
+        return frame.timestamps[frame.used++];
+    }
+
+    void FDX11GHIQueryProfiler::BeginScope(const std::string &scope, uint64_t pixels)
+    {
+        Frame &frame = mFrames[mCurrent];
+        if (!frame.open)
+        {
+            // The ring wrapped around before the GPU finished this slot.
+            if (frame.pending)
+                Collect(frame, true);
+            if (!frame.disjoint)
+            {
+                D3D11_QUERY_DESC desc = { D3D11_QUERY_TIMESTAMP_DISJOINT, 0 };
+                DXCall(DX11::Device()->CreateQuery(&desc, &frame.disjoint));
+            }
+            DX11::ImmediateContext()->Begin(frame.disjoint);
+            frame.open = true;
+        }
+        frame.scopes.push_back({ scope, pixels, frame.used, 0 });
+        mInScope = true;
+    }
+
+    void FDX11GHIQueryProfiler::EndScope()
+    {
+        mInScope = false;
+    }
+
+    void FDX11GHIQueryProfiler::BeginEvent()
+    {
+        if (mInScope)
+            DX11::ImmediateContext()->End(NextTimestamp(mFrames[mCurrent]));
+    }
+
+    void FDX11GHIQueryProfiler::EndEvent()
+    {
+        if (mInScope)
+        {
+            Frame &frame = mFrames[mCurrent];
+            DX11::ImmediateContext()->End(NextTimestamp(frame));
+            frame.scopes.back().numEvents++;
+        }
+    }
+
+    void FDX11GHIQueryProfiler::EndFrame()
+    {
+        Frame &frame = mFrames[mCurrent];
+        if (frame.open)
+        {
+            DX11::ImmediateContext()->End(frame.disjoint);
+            frame.open = false;
+            frame.pending = true;
+            mInScope = false;
+            mCurrent = (mCurrent + 1) % FrameLatency;
+        }
+        for (Frame &f : mFrames)
+        {
+            if (f.pending)
+                Collect(f, false);
+        }
+    }
+
+    bool FDX11GHIQueryProfiler::Collect(Frame &frame, bool wait)
+    {
+        ID3D11DeviceContext *context = DX11::ImmediateContext();
+        const UINT flags = wait ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH;
+
+        D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+        HRESULT hr;
+        while ((hr = context->GetData(frame.disjoint, &disjoint, sizeof(disjoint), flags)) == S_FALSE)
+        {
+            if (!wait)
+                return false;
+        }
+
+        // A disjoint frame (clock change, power event) has meaningless timestamps, drop it.
+        if (SUCCEEDED(hr) && !disjoint.Disjoint)
+        {
+            for (const Scope &scope : frame.scopes)
+            {
+                if (scope.numEvents == 0)
+                    continue;
+                uint64 ticks = 0;
+                for (uint32_t i = 0; i < scope.numEvents; ++i)
+                {
+                    UINT64 begin = 0, end = 0;
+                    while (context->GetData(frame.timestamps[scope.firstQuery + 2 * i], &begin, sizeof(begin), 0) == S_FALSE);
+                    while (context->GetData(frame.timestamps[scope.firstQuery + 2 * i + 1], &end, sizeof(end), 0) == S_FALSE);
+                    ticks += end - begin;
+                }
+                mProfiler.AddSample(scope.name, double(ticks) * 1000. / double(disjoint.Frequency), scope.pixels);
+            }
+        }
+
+        frame.scopes.clear();
+        frame.used = 0;
+        frame.pending = false;
+        return true;
+    }
+}
@@ -0,0 +1,64 @@
+//=================================================================================================
+//
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "GHIProfiler.h"
+#include "DX11.h"
+
+namespace GHI
+{
+    // Timestamp queries around every Dispatch / CopyTexture of a profile scope. Query results
+    // are read back a few frames later without stalling, a frame is only waited for when
+    // its slot in the ring is needed again.
+    class FDX11GHIQueryProfiler
+    {
+    public:
+        static const uint32_t FrameLatency = 4;
+
+        explicit FDX11GHIQueryProfiler(GHIProfiler &profiler)
+            : mProfiler(profiler)
+        {
+        }
+        ~FDX11GHIQueryProfiler();
+
+        void BeginScope(const std::string &scope, uint64_t pixels);
+        void EndScope();
+        void BeginEvent();
+        void EndEvent();
+        void EndFrame();
+
+    private:
+        struct Scope
+        {
+            std::string name;
+            uint64_t pixels;
+            uint32_t firstQuery;
+            uint32_t numEvents;
+        };
+
+        struct Frame
+        {
+            ID3D11Query *disjoint = nullptr;
+            std::vector<ID3D11Query*> timestamps; // begin / end pairs, grows as needed
+            uint32_t used = 0;
+            std::vector<Scope> scopes;
+            bool open = false;
+            bool pending = false;
+        };
+
+        ID3D11Query* NextTimestamp(Frame &frame);
+        bool Collect(Frame &frame, bool wait);
+
+        GHIProfiler &mProfiler;
+        Frame mFrames[FrameLatency];
+        uint32_t mCurrent = 0;
+        bool mInScope = false;
+    };
+}
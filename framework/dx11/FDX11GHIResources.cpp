@@ -24,18 +24,20 @@ namespace GHI
 		DXCall(CreateWICTextureFromFile(DX11::Device(), wName.c_str(), (ID3D11Resource **)&rawTexture, &rawSRV));
 		D3D11_TEXTURE2D_DESC desc;
 		rawTexture->GetDesc(&desc);
-		//AssertMsg_((desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM), "Texutre format != DXGI_FORMAT_R8G8B8A8_UNORM");
-        if (desc.Format != DXGI_FORMAT_R8G8B8A8_UNORM)
+		format = GHIFormatCast(desc.Format);
+        if (format == PixelFormat_UNKNOWN)
         {
             width = height = textureSizeInBytes = 0;
             aspect = 0.;
-            WriteLog("Texutre format != DXGI_FORMAT_R8G8B8A8_UNORM");
+            WriteLog("Texutre format is not one of EPixelFormat");
 			return;
         }
 		width = desc.Width;
 		height = desc.Height;
+		bindFlags = desc.BindFlags;
+		mipLevels = desc.MipLevels;
 		aspect = float(width) / float(height);
-		textureSizeInBytes = desc.Width * desc.Height * 4;
+		textureSizeInBytes = desc.Width * desc.Height * BytesPerPixel(format);
 	}
 
 	void FDX11GHIResourceView::CreateRTV(const GHIRTVParam &param)
@@ -53,35 +55,48 @@ namespace GHI
 	void FDX11GHIResourceView::CreateSRV(const GHISRVParam &param)
 	{
 		FDX11GHITexture *res = ResourceCast(resource);
-		if (res->rawSRV)
+		if (res->SRV(param))
         {
         }
 		else
 		{
+			const GHISRVParam key = res->Normalized(param);
 			D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
 			ZeroMemory(&viewDesc, sizeof(viewDesc));
-			viewDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			viewDesc.Format = DX11FormatCast(key.Format == PixelFormat_UNKNOWN ? res->format : key.Format);
 			viewDesc.ViewDimension = D3D_SRV_DIMENSION_TEXTURE2D;
-			viewDesc.Texture2D.MipLevels = 1;
-			viewDesc.Texture2D.MostDetailedMip = 0;
-			DXCall(DX11::Device()->CreateShaderResourceView(res->rawTexture, &viewDesc, &(res->rawSRV)));
+			viewDesc.Texture2D.MipLevels = key.MipLevels;
+			viewDesc.Texture2D.MostDetailedMip = key.MostDetailedMip;
+			ID3D11ShaderResourceView *srv = nullptr;
+			DXCall(DX11::Device()->CreateShaderResourceView(res->rawTexture, &viewDesc, &srv));
+			if (key == GHISRVParam())
+				res->rawSRV = srv;
+			else
+				res->extraSRVs.emplace_back(key, srv);
         }
 	}
 	void FDX11GHIResourceView::CreateUAV(const GHIUAVParam &param)
 	{
 		FDX11GHITexture *res = ResourceCast(resource);
-		if (res->rawUAV)
+		if (res->UAV(param))
         {
         }
 		else
 		{
+			const GHIUAVParam key = res->Normalized(param);
 			D3D11_UNORDERED_ACCESS_VIEW_DESC descView;
 			ZeroMemory(&descView, sizeof(descView));
 			descView.Texture2D = { 0 };
-			descView.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			descView.Texture2D.MipSlice = key.MostDetailedMip;
+			descView.Format = DX11FormatCast(key.Format == PixelFormat_UNKNOWN ? res->format : key.Format);
 			descView.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
 
-			DXCall(DX11::Device()->CreateUnorderedAccessView(res->rawTexture, &descView, &(res->rawUAV)));
+			ID3D11UnorderedAccessView *uav = nullptr;
+			DXCall(DX11::Device()->CreateUnorderedAccessView(res->rawTexture, &descView, &uav));
+			if (key == GHIUAVParam())
+				res->rawUAV = uav;
+			else
+				res->extraUAVs.emplace_back(key, uav);
         }
 	}
 
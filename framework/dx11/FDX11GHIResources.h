@@ -8,6 +8,8 @@
 #pragma once
 
 #include <string>
+#include <utility>
+#include <vector>
 #include <d3d11.h>
 #include "GHIResources.h" 
 #include "DXassert.h" 
@@ -26,6 +28,57 @@ namespace GHI
         }
     }
 
+    inline DXGI_FORMAT DX11FormatCast(EPixelFormat format)
+    {
+        switch (format)
+        {
+        case PixelFormat_R32G32_FLOAT:
+            return DXGI_FORMAT_R32G32_FLOAT;
+        case PixelFormat_R32_FLOAT:
+            return DXGI_FORMAT_R32_FLOAT;
+        case PixelFormat_R8_UNORM:
+            return DXGI_FORMAT_R8_UNORM;
+        case PixelFormat_R16_FLOAT:
+            return DXGI_FORMAT_R16_FLOAT;
+        case PixelFormat_R16G16B16A16_FLOAT:
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case PixelFormat_R32G32B32A32_UINT:
+            return DXGI_FORMAT_R32G32B32A32_UINT;
+        case PixelFormat_R32G32B32A32_FLOAT:
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        case PixelFormat_UNKNOWN:
+            return DXGI_FORMAT_UNKNOWN;
+        case PixelFormat_R8G8B8A8_UNORM:
+        default:
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+        }
+    }
+
+    inline EPixelFormat GHIFormatCast(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R32G32_FLOAT:
+            return PixelFormat_R32G32_FLOAT;
+        case DXGI_FORMAT_R32_FLOAT:
+            return PixelFormat_R32_FLOAT;
+        case DXGI_FORMAT_R8_UNORM:
+            return PixelFormat_R8_UNORM;
+        case DXGI_FORMAT_R16_FLOAT:
+            return PixelFormat_R16_FLOAT;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            return PixelFormat_R16G16B16A16_FLOAT;
+        case DXGI_FORMAT_R32G32B32A32_UINT:
+            return PixelFormat_R32G32B32A32_UINT;
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            return PixelFormat_R32G32B32A32_FLOAT;
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+            return PixelFormat_R8G8B8A8_UNORM;
+        default:
+            return PixelFormat_UNKNOWN;
+        }
+    }
+
     class FDX11GHIRenderTargetView : public GHIRenderTargetView
     {
 		ID3D11RenderTargetView *raw;
@@ -66,10 +119,22 @@ namespace GHI
 		ID3D11ShaderResourceView *rawSRV = nullptr;
 		ID3D11UnorderedAccessView *rawUAV = nullptr;
 		ID3D11RenderTargetView *rawRTV = nullptr;
+		// Views with other params than the default ones, created on first use.
+		std::vector<std::pair<GHISRVParam, ID3D11ShaderResourceView*>> extraSRVs;
+		std::vector<std::pair<GHIUAVParam, ID3D11UnorderedAccessView*>> extraUAVs;
 
 		FDX11GHITexture(ID3D11Texture2D *tex)
 			: rawTexture(tex)
 		{
+			D3D11_TEXTURE2D_DESC desc;
+			rawTexture->GetDesc(&desc);
+			format = GHIFormatCast(desc.Format);
+			bindFlags = desc.BindFlags;
+			mipLevels = desc.MipLevels;
+			width = desc.Width;
+			height = desc.Height;
+			aspect = float(width) / float(height);
+			textureSizeInBytes = desc.Width * desc.Height * BytesPerPixel(format);
 			view = new FDX11GHIResourceView(this);
             list.push_back(this);
 		}
@@ -86,6 +151,12 @@ namespace GHI
             DXRelease(rawSRV);
             DXRelease(rawUAV);
             DXRelease(rawRTV);
+            for (auto &v : extraSRVs)
+                DXRelease(v.second);
+            for (auto &v : extraUAVs)
+                DXRelease(v.second);
+            extraSRVs.clear();
+            extraUAVs.clear();
             AssertMsg_(rawTexture==nullptr, "Fault, DXRelease()");
             AssertMsg_(rawSRV==nullptr, "Fault, DXRelease()");
             AssertMsg_(rawUAV==nullptr, "Fault, DXRelease()");
@@ -93,6 +164,75 @@ namespace GHI
         }
 
 		void LoadFromFile(std::string filename);
+
+		//! The texture's format spelled out is the default view too.
+		GHISRVParam Normalized(GHISRVParam param) const
+		{
+			param.Format = param.Format == format ? PixelFormat_UNKNOWN : param.Format;
+			return param;
+		}
+		GHIUAVParam Normalized(GHIUAVParam param) const
+		{
+			param.Format = param.Format == format ? PixelFormat_UNKNOWN : param.Format;
+			return param;
+		}
+
+		//! Mips [first, end) the SRV / UAV view reads or writes, empty for a view of another texture.
+		void ViewMips(const void *view, uint32_t &first, uint32_t &end) const
+		{
+			first = end = 0;
+			if (!view)
+				return;
+			if (view == rawSRV || view == rawUAV)
+			{
+				end = view == rawSRV ? mipLevels : 1;
+				return;
+			}
+			for (const auto &v : extraSRVs)
+			{
+				if (v.second == view)
+				{
+					first = v.first.MostDetailedMip;
+					end = v.first.MipLevels == uint32_t(-1) ? mipLevels : first + v.first.MipLevels;
+					return;
+				}
+			}
+			for (const auto &v : extraUAVs)
+			{
+				if (v.second == view)
+				{
+					first = v.first.MostDetailedMip;
+					end = first + 1;
+					return;
+				}
+			}
+		}
+
+		//! View of param once CreateSRV() / CreateUAV() made it, nullptr before.
+		ID3D11ShaderResourceView* SRV(const GHISRVParam &param) const
+		{
+			const GHISRVParam key = Normalized(param);
+			if (key == GHISRVParam())
+				return rawSRV;
+			for (const auto &v : extraSRVs)
+			{
+				if (v.first == key)
+					return v.second;
+			}
+			return nullptr;
+		}
+		ID3D11UnorderedAccessView* UAV(const GHIUAVParam &param) const
+		{
+			const GHIUAVParam key = Normalized(param);
+			if (key == GHIUAVParam())
+				return rawUAV;
+			for (const auto &v : extraUAVs)
+			{
+				if (v.first == key)
+					return v.second;
+			}
+			return nullptr;
+		}
 	};
 
 	class FDX11GHIBuffer: public GHIBuffer 
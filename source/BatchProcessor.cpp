@@ -0,0 +1,426 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <sstream>
+#include "BatchProcessor.h"
+#include "Filter.h"
+#include "ImageIO.h"
+
+namespace fs = std::filesystem;
+
+typedef std::chrono::steady_clock Clock;
+
+static const int MaxTextureSize = 16384; //< D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION
+static const int DefaultTileSize = 4096;
+
+static double Milliseconds(Clock::time_point begin, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+bool IsBatchCommandLine(const std::vector<std::string> &args)
+{
+	return std::find(args.begin(), args.end(), "--batch") != args.end();
+}
+
+std::string BatchUsage()
+{
+	std::string names;
+	for (const std::string &name : FilterNames())
+		names += (names.empty() ? "" : ", ") + name;
+	return "usage: --batch --input <dir> --output <dir> --filters <name>[,<name>..] [--backend dx11|cpu]"
+		 " [--format png|bmp|tga|jpg] [--png-level 0..9] [--threads n] [--depth n] [--fusion on|off] [--tile n]\nfilters: " + names;
+}
+
+bool ParseBatchOptions(const std::vector<std::string> &args, BatchOptions &options, std::string &error)
+{
+	for (size_t i = 0; i < args.size(); ++i)
+	{
+		const std::string &arg = args[i];
+		if (arg == "--batch")
+			continue;
+		if (i + 1 >= args.size())
+		{
+			error = "missing value for " + arg;
+			return false;
+		}
+		const std::string &value = args[++i];
+		if (arg == "--input")
+			options.inputDir = value;
+		else if (arg == "--output")
+			options.outputDir = value;
+		else if (arg == "--backend")
+			options.backend = value;
+		else if (arg == "--format")
+			options.format = value;
+		else if (arg == "--png-level")
+			options.pngLevel = std::max(0, std::min(9, std::atoi(value.c_str())));
+		else if (arg == "--threads")
+			options.ioThreads = uint32_t(std::max(1, std::atoi(value.c_str())));
+		else if (arg == "--depth")
+			options.queueDepth = uint32_t(std::max(1, std::atoi(value.c_str())));
+		else if (arg == "--fusion")
+			options.fusion = value != "off";
+		else if (arg == "--tile")
+			options.tileSize = uint32_t(std::max(0, std::atoi(value.c_str())));
+		else if (arg == "--filters")
+		{
+			std::stringstream ss(value);
+			std::string name;
+			while (std::getline(ss, name, ','))
+			{
+				if (!name.empty())
+					options.filters.push_back(name);
+			}
+		}
+		else
+		{
+			error = "unknown argument " + arg;
+			return false;
+		}
+	}
+
+	if (options.inputDir.empty() || options.outputDir.empty() || options.filters.empty())
+		error = "--input, --output and --filters are required";
+	else if (options.backend != "dx11" && options.backend != "cpu")
+		error = "unknown backend " + options.backend;
+	return error.empty();
+}
+
+struct BatchProcessor::Decoded
+{
+	std::string path;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	GHI::GHIPixelBuffer pixels; //< RGBA8, back to the pool once uploaded
+	double decodeMs = 0.;
+	bool ok = false;
+};
+
+struct BatchProcessor::Encoded
+{
+	std::string path;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	double decodeMs = 0.;
+	double filterMs = 0.;
+	double encodeMs = 0.;
+	bool ok = false;
+};
+
+BatchProcessor::BatchProcessor(GHI::IGHIComputeCommandCotext *commandContext, const BatchOptions &options)
+	: mContext(commandContext)
+	, mOptions(options)
+	, mIOPool(options.ioThreads)
+{
+}
+
+BatchProcessor::~BatchProcessor()
+{
+	mContext->TexturePool().Release(mResult);
+	for (Filter *filter : mFilters)
+		delete filter;
+}
+
+bool BatchProcessor::InitFilters()
+{
+	// Clamped, a wrapping sampler would read the opposite border of a tile instead of the
+	// opposite border of the image.
+	GHI::GHISamplerDesc desc;
+	desc.AddressU = desc.AddressV = desc.AddressW = GHI::TextureAddressMode::CLAMP;
+	mSampler = mContext->CreateSampler(desc);
+	for (const std::string &name : mOptions.filters)
+	{
+		Filter *filter = CreateFilter(name);
+		if (!filter)
+		{
+			std::fprintf(stderr, "- [Error] unknown filter '%s'\n%s\n", name.c_str(), BatchUsage().c_str());
+			return false;
+		}
+		filter->Init(mContext);
+		filter->setSampler(mSampler);
+		mFilters.push_back(filter);
+	}
+
+	std::vector<int> chain;
+	for (Filter *filter : mFilters)
+		chain.push_back(mGraph.AddNode(filter));
+	mGraph.SetFusion(mOptions.fusion);
+	return mGraph.ConnectChain(chain);
+}
+
+GHI::GHITexture* BatchProcessor::Target(GHI::GHITexture *like)
+{
+	if (!mResult || mResult->width != like->width || mResult->height != like->height)
+	{
+		mContext->TexturePool().Release(mResult);
+		mResult = mContext->TexturePool().AcquireLike(like);
+	}
+	return mResult;
+}
+
+GHI::GHITexture* BatchProcessor::RunChain(GHI::GHITexture *input)
+{
+	// Intermediates alias within the graph, only the last filter writes the result.
+	GHI::GHITexture *output = Target(input);
+	return mGraph.Execute(mContext, input, output) ? output : nullptr;
+}
+
+bool BatchProcessor::RunTiled(const Decoded &image, GHI::GHIReadbackData &result)
+{
+	const int width = int(image.width);
+	const int height = int(image.height);
+	const int tileSize = mOptions.tileSize ? int(mOptions.tileSize) : DefaultTileSize;
+	result.width = image.width;
+	result.height = image.height;
+	result.rowPitch = image.width * 4;
+	result.pixels.resize(size_t(result.rowPitch) * height);
+
+	GHI::GHITexturePool &pool = mContext->TexturePool();
+	std::vector<uint8_t> upload;
+	std::vector<uint8_t> filtered;
+	for (int y = 0; y < height; y += tileSize)
+	{
+		for (int x = 0; x < width; x += tileSize)
+		{
+			const ImageRect output = { x, y, std::min(x + tileSize, width), std::min(y + tileSize, height) };
+			const ImageRect rect = mGraph.TileRect(output, width, height);
+			if (rect.Width() > MaxTextureSize || rect.Height() > MaxTextureSize)
+			{
+				std::fprintf(stderr, "- [Error] %s: a %dx%d tile reads %dx%d pixels, more than a texture holds, try a smaller --tile\n",
+					image.path.c_str(), output.Width(), output.Height(), rect.Width(), rect.Height());
+				return false;
+			}
+
+			const size_t rowBytes = size_t(rect.Width()) * 4;
+			upload.resize(rowBytes * rect.Height());
+			for (int row = rect.y0; row < rect.y1; ++row)
+				memcpy(&upload[(row - rect.y0) * rowBytes], image.pixels.Data() + (size_t(row) * width + rect.x0) * 4, rowBytes);
+
+			GHI::TextureDesc2D desc;
+			desc.Width = rect.Width();
+			desc.Height = rect.Height();
+			GHI::GHITexture *source = pool.Adopt(mContext->CreateTexture(desc, upload.data()));
+			GHI::GHITexture *target = pool.AcquireLike(source);
+			const ImageTile tile = { rect.x0, rect.y0, image.width, image.height };
+			filtered.resize(upload.size());
+			const bool ok = source && target && mGraph.Execute(mContext, source, target, &tile) && mContext->ReadTexture(target, filtered.data());
+			pool.Release(source);
+			pool.Release(target);
+			mContext->ResolveProfile();
+			if (!ok)
+				return false;
+
+			// Only the pixels of the tile itself are exact, the margin around it is dropped.
+			for (int row = output.y0; row < output.y1; ++row)
+			{
+				memcpy(&result.pixels[(size_t(row) * width + output.x0) * 4],
+					&filtered[(row - rect.y0) * rowBytes + size_t(output.x0 - rect.x0) * 4], size_t(output.Width()) * 4);
+			}
+		}
+	}
+	return true;
+}
+
+int BatchProcessor::Run()
+{
+	if (!InitFilters())
+		return -1;
+
+	std::vector<std::string> files;
+	std::error_code ec;
+	for (fs::directory_iterator it(mOptions.inputDir, ec), end; !ec && it != end; it.increment(ec))
+	{
+		if (it->is_regular_file() && IsImageFile(it->path().string()))
+			files.push_back(it->path().string());
+	}
+	if (ec)
+	{
+		std::fprintf(stderr, "- [Error] can not list '%s': %s\n", mOptions.inputDir.c_str(), ec.message().c_str());
+		return -1;
+	}
+	std::sort(files.begin(), files.end());
+	fs::create_directories(mOptions.outputDir, ec);
+
+	std::printf("batch: %zu images, backend %s, filters", files.size(), mOptions.backend.c_str());
+	for (const std::string &name : mOptions.filters)
+		std::printf(" %s", name.c_str());
+	std::printf("\n");
+
+	int failures = 0;
+	uint64_t totalPixels = 0;
+	double totalFilterMs = 0.;
+	auto report = [&](const Encoded &e)
+	{
+		if (!e.ok)
+		{
+			std::printf("  FAILED %s\n", e.path.c_str());
+			++failures;
+			return;
+		}
+		const double mpix = double(e.width) * e.height / 1e6;
+		std::printf("  %s %ux%u decode %.2f ms, filter %.2f ms (%.1f MPixel/s), encode %.2f ms\n",
+			e.path.c_str(), e.width, e.height, e.decodeMs, e.filterMs, e.filterMs > 0. ? mpix * 1000. / e.filterMs : 0., e.encodeMs);
+		totalPixels += uint64_t(e.width) * e.height;
+		totalFilterMs += e.filterMs;
+	};
+
+	auto decode = [](std::string path)
+	{
+		Decoded d;
+		d.path = path;
+		Clock::time_point t0 = Clock::now();
+		DecodedImage image;
+		d.ok = LoadImageRGBA8(path, image);
+		d.width = image.width;
+		d.height = image.height;
+		d.pixels = std::move(image.pixels);
+		d.decodeMs = Milliseconds(t0, Clock::now());
+		return d;
+	};
+
+	// The result of the previous image, its readback overlaps with the upload of the next one.
+	struct Readback
+	{
+		Encoded e;
+		std::string output;
+		GHI::GHIReadbackTicket ticket = 0;
+	} pending;
+
+	std::deque<std::future<Encoded>> encodes;
+	auto encode = [&](const Encoded &e, const std::string &output, std::shared_ptr<GHI::GHIReadbackData> data)
+	{
+		encodes.push_back(mIOPool.Submit([e = e, output, data, level = mOptions.pngLevel]() mutable
+		{
+			Clock::time_point t0 = Clock::now();
+			e.ok = SaveImageRGBA8(output, data->width, data->height, data->pixels.data(), level);
+			e.encodeMs = Milliseconds(t0, Clock::now());
+			return e;
+		}));
+		while (encodes.size() > mOptions.queueDepth)
+		{
+			report(encodes.front().get());
+			encodes.pop_front();
+		}
+	};
+	auto finishReadback = [&]()
+	{
+		if (pending.ticket == 0)
+			return;
+		Clock::time_point t0 = Clock::now();
+		std::shared_ptr<GHI::GHIReadbackData> data = std::make_shared<GHI::GHIReadbackData>();
+		bool ok = mContext->PollReadback(pending.ticket, *data, true) == GHI::EReadbackStatus::Ready;
+		mContext->ResolveProfile();
+		pending.ticket = 0;
+		pending.e.filterMs += Milliseconds(t0, Clock::now());
+		if (!ok)
+		{
+			report(pending.e);
+			return;
+		}
+		encode(pending.e, pending.output, data);
+	};
+
+	const Clock::time_point start = Clock::now();
+	std::deque<std::future<Decoded>> decodes;
+	size_t nextFile = 0;
+	GHI::GHITexture *source = nullptr;
+
+	while (nextFile < files.size() || !decodes.empty())
+	{
+		// Keep the decode stage queueDepth images ahead of the filter stage.
+		while (nextFile < files.size() && decodes.size() < mOptions.queueDepth)
+		{
+			std::string path = files[nextFile++];
+			decodes.push_back(mIOPool.Submit([decode, path]() { return decode(path); }));
+		}
+
+		Decoded d = decodes.front().get();
+		decodes.pop_front();
+
+		Encoded e;
+		e.path = d.path;
+		e.width = d.width;
+		e.height = d.height;
+		e.decodeMs = d.decodeMs;
+		if (!d.ok)
+		{
+			report(e);
+			continue;
+		}
+		const std::string output = (fs::path(mOptions.outputDir) / fs::path(d.path).stem()).string() + "." + mOptions.format;
+
+		const uint32_t tileLimit = mOptions.tileSize ? mOptions.tileSize : MaxTextureSize;
+		if (d.width > tileLimit || d.height > tileLimit)
+		{
+			finishReadback();
+			Clock::time_point t0 = Clock::now();
+			std::shared_ptr<GHI::GHIReadbackData> data = std::make_shared<GHI::GHIReadbackData>();
+			const bool ok = RunTiled(d, *data);
+			e.filterMs = Milliseconds(t0, Clock::now());
+			if (ok)
+				encode(e, output, data);
+			else
+				report(e);
+			continue;
+		}
+
+		Clock::time_point t0 = Clock::now();
+		GHI::TextureDesc2D desc;
+		desc.Width = d.width;
+		desc.Height = d.height;
+		mContext->TexturePool().Release(source);
+		source = mContext->TexturePool().Adopt(mContext->CreateTexture(desc, d.pixels.Data()));
+		d.pixels.Reset();
+		e.filterMs = Milliseconds(t0, Clock::now());
+
+		// The chain writes the texture the previous result is read from.
+		finishReadback();
+
+		t0 = Clock::now();
+		GHI::GHITexture *result = RunChain(source);
+		pending.ticket = result ? mContext->ReadTextureAsync(result) : 0;
+		pending.output = output;
+		e.filterMs += Milliseconds(t0, Clock::now());
+		pending.e = e;
+		if (pending.ticket == 0)
+			report(e);
+	}
+	finishReadback();
+	mContext->TexturePool().Release(source);
+	while (!encodes.empty())
+	{
+		report(encodes.front().get());
+		encodes.pop_front();
+	}
+
+	const double wallMs = Milliseconds(start, Clock::now());
+	const size_t done = files.size() - failures;
+	std::printf("total: %zu images, %d failed, %.2f s, %.2f images/s, %.1f MPixel/s end to end, %.1f MPixel/s filter stage\n",
+		done, failures, wallMs / 1000., wallMs > 0. ? done * 1000. / wallMs : 0.,
+		wallMs > 0. ? totalPixels / (wallMs * 1000.) : 0., totalFilterMs > 0. ? totalPixels / (totalFilterMs * 1000.) : 0.);
+	for (const GHI::GHIProfileStats &s : mContext->Profiler().Stats())
+	{
+		std::printf("  %s: mean %.3f ms, p95 %.3f ms, p99 %.3f ms, %.1f MPixel/s\n", s.scope.c_str(), s.meanMs, s.p95Ms, s.p99Ms, s.megaPixelsPerSecond);
+	}
+	const GHI::GHIStateCounters &state = mContext->StateShadow().Counters();
+	std::printf("  state changes: %llu issued, %llu skipped\n", (unsigned long long)state.issued, (unsigned long long)state.skipped);
+	const GHI::GHITransientStats &transients = mGraph.TransientStats();
+	std::printf("  fusion: %u filters in %u passes, %u fused\n", uint32_t(mFilters.size()), mGraph.Passes(), mGraph.FusedNodes());
+	std::printf("  intermediates: %u aliased into %u textures, %.1f MB, %.1f MB without aliasing, %.1f MB peak live\n",
+		transients.requests, transients.textures, transients.pooledBytes / 1048576., transients.naiveBytes / 1048576., transients.peakLiveBytes / 1048576.);
+	const GHI::GHITexturePoolStats &pool = mContext->TexturePool().Stats();
+	std::printf("  texture pool: %llu acquires, %llu reused, %llu destroyed, %.1f MB high water\n", (unsigned long long)pool.acquires,
+		(unsigned long long)pool.reuses, (unsigned long long)pool.destroyed, pool.highWaterBytes / 1048576.);
+	const GHI::GHIPixelBufferPoolStats buffers = GHI::GHIPixelBufferPool::Global().Stats();
+	std::printf("  decode buffers: %llu acquires, %llu reused, %.1f MB high water\n", (unsigned long long)buffers.acquires,
+		(unsigned long long)buffers.reuses, buffers.highWaterBytes / 1048576.);
+	std::fflush(stdout);
+	return failures;
+}
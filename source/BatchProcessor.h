@@ -0,0 +1,71 @@
+#ifndef BATCH_PROCESSOR_H_
+#define BATCH_PROCESSOR_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GHICommandContext.h"
+#include "FilterGraph.h"
+#include "ThreadPool.h"
+
+class Filter;
+
+struct BatchOptions
+{
+	std::string inputDir;
+	std::string outputDir;
+	std::vector<std::string> filters; //< applied in order, see FilterNames()
+	std::string backend = "dx11";     //< dx11 | cpu
+	std::string format = "png";       //< extension of the written images
+	int pngLevel = 4;                 //< 0 stores, 1 run length only, 2..9 see PNGWriteOptions
+	uint32_t ioThreads = 4;           //< decode + encode workers
+	uint32_t queueDepth = 4;          //< images decoded ahead / encodes in flight
+	bool fusion = true;               //< fuse runs of per-pixel filters into one pass
+	uint32_t tileSize = 0;            //< larger images run in tiles, 0 only tiles images over the texture limit
+};
+
+//! Parses "--batch --input <dir> --output <dir> --filters a,b[,..] [--backend dx11|cpu]
+//! [--format png|bmp|tga|jpg] [--png-level 0..9] [--threads n] [--depth n] [--fusion on|off] [--tile n]".
+//! Returns false with error set when the arguments are not usable.
+bool ParseBatchOptions(const std::vector<std::string> &args, BatchOptions &options, std::string &error);
+bool IsBatchCommandLine(const std::vector<std::string> &args);
+std::string BatchUsage();
+
+//--------------------------------------------------------------------------------------
+// Headless processing of a directory. Three stages overlap : images are decoded on the
+// IO workers ahead of the filter stage, the filter chain runs on the calling thread
+// (the command context is not thread safe) as a linear FilterGraph and results are
+// encoded on the IO workers while the next image is filtered. Images larger than a
+// texture may be run in tiles : each tile is uploaded with the margin its filters read
+// around it, filtered and read back into the result, so the GPU memory only depends on
+// the tile size.
+//--------------------------------------------------------------------------------------
+class BatchProcessor
+{
+public:
+	BatchProcessor(GHI::IGHIComputeCommandCotext *commandContext, const BatchOptions &options);
+	~BatchProcessor();
+
+	//! Returns the number of images that failed.
+	int Run();
+
+private:
+	struct Decoded;
+	struct Encoded;
+
+	bool InitFilters();
+	GHI::GHITexture* RunChain(GHI::GHITexture *input);
+	bool RunTiled(const Decoded &image, GHI::GHIReadbackData &result);
+	GHI::GHITexture* Target(GHI::GHITexture *like);
+
+	GHI::IGHIComputeCommandCotext *mContext;
+	BatchOptions mOptions;
+	GHI::ThreadPool mIOPool;
+	GHI::GHISampler *mSampler = nullptr;
+	std::vector<Filter*> mFilters;
+	FilterGraph mGraph;
+	GHI::GHITexture *mResult = nullptr; //< output of the chain, read back while the next image uploads
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "CPUBilateral.h"
+
+using namespace GHI;
+
+namespace
+{
+    // Constants of bilateral.hlsl / test.hlsl
+    const float SIGMA = 10.f;
+    const float BSIGMA = 0.1f;
+    const int MAX_RADIUS = 31;
+
+    // Range weights exp(-d2 / (2 BSIGMA^2)) by squared color distance d2, nearest entry.
+    // Beyond RANGE_MAX_D2 the weight is below 1e-10 and the last entry is 0.
+    const int RANGE_LUT_SIZE = 4096;
+    const float RANGE_MAX_D2 = 0.5f;
+    const float RANGE_LUT_SCALE = (RANGE_LUT_SIZE - 1) / RANGE_MAX_D2;
+
+    struct RangeLUT
+    {
+        float weights[RANGE_LUT_SIZE];
+
+        RangeLUT()
+        {
+            for (int i = 0; i < RANGE_LUT_SIZE - 1; ++i)
+                weights[i] = std::exp(-0.5f * (float(i) / RANGE_LUT_SCALE) / (BSIGMA * BSIGMA));
+            weights[RANGE_LUT_SIZE - 1] = 0.f;
+        }
+    };
+
+    const float* RangeWeights()
+    {
+        static const RangeLUT lut;
+        return lut.weights;
+    }
+
+    inline int RangeIndex(float d2)
+    {
+        return int(std::min(d2 * RANGE_LUT_SCALE + 0.5f, float(RANGE_LUT_SIZE - 1)));
+    }
+
+    // One block : the R, G and B planes of the output pixels and their apron, row pitch
+    // in floats. Padded on the right so that a vector of the last pixels reads zeros.
+    struct Block
+    {
+        std::vector<float> planes;
+        std::vector<float> spatial; //< (2 radius + 1)^2 weights, row major
+        uint32_t width = 0;         //< output pixels
+        uint32_t height = 0;
+        int radius = 0;
+        size_t pitch = 0;
+        size_t planeSize = 0;
+
+        const float* Plane(int c) const
+        {
+            return planes.data() + c * planeSize;
+        }
+    };
+
+    // Blocks are as large as a thread group, each worker thread reuses its own.
+    Block& LoadBlock(const FCPUGHITexture &in, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, int radius)
+    {
+        thread_local Block block;
+        block.width = x1 - x0;
+        block.height = y1 - y0;
+        block.radius = radius;
+        block.pitch = ((block.width + 2 * radius + 8 + 7) / 8) * 8;
+        block.planeSize = block.pitch * (block.height + 2 * radius);
+        block.planes.assign(3 * block.planeSize, 0.f);
+
+        float *r = block.planes.data();
+        float *g = r + block.planeSize;
+        float *b = g + block.planeSize;
+        for (uint32_t py = 0; py < block.height + 2 * radius; ++py)
+        {
+            const int y = int(y0) - radius + int(py);
+            for (uint32_t px = 0; px < block.width + 2 * radius; ++px)
+            {
+                CPUFloat4 c = in.Load(int(x0) - radius + int(px), y);
+                const size_t i = py * block.pitch + px;
+                r[i] = c.x;
+                g[i] = c.y;
+                b[i] = c.z;
+            }
+        }
+
+        const int taps = 2 * radius + 1;
+        float kernel[2 * MAX_RADIUS + 1];
+        for (int j = 0; j <= radius; ++j)
+            kernel[radius + j] = kernel[radius - j] = 0.39894f * std::exp(-0.5f * j * j / (SIGMA * SIGMA)) / SIGMA;
+        block.spatial.resize(taps * taps);
+        for (int i = 0; i < taps; ++i)
+            for (int j = 0; j < taps; ++j)
+                block.spatial[i * taps + j] = kernel[i] * kernel[j];
+        return block;
+    }
+
+    inline void StoreResult(FCPUGHITexture &out, uint32_t x, uint32_t y, float r, float g, float b, float z)
+    {
+        out.Store(x, y, CPUFloat4(r / z, g / z, b / z, 1.f));
+    }
+
+    void FilterBlockScalar(const Block &block, FCPUGHITexture &out, uint32_t x0, uint32_t y0)
+    {
+        const float *lut = RangeWeights();
+        const float *R = block.Plane(0), *G = block.Plane(1), *B = block.Plane(2);
+        const int taps = 2 * block.radius + 1;
+        for (uint32_t ty = 0; ty < block.height; ++ty)
+        {
+            for (uint32_t tx = 0; tx < block.width; ++tx)
+            {
+                const size_t center = (ty + block.radius) * block.pitch + tx + block.radius;
+                const float cr = R[center], cg = G[center], cb = B[center];
+                float z = 0.f, sr = 0.f, sg = 0.f, sb = 0.f;
+                for (int i = 0; i < taps; ++i)
+                {
+                    const size_t row = (ty + i) * block.pitch + tx;
+                    const float *spatial = block.spatial.data() + i * taps;
+                    for (int j = 0; j < taps; ++j)
+                    {
+                        const float r = R[row + j], g = G[row + j], b = B[row + j];
+                        const float dr = r - cr, dg = g - cg, db = b - cb;
+                        const float w = lut[RangeIndex(dr * dr + dg * dg + db * db)] * spatial[j];
+                        z += w;
+                        sr += w * r;
+                        sg += w * g;
+                        sb += w * b;
+                    }
+                }
+                StoreResult(out, x0 + tx, y0 + ty, sr, sg, sb, z);
+            }
+        }
+    }
+
+#if CPU_SIMD_X86
+    // SSE2 has no gather, the four table entries are read one by one.
+    void FilterBlockSSE(const Block &block, FCPUGHITexture &out, uint32_t x0, uint32_t y0)
+    {
+        const float *lut = RangeWeights();
+        const float *R = block.Plane(0), *G = block.Plane(1), *B = block.Plane(2);
+        const int taps = 2 * block.radius + 1;
+        const __m128 scale = _mm_set1_ps(RANGE_LUT_SCALE);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 last = _mm_set1_ps(float(RANGE_LUT_SIZE - 1));
+        alignas(16) int32_t index[4];
+        alignas(16) float result[4][4];
+        for (uint32_t ty = 0; ty < block.height; ++ty)
+        {
+            for (uint32_t tx = 0; tx < block.width; tx += 4)
+            {
+                const size_t center = (ty + block.radius) * block.pitch + tx + block.radius;
+                const __m128 cr = _mm_loadu_ps(R + center), cg = _mm_loadu_ps(G + center), cb = _mm_loadu_ps(B + center);
+                __m128 z = _mm_setzero_ps(), sr = _mm_setzero_ps(), sg = _mm_setzero_ps(), sb = _mm_setzero_ps();
+                for (int i = 0; i < taps; ++i)
+                {
+                    const size_t row = (ty + i) * block.pitch + tx;
+                    const float *spatial = block.spatial.data() + i * taps;
+                    for (int j = 0; j < taps; ++j)
+                    {
+                        const __m128 r = _mm_loadu_ps(R + row + j), g = _mm_loadu_ps(G + row + j), b = _mm_loadu_ps(B + row + j);
+                        const __m128 dr = _mm_sub_ps(r, cr), dg = _mm_sub_ps(g, cg), db = _mm_sub_ps(b, cb);
+                        const __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+                        _mm_store_si128((__m128i*)index, _mm_cvttps_epi32(_mm_min_ps(_mm_add_ps(_mm_mul_ps(d2, scale), half), last)));
+                        const __m128 range = _mm_setr_ps(lut[index[0]], lut[index[1]], lut[index[2]], lut[index[3]]);
+                        const __m128 w = _mm_mul_ps(range, _mm_set1_ps(spatial[j]));
+                        z = _mm_add_ps(z, w);
+                        sr = _mm_add_ps(sr, _mm_mul_ps(w, r));
+                        sg = _mm_add_ps(sg, _mm_mul_ps(w, g));
+                        sb = _mm_add_ps(sb, _mm_mul_ps(w, b));
+                    }
+                }
+                _mm_store_ps(result[0], sr);
+                _mm_store_ps(result[1], sg);
+                _mm_store_ps(result[2], sb);
+                _mm_store_ps(result[3], z);
+                for (uint32_t l = 0; l < 4 && tx + l < block.width; ++l)
+                    StoreResult(out, x0 + tx + l, y0 + ty, result[0][l], result[1][l], result[2][l], result[3][l]);
+            }
+        }
+    }
+
+    CPU_TARGET_AVX2 void FilterBlockAVX2(const Block &block, FCPUGHITexture &out, uint32_t x0, uint32_t y0)
+    {
+        const float *lut = RangeWeights();
+        const float *R = block.Plane(0), *G = block.Plane(1), *B = block.Plane(2);
+        const int taps = 2 * block.radius + 1;
+        const __m256 scale = _mm256_set1_ps(RANGE_LUT_SCALE);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 last = _mm256_set1_ps(float(RANGE_LUT_SIZE - 1));
+        alignas(32) float result[4][8];
+        for (uint32_t ty = 0; ty < block.height; ++ty)
+        {
+            for (uint32_t tx = 0; tx < block.width; tx += 8)
+            {
+                const size_t center = (ty + block.radius) * block.pitch + tx + block.radius;
+                const __m256 cr = _mm256_loadu_ps(R + center), cg = _mm256_loadu_ps(G + center), cb = _mm256_loadu_ps(B + center);
+                __m256 z = _mm256_setzero_ps(), sr = _mm256_setzero_ps(), sg = _mm256_setzero_ps(), sb = _mm256_setzero_ps();
+                for (int i = 0; i < taps; ++i)
+                {
+                    const size_t row = (ty + i) * block.pitch + tx;
+                    const float *spatial = block.spatial.data() + i * taps;
+                    for (int j = 0; j < taps; ++j)
+                    {
+                        const __m256 r = _mm256_loadu_ps(R + row + j), g = _mm256_loadu_ps(G + row + j), b = _mm256_loadu_ps(B + row + j);
+                        const __m256 dr = _mm256_sub_ps(r, cr), dg = _mm256_sub_ps(g, cg), db = _mm256_sub_ps(b, cb);
+                        const __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dr, dr), _mm256_mul_ps(dg, dg)), _mm256_mul_ps(db, db));
+                        const __m256i index = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_add_ps(_mm256_mul_ps(d2, scale), half), last));
+                        const __m256 w = _mm256_mul_ps(_mm256_i32gather_ps(lut, index, 4), _mm256_set1_ps(spatial[j]));
+                        z = _mm256_add_ps(z, w);
+                        sr = _mm256_add_ps(sr, _mm256_mul_ps(w, r));
+                        sg = _mm256_add_ps(sg, _mm256_mul_ps(w, g));
+                        sb = _mm256_add_ps(sb, _mm256_mul_ps(w, b));
+                    }
+                }
+                _mm256_store_ps(result[0], sr);
+                _mm256_store_ps(result[1], sg);
+                _mm256_store_ps(result[2], sb);
+                _mm256_store_ps(result[3], z);
+                for (uint32_t l = 0; l < 8 && tx + l < block.width; ++l)
+                    StoreResult(out, x0 + tx + l, y0 + ty, result[0][l], result[1][l], result[2][l], result[3][l]);
+            }
+        }
+    }
+#endif
+}
+
+void CPUBilateral(const FCPUGHITexture &in, FCPUGHITexture &out, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, int windowSize)
+{
+    x1 = std::min(x1, out.width);
+    y1 = std::min(y1, out.height);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    const int radius = std::max(0, std::min((windowSize - 1) / 2, MAX_RADIUS));
+    const Block &block = LoadBlock(in, x0, y0, x1, y1, radius);
+    switch (CPUSimd())
+    {
+#if CPU_SIMD_X86
+    case CPUSimdAVX2:
+        FilterBlockAVX2(block, out, x0, y0);
+        break;
+    case CPUSimdSSE:
+        FilterBlockSSE(block, out, x0, y0);
+        break;
+#endif
+    default:
+        FilterBlockScalar(block, out, x0, y0);
+        break;
+    }
+}
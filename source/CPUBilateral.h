@@ -0,0 +1,20 @@
+#ifndef CPU_BILATERAL_H_
+#define CPU_BILATERAL_H_
+
+#include <cstdint>
+#include "FCPUGHIResources.h"
+#include "CPUSimd.h"
+
+//--------------------------------------------------------------------------------------
+// bilateral.hlsl / test.hlsl for the CPU backend. A block of output pixels is filtered
+// from a planar float copy of the block and its apron, loaded once, so the taps read
+// contiguous cache resident floats instead of decoding a texel each. The spatial weights
+// of the window are computed once per block, the range weight exp(-d^2 / 2 BSIGMA^2)
+// comes from a table indexed by d^2. Eight (AVX2) or four (SSE) pixels of a row are
+// filtered at once, the scalar path runs the same code one pixel at a time; see CPUSimd.h.
+//--------------------------------------------------------------------------------------
+//! Output pixels [x0, x1) x [y0, y1) of the windowSize x windowSize bilateral of in, with
+//! the texel reads of Texture2D.Load() : taps outside of in are black.
+void CPUBilateral(const GHI::FCPUGHITexture &in, GHI::FCPUGHITexture &out, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, int windowSize);
+
+#endif
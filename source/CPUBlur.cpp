@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <vector>
+#include "CPUBlur.h"
+
+using namespace GHI;
+
+namespace
+{
+    struct Line
+    {
+        const FCPUGHITexture &in;
+        uint32_t dirX, dirY;
+        uint32_t index;
+
+        int Length() const
+        {
+            return int(dirX ? in.width : in.height);
+        }
+        //! Pixel i of the line, the edge pixel outside of it.
+        CPUFloat4 Load(int i) const
+        {
+            i = std::min(std::max(i, 0), Length() - 1);
+            return in.Load(dirX ? i : int(index), dirX ? int(index) : i);
+        }
+        void Store(FCPUGHITexture &out, int i, const CPUFloat4 &c) const
+        {
+            out.Store(dirX ? i : int(index), dirX ? int(index) : i, c);
+        }
+    };
+
+    // Worker threads keep their line buffer from one group to the next.
+    std::vector<CPUFloat4>& LoadLine(const Line &line, int first, int count)
+    {
+        thread_local std::vector<CPUFloat4> buffer;
+        buffer.resize(count);
+        for (int i = 0; i < count; ++i)
+            buffer[i] = line.Load(first + i);
+        return buffer;
+    }
+
+    inline bool UseSSE()
+    {
+        return CPU_SIMD_X86 && CPUSimd() >= CPUSimdSSE;
+    }
+
+    //! Moves the running sum of a box one pixel on : adds the pixel entering it, subtracts the one leaving.
+    inline void Slide(bool sse, CPUFloat4 &sum, const CPUFloat4 &enter, const CPUFloat4 &leave)
+    {
+#if CPU_SIMD_X86
+        if (sse)
+        {
+            _mm_storeu_ps(&sum.x, _mm_add_ps(_mm_loadu_ps(&sum.x), _mm_sub_ps(_mm_loadu_ps(&enter.x), _mm_loadu_ps(&leave.x))));
+            return;
+        }
+#endif
+        sum += enter - leave;
+    }
+}
+
+void CPUGaussianPass(const FCPUGHITexture &in, FCPUGHITexture &out, uint32_t dirX, uint32_t dirY,
+    uint32_t line, uint32_t t0, uint32_t t1, int radius, const float *weights)
+{
+    const Line l = { in, dirX, dirY, line };
+    if (line >= (dirX ? in.height : in.width))
+        return;
+    t1 = std::min(t1, uint32_t(l.Length()));
+    if (t0 >= t1)
+        return;
+
+    const std::vector<CPUFloat4> &buffer = LoadLine(l, int(t0) - radius, int(t1 - t0) + 2 * radius);
+    for (uint32_t t = t0; t < t1; ++t)
+    {
+        const CPUFloat4 *c = buffer.data() + (t - t0) + radius;
+        CPUFloat4 sum;
+#if CPU_SIMD_X86
+        if (UseSSE())
+        {
+            __m128 acc = _mm_mul_ps(_mm_loadu_ps(&c->x), _mm_set1_ps(weights[0]));
+            for (int j = 1; j <= radius; ++j)
+            {
+                const __m128 pair = _mm_add_ps(_mm_loadu_ps(&c[-j].x), _mm_loadu_ps(&c[j].x));
+                acc = _mm_add_ps(acc, _mm_mul_ps(pair, _mm_set1_ps(weights[j])));
+            }
+            _mm_storeu_ps(&sum.x, acc);
+        }
+        else
+#endif
+        {
+            sum = *c * weights[0];
+            for (int j = 1; j <= radius; ++j)
+                sum += (c[-j] + c[j]) * weights[j];
+        }
+        l.Store(out, int(t), sum);
+    }
+}
+
+void CPUBoxPass(const FCPUGHITexture &in, FCPUGHITexture &out, uint32_t dirX, uint32_t dirY,
+    uint32_t line0, uint32_t line1, uint32_t t0, uint32_t t1, int radius)
+{
+    line1 = std::min(line1, dirX ? in.height : in.width);
+    t1 = std::min(t1, dirX ? in.width : in.height);
+    if (line0 >= line1 || t0 >= t1)
+        return;
+    const float scale = 1.f / float(2 * radius + 1);
+    const bool sse = UseSSE();
+    const int count = int(t1 - t0);
+
+    for (uint32_t line = line0; line < line1; ++line)
+    {
+        const Line l = { in, dirX, dirY, line };
+        // buffer[i] is pixel t0 + i - radius, the window of pixel t0 + x is buffer[x .. x + 2 radius].
+        const std::vector<CPUFloat4> &buffer = LoadLine(l, int(t0) - radius, count + 2 * radius + 1);
+        CPUFloat4 sum;
+        for (int i = 0; i <= 2 * radius; ++i)
+            sum += buffer[i];
+        for (int x = 0; x < count; ++x)
+        {
+            l.Store(out, int(t0) + x, sum * scale);
+            Slide(sse, sum, buffer[x + 2 * radius + 1], buffer[x]);
+        }
+    }
+}
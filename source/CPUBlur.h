@@ -0,0 +1,24 @@
+#ifndef CPU_BLUR_H_
+#define CPU_BLUR_H_
+
+#include <cstdint>
+#include "FCPUGHIResources.h"
+#include "CPUSimd.h"
+
+//--------------------------------------------------------------------------------------
+// gaussian.hlsl and boxBlur.hlsl for the CPU backend. A line is copied once into a
+// buffer of float4 with the edge pixels repeated on both sides, then filtered with one
+// SSE register per pixel (the four channels at once), or plainly without SSE.
+// dirX, dirY is (1, 0) for rows and (0, 1) for columns.
+//--------------------------------------------------------------------------------------
+
+//! Pixels [t0, t1) of line of the gaussian pass, weights[0 .. radius] are normalized.
+void CPUGaussianPass(const GHI::FCPUGHITexture &in, GHI::FCPUGHITexture &out, uint32_t dirX, uint32_t dirY,
+	uint32_t line, uint32_t t0, uint32_t t1, int radius, const float *weights);
+
+//! Pixels [t0, t1) of lines [line0, line1) of the 2 radius + 1 wide box pass, the
+//! running sum starts at t0.
+void CPUBoxPass(const GHI::FCPUGHITexture &in, GHI::FCPUGHITexture &out, uint32_t dirX, uint32_t dirY,
+	uint32_t line0, uint32_t line1, uint32_t t0, uint32_t t1, int radius);
+
+#endif
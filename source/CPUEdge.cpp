@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "CPUEdge.h"
+
+using namespace GHI;
+
+namespace
+{
+    const uint8_t WEAK = 128;   // 0.5 in an R8 plane
+    const uint8_t STRONG = 255;
+
+    inline bool UseSSE()
+    {
+        return CPU_SIMD_X86 && CPUSimd() >= CPUSimdSSE;
+    }
+
+    inline bool IsR8(const FCPUGHITexture &t)
+    {
+        return t.desc.Format == PixelFormat_R8_UNORM;
+    }
+
+    //! Byte of an R8 plane, what the shaders get back from round(Load() * 255) otherwise.
+    inline int LoadByte(const FCPUGHITexture &t, uint32_t x, uint32_t y)
+    {
+        if (IsR8(t))
+            return t.Row(y)[x];
+        return int(t.Load(int(x), int(y)).x * 255.f + 0.5f);
+    }
+
+    inline void StoreByte(FCPUGHITexture &t, uint32_t x, uint32_t y, uint8_t v)
+    {
+        if (IsR8(t))
+        {
+            t.Row(y)[x] = v;
+            return;
+        }
+        const float f = float(v) / 255.f;
+        t.Store(int(x), int(y), CPUFloat4(f, f, f, 1.f));
+    }
+
+    //! The neighbours along the gradient (gx, gy), its direction rounded to 45 degrees : the
+    //! offset of step in sobelNms.hlsl, which keeps the tie on its side.
+    inline int GradientStep(int gx, int gy, int rowStride)
+    {
+        const int ax = std::abs(gx), ay = std::abs(gy);
+        if (ay * 5 <= ax * 2)
+            return 1;
+        if (ay * 2 >= ax * 5)
+            return rowStride;
+        return (gx > 0) == (gy > 0) ? rowStride + 1 : 1 - rowStride;
+    }
+
+    // Worker threads keep their block buffers from one group to the next.
+    struct SobelBlock
+    {
+        std::vector<int16_t> luma;
+        std::vector<int16_t> gx, gy;
+        std::vector<int32_t> magnitudeSq;
+    };
+}
+
+void CPULuma(const FCPUGHITexture &in, FCPUGHITexture &out, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    x1 = std::min(x1, std::min(in.width, out.width));
+    y1 = std::min(y1, std::min(in.height, out.height));
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    const bool rgba8 = in.desc.Format == PixelFormat_R8G8B8A8_UNORM;
+    for (uint32_t y = y0; y < y1; ++y)
+    {
+        const uint8_t *p = in.Row(y);
+        for (uint32_t x = x0; x < x1; ++x)
+        {
+            float v;
+            if (rgba8)
+            {
+                const uint8_t *c = p + size_t(x) * 4;
+                v = float(c[0]) / 255.f * 0.299f + float(c[1]) / 255.f * 0.587f + float(c[2]) / 255.f * 0.114f;
+            }
+            else
+            {
+                const CPUFloat4 c = in.Load(int(x), int(y));
+                v = std::min(std::max(c.x, 0.f), 1.f) * 0.299f + std::min(std::max(c.y, 0.f), 1.f) * 0.587f + std::min(std::max(c.z, 0.f), 1.f) * 0.114f;
+            }
+            StoreByte(out, x, y, FloatToUNorm8(v));
+        }
+    }
+}
+
+void CPUSobelNms(const FCPUGHITexture &luma, FCPUGHITexture &out, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, float lowSq, float highSq)
+{
+    x1 = std::min(x1, std::min(luma.width, out.width));
+    y1 = std::min(y1, std::min(luma.height, out.height));
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    const int w = int(x1 - x0), h = int(y1 - y0);
+    const int lumaStride = w + 4;     // the block and two pixels of apron on each side
+    const int gradientStride = w + 2; // the block and the neighbours suppression reads
+    thread_local SobelBlock block;
+    block.luma.resize(size_t(lumaStride) * (h + 4));
+    block.gx.resize(size_t(gradientStride) * (h + 2));
+    block.gy.resize(block.gx.size());
+    block.magnitudeSq.resize(block.gx.size());
+
+    // Luma of the block and its apron, the edge repeated outside of the image.
+    const int lastX = int(luma.width) - 1, lastY = int(luma.height) - 1;
+    for (int r = 0; r < h + 4; ++r)
+    {
+        const uint32_t sy = uint32_t(std::min(std::max(int(y0) - 2 + r, 0), lastY));
+        int16_t *dst = block.luma.data() + size_t(r) * lumaStride;
+        for (int c = 0; c < lumaStride; ++c)
+            dst[c] = int16_t(LoadByte(luma, uint32_t(std::min(std::max(int(x0) - 2 + c, 0), lastX)), sy));
+    }
+
+    // Sobel gradients, |gx|, |gy| <= 1020 fit 16 bits and gx^2 + gy^2 a 32 bit madd.
+    const bool sse = UseSSE();
+    for (int r = 0; r < h + 2; ++r)
+    {
+        const int16_t *a = block.luma.data() + size_t(r) * lumaStride;
+        const int16_t *b = a + lumaStride;
+        const int16_t *d = b + lumaStride;
+        int16_t *gx = block.gx.data() + size_t(r) * gradientStride;
+        int16_t *gy = block.gy.data() + size_t(r) * gradientStride;
+        int32_t *m = block.magnitudeSq.data() + size_t(r) * gradientStride;
+        int c = 0;
+#if CPU_SIMD_X86
+        if (sse)
+        {
+            for (; c + 8 <= gradientStride; c += 8)
+            {
+                const __m128i a0 = _mm_loadu_si128((const __m128i*)(a + c));
+                const __m128i a1 = _mm_loadu_si128((const __m128i*)(a + c + 1));
+                const __m128i a2 = _mm_loadu_si128((const __m128i*)(a + c + 2));
+                const __m128i b0 = _mm_loadu_si128((const __m128i*)(b + c));
+                const __m128i b2 = _mm_loadu_si128((const __m128i*)(b + c + 2));
+                const __m128i d0 = _mm_loadu_si128((const __m128i*)(d + c));
+                const __m128i d1 = _mm_loadu_si128((const __m128i*)(d + c + 1));
+                const __m128i d2 = _mm_loadu_si128((const __m128i*)(d + c + 2));
+                const __m128i x = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(a2, a0), _mm_sub_epi16(d2, d0)), _mm_slli_epi16(_mm_sub_epi16(b2, b0), 1));
+                const __m128i y = _mm_add_epi16(_mm_sub_epi16(_mm_add_epi16(d0, d2), _mm_add_epi16(a0, a2)), _mm_slli_epi16(_mm_sub_epi16(d1, a1), 1));
+                _mm_storeu_si128((__m128i*)(gx + c), x);
+                _mm_storeu_si128((__m128i*)(gy + c), y);
+                const __m128i lo = _mm_unpacklo_epi16(x, y);
+                const __m128i hi = _mm_unpackhi_epi16(x, y);
+                _mm_storeu_si128((__m128i*)(m + c), _mm_madd_epi16(lo, lo));
+                _mm_storeu_si128((__m128i*)(m + c + 4), _mm_madd_epi16(hi, hi));
+            }
+        }
+#endif
+        for (; c < gradientStride; ++c)
+        {
+            const int x = (a[c + 2] - a[c]) + 2 * (b[c + 2] - b[c]) + (d[c + 2] - d[c]);
+            const int y = (d[c] + 2 * d[c + 1] + d[c + 2]) - (a[c] + 2 * a[c + 1] + a[c + 2]);
+            gx[c] = int16_t(x);
+            gy[c] = int16_t(y);
+            m[c] = x * x + y * y;
+        }
+    }
+
+    // Non-maximum suppression and the double threshold, the magnitudes are exact
+    // integers in float as well as in the shader.
+    for (int r = 0; r < h; ++r)
+    {
+        const size_t row = size_t(r + 1) * gradientStride + 1;
+        const int16_t *gx = block.gx.data() + row;
+        const int16_t *gy = block.gy.data() + row;
+        const int32_t *m = block.magnitudeSq.data() + row;
+        for (int c = 0; c < w; ++c)
+        {
+            const float magnitudeSq = float(m[c]);
+            uint8_t edge = 0;
+            if (magnitudeSq >= lowSq)
+            {
+                const int step = GradientStep(gx[c], gy[c], gradientStride);
+                if (m[c] >= m[c + step] && m[c] > m[c - step])
+                    edge = magnitudeSq >= highSq ? STRONG : WEAK;
+            }
+            StoreByte(out, x0 + uint32_t(c), y0 + uint32_t(r), edge);
+        }
+    }
+}
+
+void CPUHysteresis(const FCPUGHITexture &in, FCPUGHITexture &out, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, bool final)
+{
+    const uint32_t width = in.width, height = in.height;
+    x1 = std::min(x1, std::min(width, out.width));
+    y1 = std::min(y1, std::min(height, out.height));
+    if (x0 >= x1 || y0 >= y1 || !IsR8(in))
+        return;
+
+    // Rows outside of the image read as zero, like Texture2D.Load().
+    thread_local std::vector<uint8_t> zeros;
+    zeros.assign(width, 0);
+    const bool sse = UseSSE() && IsR8(out);
+    for (uint32_t y = y0; y < y1; ++y)
+    {
+        const uint8_t *rows[3] = { y > 0 ? in.Row(y - 1) : zeros.data(), in.Row(y), y + 1 < height ? in.Row(y + 1) : zeros.data() };
+        uint32_t x = x0;
+        // Pixel x of the output, the scalar path and the edges of the rows.
+        auto scalar = [&](uint32_t x)
+        {
+            uint8_t strongest = 0;
+            for (const uint8_t *p : rows)
+            {
+                strongest = std::max(strongest, p[x]);
+                if (x > 0)
+                    strongest = std::max(strongest, p[x - 1]);
+                if (x + 1 < width)
+                    strongest = std::max(strongest, p[x + 1]);
+            }
+            uint8_t edge = rows[1][x];
+            if (edge == WEAK && strongest == STRONG)
+                edge = STRONG;
+            if (final && edge != STRONG)
+                edge = 0;
+            StoreByte(out, x, y, edge);
+        };
+#if CPU_SIMD_X86
+        if (sse)
+        {
+            if (x == 0)
+                scalar(x++);
+            const __m128i weak = _mm_set1_epi8(char(WEAK));
+            const __m128i strong = _mm_set1_epi8(char(STRONG));
+            uint8_t *dst = out.Row(y);
+            for (; x + 16 <= x1 && x + 16 < width; x += 16)
+            {
+                __m128i strongest = _mm_setzero_si128();
+                for (const uint8_t *p : rows)
+                {
+                    strongest = _mm_max_epu8(strongest, _mm_loadu_si128((const __m128i*)(p + x - 1)));
+                    strongest = _mm_max_epu8(strongest, _mm_loadu_si128((const __m128i*)(p + x)));
+                    strongest = _mm_max_epu8(strongest, _mm_loadu_si128((const __m128i*)(p + x + 1)));
+                }
+                const __m128i center = _mm_loadu_si128((const __m128i*)(rows[1] + x));
+                const __m128i promote = _mm_and_si128(_mm_cmpeq_epi8(center, weak), _mm_cmpeq_epi8(strongest, strong));
+                __m128i edge = _mm_or_si128(center, promote);
+                if (final)
+                    edge = _mm_cmpeq_epi8(edge, strong);
+                _mm_storeu_si128((__m128i*)(dst + x), edge);
+            }
+        }
+#endif
+        for (; x < x1; ++x)
+            scalar(x);
+    }
+}
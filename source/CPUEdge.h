@@ -0,0 +1,24 @@
+#ifndef CPU_EDGE_H_
+#define CPU_EDGE_H_
+
+#include <cstdint>
+#include "FCPUGHIResources.h"
+#include "CPUSimd.h"
+
+//--------------------------------------------------------------------------------------
+// The passes of EdgeFilter (luma.hlsl, sobelNms.hlsl, hysteresis.hlsl) for the CPU
+// backend. They walk the rows of their block straight over the bytes of the R8 planes
+// instead of decoding a texel per tap : the Sobel pass copies the luma of its block and
+// apron once into 16 bit integers, computes the gradients of a row eight pixels at a time
+// (SSE) and suppresses from the cache resident result, hysteresis compares sixteen
+// pixels at a time. AVX2 runs the SSE paths, the scalar one is there to compare.
+//--------------------------------------------------------------------------------------
+//! luma.hlsl : out[x0, x1) x [y0, y1) = Rec. 601 luma of in.
+void CPULuma(const GHI::FCPUGHITexture &in, GHI::FCPUGHITexture &out, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+//! sobelNms.hlsl : 0, 128 (weak) or 255 (strong) edges of the R8 luma into the R8 out,
+//! lowSq / highSq are squared gradient magnitudes in 8 bit luma steps.
+void CPUSobelNms(const GHI::FCPUGHITexture &luma, GHI::FCPUGHITexture &out, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, float lowSq, float highSq);
+//! hysteresis.hlsl : one pass over the R8 edges of in; final drops the weak edges left.
+void CPUHysteresis(const GHI::FCPUGHITexture &in, GHI::FCPUGHITexture &out, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, bool final);
+
+#endif
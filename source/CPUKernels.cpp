@@ -0,0 +1,810 @@
+/*
+ * Source Header
+ *
+ * Copyright (C) 2014-2015  Yaochuang Ding - <ych_ding@163.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to 
+ * deal in the Software without restriction, including without limitation the 
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ *    this list of conditions and the following disclaimer in the documentation 
+ *    and/or other materials provided with the distribution, and in the same 
+ *    place and form as other copyright, license and disclaimer information.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL 
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ *
+ */
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "CPUKernels.h"
+#include "CPUBilateral.h"
+#include "CPUBlur.h"
+#include "CPUEdge.h"
+#include "CPULut.h"
+#include "CPUKernel.h"
+
+using namespace GHI;
+
+namespace
+{
+    const float PI = 3.1415926535f;
+
+    inline float saturate(float v)
+    {
+        return v < 0.f ? 0.f : (v > 1.f ? 1.f : v);
+    }
+
+    inline float smoothstep(float a, float b, float x)
+    {
+        float t = saturate((x - a) / (b - a));
+        return t * t * (3.f - 2.f * t);
+    }
+
+    // The head of the constant buffers below, remap.hlsl reads only this part
+    struct ImageCB
+    {
+        uint32_t width;
+        uint32_t height;
+        int32_t originX;
+        int32_t originY;
+
+        // warps.hlsli imageToTexture(), round() of HLSL rounds halves to even
+        float ToTextureU(float u, const FCPUGHITexture *map) const
+        {
+            return (std::nearbyint(u * width * 256.f) / 256.f - originX) / map->width;
+        }
+        float ToTextureV(float v, const FCPUGHITexture *map) const
+        {
+            return (std::nearbyint(v * height * 256.f) / 256.f - originY) / map->height;
+        }
+    };
+
+    // cbuffer CB of fishEye.hlsl / fishEyeTable.hlsl
+    struct FishEyeCB : ImageCB
+    {
+        float aperture;
+    };
+
+    // cbuffer CB of swirl.hlsl / swirlTable.hlsl
+    struct SwirlCB : ImageCB
+    {
+        float radius;
+        float angle;
+    };
+
+    // cbuffer CB of lensCircle.hlsl / lensCircleTable.hlsl
+    struct LensCircleCB : ImageCB
+    {
+        float inner;
+        float outer;
+    };
+
+    //--------------------------------------------------------------------------------------
+    // warps.hlsli
+    //--------------------------------------------------------------------------------------
+    void FishEyeWarp(float &u, float &v, float aperture)
+    {
+        const float apertureHalf = 0.5f * aperture * (PI / 180.f);
+        const float maxFactor = std::sin(apertureHalf);
+        float xy0 = 2.f * u - 1.f;
+        float xy1 = 2.f * v - 1.f;
+        float d = std::sqrt(xy0 * xy0 + xy1 * xy1);
+        if (d < (2.f - maxFactor))
+        {
+            d = d * maxFactor;
+            float z = std::sqrt(1.f - d * d);
+            float r = std::atan2(d, z) / PI;
+            float phi = std::atan2(xy1, xy0);
+            u = r * std::cos(phi) + 0.5f;
+            v = r * std::sin(phi) + 0.5f;
+        }
+    }
+
+    void SwirlWarp(float x, float y, float width, float height, float radius, float angle, float &u, float &v)
+    {
+        const float cx = width * .5f;
+        const float cy = height * .5f;
+        float ux = x - cx;
+        float uy = y - cy;
+        float r = std::sqrt(ux * ux + uy * uy);
+        if (r < radius)
+        {
+            float percent = (radius - r) / radius;
+            float theta = percent * percent * angle * 8.f;
+            float s = std::sin(theta);
+            float c = std::cos(theta);
+            float nx = ux * c - uy * s;
+            float ny = ux * s + uy * c;
+            ux = nx;
+            uy = ny;
+        }
+        u = (ux + cx) / width;
+        v = (uy + cy) / height;
+    }
+
+    float LensCircleWeight(float u, float v, float inner, float outer)
+    {
+        float dist = std::sqrt((u - .5f) * (u - .5f) + (v - .5f) * (v - .5f));
+        return smoothstep(outer, inner, dist);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // bilateral.hlsl / test.hlsl, see CPUBilateral.h
+    //--------------------------------------------------------------------------------------
+    void Bilateral(const FCPUBindings &b, const FCPUThreadGroup &g, int windowSize)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !out)
+            return;
+        CPUBilateral(*in, *out, g.x0, g.y0, g.x1, g.y1, windowSize);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // bilateralSeparable.hlsl
+    //--------------------------------------------------------------------------------------
+    struct BilateralPassCB
+    {
+        uint32_t direction[2];
+        uint32_t radius;
+        float rangeScale;
+        float spatial[20];
+    };
+
+    void BilateralSeparable(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !out)
+            return;
+        const BilateralPassCB &cb = b.Constants<BilateralPassCB>(0);
+        const int dx = int(cb.direction[0]);
+        const int dy = int(cb.direction[1]);
+        const int radius = std::min(int(cb.radius), 19);
+
+        std::vector<CPUFloat4> lineCache(g.x1 - g.x0 + 2 * radius);
+        for (uint32_t l = g.y0; l < g.y1; ++l)
+        {
+            // x runs along the filter direction, the line is a row (dx) or a column (dy)
+            const int ox = dy * int(l);
+            const int oy = dx * int(l);
+            if (uint32_t(ox) >= out->width || uint32_t(oy) >= out->height)
+                continue;
+            for (size_t i = 0; i < lineCache.size(); ++i)
+            {
+                int t = int(g.x0) - radius + int(i);
+                lineCache[i] = in->Load(ox + dx * t, oy + dy * t);
+            }
+            for (uint32_t t = g.x0; t < g.x1; ++t)
+            {
+                const CPUFloat4 &c = lineCache[t - g.x0 + radius];
+                float Z = 0.f;
+                CPUFloat4 sum;
+                for (int j = -radius; j <= radius; ++j)
+                {
+                    const CPUFloat4 &cc = lineCache[t - g.x0 + radius + j];
+                    CPUFloat4 d = cc - c;
+                    float factor = cb.spatial[j < 0 ? -j : j] * std::exp(-(d.x * d.x + d.y * d.y + d.z * d.z) * cb.rangeScale);
+                    Z += factor;
+                    sum += cc * factor;
+                }
+                out->Store(ox + dx * int(t), oy + dy * int(t), CPUFloat4(sum.x / Z, sum.y / Z, sum.z / Z, 1.f));
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    // gaussian.hlsl / boxBlur.hlsl, see CPUBlur.h
+    //--------------------------------------------------------------------------------------
+    struct GaussianPassCB
+    {
+        uint32_t direction[2];
+        uint32_t radius;
+        uint32_t pad;
+        float weights[28];
+    };
+
+    void GaussianPass(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !out)
+            return;
+        const GaussianPassCB &cb = b.Constants<GaussianPassCB>(0);
+        CPUGaussianPass(*in, *out, cb.direction[0], cb.direction[1], g.y0, g.x0, g.x1, std::min(int(cb.radius), 24), cb.weights);
+    }
+
+    struct BoxPassCB
+    {
+        uint32_t direction[2];
+        uint32_t radius;
+        int32_t origin;
+    };
+
+    void BoxPass(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !out)
+            return;
+        const BoxPassCB &cb = b.Constants<BoxPassCB>(0);
+        // The segment of boxBlur.hlsl, SEGMENT pixels aligned in the image.
+        const int segment = 64;
+        const int start = (cb.origin / segment + int(g.y0)) * segment - cb.origin;
+        CPUBoxPass(*in, *out, cb.direction[0], cb.direction[1], g.x0, g.x1, uint32_t(std::max(start, 0)), uint32_t(start + segment), int(cb.radius));
+    }
+
+    //--------------------------------------------------------------------------------------
+    // fishEye.hlsl
+    //--------------------------------------------------------------------------------------
+    void FishEye(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !out)
+            return;
+        const FishEyeCB &cb = b.Constants<FishEyeCB>(0);
+
+        ForEachThread(g, out->width, out->height, [&](uint32_t x, uint32_t y)
+        {
+            float u = float(int(x) + cb.originX) / float(cb.width);
+            float v = float(int(y) + cb.originY) / float(cb.height);
+            FishEyeWarp(u, v, cb.aperture);
+            out->Store(x, y, in->SampleLevel(b.sampler[0], cb.ToTextureU(u, in), cb.ToTextureV(v, in)));
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // fishEyeTable.hlsl
+    //--------------------------------------------------------------------------------------
+    void FishEyeTable(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        FCPUGHITexture *table = b.uav[0];
+        if (!table)
+            return;
+        const FishEyeCB &cb = b.Constants<FishEyeCB>(0);
+
+        ForEachThread(g, table->width, table->height, [&](uint32_t x, uint32_t y)
+        {
+            float u = float(int(x) + cb.originX) / float(cb.width);
+            float v = float(int(y) + cb.originY) / float(cb.height);
+            FishEyeWarp(u, v, cb.aperture);
+            table->Store(x, y, CPUFloat4(u, v, 0.f, 0.f));
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // swirl.hlsl (swirlSample2)
+    //--------------------------------------------------------------------------------------
+    void Swirl(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !out)
+            return;
+        const SwirlCB &cb = b.Constants<SwirlCB>(0);
+
+        ForEachThread(g, out->width, out->height, [&](uint32_t x, uint32_t y)
+        {
+            float u, v;
+            SwirlWarp(float(int(x) + cb.originX), float(int(y) + cb.originY), float(cb.width), float(cb.height), cb.radius, cb.angle, u, v);
+            out->Store(x, y, in->SampleLevel(b.sampler[0], cb.ToTextureU(u, in), cb.ToTextureV(v, in)));
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // swirlTable.hlsl
+    //--------------------------------------------------------------------------------------
+    void SwirlTable(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        FCPUGHITexture *table = b.uav[0];
+        if (!table)
+            return;
+        const SwirlCB &cb = b.Constants<SwirlCB>(0);
+
+        ForEachThread(g, table->width, table->height, [&](uint32_t x, uint32_t y)
+        {
+            float u, v;
+            SwirlWarp(float(int(x) + cb.originX), float(int(y) + cb.originY), float(cb.width), float(cb.height), cb.radius, cb.angle, u, v);
+            table->Store(x, y, CPUFloat4(u, v, 0.f, 0.f));
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // lensCircle.hlsl
+    //--------------------------------------------------------------------------------------
+    void LensCircle(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !out)
+            return;
+        const LensCircleCB &cb = b.Constants<LensCircleCB>(0);
+
+        ForEachThread(g, out->width, out->height, [&](uint32_t x, uint32_t y)
+        {
+            float u = float(int(x) + cb.originX) / float(cb.width);
+            float v = float(int(y) + cb.originY) / float(cb.height);
+            CPUFloat4 data = in->Load(x, y);
+            float k = LensCircleWeight(u, v, cb.inner, cb.outer);
+            out->Store(x, y, CPUFloat4(data.x * k, data.y * k, data.z * k, data.w));
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // lensCircleTable.hlsl
+    //--------------------------------------------------------------------------------------
+    void LensCircleTable(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        FCPUGHITexture *table = b.uav[0];
+        if (!table)
+            return;
+        const LensCircleCB &cb = b.Constants<LensCircleCB>(0);
+
+        ForEachThread(g, table->width, table->height, [&](uint32_t x, uint32_t y)
+        {
+            float u = float(int(x) + cb.originX) / float(cb.width);
+            float v = float(int(y) + cb.originY) / float(cb.height);
+            table->Store(x, y, CPUFloat4(LensCircleWeight(u, v, cb.inner, cb.outer), 0.f, 0.f, 0.f));
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // remap.hlsl
+    //--------------------------------------------------------------------------------------
+    void Remap(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        const FCPUGHITexture *table = b.srv[1];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !table || !out)
+            return;
+        const ImageCB &cb = b.Constants<ImageCB>(0);
+
+        ForEachThread(g, out->width, out->height, [&](uint32_t x, uint32_t y)
+        {
+            CPUFloat4 uv = table->Load(x, y);
+            out->Store(x, y, in->SampleLevel(b.sampler[0], cb.ToTextureU(uv.x, in), cb.ToTextureV(uv.y, in)));
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // remapWeight.hlsl
+    //--------------------------------------------------------------------------------------
+    void RemapWeight(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        const FCPUGHITexture *table = b.srv[1];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !table || !out)
+            return;
+        ForEachThread(g, out->width, out->height, [&](uint32_t x, uint32_t y)
+        {
+            CPUFloat4 data = in->Load(x, y);
+            float k = table->Load(x, y).x;
+            out->Store(x, y, CPUFloat4(data.x * k, data.y * k, data.z * k, data.w));
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // pointwise.hlsli
+    //--------------------------------------------------------------------------------------
+    enum EPointwiseOp
+    {
+        PW_NONE = 0,
+        PW_POSTERIZE = 1,
+        PW_LENS_CIRCLE = 2,
+    };
+
+    inline float PosterizeChannel(float c)
+    {
+        const float gamma = 0.6f;
+        const float numColors = 8.f;
+        c = std::pow(c, gamma);
+        c = std::floor(c * numColors) / numColors;
+        return std::pow(c, 1.f / gamma);
+    }
+
+    inline CPUFloat4 Posterize(const CPUFloat4 &c)
+    {
+        return CPUFloat4(PosterizeChannel(c.x), PosterizeChannel(c.y), PosterizeChannel(c.z), 1.f);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // denoise.hlsl
+    //--------------------------------------------------------------------------------------
+    void Denoise(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !out)
+            return;
+
+        ForEachThread(g, out->width, out->height, [&](uint32_t x, uint32_t y)
+        {
+            out->Store(x, y, Posterize(in->Load(x, y)));
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // pointwise.hlsl, the ops come from the constant buffer instead of the STAGE defines
+    //--------------------------------------------------------------------------------------
+    struct PointwiseCB : ImageCB
+    {
+        uint32_t stageCount;
+        uint32_t pad[3];
+        uint32_t ops[4];
+        float params[4][4];
+    };
+
+    void Pointwise(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !out)
+            return;
+        const PointwiseCB &cb = b.Constants<PointwiseCB>(0);
+        const uint32_t stageCount = std::min(cb.stageCount, 4u);
+
+        ForEachThread(g, out->width, out->height, [&](uint32_t x, uint32_t y)
+        {
+            const float u = float(int(x) + cb.originX) / float(cb.width);
+            const float v = float(int(y) + cb.originY) / float(cb.height);
+            CPUFloat4 data = in->Load(x, y);
+            for (uint32_t i = 0; i < stageCount; ++i)
+            {
+                if (cb.ops[i] == PW_POSTERIZE)
+                {
+                    data = Posterize(data);
+                }
+                else if (cb.ops[i] == PW_LENS_CIRCLE)
+                {
+                    float k = LensCircleWeight(u, v, cb.params[i][0], cb.params[i][1]);
+                    data = CPUFloat4(data.x * k, data.y * k, data.z * k, data.w);
+                }
+            }
+            out->Store(x, y, data);
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // lut.hlsl
+    //--------------------------------------------------------------------------------------
+    void ApplyLUT(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        const FCPUGHITexture *lut = b.srv[1];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !lut || !out)
+            return;
+        CPUApplyLUT(*in, *lut, *out, g.x0, g.y0, g.x1, g.y1, b.Constants<CPULUTParams>(0));
+    }
+
+    //--------------------------------------------------------------------------------------
+    // luma.hlsl, sobelNms.hlsl, hysteresis.hlsl : the passes of EdgeFilter
+    //--------------------------------------------------------------------------------------
+    void Luma(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !out)
+            return;
+        CPULuma(*in, *out, g.x0, g.y0, g.x1, g.y1);
+    }
+
+    struct EdgeThresholdsCB
+    {
+        float lowSq;
+        float highSq;
+    };
+
+    void SobelNms(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *luma = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!luma || !out)
+            return;
+        const EdgeThresholdsCB &cb = b.Constants<EdgeThresholdsCB>(0);
+        CPUSobelNms(*luma, *out, g.x0, g.y0, g.x1, g.y1, cb.lowSq, cb.highSq);
+    }
+
+    void Hysteresis(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !out)
+            return;
+        CPUHysteresis(*in, *out, g.x0, g.y0, g.x1, g.y1, b.Constants<uint32_t>(0) != 0);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // downsample.hlsl, the views of the two mips are bound as textures of their own
+    //--------------------------------------------------------------------------------------
+    void Downsample(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *src = b.srv[0];
+        FCPUGHITexture *dst = b.uav[0];
+        if (!src || !dst || src->width == 0 || src->height == 0)
+            return;
+
+        const int lastX = int(src->width) - 1;
+        const int lastY = int(src->height) - 1;
+        ForEachThread(g, dst->width, dst->height, [&](uint32_t x, uint32_t y)
+        {
+            const int x0 = std::min(int(x) * 2, lastX), x1 = std::min(int(x) * 2 + 1, lastX);
+            const int y0 = std::min(int(y) * 2, lastY), y1 = std::min(int(y) * 2 + 1, lastY);
+            CPUFloat4 sum = src->Load(x0, y0) + src->Load(x1, y0) + src->Load(x0, y1) + src->Load(x1, y1);
+            dst->Store(x, y, sum * 0.25f);
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // satRows.hlsl / satColumns.hlsl / localStats.hlsl
+    //--------------------------------------------------------------------------------------
+    inline CPUUint4 ToUInt8(const CPUFloat4 &c)
+    {
+        return CPUUint4(uint32_t(saturate(c.x) * 255.f + 0.5f), uint32_t(saturate(c.y) * 255.f + 0.5f),
+            uint32_t(saturate(c.z) * 255.f + 0.5f), uint32_t(saturate(c.w) * 255.f + 0.5f));
+    }
+
+    struct SATPassCB
+    {
+        uint32_t squares;
+        uint32_t factor;
+    };
+
+    void SATRows(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        FCPUGHITexture *sums = b.uav[0];
+        const SATPassCB &cb = b.Constants<SATPassCB>(0);
+        FCPUGHITexture *squares = cb.squares ? b.uav[1] : nullptr;
+        const FCPUGHITexture *factor = cb.factor ? b.srv[1] : in;
+        if (!in || !sums || !factor)
+            return;
+
+        const uint32_t y1 = std::min(g.x1, in->height);
+        for (uint32_t y = g.x0; y < y1; ++y)
+        {
+            CPUUint4 sum, square;
+            for (uint32_t x = 0; x < in->width; ++x)
+            {
+                const CPUUint4 texel = ToUInt8(in->Load(x, y));
+                sum += texel;
+                sums->StoreUint(x, y, sum);
+                if (squares)
+                {
+                    square += texel * (factor == in ? texel : ToUInt8(factor->Load(x, y)));
+                    squares->StoreUint(x, y, square);
+                }
+            }
+        }
+    }
+
+    // The columns of the group are summed side by side, a row at a time, as the rows are stored.
+    void SATColumns(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *rowSums = b.srv[0];
+        const FCPUGHITexture *rowSquares = b.srv[1];
+        FCPUGHITexture *sums = b.uav[0];
+        FCPUGHITexture *squares = b.Constants<SATPassCB>(0).squares ? b.uav[1] : nullptr;
+        if (!rowSums || !sums || (squares && !rowSquares))
+            return;
+
+        const uint32_t x1 = std::min(g.x1, rowSums->width);
+        if (g.x0 >= x1)
+            return;
+        std::vector<CPUUint4> sum(x1 - g.x0), square(squares ? x1 - g.x0 : 0);
+        for (uint32_t y = 0; y < rowSums->height; ++y)
+        {
+            for (uint32_t x = g.x0; x < x1; ++x)
+            {
+                CPUUint4 &s = sum[x - g.x0];
+                s += rowSums->LoadUint(x, y);
+                sums->StoreUint(x, y, s);
+                if (squares)
+                {
+                    CPUUint4 &q = square[x - g.x0];
+                    q += rowSquares->LoadUint(x, y);
+                    squares->StoreUint(x, y, q);
+                }
+            }
+        }
+    }
+
+    struct LocalStatsCB
+    {
+        int32_t radius;
+        uint32_t mode;
+        float gain;
+    };
+
+    //! Sum of the window [x0, x1] x [y0, y1], LoadUint() returns 0 left of and above the table.
+    inline CPUUint4 WindowSum(const FCPUGHITexture &table, int x0, int y0, int x1, int y1)
+    {
+        return table.LoadUint(x1, y1) - table.LoadUint(x0 - 1, y1) - table.LoadUint(x1, y0 - 1) + table.LoadUint(x0 - 1, y0 - 1);
+    }
+
+    inline CPUFloat4 ToFloat4(const CPUUint4 &c)
+    {
+        return CPUFloat4(float(c.x), float(c.y), float(c.z), float(c.w));
+    }
+
+    void LocalStats(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *sums = b.srv[0];
+        const FCPUGHITexture *squares = b.srv[1];
+        FCPUGHITexture *out = b.uav[0];
+        if (!sums || !out)
+            return;
+        const LocalStatsCB &cb = b.Constants<LocalStatsCB>(0);
+        if (cb.mode != 0 && !squares)
+            return;
+
+        ForEachThread(g, std::min(out->width, sums->width), std::min(out->height, sums->height), [&](uint32_t x, uint32_t y)
+        {
+            const int x0 = std::max(int(x) - cb.radius, 0), x1 = std::min(int(x) + cb.radius, int(sums->width) - 1);
+            const int y0 = std::max(int(y) - cb.radius, 0), y1 = std::min(int(y) + cb.radius, int(sums->height) - 1);
+            const float count = float((x1 - x0 + 1) * (y1 - y0 + 1));
+
+            const CPUFloat4 mean = ToFloat4(WindowSum(*sums, x0, y0, x1, y1)) * (1.f / count);
+            if (cb.mode == 0)
+            {
+                out->Store(x, y, mean * (1.f / 255.f));
+                return;
+            }
+            const CPUFloat4 square = ToFloat4(WindowSum(*squares, x0, y0, x1, y1)) * (1.f / count);
+            auto deviation = [&](float s, float m)
+            {
+                return saturate(std::sqrt(std::max(s - m * m, 0.f)) / 255.f * cb.gain);
+            };
+            out->Store(x, y, CPUFloat4(deviation(square.x, mean.x), deviation(square.y, mean.y), deviation(square.z, mean.z), 1.f));
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // guidedCoeffs.hlsl / guidedOutput.hlsl
+    //--------------------------------------------------------------------------------------
+    struct GuidedCB
+    {
+        int32_t radius;
+        float epsilon;
+    };
+
+    void GuidedCoeffs(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *guideSums = b.srv[0];
+        const FCPUGHITexture *guideSquares = b.srv[1];
+        const FCPUGHITexture *inputSums = b.srv[2];
+        const FCPUGHITexture *inputProducts = b.srv[3];
+        FCPUGHITexture *mapA = b.uav[0];
+        FCPUGHITexture *mapB = b.uav[1];
+        if (!guideSums || !guideSquares || !inputSums || !inputProducts || !mapA || !mapB)
+            return;
+        const GuidedCB &cb = b.Constants<GuidedCB>(0);
+        const int width = int(guideSums->width), height = int(guideSums->height);
+
+        ForEachThread(g, guideSums->width, guideSums->height, [&](uint32_t x, uint32_t y)
+        {
+            const int x0 = std::max(int(x) - cb.radius, 0), x1 = std::min(int(x) + cb.radius, width - 1);
+            const int y0 = std::max(int(y) - cb.radius, 0), y1 = std::min(int(y) + cb.radius, height - 1);
+            // The tables count texels as 8 bit integers, the means are brought back to [0, 1].
+            const float scale = 1.f / (float((x1 - x0 + 1) * (y1 - y0 + 1)) * 255.f);
+
+            const CPUFloat4 meanI = ToFloat4(WindowSum(*guideSums, x0, y0, x1, y1)) * scale;
+            const CPUFloat4 meanP = ToFloat4(WindowSum(*inputSums, x0, y0, x1, y1)) * scale;
+            const CPUFloat4 meanII = ToFloat4(WindowSum(*guideSquares, x0, y0, x1, y1)) * (scale / 255.f);
+            const CPUFloat4 meanIP = ToFloat4(WindowSum(*inputProducts, x0, y0, x1, y1)) * (scale / 255.f);
+
+            auto coefficient = [&](float mI, float mP, float mII, float mIP)
+            {
+                return (mIP - mI * mP) / (std::max(mII - mI * mI, 0.f) + cb.epsilon);
+            };
+            const CPUFloat4 a(coefficient(meanI.x, meanP.x, meanII.x, meanIP.x), coefficient(meanI.y, meanP.y, meanII.y, meanIP.y),
+                coefficient(meanI.z, meanP.z, meanII.z, meanIP.z), coefficient(meanI.w, meanP.w, meanII.w, meanIP.w));
+            mapA->Store(x, y, a);
+            mapB->Store(x, y, CPUFloat4(meanP.x - a.x * meanI.x, meanP.y - a.y * meanI.y, meanP.z - a.z * meanI.z, meanP.w - a.w * meanI.w));
+        });
+    }
+
+    void GuidedOutput(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *guide = b.srv[0];
+        const FCPUGHITexture *meanA = b.srv[1];
+        const FCPUGHITexture *meanB = b.srv[2];
+        const FCPUGHITexture *in = b.srv[3];
+        FCPUGHITexture *out = b.uav[0];
+        if (!guide || !meanA || !meanB || !in || !out)
+            return;
+
+        ForEachThread(g, out->width, out->height, [&](uint32_t x, uint32_t y)
+        {
+            const CPUFloat4 I = guide->Load(x, y), a = meanA->Load(x, y), m = meanB->Load(x, y);
+            out->Store(x, y, CPUFloat4(a.x * I.x + m.x, a.y * I.y + m.y, a.z * I.z + m.z, in->Load(x, y).w));
+        });
+    }
+
+    //--------------------------------------------------------------------------------------
+    // localContrast.hlsl
+    //--------------------------------------------------------------------------------------
+    struct LocalContrastCB
+    {
+        uint32_t mip;
+        float amount;
+        float invScale;
+    };
+
+    void LocalContrast(const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        const FCPUGHITexture *in = b.srv[0];
+        const FCPUGHITexture *pyramid = b.srv[1];
+        FCPUGHITexture *out = b.uav[0];
+        if (!in || !pyramid || !out)
+            return;
+        const LocalContrastCB &cb = b.Constants<LocalContrastCB>(0);
+        const FCPUGHITexture *mip = pyramid->Mip(cb.mip);
+        if (!mip)
+            return;
+        const float gain = 1.f + cb.amount;
+
+        ForEachThread(g, out->width, out->height, [&](uint32_t x, uint32_t y)
+        {
+            const float u = (float(x) + 0.5f) * cb.invScale / float(mip->width);
+            const float v = (float(y) + 0.5f) * cb.invScale / float(mip->height);
+            CPUFloat4 data = in->Load(x, y);
+            CPUFloat4 base = pyramid->SampleLevel(b.sampler[0], u, v, float(cb.mip));
+            CPUFloat4 result = base + (data - base) * gain;
+            out->Store(x, y, CPUFloat4(result.x, result.y, result.z, data.w));
+        });
+    }
+}
+
+void RegisterCPUKernels()
+{
+    CPUKernelRegistry::Register("test.hlsl", [](const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        Bilateral(b, g, int(b.Constants<uint32_t>(0)));
+    });
+    CPUKernelRegistry::Register("bilateral.hlsl", [](const FCPUBindings &b, const FCPUThreadGroup &g)
+    {
+        Bilateral(b, g, 15);
+    });
+    CPUKernelRegistry::Register("bilateralSeparable.hlsl", BilateralSeparable, 128, 1);
+    CPUKernelRegistry::Register("gaussian.hlsl", GaussianPass, 128, 1);
+    CPUKernelRegistry::Register("boxBlur.hlsl", BoxPass, 64, 1);
+    CPUKernelRegistry::Register("fishEye.hlsl", FishEye);
+    CPUKernelRegistry::Register("swirl.hlsl", Swirl);
+    CPUKernelRegistry::Register("lensCircle.hlsl", LensCircle);
+    CPUKernelRegistry::Register("fishEyeTable.hlsl", FishEyeTable);
+    CPUKernelRegistry::Register("swirlTable.hlsl", SwirlTable);
+    CPUKernelRegistry::Register("lensCircleTable.hlsl", LensCircleTable);
+    CPUKernelRegistry::Register("remap.hlsl", Remap);
+    CPUKernelRegistry::Register("remapWeight.hlsl", RemapWeight);
+    CPUKernelRegistry::Register("denoise.hlsl", Denoise);
+    CPUKernelRegistry::Register("pointwise.hlsl", Pointwise);
+    CPUKernelRegistry::Register("lut.hlsl", ApplyLUT);
+    CPUKernelRegistry::Register("luma.hlsl", Luma);
+    CPUKernelRegistry::Register("sobelNms.hlsl", SobelNms, 32, 8);
+    CPUKernelRegistry::Register("hysteresis.hlsl", Hysteresis);
+    CPUKernelRegistry::Register("downsample.hlsl", Downsample, 8, 8);
+    CPUKernelRegistry::Register("localContrast.hlsl", LocalContrast);
+    CPUKernelRegistry::Register("satRows.hlsl", SATRows, 64, 1);
+    CPUKernelRegistry::Register("satColumns.hlsl", SATColumns, 64, 1);
+    CPUKernelRegistry::Register("localStats.hlsl", LocalStats);
+    CPUKernelRegistry::Register("guidedCoeffs.hlsl", GuidedCoeffs);
+    CPUKernelRegistry::Register("guidedOutput.hlsl", GuidedOutput);
+}
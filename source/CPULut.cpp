@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cstring>
+#include "CPULut.h"
+
+using namespace GHI;
+
+namespace
+{
+    const uint32_t LUT_1D = 0;
+    const uint32_t LUT_TETRAHEDRAL = 2;
+
+    inline bool UseSSE()
+    {
+        return CPU_SIMD_X86 && CPUSimd() >= CPUSimdSSE;
+    }
+
+    struct Table
+    {
+        const FCPUGHITexture &lut;
+        uint32_t size;
+
+        //! Entry i of a 1D table, (r, g, b) of a cube : four floats of the texture.
+        const float* Entry(uint32_t i) const
+        {
+            return reinterpret_cast<const float*>(lut.Row(0) + size_t(i) * 16);
+        }
+        const float* Entry(uint32_t r, uint32_t g, uint32_t b) const
+        {
+            return reinterpret_cast<const float*>(lut.Row(b) + size_t(r + size * g) * 16);
+        }
+    };
+
+    //! Lattice cell i and position f in it of each channel of c, as lut.hlsl computes them.
+    inline void Cell(const CPULUTParams &params, const float c[4], uint32_t i[4], float f[4])
+    {
+        const float last = float(params.size - 1);
+        for (int k = 0; k < 4; ++k)
+        {
+            const float p = std::min(std::max((c[k] - params.domainMin[k]) * params.domainScale[k], 0.f), last);
+            i[k] = std::min(uint32_t(p), params.size - 2);
+            f[k] = p - float(i[k]);
+        }
+    }
+
+    //! The axes of the tetrahedron holding f by decreasing fraction, see Tetrahedral() in lut.hlsl.
+    inline void TetrahedronAxes(const float f[4], int axes[3])
+    {
+        if (f[0] > f[1])
+        {
+            if (f[1] > f[2])      { axes[0] = 0; axes[1] = 1; axes[2] = 2; }
+            else if (f[0] > f[2]) { axes[0] = 0; axes[1] = 2; axes[2] = 1; }
+            else                  { axes[0] = 2; axes[1] = 0; axes[2] = 1; }
+        }
+        else
+        {
+            if (f[2] > f[1])      { axes[0] = 2; axes[1] = 1; axes[2] = 0; }
+            else if (f[2] > f[0]) { axes[0] = 1; axes[1] = 2; axes[2] = 0; }
+            else                  { axes[0] = 1; axes[1] = 0; axes[2] = 2; }
+        }
+    }
+
+    void LookUp(const Table &table, const CPULUTParams &params, const float c[4], float result[4])
+    {
+        uint32_t i[4];
+        float f[4];
+        Cell(params, c, i, f);
+        if (params.mode == LUT_1D)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                const float a = table.Entry(i[k])[k], b = table.Entry(i[k] + 1)[k];
+                result[k] = a + (b - a) * f[k];
+            }
+            return;
+        }
+
+        if (params.mode == LUT_TETRAHEDRAL)
+        {
+            int axes[3];
+            TetrahedronAxes(f, axes);
+            uint32_t corner[3] = { i[0], i[1], i[2] };
+            const float *previous = table.Entry(corner[0], corner[1], corner[2]);
+            for (int k = 0; k < 3; ++k)
+                result[k] = previous[k];
+            for (int step = 0; step < 3; ++step)
+            {
+                ++corner[axes[step]];
+                const float *next = table.Entry(corner[0], corner[1], corner[2]);
+                for (int k = 0; k < 3; ++k)
+                    result[k] = result[k] + (next[k] - previous[k]) * f[axes[step]];
+                previous = next;
+            }
+        }
+        else
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                float c0[2];
+                for (uint32_t b = 0; b < 2; ++b)
+                {
+                    float cg[2];
+                    for (uint32_t g = 0; g < 2; ++g)
+                    {
+                        const float e0 = table.Entry(i[0], i[1] + g, i[2] + b)[k];
+                        const float e1 = table.Entry(i[0] + 1, i[1] + g, i[2] + b)[k];
+                        cg[g] = e0 + (e1 - e0) * f[0];
+                    }
+                    c0[b] = cg[0] + (cg[1] - cg[0]) * f[1];
+                }
+                result[k] = c0[0] + (c0[1] - c0[0]) * f[2];
+            }
+        }
+        result[3] = c[3];
+    }
+
+#if CPU_SIMD_X86
+    inline __m128 Lerp(__m128 a, __m128 b, __m128 t)
+    {
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+    }
+
+    inline __m128 Lane(__m128 v, int k)
+    {
+        alignas(16) float f[4];
+        _mm_store_ps(f, v);
+        return _mm_set1_ps(f[k]);
+    }
+
+    //! The same arithmetic as LookUp(), an entry of the table per register.
+    __m128 LookUpSSE(const Table &table, const CPULUTParams &params, __m128 c)
+    {
+        __m128 p = _mm_mul_ps(_mm_sub_ps(c, _mm_loadu_ps(params.domainMin)), _mm_loadu_ps(params.domainScale));
+        p = _mm_min_ps(_mm_max_ps(p, _mm_setzero_ps()), _mm_set1_ps(float(params.size - 1)));
+        __m128i cell = _mm_cvttps_epi32(p);
+        cell = _mm_add_epi32(cell, _mm_cmpgt_epi32(cell, _mm_set1_epi32(int(params.size - 2)))); // min(cell, size - 2)
+        const __m128 f = _mm_sub_ps(p, _mm_cvtepi32_ps(cell));
+        alignas(16) uint32_t i[4];
+        _mm_store_si128((__m128i*)i, cell);
+
+        if (params.mode == LUT_1D)
+        {
+            __m128 a = _mm_setzero_ps(), b = _mm_setzero_ps();
+            for (int k = 0; k < 4; ++k)
+            {
+                alignas(16) int32_t lane[4] = {};
+                lane[k] = -1;
+                const __m128 mask = _mm_castsi128_ps(_mm_load_si128((const __m128i*)lane));
+                a = _mm_or_ps(a, _mm_and_ps(mask, _mm_loadu_ps(table.Entry(i[k]))));
+                b = _mm_or_ps(b, _mm_and_ps(mask, _mm_loadu_ps(table.Entry(i[k] + 1))));
+            }
+            return Lerp(a, b, f);
+        }
+
+        __m128 result;
+        if (params.mode == LUT_TETRAHEDRAL)
+        {
+            alignas(16) float fractions[4];
+            _mm_store_ps(fractions, f);
+            int axes[3];
+            TetrahedronAxes(fractions, axes);
+            uint32_t corner[3] = { i[0], i[1], i[2] };
+            __m128 previous = _mm_loadu_ps(table.Entry(corner[0], corner[1], corner[2]));
+            result = previous;
+            for (int step = 0; step < 3; ++step)
+            {
+                ++corner[axes[step]];
+                const __m128 next = _mm_loadu_ps(table.Entry(corner[0], corner[1], corner[2]));
+                result = _mm_add_ps(result, _mm_mul_ps(_mm_sub_ps(next, previous), _mm_set1_ps(fractions[axes[step]])));
+                previous = next;
+            }
+        }
+        else
+        {
+            const __m128 fr = Lane(f, 0), fg = Lane(f, 1), fb = Lane(f, 2);
+            __m128 c0[2];
+            for (uint32_t b = 0; b < 2; ++b)
+            {
+                const __m128 cg0 = Lerp(_mm_loadu_ps(table.Entry(i[0], i[1], i[2] + b)), _mm_loadu_ps(table.Entry(i[0] + 1, i[1], i[2] + b)), fr);
+                const __m128 cg1 = Lerp(_mm_loadu_ps(table.Entry(i[0], i[1] + 1, i[2] + b)), _mm_loadu_ps(table.Entry(i[0] + 1, i[1] + 1, i[2] + b)), fr);
+                c0[b] = Lerp(cg0, cg1, fg);
+            }
+            result = Lerp(c0[0], c0[1], fb);
+        }
+        // alpha of the input
+        const __m128 alpha = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+        return _mm_or_ps(_mm_andnot_ps(alpha, result), _mm_and_ps(alpha, c));
+    }
+
+    inline __m128 LoadRGBA8(const uint8_t *p)
+    {
+        int32_t v;
+        memcpy(&v, p, 4);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i c = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero);
+        return _mm_mul_ps(_mm_cvtepi32_ps(c), _mm_set1_ps(1.f / 255.f));
+    }
+
+    //! FloatToUNorm8() of the four channels.
+    inline void StoreRGBA8(uint8_t *p, __m128 c)
+    {
+        c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1.f));
+        const __m128i v = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f)));
+        const int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(v, v), _mm_setzero_si128()));
+        memcpy(p, &bytes, 4);
+    }
+#endif
+}
+
+void CPUApplyLUT(const FCPUGHITexture &in, const FCPUGHITexture &lut, FCPUGHITexture &out,
+    uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, const CPULUTParams &params)
+{
+    x1 = std::min(x1, out.width);
+    y1 = std::min(y1, out.height);
+    if (x0 >= x1 || y0 >= y1 || params.size < 2 || lut.desc.Format != PixelFormat_R32G32B32A32_FLOAT)
+        return;
+    const bool is1D = params.mode == LUT_1D;
+    if (lut.width < (is1D ? params.size : params.size * params.size) || lut.height < (is1D ? 1 : params.size))
+        return;
+
+    const Table table = { lut, params.size };
+    const bool bytesIn = in.desc.Format == PixelFormat_R8G8B8A8_UNORM;
+    const bool bytesOut = out.desc.Format == PixelFormat_R8G8B8A8_UNORM;
+    const bool sse = UseSSE();
+    for (uint32_t y = y0; y < y1; ++y)
+    {
+        const bool rowIn = bytesIn && y < in.height;
+        for (uint32_t x = x0; x < x1; ++x)
+        {
+            const bool texelIn = rowIn && x < in.width;
+#if CPU_SIMD_X86
+            if (sse)
+            {
+                __m128 c;
+                if (texelIn)
+                {
+                    c = LoadRGBA8(in.Row(y) + size_t(x) * 4);
+                }
+                else
+                {
+                    const CPUFloat4 texel = in.Load(int(x), int(y));
+                    c = _mm_loadu_ps(&texel.x);
+                }
+                const __m128 result = LookUpSSE(table, params, c);
+                if (bytesOut)
+                {
+                    StoreRGBA8(out.Row(y) + size_t(x) * 4, result);
+                }
+                else
+                {
+                    CPUFloat4 texel;
+                    _mm_storeu_ps(&texel.x, result);
+                    out.Store(int(x), int(y), texel);
+                }
+                continue;
+            }
+#endif
+            const CPUFloat4 texel = in.Load(int(x), int(y));
+            CPUFloat4 result;
+            LookUp(table, params, &texel.x, &result.x);
+            out.Store(int(x), int(y), result);
+        }
+    }
+}
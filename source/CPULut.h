@@ -0,0 +1,27 @@
+#ifndef CPU_LUT_H_
+#define CPU_LUT_H_
+
+#include <cstdint>
+#include "FCPUGHIResources.h"
+#include "CPUSimd.h"
+
+//--------------------------------------------------------------------------------------
+// lut.hlsl for the CPU backend. The table is read straight from the floats of its
+// R32G32B32A32_FLOAT texture and 8 bit images straight from their bytes; an entry of the
+// table is one SSE register, so the lerps of a cube are four wide, the channels of a 1D
+// table are picked out with lane masks. The scalar path is there to compare.
+//--------------------------------------------------------------------------------------
+struct CPULUTParams
+{
+	uint32_t size;
+	uint32_t mode; //< LUT_ defines of lut.hlsl
+	float pad[2];
+	float domainMin[4];
+	float domainScale[4];
+};
+
+//! Output pixels [x0, x1) x [y0, y1) of in mapped through the table lut.
+void CPUApplyLUT(const GHI::FCPUGHITexture &in, const GHI::FCPUGHITexture &lut, GHI::FCPUGHITexture &out,
+	uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, const CPULUTParams &params);
+
+#endif
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <atomic>
+#include "CPUSimd.h"
+
+#if CPU_SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    ECPUSimd DetectSimd()
+    {
+#if CPU_SIMD_X86
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        // The OS must save the YMM registers too.
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+        {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5))
+                return CPUSimdAVX2;
+        }
+        return CPUSimdSSE;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? CPUSimdAVX2 : CPUSimdSSE;
+#endif
+#else
+        return CPUSimdScalar;
+#endif
+    }
+
+    std::atomic<int>& ActiveSimd()
+    {
+        static std::atomic<int> simd{ int(CPUSimdSupported()) };
+        return simd;
+    }
+}
+
+ECPUSimd CPUSimdSupported()
+{
+    static const ECPUSimd supported = DetectSimd();
+    return supported;
+}
+
+void SetCPUSimd(ECPUSimd simd)
+{
+    ActiveSimd() = int(std::min(simd, CPUSimdSupported()));
+}
+
+ECPUSimd CPUSimd()
+{
+    return ECPUSimd(ActiveSimd().load());
+}
+
+const char* CPUSimdName(ECPUSimd simd)
+{
+    switch (simd)
+    {
+    case CPUSimdAVX2: return "AVX2";
+    case CPUSimdSSE: return "SSE";
+    default: return "scalar";
+    }
+}
+
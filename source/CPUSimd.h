@@ -0,0 +1,36 @@
+#ifndef CPU_SIMD_H_
+#define CPU_SIMD_H_
+
+//--------------------------------------------------------------------------------------
+// Instruction sets the vectorized CPU kernels are built for, chosen at run time.
+// CPU_SIMD_X86 is 1 where the SSE / AVX2 paths are compiled, functions using AVX2
+// are declared CPU_TARGET_AVX2 so the rest of the file stays plain x86-64.
+//--------------------------------------------------------------------------------------
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define CPU_TARGET_AVX2
+#else
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define CPU_SIMD_X86 0
+#endif
+
+enum ECPUSimd
+{
+	CPUSimdScalar = 0,
+	CPUSimdSSE = 1,
+	CPUSimdAVX2 = 2,
+};
+
+//! Widest instruction set of this CPU the kernels are built for.
+ECPUSimd CPUSimdSupported();
+//! Instruction set the kernels use, CPUSimdSupported() by default. Wider ones than the
+//! CPU supports are lowered to it, narrower ones are there to compare.
+void SetCPUSimd(ECPUSimd simd);
+ECPUSimd CPUSimd();
+const char* CPUSimdName(ECPUSimd simd);
+
+#endif
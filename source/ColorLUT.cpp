@@ -0,0 +1,165 @@
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include "ColorLUT.h"
+
+ColorLUT ColorLUT::Identity(EColorLUTType type, uint32_t size)
+{
+	ColorLUT lut;
+	lut.type = type;
+	lut.size = size;
+	lut.title = "identity";
+	lut.entries.resize(size_t(lut.TextureWidth()) * lut.TextureHeight() * 4);
+	const float scale = 1.f / float(size - 1); // as 8 bit texels load : k * (1 / 255)
+	float *e = lut.entries.data();
+	if (type == ColorLUT1D)
+	{
+		for (uint32_t i = 0; i < size; ++i, e += 4)
+			e[0] = e[1] = e[2] = e[3] = float(i) * scale;
+		return lut;
+	}
+	for (uint32_t b = 0; b < size; ++b)
+	{
+		for (uint32_t g = 0; g < size; ++g)
+		{
+			for (uint32_t r = 0; r < size; ++r, e += 4)
+			{
+				e[0] = float(r) * scale;
+				e[1] = float(g) * scale;
+				e[2] = float(b) * scale;
+				e[3] = 1.f;
+			}
+		}
+	}
+	return lut;
+}
+
+bool ColorLUT::LoadCube(const std::string &filename, std::string &error)
+{
+	std::ifstream stream(filename);
+	if (!stream)
+	{
+		error = "can not open '" + filename + "'";
+		return false;
+	}
+	if (!ParseCube(stream, error))
+	{
+		error = filename + ": " + error;
+		return false;
+	}
+	if (title.empty())
+		title = filename.substr(filename.find_last_of("\\/") + 1);
+	return true;
+}
+
+bool ColorLUT::ParseCube(std::istream &stream, std::string &error)
+{
+	ColorLUT lut;
+	std::vector<float> rgb;
+	std::string line;
+	for (int number = 1; std::getline(stream, line); ++number)
+	{
+		std::istringstream words(line);
+		std::string keyword;
+		if (!(words >> keyword) || keyword[0] == '#')
+			continue;
+		const std::string where = "line " + std::to_string(number) + ": ";
+		if (keyword == "TITLE")
+		{
+			const size_t open = line.find('"'), close = line.rfind('"');
+			lut.title = open < close ? line.substr(open + 1, close - open - 1) : "";
+		}
+		else if (keyword == "LUT_1D_SIZE" || keyword == "LUT_3D_SIZE")
+		{
+			const EColorLUTType type = keyword == "LUT_1D_SIZE" ? ColorLUT1D : ColorLUT3D;
+			long size = 0;
+			if (!(words >> size) || size < 2 || uint32_t(size) > (type == ColorLUT1D ? MAX_1D_SIZE : MAX_3D_SIZE))
+			{
+				error = where + keyword + " is not in 2.." + std::to_string(type == ColorLUT1D ? MAX_1D_SIZE : MAX_3D_SIZE);
+				return false;
+			}
+			if (lut.size)
+			{
+				error = where + "a 1D shaper in front of the cube is not supported";
+				return false;
+			}
+			lut.type = type;
+			lut.size = uint32_t(size);
+		}
+		else if (keyword == "DOMAIN_MIN" || keyword == "DOMAIN_MAX")
+		{
+			float *domain = keyword == "DOMAIN_MIN" ? lut.domainMin : lut.domainMax;
+			if (!(words >> domain[0] >> domain[1] >> domain[2]))
+			{
+				error = where + keyword + " needs three values";
+				return false;
+			}
+		}
+		else if (keyword == "LUT_1D_INPUT_RANGE" || keyword == "LUT_3D_INPUT_RANGE")
+		{
+			float low, high;
+			if (!(words >> low >> high))
+			{
+				error = where + keyword + " needs two values";
+				return false;
+			}
+			for (int c = 0; c < 3; ++c)
+			{
+				lut.domainMin[c] = low;
+				lut.domainMax[c] = high;
+			}
+		}
+		else
+		{
+			std::istringstream values(line);
+			float r, g, b;
+			if (!(values >> r >> g >> b))
+			{
+				const bool number = std::isdigit((unsigned char)keyword[0]) || keyword[0] == '-' || keyword[0] == '+' || keyword[0] == '.';
+				error = where + (number ? "an entry needs three values" : "unknown keyword '" + keyword + "'");
+				return false;
+			}
+			rgb.insert(rgb.end(), { r, g, b });
+		}
+	}
+
+	if (!lut.size)
+	{
+		error = "no LUT_1D_SIZE or LUT_3D_SIZE";
+		return false;
+	}
+	for (int c = 0; c < 3; ++c)
+	{
+		if (!(lut.domainMax[c] > lut.domainMin[c]))
+		{
+			error = "DOMAIN_MAX is not above DOMAIN_MIN";
+			return false;
+		}
+	}
+	const size_t count = size_t(lut.TextureWidth()) * lut.TextureHeight();
+	if (rgb.size() != count * 3)
+	{
+		error = std::to_string(rgb.size() / 3) + " entries, " + std::to_string(count) + " expected";
+		return false;
+	}
+
+	// Alpha is left as it is : the identity curve in a 1D table, unused in a cube.
+	lut.entries = Identity(lut.type, lut.size).entries;
+	for (size_t i = 0; i < count; ++i)
+	{
+		for (int c = 0; c < 3; ++c)
+			lut.entries[i * 4 + c] = rgb[i * 3 + c];
+	}
+	*this = std::move(lut);
+	return true;
+}
+
+GHI::TextureDesc2D ColorLUT::TextureDesc() const
+{
+	GHI::TextureDesc2D desc;
+	desc.Width = TextureWidth();
+	desc.Height = TextureHeight();
+	desc.Format = GHI::PixelFormat_R32G32B32A32_FLOAT;
+	desc.BindFlags = GHI::BindFlag_SHADER_RESOURCE | GHI::BindFlag_UNORDERED_ACCESS;
+	return desc;
+}
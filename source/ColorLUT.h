@@ -0,0 +1,55 @@
+#ifndef COLOR_LUT_H_
+#define COLOR_LUT_H_
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "GHIResources.h"
+
+//--------------------------------------------------------------------------------------
+// Colour lookup tables for lut.hlsl : a 1D table maps every channel on its own, a 3D
+// table (a cube) maps the rgb triplet at once. The entries are RGBA floats in the layout
+// of the R32G32B32A32_FLOAT texture the shader reads : the N entries of a 1D table are an
+// N x 1 texture, entry (r, g, b) of an N^3 cube is texel (r + N g, b) of an N^2 x N
+// texture, which is the order of the data lines of a .cube file.
+//--------------------------------------------------------------------------------------
+enum EColorLUTType
+{
+	ColorLUT1D = 0,
+	ColorLUT3D = 1,
+};
+
+struct ColorLUT
+{
+	static constexpr uint32_t MAX_1D_SIZE = 16384; //< entries in a texture row
+	static constexpr uint32_t MAX_3D_SIZE = 128;   //< N^2 entries in a texture row
+
+	EColorLUTType type = ColorLUT3D;
+	uint32_t size = 0;
+	float domainMin[3] = { 0.f, 0.f, 0.f }; //< input mapped to the first entry
+	float domainMax[3] = { 1.f, 1.f, 1.f }; //< and to the last one
+	std::string title;
+	std::vector<float> entries;             //< rgba, alpha is the alpha curve of a 1D table
+
+	//! Each entry holds its own lattice point, alpha 1 in a cube. Baking runs a filter over it.
+	static ColorLUT Identity(EColorLUTType type, uint32_t size);
+
+	//! Reads an Adobe / Resolve .cube file : TITLE, LUT_1D_SIZE or LUT_3D_SIZE, DOMAIN_MIN /
+	//! DOMAIN_MAX or LUT_xD_INPUT_RANGE and the entries. error tells what is wrong otherwise.
+	bool LoadCube(const std::string &filename, std::string &error);
+	bool ParseCube(std::istream &stream, std::string &error);
+
+	uint32_t TextureWidth() const
+	{
+		return type == ColorLUT1D ? size : size * size;
+	}
+	uint32_t TextureHeight() const
+	{
+		return type == ColorLUT1D ? 1 : size;
+	}
+	GHI::TextureDesc2D TextureDesc() const;
+};
+
+#endif
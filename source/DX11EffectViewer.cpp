@@ -1,9 +1,17 @@
+#include <algorithm>
+#include <chrono>
+#include <shellapi.h>
 #include "DX11EffectViewer.h"
 #include "Utils.h"
-
-#define STBI_MSC_SECURE_CRT
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
+#include "BatchProcessor.h"
+#include "FilterBenchmark.h"
+#include "CPUKernels.h"
+#include "ImageIO.h"
+#include "DX11.h"
+#include "FDX11GHICommandContext.h"
+#include "FCPUGHICommandContext.h"
+#include "PNGWriter.h"
+#include "ShaderDiskCache.h"
 
 #define IMAGE_REPO "..\\images"
 
@@ -21,11 +29,11 @@ void SafeRelease(T **ppT)
 int	DX11EffectViewer::initialize()
 {
 	loadImage(m_defaultImage); //< Load source image as texture and upate image size.
-	mFinalTexture = commandContext->CreateTextureByAnother(mSrcTexture);
-	mDstTexture = commandContext->CreateTextureByAnother(mSrcTexture);
+	acquireTargets();
 
     getFiles(IMAGE_REPO , mImageList);
     mCurrentImage = mImageList.begin();
+	mPrefetcher.Start(mImageList, 1);
 
 	INFO("DX11EffectViewer Initialized, default image:%s\n", m_defaultImage.c_str());
 	return 0;
@@ -84,18 +92,104 @@ bool DX11EffectViewer::CreateCSConstBuffer()
 //////////////////////////////////////////////////////////////////////////////////////////////////
 bool DX11EffectViewer::loadImage(std::string imagefile)
 {
-	mSrcTexture = commandContext->CreateTexture(imagefile);
+	DecodedImage image;
+	DecodeOptions options;
+	options.halfFloatHDR = true;
+	return LoadImageRGBA8(imagefile, image, options) && setSourceTexture(uploadImage(image));
+}
+
+//! The decoded rows have the pitch of the texture, they upload as they are.
+GHI::GHITexture* DX11EffectViewer::uploadImage(const DecodedImage &image)
+{
+	GHI::TextureDesc2D desc;
+	desc.Width = image.width;
+	desc.Height = image.height;
+	desc.Format = image.format;
+	return commandContext->TexturePool().Adopt(commandContext->CreateTexture(desc, image.pixels.Data()));
+}
+
+//! The previous image stays current when texture is not usable.
+bool DX11EffectViewer::setSourceTexture(GHI::GHITexture *texture)
+{
+	GHI::GHITexturePool &pool = commandContext->TexturePool();
+	if (!texture || texture->width == 0)
+	{
+		pool.Release(texture);
+		return false;
+	}
+	pool.Release(mSrcTexture);
+	mSrcTexture = texture;
 	m_imageWidth = mSrcTexture->width;
 	m_imageHeight = mSrcTexture->height;
 	m_Aspect = mSrcTexture->aspect;
 	m_textureSizeInBytes = mSrcTexture->textureSizeInBytes;
 
-	return m_imageWidth > 0 ? true : false;
+	return true;
+}
+
+//! Images are decoded ahead on the prefetcher workers, a switch only uploads. Presses
+//! made while the next image is still decoding skip the images in between.
+void DX11EffectViewer::pollNextImage()
+{
+	ImagePrefetcher::Image image;
+	while (mImageSwitches > 0 && mPrefetcher.Next(image))
+	{
+		if (--mImageSwitches > 0)
+			continue;
+
+		if (!setSourceTexture(uploadImage(image.decoded)))
+			return;
+		mCurrentImage = mImageList.begin() + image.index;
+		DEBUG("Switch to image [%s]\n", (*mCurrentImage).c_str());
+		acquireTargets();
+		activeCurFilter();
+	}
+}
+
+//! Result textures of the current image size, the old ones go back to the pool.
+void DX11EffectViewer::acquireTargets()
+{
+	GHI::GHITexturePool &pool = commandContext->TexturePool();
+	pool.Release(mDstTexture);
+	pool.Release(mFinalTexture);
+	mDstTexture = pool.AcquireLike(mSrcTexture);
+	mFinalTexture = pool.AcquireLike(mSrcTexture);
 }
 
+//! Only queues the readback, pollSaveResult() encodes it once the GPU copy is done.
 void DX11EffectViewer::SaveResult()
 {
-	stbi_write_png("output.png", m_imageWidth, m_imageHeight, 4, GetResultImage(), m_imageWidth * 4);
+	if (mSaveTicket == 0)
+		mSaveTicket = commandContext->ReadTextureAsync(mFinalTexture);
+}
+
+void DX11EffectViewer::pollSaveResult()
+{
+	if (mSaveTicket == 0)
+		return;
+
+	std::shared_ptr<GHI::GHIReadbackData> data = std::make_shared<GHI::GHIReadbackData>();
+	GHI::EReadbackStatus status = commandContext->PollReadback(mSaveTicket, *data);
+	if (status == GHI::EReadbackStatus::Pending)
+		return;
+	mSaveTicket = 0;
+	if (status != GHI::EReadbackStatus::Ready)
+	{
+		EINFO("readback of the result image failed\n");
+		return;
+	}
+
+	// Encoding takes longer than a frame, keep it off the frame loop.
+	PNGWriteOptions options;
+	options.level = mPNGLevel;
+	GHI::ThreadPool::Global().Submit([data, options]()
+	{
+		GHI::ConvertReadbackToRGBA8(*data); // HDR images are filtered in half floats
+		if (WritePNGRGBA8("output.png", data->width, data->height, data->pixels.data(), data->rowPitch, options))
+			INFO("result saved to output.png\n");
+		else
+			EINFO("can not write output.png\n");
+	});
 }
 
 /**
@@ -104,33 +198,10 @@ void DX11EffectViewer::SaveResult()
  */
 byte* DX11EffectViewer::GetResultImage()
 {
-#if 0 
-	if (!m_resultGPUCopy)
-	{
-		D3D11_TEXTURE2D_DESC desc;
-		ZeroMemory(&desc, sizeof(desc));
-		m_resultImageTexture->GetDesc(&desc);
-		desc.Usage = D3D11_USAGE_STAGING; // Support data copy from GPU to CPU.
-		desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-		desc.BindFlags = 0;
-		desc.MiscFlags = 0;
-		D3D11_CALL_CHECK(m_pd3dDevice->CreateTexture2D(&desc, NULL, &m_resultGPUCopy));
-		
-	}
-	if (!m_resultCPUCopy)
-	{
-		m_resultCPUCopy = new byte[m_textureSizeInBytes];
-	}
-
-	m_pImmediateContext->CopyResource(m_resultGPUCopy, m_resultImageTexture); // Copy resource by GPU
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	D3D11_CALL_CHECK(m_pImmediateContext->Map(m_resultGPUCopy, 0, D3D11_MAP_READ, 0, &mappedResource));
-	memcpy(m_resultCPUCopy, mappedResource.pData, m_textureSizeInBytes); // copy from GPU meory into CPU memory.
-	m_pImmediateContext->Unmap(m_resultGPUCopy, 0);
-	return m_resultCPUCopy; // return CPU copy of GPU resource.
-
-#endif
-    return 0;
+	mResultCPUCopy.resize(size_t(mFinalTexture->width) * mFinalTexture->height * GHI::BytesPerPixel(mFinalTexture->format));
+	if (!commandContext->ReadTexture(mFinalTexture, mResultCPUCopy.data()))
+		return nullptr;
+	return mResultCPUCopy.data(); // return CPU copy of GPU resource.
 }
 
 void DX11EffectViewer::WindowMessageCallback(void* context, HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
@@ -183,8 +254,168 @@ void DX11EffectViewer::WindowMessageCallback(void* context, HWND hWnd, UINT mess
 	}
 }
 
+static std::vector<std::string> CommandLineArgs(LPWSTR lpCmdLine)
+{
+	std::vector<std::string> args;
+	int argc = 0;
+	LPWSTR *argv = (lpCmdLine && *lpCmdLine) ? CommandLineToArgvW(lpCmdLine, &argc) : nullptr;
+	for (int i = 0; i < argc; ++i)
+	{
+		int size = WideCharToMultiByte(CP_UTF8, 0, argv[i], -1, nullptr, 0, nullptr, nullptr);
+		std::string arg(size > 0 ? size - 1 : 0, '\0');
+		WideCharToMultiByte(CP_UTF8, 0, argv[i], -1, &arg[0], size, nullptr, nullptr);
+		args.push_back(arg);
+	}
+	if (argv)
+		LocalFree(argv);
+	return args;
+}
+
+// The exe is a windows subsystem application, report to the console it was started from.
+static void AttachParentConsole()
+{
+	if (AttachConsole(ATTACH_PARENT_PROCESS))
+	{
+		freopen("CONOUT$", "w", stdout);
+		freopen("CONOUT$", "w", stderr);
+	}
+}
+
+//! Headless run, no window and no swap chain are created.
+static int RunBatch(const std::vector<std::string> &args)
+{
+	AttachParentConsole();
+
+	BatchOptions options;
+	std::string error;
+	if (!ParseBatchOptions(args, options, error))
+	{
+		fprintf(stderr, "- [Error] %s\n%s\n", error.c_str(), BatchUsage().c_str());
+		return -1;
+	}
+
+	int failures = 0;
+	try
+	{
+		GHI::IGHIComputeCommandCotext *commandContext = nullptr;
+		if (options.backend == "cpu")
+		{
+			RegisterCPUKernels();
+			commandContext = new GHI::FCPUIGHIComputeCommandCotext;
+		}
+		else
+		{
+			DX11::Initialize(D3D_FEATURE_LEVEL_11_0);
+			commandContext = new GHI::FDX11IGHIComputeCommandCotext;
+		}
+
+		{
+			BatchProcessor processor(commandContext, options);
+			failures = processor.Run();
+		}
+
+		for (auto it = GHI::GHIResource::list.begin(); it != GHI::GHIResource::list.end(); ++it)
+		{
+			(*it)->release();
+		}
+		delete commandContext;
+		if (options.backend != "cpu")
+			DX11::Shutdown();
+	}
+	catch (GHI::Exception exception)
+	{
+		exception.ShowErrorMessage();
+		return -1;
+	}
+	return failures == 0 ? 0 : 1;
+}
+
+//! "--benchmark shaders" : creates every effect with an empty disk cache, then again
+//! with the cache filled by the first pass, and prints both startup times. The cache
+//! lives in a temporary directory, the one of the viewer is left alone.
+static int RunShaderBenchmark()
+{
+	AttachParentConsole();
+
+	std::vector<std::string> files;
+	getFiles(SHADERS_REPO, files);
+	files.erase(std::remove_if(files.begin(), files.end(), [](const std::string &file)
+	{
+		return GHI::FileExtension(file.c_str()) != "hlsl";
+	}), files.end());
+
+	std::error_code ec;
+	const std::filesystem::path directory = std::filesystem::temp_directory_path(ec) / "ImageEffectsShaderBenchmark";
+	std::filesystem::remove_all(directory, ec);
+	GHI::ShaderDiskCache diskCache(directory.string());
+
+	try
+	{
+		DX11::Initialize(D3D_FEATURE_LEVEL_11_0);
+		GHI::FDX11IGHIComputeCommandCotext *commandContext = new GHI::FDX11IGHIComputeCommandCotext;
+		commandContext->SetShaderDiskCache(&diskCache);
+
+		auto pass = [&](const char *name)
+		{
+			diskCache.ResetCounters();
+			auto t0 = std::chrono::steady_clock::now();
+			size_t created = 0;
+			for (const std::string &file : files)
+			{
+				if (commandContext->CreateComputeShader(file))
+					++created;
+			}
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+			printf("%s: %zu/%zu shaders in %.1f ms, disk cache %u hits, %u misses\n", name, created, files.size(), ms, diskCache.Hits(), diskCache.Misses());
+			return ms;
+		};
+
+		double cold = pass("cold start");
+		double warm = pass("warm start");
+		printf("speedup %.1fx\n", warm > 0. ? cold / warm : 0.);
+
+		for (auto it = GHI::GHIResource::list.begin(); it != GHI::GHIResource::list.end(); ++it)
+		{
+			(*it)->release();
+		}
+		delete commandContext;
+		DX11::Shutdown();
+	}
+	catch (GHI::Exception exception)
+	{
+		exception.ShowErrorMessage();
+		std::filesystem::remove_all(directory, ec);
+		return -1;
+	}
+	std::filesystem::remove_all(directory, ec);
+	fflush(stdout);
+	return 0;
+}
+
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow)
 {
+	std::vector<std::string> args = CommandLineArgs(lpCmdLine);
+	if (IsBatchCommandLine(args))
+	{
+		return RunBatch(args);
+	}
+	auto benchmark = std::find(args.begin(), args.end(), "--benchmark");
+	if (benchmark != args.end())
+	{
+		const std::string name = benchmark + 1 != args.end() ? *(benchmark + 1) : "";
+		if (name == "shaders")
+		{
+			return RunShaderBenchmark();
+		}
+		AttachParentConsole();
+		if (!RunFilterBenchmark(name))
+		{
+			fprintf(stderr, "%s\n  shaders : startup time of every effect with an empty and a filled disk cache\n", FilterBenchmarkUsage().c_str());
+			return -1;
+		}
+		return 0;
+	}
+
 	DX11EffectViewer viewer;
 	viewer.Run();
 	return 0;
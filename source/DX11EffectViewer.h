@@ -3,16 +3,21 @@
 // code migration. https://msdn.microsoft.com/en-us/library/windows/desktop/ee418730(v=vs.85).aspx
 //#include <DirectXMath.h>
 
+#include <chrono>
 #include <vector> 
 #include "imgui.h"
 #include "ImNodes.h"
 #include "ImNodesEz.h"
 #include "Filter.h"
+#include "FilterGraph.h"
 #include "Utils.h"
 #include "App.h"
 
 #include "GHIResources.h"
 #include "GHICommandContext.h"
+#include "ThreadPool.h"
+#include "ImagePrefetcher.h"
+#include "ShaderDiskCache.h"
 
 struct alignas(16) CB
 {
@@ -52,30 +57,21 @@ public:
     void NextEffect()
     {
 		mCurFilter+1 == mFilters.end() ? mCurFilter = mFilters.begin() : mCurFilter++;
+        selectCurFilter();
         activeCurFilter();
     }
 
     void PrevEffect()
     {
 		mCurFilter == mFilters.begin() ? mCurFilter = mFilters.end()-1 : mCurFilter--;
+        selectCurFilter();
         activeCurFilter();
     }
 
+    //! Switches once the prefetcher has decoded the next image, see pollNextImage().
     void NextImage()
     {
-        mCurrentImage+1 == mImageList.end() ? mCurrentImage = mImageList.begin() : mCurrentImage++;
-		DEBUG("Switch to image [%s]\n", (*mCurrentImage).c_str());
-
-		while (!loadImage((*mCurrentImage)))
-		{
-			DEBUG("image [%s] load failed.\n", (*mCurrentImage).c_str());
-			mCurrentImage+1 == mImageList.end() ? mCurrentImage = mImageList.begin() : mCurrentImage++;
-			DEBUG("Switch to image [%s]\n", (*mCurrentImage).c_str());
-		}
-	    mDstTexture = commandContext->CreateTextureByAnother(mSrcTexture);
-	    mFinalTexture = commandContext->CreateTextureByAnother(mSrcTexture);
-
-        activeCurFilter();
+		++mImageSwitches;
     }
 
     void UpdateEffects()
@@ -104,6 +100,8 @@ protected:
 		}
 #endif
 
+		// Filter::Init creates the compute shaders, the disk cache makes this cheap after the first start.
+		auto shaderStart = std::chrono::steady_clock::now();
 		filter = new BilaterialFilter();
 		filter->Init(commandContext);
 		filter->setSampler(linearSampler);
@@ -124,17 +122,75 @@ protected:
 		filter->setSampler(linearSampler);
 		mFilters.push_back(filter);
 
+		filter = new DenoiseFilter();
+		filter->Init(commandContext);
+		filter->setSampler(linearSampler);
+		mFilters.push_back(filter);
+
+		filter = new LocalContrastFilter();
+		filter->Init(commandContext);
+		filter->setSampler(linearSampler);
+		mFilters.push_back(filter);
+
+		filter = new GaussianBlurFilter();
+		filter->Init(commandContext);
+		filter->setSampler(linearSampler);
+		mFilters.push_back(filter);
+
+		filter = new BoxFilter();
+		filter->Init(commandContext);
+		filter->setSampler(linearSampler);
+		mFilters.push_back(filter);
+
+		filter = new LocalVarianceFilter();
+		filter->Init(commandContext);
+		filter->setSampler(linearSampler);
+		mFilters.push_back(filter);
+
+		filter = new GuidedFilter();
+		filter->Init(commandContext);
+		filter->setSampler(linearSampler);
+		mFilters.push_back(filter);
+
+		filter = new GuidedFilter(true);
+		filter->Init(commandContext);
+		filter->setSampler(linearSampler);
+		mFilters.push_back(filter);
+
+		filter = new EdgeFilter();
+		filter->Init(commandContext);
+		filter->setSampler(linearSampler);
+		mFilters.push_back(filter);
+
+		filter = new LUTFilter(new DenoiseFilter());
+		filter->Init(commandContext);
+		filter->setSampler(linearSampler);
+		mFilters.push_back(filter);
+		mShaderStartupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shaderStart).count();
+		INFO("shaders created in %.1f ms, disk cache %u hits, %u misses\n", mShaderStartupMs,
+			GHI::ShaderDiskCache::Global().Hits(), GHI::ShaderDiskCache::Global().Misses());
+
+		// Every filter is a node of the graph, F1 / F2 wire one of them between input and output.
+		for (Filter *f : mFilters)
+			mFilterNodes.push_back(mGraph.AddNode(f));
+		mChainPreset = { mFilterNodes[4], mFilterNodes[0], mFilterNodes[3] }; //< denoise -> bilateral -> lens circle
+
 		mCurFilter = mFilters.begin();
+        selectCurFilter();
         activeCurFilter();
 	}
 
 	virtual void Update(const GHI::Timer& timer) override
 	{
 		this->updateUI();
-		(*mCurFilter)->UpdateUI(commandContext);
+		mGraph.UpdateUI(commandContext);
+		pollSaveResult();
+		pollNextImage();
 	}
 	virtual void Render(const GHI::Timer& timer) override
 	{
+		if (mRunEveryFrame)
+			activeCurFilter();
 		render();
 	}
 
@@ -147,18 +203,29 @@ private:
 	void	render();
 	int     initialize();
 
+    void selectCurFilter()
+    {
+		mGraph.DisconnectAll();
+		mGraph.ConnectChain({ mFilterNodes[mCurFilter - mFilters.begin()] });
+    }
+
+    //! Runs the graph, each node is profiled under its filter's description.
     void activeCurFilter()
     {
-		(*mCurFilter)->addInput(mSrcTexture);
-		(*mCurFilter)->addOutput(mDstTexture);
-		(*mCurFilter)->Active(commandContext);
-		commandContext->CopyTexture(mFinalTexture, mDstTexture); //< dst <-- src
+		if (mGraph.Execute(commandContext, mSrcTexture, mDstTexture))
+			commandContext->CopyTexture(mFinalTexture, mDstTexture); //< dst <-- src
     }
 
     std::vector<std::string> mImageList;
     std::vector<std::string>::iterator mCurrentImage;
+	ImagePrefetcher mPrefetcher;
+	uint32_t mImageSwitches = 0; //< F3 presses not served yet, only the last one is uploaded
 
 	bool loadImage(std::string imagefile);
+	GHI::GHITexture* uploadImage(const DecodedImage &image);
+	bool setSourceTexture(GHI::GHITexture *texture);
+	void pollNextImage();
+	void acquireTargets();
 	void updateUI()
 	{
 		ImGui::Begin("UI");
@@ -168,9 +235,89 @@ private:
 
 		if (ImGui::Button("Save")) // Buttons return true when clicked (most widgets return true when edited/activated)
 		{
+			SaveResult();
 		}
 		ImGui::SameLine();
 		ImGui::Text("Application Average: %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+		ImGui::Text("Frame rate (last %u frames): %u FPS", NumTimeDeltaSamples, fps);
+		ImGui::Text("Shader startup: %.1f ms, disk cache %u hits, %u misses", mShaderStartupMs,
+			GHI::ShaderDiskCache::Global().Hits(), GHI::ShaderDiskCache::Global().Misses());
+		ImGui::Checkbox("Run filter every frame", &mRunEveryFrame);
+		bool fusion = mGraph.Fusion();
+		if (ImGui::Checkbox("Fuse per-pixel filters", &fusion))
+		{
+			mGraph.SetFusion(fusion);
+			activeCurFilter();
+		}
+		if (ImGui::Button("Chain: denoise > bilateral > lens circle"))
+		{
+			mGraph.DisconnectAll();
+			mGraph.ConnectChain(mChainPreset);
+			activeCurFilter();
+		}
+		ImGui::SliderInt("PNG level", &mPNGLevel, 0, 9); // 0 stores, faster export
+		ImGui::End();
+
+		profilerUI();
+	}
+
+	void profilerUI()
+	{
+		ImGui::Begin("Profiler");
+		std::vector<GHI::GHIProfileStats> stats = commandContext->Profiler().Stats();
+		ImGui::Columns(7, "profiler stats");
+		ImGui::Text("filter"); ImGui::NextColumn();
+		ImGui::Text("samples"); ImGui::NextColumn();
+		ImGui::Text("min ms"); ImGui::NextColumn();
+		ImGui::Text("mean ms"); ImGui::NextColumn();
+		ImGui::Text("p95 ms"); ImGui::NextColumn();
+		ImGui::Text("p99 ms"); ImGui::NextColumn();
+		ImGui::Text("MPixel/s"); ImGui::NextColumn();
+		ImGui::Separator();
+		for (const GHI::GHIProfileStats &s : stats)
+		{
+			ImGui::Text("%s", s.scope.c_str()); ImGui::NextColumn();
+			ImGui::Text("%llu", (unsigned long long)s.samples); ImGui::NextColumn();
+			ImGui::Text("%.3f", s.minMs); ImGui::NextColumn();
+			ImGui::Text("%.3f", s.meanMs); ImGui::NextColumn();
+			ImGui::Text("%.3f", s.p95Ms); ImGui::NextColumn();
+			ImGui::Text("%.3f", s.p99Ms); ImGui::NextColumn();
+			ImGui::Text("%.1f", s.megaPixelsPerSecond); ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+		ImGui::Separator();
+		const GHI::GHIStateCounters &state = commandContext->StateShadow().Counters();
+		ImGui::Text("State changes: %llu issued, %llu skipped", (unsigned long long)state.issued, (unsigned long long)state.skipped);
+		const GHI::GHITexturePoolStats &pool = commandContext->TexturePool().Stats();
+		ImGui::Text("Texture pool: %u live, %.1f MB, %u free, %.1f MB, %.1f MB high water, %llu of %llu acquires reused",
+			pool.liveTextures, pool.liveBytes / 1048576., pool.freeTextures, pool.freeBytes / 1048576., pool.highWaterBytes / 1048576.,
+			(unsigned long long)pool.reuses, (unsigned long long)pool.acquires);
+		ImGui::Text("Fusion: %u passes, %u filters fused", mGraph.Passes(), mGraph.FusedNodes());
+		const GHI::GHITransientStats &transients = mGraph.TransientStats();
+		ImGui::Text("Intermediates: %u aliased into %u textures, %.1f MB, %.1f MB without aliasing, %.1f MB peak live",
+			transients.requests, transients.textures, transients.pooledBytes / 1048576., transients.naiveBytes / 1048576., transients.peakLiveBytes / 1048576.);
+
+		if (ImGui::Button("Export CSV"))
+		{
+			if (commandContext->Profiler().ExportCSV("profile.csv"))
+				INFO("profile saved to profile.csv\n");
+			else
+				EINFO("can not write profile.csv\n");
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Export JSON"))
+		{
+			if (commandContext->Profiler().ExportJSON("profile.json"))
+				INFO("profile saved to profile.json\n");
+			else
+				EINFO("can not write profile.json\n");
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Reset"))
+		{
+			commandContext->Profiler().Reset();
+			commandContext->StateShadow().ResetCounters();
+		}
 		ImGui::End();
 	}
 
@@ -178,6 +325,7 @@ private:
    // void UpdateCSConstBuffer();
 
 	byte*	GetResultImage();
+	void	pollSaveResult();
     
 	// Fields
 	int	m_imageWidth = 0;
@@ -191,4 +339,12 @@ private:
 	GHI::GHITexture *mFinalTexture = nullptr;
 	std::vector<Filter*> mFilters;
 	std::vector<Filter*>::iterator mCurFilter;
+	FilterGraph mGraph;
+	std::vector<int> mFilterNodes; //< graph node of each filter in mFilters
+	std::vector<int> mChainPreset;
+	bool mRunEveryFrame = true;
+	std::vector<byte> mResultCPUCopy;
+	GHI::GHIReadbackTicket mSaveTicket = 0;
+	int mPNGLevel = 4;
+	double mShaderStartupMs = 0.;
 };
\ No newline at end of file
@@ -28,8 +28,87 @@
  *
  */
 
+#include <cstdio>
 #include <fstream>
 #include <regex>
 #include "Filter.h"
 
+Filter* CreateFilter(const std::string &name)
+{
+	if (name == "denoise")
+	{
+		return new DenoiseFilter();
+	}
+	else if (name == "bilateral")
+	{
+		return new BilaterialFilter();
+	}
+	else if (name == "bilateral-fast")
+	{
+		BilaterialFilter *filter = new BilaterialFilter();
+		filter->setSeparable(true);
+		return filter;
+	}
+	else if (name == "fisheye")
+	{
+		return new FishEyeFilter();
+	}
+	else if (name == "swirl")
+	{
+		return new SwirlFilter();
+	}
+	else if (name == "lenscircle")
+	{
+		return new LensCircleFilter();
+	}
+	else if (name == "localcontrast")
+	{
+		return new LocalContrastFilter();
+	}
+	else if (name == "gaussian")
+	{
+		return new GaussianBlurFilter();
+	}
+	else if (name == "box")
+	{
+		return new BoxFilter();
+	}
+	else if (name == "localvariance")
+	{
+		return new LocalVarianceFilter();
+	}
+	else if (name == "guided")
+	{
+		return new GuidedFilter();
+	}
+	else if (name == "guided-cross")
+	{
+		return new GuidedFilter(true);
+	}
+	else if (name == "edge")
+	{
+		return new EdgeFilter();
+	}
+	else if (name == "posterize-lut")
+	{
+		return new LUTFilter(new DenoiseFilter());
+	}
+	else if (name.compare(0, 4, "lut=") == 0)
+	{
+		LUTFilter *filter = new LUTFilter();
+		std::string error;
+		if (!filter->LoadCube(name.substr(4), error))
+		{
+			std::fprintf(stderr, "- [Error] %s\n", error.c_str());
+			delete filter;
+			return nullptr;
+		}
+		return filter;
+	}
+	return nullptr;
+}
 
+std::vector<std::string> FilterNames()
+{
+	return { "denoise", "bilateral", "bilateral-fast", "fisheye", "swirl", "lenscircle", "localcontrast", "gaussian", "box", "localvariance", "guided", "guided-cross", "edge", "posterize-lut", "lut=<file.cube>" };
+}
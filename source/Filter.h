@@ -37,13 +37,20 @@
 #include <sstream>
 #include <list>
 #include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <cassert>
 
 #include "imgui.h"
-#include "ImNodes.h"
-#include "ImNodesEz.h"
 #include "Utils.h"
 #include "GHIResources.h"
 #include "GHICommandContext.h"
+#include "RemapTable.h"
+#include "MipPyramid.h"
+#include "SummedAreaTable.h"
+#include "ColorLUT.h"
 
 class FilterParam
 {
@@ -69,6 +76,79 @@ class OutputParam : public FilterParam
 {
 };
 
+//! Pixels [x0, x1) x [y0, y1) of an image.
+struct ImageRect
+{
+	int x0 = 0;
+	int y0 = 0;
+	int x1 = 0;
+	int y1 = 0;
+
+	int Width() const
+	{
+		return x1 - x0;
+	}
+	int Height() const
+	{
+		return y1 - y0;
+	}
+	bool Empty() const
+	{
+		return x1 <= x0 || y1 <= y0;
+	}
+	ImageRect Grow(int pixels) const
+	{
+		return { x0 - pixels, y0 - pixels, x1 + pixels, y1 + pixels };
+	}
+	ImageRect Union(const ImageRect &other) const
+	{
+		if (Empty())
+			return other;
+		if (other.Empty())
+			return *this;
+		return { std::min(x0, other.x0), std::min(y0, other.y0), std::max(x1, other.x1), std::max(y1, other.y1) };
+	}
+	ImageRect Clamp(int width, int height) const
+	{
+		return { std::max(x0, 0), std::max(y0, 0), std::min(x1, width), std::min(y1, height) };
+	}
+};
+
+//! Where the textures of a tiled run sit in the image : texel (0, 0) is image pixel
+//! (x, y) of an imageWidth x imageHeight image. A zero size means the whole image.
+struct ImageTile
+{
+	int x = 0;
+	int y = 0;
+	unsigned int imageWidth = 0;
+	unsigned int imageHeight = 0;
+};
+
+//! Per-pixel operations of effects/pointwise.hlsli, the values match the PW_ defines there.
+enum EPointwiseOp
+{
+	PointwiseNone = 0,
+	PointwisePosterize = 1,
+	PointwiseLensCircle = 2,
+};
+
+//! How the output colour of a per-pixel filter depends on its input colour, when it does
+//! not depend on anything else (the position, the neighbours). LUTFilter bakes such
+//! filters into a table : a per-channel one into a 1D table, any of them into a cube.
+enum EColorTransform
+{
+	ColorTransformNone = 0,
+	ColorTransformPerChannel = 1,
+	ColorTransform3D = 2,
+};
+
+//! One stage of a fused per-pixel kernel, params are the op's constants.
+struct PointwiseStage
+{
+	unsigned int op = PointwiseNone;
+	float params[4] = {};
+};
+
 class Filter
 {
 protected:
@@ -78,6 +158,18 @@ protected:
 	GHI::GHIShader* computeShader = nullptr;
 	std::string mShaderFile;
 	std::string mDescription = "an image filter";
+	ImageTile mTile;
+
+	//! Size of the image and position of the bound textures in it, the filters which
+	//! depend on the pixel position compute it in image coordinates.
+	void ImageRegion(unsigned int &width, unsigned int &height, int &originX, int &originY) const
+	{
+		const GHI::GHITexture *input = mInputs[0]->res;
+		width = mTile.imageWidth ? mTile.imageWidth : input->width;
+		height = mTile.imageHeight ? mTile.imageHeight : input->height;
+		originX = mTile.x;
+		originY = mTile.y;
+	}
 
 public:
 
@@ -86,18 +178,66 @@ public:
 	{
 
 	}
+	virtual ~Filter()
+	{
+	}
+
+	const std::string& Description() const
+	{
+		return mDescription;
+	}
 
 	void setSampler(GHI::GHISampler *samp)
 	{
 		sampler = samp;
 	}
+	//! Number of images the filter reads, the graph connects one edge per input slot.
+	virtual int InputCount() const
+	{
+		return 1;
+	}
+	void setInput(int slot, GHI::GHITexture *res)
+	{
+		while (int(mInputs.size()) <= slot)
+			mInputs.push_back(new FilterParam(mInputs.empty() ? "input image" : "input image " + std::to_string(mInputs.size()), nullptr));
+		mInputs[slot]->res = res;
+	}
+	//! Set by FilterGraph before a tiled run, reset to the whole image afterwards.
+	void setTile(const ImageTile &tile)
+	{
+		mTile = tile;
+	}
+	//! Pixels of the input the pixels of output are computed from, tiled runs load
+	//! this much around every tile. Neighbourhood filters grow it by their radius.
+	virtual ImageRect InputRect(const ImageRect &output, int imageWidth, int imageHeight) const
+	{
+		return output;
+	}
+	//! Format of the output when the first input has format input. Filters whose result
+	//! is one channel (luma, edges, masks) return an R8 / R16F format, their intermediate
+	//! then costs a quarter of the bandwidth; FilterGraph allocates what this returns.
+	virtual GHI::EPixelFormat OutputFormat(GHI::EPixelFormat input) const
+	{
+		return input;
+	}
+	//! Filters whose output pixel only depends on the same input pixel describe themselves
+	//! as a stage of pointwise.hlsl, FilterGraph then fuses runs of them into one pass.
+	virtual bool GetPointwiseStage(PointwiseStage &stage) const
+	{
+		return false;
+	}
+	//! Filters that only map colours say so, LUTFilter can then stand for them.
+	virtual EColorTransform ColorTransform() const
+	{
+		return ColorTransformNone;
+	}
 	void addInput(GHI::GHITexture *res)
 	{
-		mInputs.size() <=0 ? mInputs.push_back(new FilterParam("input image",res)) : mInputs[0] = new FilterParam("input image",res);
+		setInput(0, res);
 	}
 	void addOutput(GHI::GHITexture *res)
 	{
-		mOutputs.size() <= 0 ? mOutputs.push_back(new FilterParam("output image",res)) : mOutputs[0] = new FilterParam("output image",res);
+		mOutputs.size() <= 0 ? mOutputs.push_back(new FilterParam("output image",res)) : (void)(mOutputs[0]->res = res);
 	}
 
 	virtual void Init(GHI::IGHIComputeCommandCotext *commandContext)
@@ -105,53 +245,14 @@ public:
 		computeShader = commandContext->GetComputeShader(mShaderFile);
 	}
 
+	//! Parameter window of the filter, the node canvas is drawn by FilterGraph.
 	virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext)
 	{
-        static ImNodes::CanvasState canvas;
-
-        if (ImGui::Begin("ImNodes", nullptr, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse))
-        {
-            ImNodes::BeginCanvas(&canvas);
-
-            struct Node
-            {
-                ImVec2 pos{};
-                bool selected{};
-                ImNodes::Ez::SlotInfo inputs[1];
-                ImNodes::Ez::SlotInfo outputs[1];
-            };
-
-            static Node nodes[3] =
-            {
-            { { 50, 100 }, false,{ { "In", 1 } },{ { "Out", 1 } } },
-            { { 250, 50 }, false,{ { "In", 1 } },{ { "Out", 1 } } },
-            { { 250, 100 }, false,{ { "In", 1 } },{ { "Out", 1 } } },
-            };
-
-            if (ImNodes::Ez::BeginNode(&nodes[0], "Input Image", &nodes[0].pos, &nodes[0].selected))
-            {
-                ImNodes::Ez::InputSlots(nodes[0].inputs, 0);
-                ImNodes::Ez::OutputSlots(nodes[0].outputs, 1);
-                ImNodes::Ez::EndNode();
-            }
-            if (ImNodes::Ez::BeginNode(&nodes[1], mDescription.c_str(), &nodes[1].pos, &nodes[1].selected))
-            {
-                ImNodes::Ez::InputSlots(nodes[1].inputs, 1);
-                ImNodes::Ez::OutputSlots(nodes[1].outputs, 1);
-                ImNodes::Ez::EndNode();
-            }
-            if (ImNodes::Ez::BeginNode(&nodes[2], "Output Image", &nodes[2].pos, &nodes[2].selected))
-            {
-                ImNodes::Ez::InputSlots(nodes[2].inputs, 1);
-                ImNodes::Ez::OutputSlots(nodes[2].outputs, 0);
-                ImNodes::Ez::EndNode();
-            }
-            ImNodes::Connection(&nodes[1], "In", &nodes[0], "Out");
-            ImNodes::Connection(&nodes[2], "In", &nodes[1], "Out");
-
-            ImNodes::EndCanvas();
-        }
-        ImGui::End();
+	}
+	//! Hands the pooled intermediates of the filter back to the pool of commandContext,
+	//! the next Active() acquires them again.
+	virtual void Release(GHI::IGHIComputeCommandCotext *commandContext)
+	{
 	}
 	virtual void Active(GHI::IGHIComputeCommandCotext *commandContext)
 	{
@@ -174,16 +275,54 @@ class BilaterialFilter : public Filter
 		unsigned int wSize;
 	};
 
+	//! Matches cbuffer BilateralPass in bilateralSeparable.hlsl
+	struct alignas(16) SeparablePass
+	{
+		unsigned int direction[2];
+		unsigned int radius;
+		float rangeScale;
+		float spatial[20];
+	};
+
+	enum EMode
+	{
+		Exact = 0,     //< full wSize x wSize window, the reference
+		Separable = 1, //< horizontal + vertical pass approximation
+	};
+
+	static constexpr float SIGMA = 10.f;
+	static constexpr float BSIGMA = 0.1f;
+	static constexpr int SEPARABLE_GROUP_SIZE = 128;
+
 	FilterSize data;
 	GHI::GHIBuffer* constBuffer = nullptr;
     int windowWdith = 5;
+
+	int mode = EMode::Exact;
+	int separableWindow = 0;
+	std::string mSeparableShaderFile;
+	GHI::GHIShader* separableShader = nullptr;
+	GHI::GHIBuffer* passBuffer[2] = { nullptr, nullptr };
+	GHI::GHITexture* tempTexture = nullptr;
+
 public:
-	BilaterialFilter(std::string filename = "..\\effects\\test.hlsl")
+	BilaterialFilter(std::string filename = "..\\effects\\test.hlsl", std::string separableFile = "..\\effects\\bilateralSeparable.hlsl")
 		: Filter(filename)
+		, mSeparableShaderFile(separableFile)
 	{
         mDescription = "Bilaterial Filter";
 	}
 
+	void setSeparable(bool separable)
+	{
+		mode = separable ? EMode::Separable : EMode::Exact;
+	}
+	//! Same range as the slider : odd, 3 .. 17.
+	void setWindow(int window)
+	{
+		windowWdith = std::min(std::max(window | 1, 3), 17);
+	}
+
     virtual void Init(GHI::IGHIComputeCommandCotext *commandContext) override
     {
         // Generate const buffer definition & create Const buffer
@@ -191,6 +330,11 @@ public:
 		constBuffer = commandContext->CreateConstBuffer(sizeof(cb), &cb);
 		commandContext->SetConstBuffer(constBuffer, 0);
 		computeShader = commandContext->GetComputeShader(mShaderFile);
+
+		SeparablePass pass = {};
+		passBuffer[0] = commandContext->CreateConstBuffer(sizeof(pass), &pass);
+		passBuffer[1] = commandContext->CreateConstBuffer(sizeof(pass), &pass);
+		separableShader = commandContext->GetComputeShader(mSeparableShaderFile);
     }
 
 	virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext) override
@@ -205,11 +349,20 @@ public:
             windowWdith & 0x1 ? windowWdith : windowWdith += 1;
 			DEBUG("Filter Size:%d", windowWdith);
         }
+        ImGui::RadioButton("Exact", &mode, EMode::Exact);
+        ImGui::SameLine();
+        ImGui::RadioButton("Separable (fast)", &mode, EMode::Separable);
         ImGui::End();
 	}
 
 	virtual void Active(GHI::IGHIComputeCommandCotext *commandContext) override
 	{
+		if (mode == EMode::Separable)
+		{
+			ActiveSeparable(commandContext);
+			return;
+		}
+
 		DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
         if (data.wSize != windowWdith)
         {
@@ -227,144 +380,1521 @@ public:
 		commandContext->Dispatch((imageWidth + 31) / 32, (imageHeight + 31) / 32, 1);
 	}
 
+	//! Both modes read (windowWdith - 1) / 2 pixels around the output pixel.
+	virtual ImageRect InputRect(const ImageRect &output, int imageWidth, int imageHeight) const override
+	{
+		return output.Grow((windowWdith - 1) / 2).Clamp(imageWidth, imageHeight);
+	}
+
+	virtual void Release(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		commandContext->TexturePool().Release(tempTexture);
+		tempTexture = nullptr;
+	}
+
+private:
+	static float normpdf(float x, float sigma)
+	{
+		return 0.39894f * std::exp(-0.5f * x * x / (sigma * sigma)) / sigma;
+	}
+
+	//! Spatial weights only depend on the window, compute them once instead of per thread.
+	void UpdateSeparablePasses(GHI::IGHIComputeCommandCotext *commandContext)
+	{
+		SeparablePass pass = {};
+		pass.radius = (windowWdith - 1) / 2;
+		pass.rangeScale = 0.5f / (BSIGMA * BSIGMA);
+		for (unsigned int j = 0; j <= pass.radius; ++j)
+		{
+			pass.spatial[j] = normpdf(float(j), SIGMA);
+		}
+
+		pass.direction[0] = 1; pass.direction[1] = 0;
+		commandContext->UpdateBuffer(passBuffer[0], &pass, sizeof(pass));
+		pass.direction[0] = 0; pass.direction[1] = 1;
+		commandContext->UpdateBuffer(passBuffer[1], &pass, sizeof(pass));
+		separableWindow = windowWdith;
+	}
+
+	void ActiveSeparable(GHI::IGHIComputeCommandCotext *commandContext)
+	{
+		DEBUG("active compute shader: [%s]", separableShader->info.shaderfile.c_str());
+		GHI::GHITexture *input = (*mInputs[0])();
+		GHI::GHITexture *output = (*mOutputs[0])();
+		int imageWidth = input->width;
+		int imageHeight = input->height;
+
+		if (separableWindow != windowWdith)
+		{
+			UpdateSeparablePasses(commandContext);
+		}
+		if (tempTexture && (tempTexture->width != input->width || tempTexture->height != input->height || tempTexture->format != input->format))
+		{
+			commandContext->TexturePool().Release(tempTexture);
+			tempTexture = nullptr;
+		}
+		if (!tempTexture)
+		{
+			GHI::TextureDesc2D desc;
+			desc.Width = input->width;
+			desc.Height = input->height;
+			desc.Format = input->format;
+			desc.BindFlags = GHI::BindFlag_SHADER_RESOURCE | GHI::BindFlag_UNORDERED_ACCESS;
+			tempTexture = commandContext->TexturePool().Acquire(desc);
+		}
+
+		commandContext->SetShader(separableShader);
+
+		// horizontal pass : input -> temp
+		commandContext->SetConstBuffer(passBuffer[0], 0);
+		commandContext->SetShaderResource(input, 0, GHI::GHISRVParam());
+		commandContext->SetShaderResource(tempTexture, 0, GHI::GHIUAVParam());
+		commandContext->Dispatch((imageWidth + SEPARABLE_GROUP_SIZE - 1) / SEPARABLE_GROUP_SIZE, imageHeight, 1);
+
+		// vertical pass : temp -> output
+		commandContext->SetShaderResource(output, 0, GHI::GHIUAVParam());
+		commandContext->SetConstBuffer(passBuffer[1], 0);
+		commandContext->SetShaderResource(tempTexture, 0, GHI::GHISRVParam());
+		commandContext->Dispatch((imageHeight + SEPARABLE_GROUP_SIZE - 1) / SEPARABLE_GROUP_SIZE, imageWidth, 1);
+	}
+
+};
+
+//! Base of the filters that can run from a RemapTable. Subclasses fill their constant
+//! buffer (image width, height and tile origin first, see ImageRegion(), then their
+//! parameters) and call ActiveRemap() from Active().
+class RemapFilter : public Filter
+{
+protected:
+	GHI::GHIBuffer* constBuffer = nullptr;
+	std::string mTableShaderFile;
+	std::string mApplyShaderFile;
+	GHI::GHIShader* tableShader = nullptr;
+	GHI::GHIShader* applyShader = nullptr;
+	RemapTable table;
+	std::vector<unsigned char> lastParams;
+	bool useTable = true;
+
+public:
+	RemapFilter(std::string filename, std::string tableFile, std::string applyFile, GHI::EPixelFormat tableFormat)
+		: Filter(filename)
+		, mTableShaderFile(tableFile)
+		, mApplyShaderFile(applyFile)
+		, table(tableFormat)
+	{
+	}
+
+	void InitRemap(GHI::IGHIComputeCommandCotext *commandContext, const void *params, int size)
+	{
+		constBuffer = commandContext->CreateConstBuffer(size, params);
+		commandContext->SetConstBuffer(constBuffer, 0);
+		computeShader = commandContext->GetComputeShader(mShaderFile);
+		tableShader = commandContext->GetComputeShader(mTableShaderFile);
+		applyShader = commandContext->GetComputeShader(mApplyShaderFile);
+		lastParams.assign((const unsigned char*)params, (const unsigned char*)params + size);
+	}
+
+	void RemapUI()
+	{
+		ImGui::Checkbox("Use remap table", &useTable);
+		ImGui::Text("table builds: %u, reuses: %u", table.Builds(), table.Hits());
+	}
+
+	void ActiveRemap(GHI::IGHIComputeCommandCotext *commandContext, const void *params, int size)
+	{
+		GHI::GHITexture *input = (*mInputs[0])();
+		GHI::GHITexture *output = (*mOutputs[0])();
+		int imageWidth = input->width;
+		int imageHeight = input->height;
+
+		const unsigned char *bytes = (const unsigned char*)params;
+		if (lastParams.size() != size_t(size) || !std::equal(lastParams.begin(), lastParams.end(), bytes))
+		{
+			lastParams.assign(bytes, bytes + size);
+			commandContext->UpdateBuffer(constBuffer, (void*)params, size);
+			table.Invalidate();
+		}
+
+		commandContext->SetSampler(sampler, 0, GHI::EShaderStage::CS);
+		commandContext->SetConstBuffer(constBuffer, 0);
+		if (!useTable || !tableShader || !applyShader)
+		{
+			DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
+			commandContext->SetShader(computeShader);
+			commandContext->SetShaderResource(input, 0, GHI::GHISRVParam());
+			commandContext->SetShaderResource(output, 0, GHI::GHIUAVParam());
+			commandContext->Dispatch((imageWidth + 31) / 32, (imageHeight + 31) / 32, 1);
+			return;
+		}
+
+		if (table.Acquire(commandContext, imageWidth, imageHeight, RemapTable::Hash(params, size)))
+		{
+			DEBUG("build remap table: [%s] %dx%d", tableShader->info.shaderfile.c_str(), imageWidth, imageHeight);
+			commandContext->SetShader(tableShader);
+			commandContext->SetShaderResource(table.Table(), 0, GHI::GHIUAVParam());
+			commandContext->Dispatch((imageWidth + 31) / 32, (imageHeight + 31) / 32, 1);
+		}
+
+		// Bind the output first so the table is no longer a UAV when it is read as t1.
+		DEBUG("active compute shader: [%s]", applyShader->info.shaderfile.c_str());
+		commandContext->SetShader(applyShader);
+		commandContext->SetShaderResource(output, 0, GHI::GHIUAVParam());
+		commandContext->SetShaderResource(input, 0, GHI::GHISRVParam());
+		commandContext->SetShaderResource(table.Table(), 1, GHI::GHISRVParam());
+		commandContext->Dispatch((imageWidth + 31) / 32, (imageHeight + 31) / 32, 1);
+	}
 };
 
-    class FishEyeFilter :public Filter
+    class FishEyeFilter :public RemapFilter
     {
-	    struct alignas(16) ImageSize
+	    //! Matches cbuffer CB in fishEye.hlsl / fishEyeTable.hlsl
+	    struct alignas(16) FishEyeParams
 	    {
 		    unsigned int width;
 		    unsigned int height;
+		    int originX;
+		    int originY;
+		    float aperture;
 	    };
 
-	    ImageSize data;
-        GHI::GHIBuffer* constBuffer = nullptr;
+	    FishEyeParams data = { 0, 0, 0, 0, 178.f };
     public:
         FishEyeFilter(std::string filename = "..\\effects\\fishEye.hlsl")
-            : Filter(filename)
+            : RemapFilter(filename, "..\\effects\\fishEyeTable.hlsl", "..\\effects\\remap.hlsl", GHI::PixelFormat_R32G32_FLOAT)
         {
             mDescription = "Fish Eye Filter";
         }
 
         virtual void Init(GHI::IGHIComputeCommandCotext *commandContext) override
         {
-            // Generate const buffer definition & create Const buffer
-            ImageSize cb = {  };
-            constBuffer = commandContext->CreateConstBuffer(sizeof(cb), &cb);
-            commandContext->SetConstBuffer(constBuffer, 0);
-            computeShader = commandContext->GetComputeShader(mShaderFile);
+            InitRemap(commandContext, &data, sizeof(data));
+        }
+
+        virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext) override
+        {
+            Filter::UpdateUI(commandContext);
+
+            ImGui::Begin("Fish Eye UI");
+            ImGui::SliderFloat("Aperture", &data.aperture, 90.f, 180.f);
+            RemapUI();
+            ImGui::End();
         }
+
         virtual void Active(GHI::IGHIComputeCommandCotext *commandContext) override
         {
-            DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
+            ImageRegion(data.width, data.height, data.originX, data.originY);
+            ActiveRemap(commandContext, &data, sizeof(data));
+        }
+
+        //! In 2 * uv - 1 space a pixel at distance d from the center samples on the same ray,
+        //! at r(d) from the center in uv space. Outside of the lens the image is kept.
+        virtual ImageRect InputRect(const ImageRect &output, int imageWidth, int imageHeight) const override
+        {
+            const float PI = 3.1415926535f;
+            const float maxFactor = std::sin(0.5f * data.aperture * (PI / 180.f));
+            const float x0 = 2.f * output.x0 / imageWidth - 1.f, x1 = 2.f * output.x1 / imageWidth - 1.f;
+            const float y0 = 2.f * output.y0 / imageHeight - 1.f, y1 = 2.f * output.y1 / imageHeight - 1.f;
+            const float nx = std::min(std::max(0.f, x0), x1), ny = std::min(std::max(0.f, y0), y1);
+            const float fx = std::max(std::abs(x0), std::abs(x1)), fy = std::max(std::abs(y0), std::abs(y1));
+            const float dMin = std::sqrt(nx * nx + ny * ny);
+            const float dMax = std::sqrt(fx * fx + fy * fy);
+            if (dMin >= 2.f - maxFactor)
+                return output.Grow(2).Clamp(imageWidth, imageHeight);
+
+            auto radius = [&](float d)
+            {
+                d = std::min(d * maxFactor, 1.f);
+                return std::atan2(d, std::sqrt(1.f - d * d)) / PI;
+            };
+            const float rMin = radius(dMin), rMax = radius(dMax);
+
+            // Angles the rect covers around the center, all of them when it holds the center.
+            float aMin = -PI, aMax = PI;
+            if (x0 > 0.f || x1 < 0.f || y0 > 0.f || y1 < 0.f)
+            {
+                const bool wraps = x1 <= 0.f && y0 < 0.f && y1 > 0.f; // crosses the -x axis
+                const float corners[4][2] = { { x0, y0 }, { x1, y0 }, { x0, y1 }, { x1, y1 } };
+                aMin = 4.f * PI;
+                aMax = -4.f * PI;
+                for (const float *c : corners)
+                {
+                    float a = std::atan2(c[1], c[0]);
+                    a = wraps && a < 0.f ? a + 2.f * PI : a;
+                    aMin = std::min(aMin, a);
+                    aMax = std::max(aMax, a);
+                }
+            }
 
-            int imageWidth = (*mInputs[0])()->width;
-            int imageHeight = (*mInputs[0])()->height;
-            if (imageWidth != data.width || imageHeight != data.height)
+            ImageRect lens; // empty, grown by the corners and extremes of the sector
+            auto add = [&](float r, float a)
+            {
+                const int x = int(std::floor((0.5f + r * std::cos(a)) * imageWidth));
+                const int y = int(std::floor((0.5f + r * std::sin(a)) * imageHeight));
+                lens = lens.Union({ x, y, x + 1, y + 1 });
+            };
+            for (float r : { rMin, rMax })
+            {
+                add(r, aMin);
+                add(r, aMax);
+            }
+            for (int k = -2; k <= 4; ++k) // extremes of the arc on the axes
             {
-                data.height = imageHeight;
-                data.width = imageWidth;
-                commandContext->UpdateBuffer(constBuffer, &data, sizeof(data));
+                if (k * PI / 2.f > aMin && k * PI / 2.f < aMax)
+                    add(rMax, k * PI / 2.f);
             }
-            commandContext->SetSampler(sampler, 0, GHI::EShaderStage::CS);
-            commandContext->SetConstBuffer(constBuffer, 0);
-            commandContext->SetShader(computeShader);
-            commandContext->SetShaderResource((*mInputs[0])(), 0, GHI::GHISRVParam());
-            commandContext->SetShaderResource((*mOutputs[0])(), 0, GHI::GHIUAVParam());
-            commandContext->Dispatch((imageWidth + 31) / 32, (imageHeight + 31) / 32, 1);
+            if (dMax >= 2.f - maxFactor)
+                lens = lens.Union(output);
+            return lens.Grow(2).Clamp(imageWidth, imageHeight); // + the bilinear footprint
         }
     };
 
-    class LensCircleFilter :public Filter
+    class LensCircleFilter :public RemapFilter
     {
-        struct alignas(16) ImageSize
+        //! Matches cbuffer CB in lensCircle.hlsl / lensCircleTable.hlsl
+        struct alignas(16) LensCircleParams
         {
             unsigned int width;
             unsigned int height;
+            int originX;
+            int originY;
+            float inner;
+            float outer;
         };
 
-        ImageSize data;
-        GHI::GHIBuffer* constBuffer = nullptr;
+        LensCircleParams data = { 0, 0, 0, 0, 0.38f, 0.48f };
     public:
         LensCircleFilter(std::string filename = "..\\effects\\lensCircle.hlsl")
-            : Filter(filename)
+            : RemapFilter(filename, "..\\effects\\lensCircleTable.hlsl", "..\\effects\\remapWeight.hlsl", GHI::PixelFormat_R32_FLOAT)
         {
             mDescription = "Lens Circle Filter";
         }
 
         virtual void Init(GHI::IGHIComputeCommandCotext *commandContext) override
         {
-            // Generate const buffer definition & create Const buffer
-            ImageSize cb = {};
-            constBuffer = commandContext->CreateConstBuffer(sizeof(cb), &cb);
-            commandContext->SetConstBuffer(constBuffer, 0);
-            computeShader = commandContext->GetComputeShader(mShaderFile);
+            InitRemap(commandContext, &data, sizeof(data));
+        }
+
+        virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext) override
+        {
+            Filter::UpdateUI(commandContext);
+
+            ImGui::Begin("Lens Circle UI");
+            ImGui::SliderFloat("Inner Radius", &data.inner, 0.f, 0.7f);
+            ImGui::SliderFloat("Outer Radius", &data.outer, 0.f, 0.7f);
+            RemapUI();
+            ImGui::End();
         }
+
         virtual void Active(GHI::IGHIComputeCommandCotext *commandContext) override
         {
-            DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
+            ImageRegion(data.width, data.height, data.originX, data.originY);
+            ActiveRemap(commandContext, &data, sizeof(data));
+        }
 
-            int imageWidth = (*mInputs[0])()->width;
-            int imageHeight = (*mInputs[0])()->height;
-            if (imageWidth != data.width || imageHeight != data.height)
-            {
-                data.height = imageHeight;
-                data.width = imageWidth;
-                commandContext->UpdateBuffer(constBuffer, &data, sizeof(data));
-            }
-            commandContext->SetSampler(sampler, 0, GHI::EShaderStage::CS);
-            commandContext->SetConstBuffer(constBuffer, 0);
-            commandContext->SetShader(computeShader);
-            commandContext->SetShaderResource((*mInputs[0])(), 0, GHI::GHISRVParam());
-            commandContext->SetShaderResource((*mOutputs[0])(), 0, GHI::GHIUAVParam());
-            commandContext->Dispatch((imageWidth + 31) / 32, (imageHeight + 31) / 32, 1);
+        virtual bool GetPointwiseStage(PointwiseStage &stage) const override
+        {
+            stage.op = PointwiseLensCircle;
+            stage.params[0] = data.inner;
+            stage.params[1] = data.outer;
+            return true;
         }
     };
 
-    class SwirlFilter :public Filter
+    class SwirlFilter :public RemapFilter
     {
-        struct alignas(16) ImageSize
+        //! Matches cbuffer CB in swirl.hlsl / swirlTable.hlsl
+        struct alignas(16) SwirlParams
         {
             unsigned int width;
             unsigned int height;
+            int originX;
+            int originY;
+            float radius;
+            float angle;
         };
 
-        ImageSize data;
-        GHI::GHIBuffer* constBuffer = nullptr;
+        SwirlParams data = { 0, 0, 0, 0, 200.f, .8f };
     public:
         SwirlFilter(std::string filename = "..\\effects\\swirl.hlsl")
-            : Filter(filename)
+            : RemapFilter(filename, "..\\effects\\swirlTable.hlsl", "..\\effects\\remap.hlsl", GHI::PixelFormat_R32G32_FLOAT)
         {
             mDescription = "Swirl Filter";
         }
 
         virtual void Init(GHI::IGHIComputeCommandCotext *commandContext) override
         {
-            // Generate const buffer definition & create Const buffer
-            ImageSize cb = {};
-            constBuffer = commandContext->CreateConstBuffer(sizeof(cb), &cb);
-            commandContext->SetConstBuffer(constBuffer, 0);
-            computeShader = commandContext->GetComputeShader(mShaderFile);
+            InitRemap(commandContext, &data, sizeof(data));
+        }
+
+        virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext) override
+        {
+            Filter::UpdateUI(commandContext);
+
+            ImGui::Begin("Swirl UI");
+            ImGui::SliderFloat("Radius", &data.radius, 10.f, 1000.f);
+            ImGui::SliderFloat("Angle", &data.angle, -2.f, 2.f);
+            RemapUI();
+            ImGui::End();
         }
+
         virtual void Active(GHI::IGHIComputeCommandCotext *commandContext) override
         {
-            DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
+            ImageRegion(data.width, data.height, data.originX, data.originY);
+            ActiveRemap(commandContext, &data, sizeof(data));
+        }
+
+        //! Pixels within the radius rotate around the center and keep their distance to it.
+        virtual ImageRect InputRect(const ImageRect &output, int imageWidth, int imageHeight) const override
+        {
+            const float cx = imageWidth * .5f;
+            const float cy = imageHeight * .5f;
+            const float nx = std::min(std::max(cx, float(output.x0)), float(output.x1)) - cx;
+            const float ny = std::min(std::max(cy, float(output.y0)), float(output.y1)) - cy;
+            if (std::sqrt(nx * nx + ny * ny) >= data.radius)
+                return output.Grow(2).Clamp(imageWidth, imageHeight);
 
-            int imageWidth = (*mInputs[0])()->width;
-            int imageHeight = (*mInputs[0])()->height;
-            if (imageWidth != data.width || imageHeight != data.height)
-            {
-                data.height = imageHeight;
-                data.width = imageWidth;
-                commandContext->UpdateBuffer(constBuffer, &data, sizeof(data));
-            }
-            commandContext->SetSampler(sampler, 0, GHI::EShaderStage::CS);
-            commandContext->SetConstBuffer(constBuffer, 0);
-            commandContext->SetShader(computeShader);
-            commandContext->SetShaderResource((*mInputs[0])(), 0, GHI::GHISRVParam());
-            commandContext->SetShaderResource((*mOutputs[0])(), 0, GHI::GHIUAVParam());
-            commandContext->Dispatch((imageWidth + 31) / 32, (imageHeight + 31) / 32, 1);
+            const float fx = std::max(std::abs(output.x0 - cx), std::abs(output.x1 - cx));
+            const float fy = std::max(std::abs(output.y0 - cy), std::abs(output.y1 - cy));
+            const float r = std::min(std::sqrt(fx * fx + fy * fy), data.radius);
+            ImageRect swirl = { int(std::floor(cx - r)), int(std::floor(cy - r)), int(std::ceil(cx + r)), int(std::ceil(cy + r)) };
+            return swirl.Union(output).Grow(2).Clamp(imageWidth, imageHeight); // + the bilinear footprint
         }
     };
 
+//! denoise.hlsl, posterizes in a gamma space to flatten noise in smooth areas.
+class DenoiseFilter : public Filter
+{
+public:
+	DenoiseFilter(std::string filename = "..\\effects\\denoise.hlsl")
+		: Filter(filename)
+	{
+		mDescription = "Denoise Filter";
+	}
+
+	virtual bool GetPointwiseStage(PointwiseStage &stage) const override
+	{
+		stage.op = PointwisePosterize;
+		return true;
+	}
+	virtual EColorTransform ColorTransform() const override
+	{
+		return ColorTransformPerChannel;
+	}
+};
+
+//! localContrast.hlsl, scales the detail of every pixel against a coarse level of the mip
+//! pyramid of the image. The coarse level costs a third of the image to build whatever
+//! its scale, where a blur of the same radius would read 2^level x 2^level pixels.
+class LocalContrastFilter : public Filter
+{
+	//! Matches cbuffer CB in localContrast.hlsl
+	struct alignas(16) LocalContrastParams
+	{
+		unsigned int mip;
+		float amount;
+		float invScale;
+	};
+
+	LocalContrastParams data = { 0, 0.f, 0.f };
+	GHI::GHIBuffer* constBuffer = nullptr;
+	MipPyramid mPyramid;
+	int level = 4;       //< of the pyramid the detail is measured against
+	float amount = 0.6f;
+
+public:
+	LocalContrastFilter(std::string filename = "..\\effects\\localContrast.hlsl")
+		: Filter(filename)
+	{
+		mDescription = "Local Contrast Filter";
+	}
+
+	virtual void Init(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		constBuffer = commandContext->CreateConstBuffer(sizeof(data), &data);
+		computeShader = commandContext->GetComputeShader(mShaderFile);
+		mPyramid.Init(commandContext);
+	}
+
+	virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		Filter::UpdateUI(commandContext);
+
+		ImGui::Begin("Local Contrast UI");
+		ImGui::SliderInt("Scale (pyramid level)", &level, 1, 8);
+		ImGui::SliderFloat("Amount", &amount, -1.f, 3.f);
+		ImGui::End();
+	}
+
+	virtual void Active(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
+		GHI::GHITexture *input = (*mInputs[0])();
+		mPyramid.Build(commandContext, input, level + 1);
+
+		// A 1 x 1 image has no pyramid, its own pixel is the base and the result is the input.
+		const int used = std::min(level, int(mPyramid.Levels()) - 1);
+		GHI::GHITexture *pyramid = used > 0 ? mPyramid.Texture() : input;
+		LocalContrastParams params = { unsigned(std::max(used - 1, 0)), amount, 1.f / float(1 << used) };
+		if (memcmp(&params, &data, sizeof(data)) != 0)
+		{
+			data = params;
+			commandContext->UpdateBuffer(constBuffer, &data, sizeof(data));
+		}
+
+		commandContext->SetSampler(sampler, 0, GHI::EShaderStage::CS);
+		commandContext->SetConstBuffer(constBuffer, 0);
+		commandContext->SetShader(computeShader);
+		commandContext->SetShaderResource(input, 0, GHI::GHISRVParam());
+		commandContext->SetShaderResource(pyramid, 1, GHI::GHISRVParam());
+		commandContext->SetShaderResource((*mOutputs[0])(), 0, GHI::GHIUAVParam());
+		commandContext->Dispatch((input->width + 31) / 32, (input->height + 31) / 32, 1);
+	}
+
+	//! A texel of level n averages 2^n pixels, the bilinear sample reaches one more texel.
+	//! The pyramid of a tile is built from the tile's first pixel on, so the rect is also
+	//! aligned on 2^n pixels of the image : the texels then are those of an untiled run.
+	virtual ImageRect InputRect(const ImageRect &output, int imageWidth, int imageHeight) const override
+	{
+		const int texel = 1 << level;
+		ImageRect rect = output.Grow(2 * texel).Clamp(imageWidth, imageHeight);
+		rect.x0 &= ~(texel - 1);
+		rect.y0 &= ~(texel - 1);
+		rect.x1 = (rect.x1 + texel - 1) & ~(texel - 1);
+		rect.y1 = (rect.y1 + texel - 1) & ~(texel - 1);
+		return rect.Clamp(imageWidth, imageHeight);
+	}
+};
+
+//! Gaussian blur of any sigma. Small sigmas run the taps directly, a horizontal then a
+//! vertical pass of gaussian.hlsl; larger ones three box blurs per direction of
+//! boxBlur.hlsl (the variance of the three boxes is sigma^2), whose cost does not depend
+//! on sigma. The passes go through RGBA16F intermediates, the result is rounded once.
+//! A thread of the box passes runs BOX_SEGMENT pixels of a line, the segments are placed
+//! in image coordinates so a tile rounds its running sums as the whole image does.
+class GaussianBlurFilter : public Filter
+{
+public:
+	enum EMode
+	{
+		Auto = 0,   //< taps up to DIRECT_MAX_SIGMA, boxes above
+		Direct = 1, //< taps, sigma is clamped to DIRECT_MAX_SIGMA
+		Box = 2,    //< three boxes
+	};
+
+	static constexpr float DIRECT_MAX_SIGMA = 8.f;
+
+private:
+	//! Matches cbuffer GaussianPass in gaussian.hlsl
+	struct alignas(16) GaussianPass
+	{
+		unsigned int direction[2];
+		unsigned int radius;
+		unsigned int pad;
+		float weights[28];
+	};
+
+	//! Matches cbuffer BoxPass in boxBlur.hlsl
+	struct alignas(16) BoxPass
+	{
+		unsigned int direction[2];
+		unsigned int radius;
+		int origin;
+	};
+
+	static constexpr int MAX_RADIUS = 24;
+	static constexpr int GAUSSIAN_GROUP_SIZE = 128;
+	static constexpr int BOX_GROUP_SIZE = 64;
+	static constexpr int BOX_SEGMENT = 64; //< SEGMENT in boxBlur.hlsl
+	static constexpr int BOXES = 3;
+
+	float sigma = 3.f;
+	int mode = EMode::Auto;
+
+	std::string mBoxShaderFile;
+	GHI::GHIShader* boxShader = nullptr;
+	GHI::GHIBuffer* gaussianBuffer[2] = { nullptr, nullptr };
+	GHI::GHIBuffer* boxBuffer[2 * BOXES] = {};
+	GHI::GHITexture* tempTexture[2] = { nullptr, nullptr };
+
+	float plannedSigma = -1.f;
+	bool plannedDirect = false;
+	int gaussianRadius = 0;
+	int boxRadius[BOXES] = {};
+	int boxOrigin[2] = {}; //< of the tile the box passes are set up for
+
+public:
+	GaussianBlurFilter(std::string filename = "..\\effects\\gaussian.hlsl", std::string boxFile = "..\\effects\\boxBlur.hlsl")
+		: Filter(filename)
+		, mBoxShaderFile(boxFile)
+	{
+		mDescription = "Gaussian Blur Filter";
+	}
+
+	void setSigma(float s)
+	{
+		sigma = std::max(s, 0.1f);
+	}
+	void setMode(EMode m)
+	{
+		mode = m;
+	}
+	//! Direct taps are used for this sigma.
+	bool UseTaps() const
+	{
+		return mode == EMode::Direct || (mode == EMode::Auto && sigma <= DIRECT_MAX_SIGMA);
+	}
+
+	virtual void Init(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		GaussianPass pass = {};
+		gaussianBuffer[0] = commandContext->CreateConstBuffer(sizeof(pass), &pass);
+		gaussianBuffer[1] = commandContext->CreateConstBuffer(sizeof(pass), &pass);
+		BoxPass box = {};
+		for (GHI::GHIBuffer *&buffer : boxBuffer)
+			buffer = commandContext->CreateConstBuffer(sizeof(box), &box);
+		computeShader = commandContext->GetComputeShader(mShaderFile);
+		boxShader = commandContext->GetComputeShader(mBoxShaderFile);
+	}
+
+	virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		Filter::UpdateUI(commandContext);
+
+		ImGui::Begin("Gaussian Blur UI");
+		ImGui::SliderFloat("Sigma", &sigma, 0.5f, 64.f, "%.2f", 2.f);
+		ImGui::RadioButton("Auto", &mode, EMode::Auto);
+		ImGui::SameLine();
+		ImGui::RadioButton("Taps", &mode, EMode::Direct);
+		ImGui::SameLine();
+		ImGui::RadioButton("Boxes (constant time)", &mode, EMode::Box);
+		if (UseTaps())
+			ImGui::Text("%d taps per pass", 2 * gaussianRadius + 1);
+		else
+			ImGui::Text("boxes of %d, %d, %d pixels", 2 * boxRadius[0] + 1, 2 * boxRadius[1] + 1, 2 * boxRadius[2] + 1);
+		ImGui::End();
+	}
+
+	virtual void Active(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		GHI::GHITexture *input = (*mInputs[0])();
+		GHI::GHITexture *output = (*mOutputs[0])();
+		const bool direct = UseTaps();
+		unsigned int imageWidth, imageHeight;
+		int originX, originY;
+		ImageRegion(imageWidth, imageHeight, originX, originY);
+		if (plannedSigma != sigma || plannedDirect != direct || (!direct && (boxOrigin[0] != originX || boxOrigin[1] != originY)))
+		{
+			boxOrigin[0] = originX;
+			boxOrigin[1] = originY;
+			UpdatePasses(commandContext, direct);
+		}
+		AcquireTemps(commandContext, input, direct ? 1 : 2);
+
+		if (direct)
+		{
+			DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
+			commandContext->SetShader(computeShader);
+			// horizontal pass : input -> temp, vertical pass : temp -> output
+			commandContext->SetConstBuffer(gaussianBuffer[0], 0);
+			commandContext->SetShaderResource(input, 0, GHI::GHISRVParam());
+			commandContext->SetShaderResource(tempTexture[0], 0, GHI::GHIUAVParam());
+			commandContext->Dispatch((input->width + GAUSSIAN_GROUP_SIZE - 1) / GAUSSIAN_GROUP_SIZE, input->height, 1);
+
+			commandContext->SetConstBuffer(gaussianBuffer[1], 0);
+			commandContext->SetShaderResource(output, 0, GHI::GHIUAVParam());
+			commandContext->SetShaderResource(tempTexture[0], 0, GHI::GHISRVParam());
+			commandContext->Dispatch((input->height + GAUSSIAN_GROUP_SIZE - 1) / GAUSSIAN_GROUP_SIZE, input->width, 1);
+			return;
+		}
+
+		// Three horizontal then three vertical boxes, ping-ponging between the temps, the last one into output.
+		DEBUG("active compute shader: [%s]", boxShader->info.shaderfile.c_str());
+		commandContext->SetShader(boxShader);
+		for (int pass = 0; pass < 2 * BOXES; ++pass)
+		{
+			GHI::GHITexture *src = pass == 0 ? input : tempTexture[(pass - 1) & 1];
+			GHI::GHITexture *dst = pass == 2 * BOXES - 1 ? output : tempTexture[pass & 1];
+			const bool rows = pass < BOXES;
+			const unsigned int lines = rows ? input->height : input->width;
+			const unsigned int length = rows ? input->width : input->height;
+			const unsigned int segments = (boxOrigin[rows ? 0 : 1] % BOX_SEGMENT + length + BOX_SEGMENT - 1) / BOX_SEGMENT;
+			commandContext->SetConstBuffer(boxBuffer[pass], 0);
+			commandContext->SetShaderResource(dst, 0, GHI::GHIUAVParam());
+			commandContext->SetShaderResource(src, 0, GHI::GHISRVParam());
+			commandContext->Dispatch((lines + BOX_GROUP_SIZE - 1) / BOX_GROUP_SIZE, segments, 1);
+		}
+	}
+
+	//! Pixels farther than the taps, or the three box radii added, do not reach the output.
+	//! A box pass rounds like the whole image from the first segment whose window is
+	//! exact in the tile on, which is up to a segment further in per box.
+	virtual ImageRect InputRect(const ImageRect &output, int imageWidth, int imageHeight) const override
+	{
+		int reach = 0;
+		if (UseTaps())
+			reach = std::min(int(std::ceil(3.f * std::min(sigma, DIRECT_MAX_SIGMA))), MAX_RADIUS);
+		else
+			reach = BoxRadii(sigma, nullptr) + BOXES * BOX_SEGMENT;
+		return output.Grow(reach).Clamp(imageWidth, imageHeight);
+	}
+
+	virtual void Release(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		for (GHI::GHITexture *&temp : tempTexture)
+		{
+			commandContext->TexturePool().Release(temp);
+			temp = nullptr;
+		}
+	}
+
+private:
+	//! Radii of the three boxes whose variance is closest to sigma^2, returns their sum.
+	static int BoxRadii(float s, int radii[BOXES])
+	{
+		// The first m boxes are wl wide, the others wl + 2, wl odd.
+		const float variance = 12.f * s * s;
+		int wl = int(std::floor(std::sqrt(variance / BOXES + 1.f)));
+		wl -= (wl & 1) ? 0 : 1;
+		const int m = int(std::round((variance - BOXES * wl * wl - 4.f * BOXES * wl - 3.f * BOXES) / (-4.f * wl - 4.f)));
+		int sum = 0;
+		for (int i = 0; i < BOXES; ++i)
+		{
+			const int radius = ((i < m ? wl : wl + 2) - 1) / 2;
+			if (radii)
+				radii[i] = radius;
+			sum += radius;
+		}
+		return sum;
+	}
+
+	void UpdatePasses(GHI::IGHIComputeCommandCotext *commandContext, bool direct)
+	{
+		if (direct)
+		{
+			const float s = std::min(sigma, DIRECT_MAX_SIGMA);
+			GaussianPass pass = {};
+			gaussianRadius = std::min(int(std::ceil(3.f * s)), MAX_RADIUS);
+			pass.radius = gaussianRadius;
+			float sum = 0.f;
+			for (int j = 0; j <= gaussianRadius; ++j)
+			{
+				pass.weights[j] = std::exp(-0.5f * j * j / (s * s));
+				sum += j ? 2.f * pass.weights[j] : pass.weights[j];
+			}
+			for (int j = 0; j <= gaussianRadius; ++j)
+				pass.weights[j] /= sum;
+
+			pass.direction[0] = 1; pass.direction[1] = 0;
+			commandContext->UpdateBuffer(gaussianBuffer[0], &pass, sizeof(pass));
+			pass.direction[0] = 0; pass.direction[1] = 1;
+			commandContext->UpdateBuffer(gaussianBuffer[1], &pass, sizeof(pass));
+		}
+		else
+		{
+			BoxRadii(sigma, boxRadius);
+			for (int pass = 0; pass < 2 * BOXES; ++pass)
+			{
+				BoxPass box = {};
+				box.direction[0] = pass < BOXES ? 1 : 0;
+				box.direction[1] = pass < BOXES ? 0 : 1;
+				box.radius = boxRadius[pass % BOXES];
+				box.origin = boxOrigin[pass < BOXES ? 0 : 1];
+				commandContext->UpdateBuffer(boxBuffer[pass], &box, sizeof(box));
+			}
+		}
+		plannedSigma = sigma;
+		plannedDirect = direct;
+	}
+
+	//! RGBA16F, the passes do not round to the 8 bits of the image in between.
+	void AcquireTemps(GHI::IGHIComputeCommandCotext *commandContext, const GHI::GHITexture *input, int count)
+	{
+		for (int i = 0; i < 2; ++i)
+		{
+			GHI::GHITexture *&temp = tempTexture[i];
+			if (temp && (i >= count || temp->width != input->width || temp->height != input->height))
+			{
+				commandContext->TexturePool().Release(temp);
+				temp = nullptr;
+			}
+			if (!temp && i < count)
+			{
+				GHI::TextureDesc2D desc;
+				desc.Width = input->width;
+				desc.Height = input->height;
+				desc.Format = GHI::PixelFormat_R16G16B16A16_FLOAT;
+				desc.BindFlags = GHI::BindFlag_SHADER_RESOURCE | GHI::BindFlag_UNORDERED_ACCESS;
+				temp = commandContext->TexturePool().Acquire(desc);
+			}
+		}
+	}
+};
+
+//! localStats.hlsl, statistics of the window around every pixel read from the summed-area
+//! tables of the image : four loads per pixel whatever the radius, the tables cost two
+//! passes over the image. The window is clipped to the image.
+class LocalStatsFilter : public Filter
+{
+public:
+	enum EStat
+	{
+		Mean = 0,              //< box filter
+		StandardDeviation = 1,
+	};
+
+private:
+	//! Matches cbuffer LocalStats in localStats.hlsl
+	struct alignas(16) LocalStatsParams
+	{
+		int radius;
+		unsigned int mode;
+		float gain;
+	};
+
+	LocalStatsParams data = { 0, 0, 0.f };
+	GHI::GHIBuffer* constBuffer = nullptr;
+	SummedAreaTable mTable;
+	const EStat mStat;
+	int maxRadius = 0;
+
+protected:
+	int radius = 8;
+	float gain = 4.f; //< of the standard deviation
+
+public:
+	LocalStatsFilter(EStat stat, std::string filename = "..\\effects\\localStats.hlsl")
+		: Filter(filename)
+		, mStat(stat)
+	{
+		maxRadius = stat == Mean ? 1024 : SummedAreaTable::MaxSquaresRadius();
+	}
+
+	void setRadius(int r)
+	{
+		radius = std::max(0, std::min(r, maxRadius));
+	}
+
+	virtual void Init(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		constBuffer = commandContext->CreateConstBuffer(sizeof(data), &data);
+		computeShader = commandContext->GetComputeShader(mShaderFile);
+		mTable.Init(commandContext);
+	}
+
+	virtual void Active(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
+		GHI::GHITexture *input = (*mInputs[0])();
+		mTable.Build(commandContext, input, mStat != Mean);
+
+		setRadius(radius);
+		LocalStatsParams params = { radius, unsigned(mStat), gain };
+		if (memcmp(&params, &data, sizeof(data)) != 0)
+		{
+			data = params;
+			commandContext->UpdateBuffer(constBuffer, &data, sizeof(data));
+		}
+
+		commandContext->SetConstBuffer(constBuffer, 0);
+		commandContext->SetShader(computeShader);
+		commandContext->SetShaderResource(mTable.Sums(), 0, GHI::GHISRVParam());
+		if (mTable.Squares())
+			commandContext->SetShaderResource(mTable.Squares(), 1, GHI::GHISRVParam());
+		commandContext->SetShaderResource((*mOutputs[0])(), 0, GHI::GHIUAVParam());
+		commandContext->Dispatch((input->width + 31) / 32, (input->height + 31) / 32, 1);
+	}
+
+	//! The window clipped to the tile is the window clipped to the image once the tile
+	//! reaches radius pixels further, or the image border.
+	virtual ImageRect InputRect(const ImageRect &output, int imageWidth, int imageHeight) const override
+	{
+		return output.Grow(radius).Clamp(imageWidth, imageHeight);
+	}
+
+	//! 8 bits, the tables clamp and round the texels.
+	virtual GHI::EPixelFormat OutputFormat(GHI::EPixelFormat input) const override
+	{
+		return SummedAreaTable::OutputFormat(input);
+	}
+};
+
+//! Box filter of any radius, the mean of the window.
+class BoxFilter : public LocalStatsFilter
+{
+public:
+	BoxFilter()
+		: LocalStatsFilter(Mean)
+	{
+		mDescription = "Box Filter";
+	}
+
+	virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		Filter::UpdateUI(commandContext);
+
+		ImGui::Begin("Box Filter UI");
+		ImGui::SliderInt("Radius", &radius, 0, 256);
+		ImGui::End();
+	}
+};
+
+//! Local standard deviation of every channel, scaled by gain : texture and edges light up.
+class LocalVarianceFilter : public LocalStatsFilter
+{
+public:
+	LocalVarianceFilter()
+		: LocalStatsFilter(StandardDeviation)
+	{
+		mDescription = "Local Variance Filter";
+	}
+
+	virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		Filter::UpdateUI(commandContext);
+
+		ImGui::Begin("Local Variance UI");
+		ImGui::SliderInt("Radius", &radius, 1, 128);
+		ImGui::SliderFloat("Gain", &gain, 1.f, 16.f);
+		ImGui::End();
+	}
+};
+
+//! Guided filter (He et al.) : every window fits the output as a linear function of the
+//! guide, q = a I + b, which keeps the edges of the guide. The window means come from
+//! summed-area tables and the means of a and b from box passes of boxBlur.hlsl, so the
+//! cost per pixel does not depend on the radius, unlike the bilateral. Self-guided, the
+//! guide is the input; cross-guided, it is the image of the second input slot.
+class GuidedFilter : public Filter
+{
+	//! Matches cbuffer Guided in guidedCoeffs.hlsl
+	struct alignas(16) GuidedParams
+	{
+		int radius;
+		float epsilon;
+	};
+
+	//! Matches cbuffer BoxPass in boxBlur.hlsl
+	struct alignas(16) BoxPass
+	{
+		unsigned int direction[2];
+		unsigned int radius;
+		int origin;
+	};
+
+	static constexpr int BOX_GROUP_SIZE = 64;
+	static constexpr int BOX_SEGMENT = 64; //< SEGMENT in boxBlur.hlsl
+
+	const bool mCrossGuided;
+	GuidedParams data = { -1, 0.f };
+	int boxOrigin[2] = {};
+	GHI::GHIBuffer* constBuffer = nullptr;
+	GHI::GHIBuffer* boxBuffer[2] = { nullptr, nullptr };
+	std::string mOutputShaderFile;
+	std::string mBoxShaderFile;
+	GHI::GHIShader* outputShader = nullptr;
+	GHI::GHIShader* boxShader = nullptr;
+	SummedAreaTable mGuideTable;
+	SummedAreaTable mInputTable;
+	GHI::GHITexture* tempTexture[3] = { nullptr, nullptr, nullptr }; //< a, b, the box passes in between
+
+	int radius = 8;
+	float edge = 0.1f; //< sqrt(epsilon) : guide contrast below it is smoothed away
+
+public:
+	GuidedFilter(bool crossGuided = false, std::string filename = "..\\effects\\guidedCoeffs.hlsl",
+		std::string outputFile = "..\\effects\\guidedOutput.hlsl", std::string boxFile = "..\\effects\\boxBlur.hlsl")
+		: Filter(filename)
+		, mCrossGuided(crossGuided)
+		, mOutputShaderFile(outputFile)
+		, mBoxShaderFile(boxFile)
+	{
+		mDescription = crossGuided ? "Cross Guided Filter" : "Guided Filter";
+	}
+
+	//! The guide of a cross-guided filter is input slot 1.
+	virtual int InputCount() const override
+	{
+		return mCrossGuided ? 2 : 1;
+	}
+
+	void setRadius(int r)
+	{
+		radius = std::max(1, std::min(r, SummedAreaTable::MaxSquaresRadius()));
+	}
+	void setEdge(float e)
+	{
+		edge = std::max(e, 0.001f);
+	}
+
+	virtual void Init(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		constBuffer = commandContext->CreateConstBuffer(sizeof(data), &data);
+		BoxPass box = {};
+		for (GHI::GHIBuffer *&buffer : boxBuffer)
+			buffer = commandContext->CreateConstBuffer(sizeof(box), &box);
+		computeShader = commandContext->GetComputeShader(mShaderFile);
+		outputShader = commandContext->GetComputeShader(mOutputShaderFile);
+		boxShader = commandContext->GetComputeShader(mBoxShaderFile);
+		mGuideTable.Init(commandContext);
+		mInputTable.Init(commandContext);
+	}
+
+	virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		Filter::UpdateUI(commandContext);
+
+		ImGui::Begin(mCrossGuided ? "Cross Guided Filter UI" : "Guided Filter UI");
+		ImGui::SliderInt("Radius", &radius, 1, SummedAreaTable::MaxSquaresRadius());
+		ImGui::SliderFloat("Edge (sqrt epsilon)", &edge, 0.01f, 0.5f);
+		ImGui::End();
+	}
+
+	virtual void Active(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
+		GHI::GHITexture *input = (*mInputs[0])();
+		GHI::GHITexture *guide = mCrossGuided && mInputs.size() > 1 ? (*mInputs[1])() : nullptr;
+		if (!guide || guide->width != input->width || guide->height != input->height)
+			guide = input;
+
+		// Self-guided, the input tables are those of the guide : I p is I^2.
+		mGuideTable.Build(commandContext, guide, true);
+		SummedAreaTable &inputTable = guide == input ? mGuideTable : mInputTable;
+		if (guide != input)
+			mInputTable.Build(commandContext, input, true, guide);
+		UpdateParams(commandContext);
+		AcquireTemps(commandContext, input);
+
+		commandContext->SetConstBuffer(constBuffer, 0);
+		commandContext->SetShader(computeShader);
+		commandContext->SetShaderResource(tempTexture[0], 0, GHI::GHIUAVParam());
+		commandContext->SetShaderResource(tempTexture[1], 1, GHI::GHIUAVParam());
+		commandContext->SetShaderResource(mGuideTable.Sums(), 0, GHI::GHISRVParam());
+		commandContext->SetShaderResource(mGuideTable.Squares(), 1, GHI::GHISRVParam());
+		commandContext->SetShaderResource(inputTable.Sums(), 2, GHI::GHISRVParam());
+		commandContext->SetShaderResource(inputTable.Squares(), 3, GHI::GHISRVParam());
+		commandContext->Dispatch((input->width + 31) / 32, (input->height + 31) / 32, 1);
+
+		// Means of a and b : a horizontal box into the third temp, a vertical one back.
+		commandContext->SetShader(boxShader);
+		for (int map = 0; map < 2; ++map)
+		{
+			for (int pass = 0; pass < 2; ++pass)
+			{
+				GHI::GHITexture *src = pass == 0 ? tempTexture[map] : tempTexture[2];
+				GHI::GHITexture *dst = pass == 0 ? tempTexture[2] : tempTexture[map];
+				const unsigned int lines = pass == 0 ? input->height : input->width;
+				const unsigned int length = pass == 0 ? input->width : input->height;
+				const unsigned int segments = (boxOrigin[pass] % BOX_SEGMENT + length + BOX_SEGMENT - 1) / BOX_SEGMENT;
+				commandContext->SetConstBuffer(boxBuffer[pass], 0);
+				commandContext->SetShaderResource(dst, 0, GHI::GHIUAVParam());
+				commandContext->SetShaderResource(src, 0, GHI::GHISRVParam());
+				commandContext->Dispatch((lines + BOX_GROUP_SIZE - 1) / BOX_GROUP_SIZE, segments, 1);
+			}
+		}
+
+		commandContext->SetShader(outputShader);
+		commandContext->SetShaderResource((*mOutputs[0])(), 0, GHI::GHIUAVParam());
+		commandContext->SetShaderResource(guide, 0, GHI::GHISRVParam());
+		commandContext->SetShaderResource(tempTexture[0], 1, GHI::GHISRVParam());
+		commandContext->SetShaderResource(tempTexture[1], 2, GHI::GHISRVParam());
+		commandContext->SetShaderResource(input, 3, GHI::GHISRVParam());
+		commandContext->Dispatch((input->width + 31) / 32, (input->height + 31) / 32, 1);
+	}
+
+	//! The windows of a pixel's coefficients and the windows of the means around it. The
+	//! box pass of each direction rounds like the whole image from the first segment whose
+	//! window is exact in the tile on, which is up to a segment further in.
+	virtual ImageRect InputRect(const ImageRect &output, int imageWidth, int imageHeight) const override
+	{
+		return output.Grow(2 * radius + BOX_SEGMENT).Clamp(imageWidth, imageHeight);
+	}
+
+	//! 8 bits, the tables of the window means clamp and round the texels.
+	virtual GHI::EPixelFormat OutputFormat(GHI::EPixelFormat input) const override
+	{
+		return SummedAreaTable::OutputFormat(input);
+	}
+
+private:
+	void UpdateParams(GHI::IGHIComputeCommandCotext *commandContext)
+	{
+		setRadius(radius);
+		setEdge(edge);
+		GuidedParams params = { radius, edge * edge };
+		unsigned int imageWidth, imageHeight;
+		int originX, originY;
+		ImageRegion(imageWidth, imageHeight, originX, originY);
+		if (memcmp(&params, &data, sizeof(data)) == 0 && boxOrigin[0] == originX && boxOrigin[1] == originY)
+			return;
+		data = params;
+		boxOrigin[0] = originX;
+		boxOrigin[1] = originY;
+		commandContext->UpdateBuffer(constBuffer, &data, sizeof(data));
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			BoxPass box = {};
+			box.direction[0] = pass == 0 ? 1 : 0;
+			box.direction[1] = pass == 0 ? 0 : 1;
+			box.radius = radius;
+			box.origin = boxOrigin[pass];
+			commandContext->UpdateBuffer(boxBuffer[pass], &box, sizeof(box));
+		}
+	}
+
+	//! RGBA16F, a and b are signed and not limited to [0, 1].
+	void AcquireTemps(GHI::IGHIComputeCommandCotext *commandContext, const GHI::GHITexture *input)
+	{
+		for (GHI::GHITexture *&temp : tempTexture)
+		{
+			if (temp && (temp->width != input->width || temp->height != input->height))
+			{
+				commandContext->TexturePool().Release(temp);
+				temp = nullptr;
+			}
+			if (!temp)
+			{
+				GHI::TextureDesc2D desc;
+				desc.Width = input->width;
+				desc.Height = input->height;
+				desc.Format = GHI::PixelFormat_R16G16B16A16_FLOAT;
+				desc.BindFlags = GHI::BindFlag_SHADER_RESOURCE | GHI::BindFlag_UNORDERED_ACCESS;
+				temp = commandContext->TexturePool().Acquire(desc);
+			}
+		}
+	}
+};
+
+//! Canny edges : the luma into an R8 plane, a 3x3 Sobel with non-maximum suppression and
+//! a double threshold, then hysteresis passes that keep the weak edges connected to the
+//! strong ones, each pass following them one pixel further. The output is 0 or 1.
+class EdgeFilter : public Filter
+{
+	//! Matches cbuffer EdgeThresholds in sobelNms.hlsl
+	struct alignas(16) EdgeThresholds
+	{
+		float lowSq;
+		float highSq;
+	};
+
+	//! Matches cbuffer Hysteresis in hysteresis.hlsl
+	struct alignas(16) HysteresisPass
+	{
+		unsigned int final;
+	};
+
+	//! The thresholds are fractions of the gradient of a black to white step, 4 * 255.
+	static constexpr float MAX_GRADIENT = 4.f * 255.f;
+	static constexpr int MAX_PASSES = 32;
+
+	EdgeThresholds data = { -1.f, -1.f };
+	GHI::GHIBuffer* constBuffer = nullptr;
+	GHI::GHIBuffer* passBuffer[2] = { nullptr, nullptr }; //< intermediate, final
+	std::string mSobelShaderFile;
+	std::string mHysteresisShaderFile;
+	GHI::GHIShader* sobelShader = nullptr;
+	GHI::GHIShader* hysteresisShader = nullptr;
+	GHI::GHITexture* tempTexture[2] = { nullptr, nullptr }; //< R8 : the luma, then the passes ping-pong
+
+	float low = 0.1f;
+	float high = 0.25f;
+	int passes = 8;
+
+public:
+	EdgeFilter(std::string filename = "..\\effects\\luma.hlsl", std::string sobelFile = "..\\effects\\sobelNms.hlsl",
+		std::string hysteresisFile = "..\\effects\\hysteresis.hlsl")
+		: Filter(filename)
+		, mSobelShaderFile(sobelFile)
+		, mHysteresisShaderFile(hysteresisFile)
+	{
+		mDescription = "Edge Filter";
+	}
+
+	void setThresholds(float lowThreshold, float highThreshold)
+	{
+		low = std::max(0.f, std::min(lowThreshold, 1.f));
+		high = std::max(low, std::min(highThreshold, 1.f));
+	}
+	void setPasses(int n)
+	{
+		passes = std::max(1, std::min(n, MAX_PASSES));
+	}
+
+	virtual void Init(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		constBuffer = commandContext->CreateConstBuffer(sizeof(data), &data);
+		for (unsigned int final = 0; final < 2; ++final)
+		{
+			HysteresisPass pass = { final };
+			passBuffer[final] = commandContext->CreateConstBuffer(sizeof(pass), &pass);
+		}
+		computeShader = commandContext->GetComputeShader(mShaderFile);
+		sobelShader = commandContext->GetComputeShader(mSobelShaderFile);
+		hysteresisShader = commandContext->GetComputeShader(mHysteresisShaderFile);
+	}
+
+	virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		Filter::UpdateUI(commandContext);
+
+		ImGui::Begin("Edge Filter UI");
+		ImGui::SliderFloat("Low threshold", &low, 0.f, 1.f);
+		ImGui::SliderFloat("High threshold", &high, 0.f, 1.f);
+		ImGui::SliderInt("Hysteresis passes", &passes, 1, MAX_PASSES);
+		ImGui::End();
+	}
+
+	virtual void Active(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
+		GHI::GHITexture *input = (*mInputs[0])();
+		UpdateParams(commandContext);
+		AcquireTemps(commandContext, input);
+
+		commandContext->SetShader(computeShader);
+		commandContext->SetShaderResource(tempTexture[0], 0, GHI::GHIUAVParam());
+		commandContext->SetShaderResource(input, 0, GHI::GHISRVParam());
+		commandContext->Dispatch((input->width + 31) / 32, (input->height + 31) / 32, 1);
+
+		commandContext->SetConstBuffer(constBuffer, 0);
+		commandContext->SetShader(sobelShader);
+		commandContext->SetShaderResource(tempTexture[1], 0, GHI::GHIUAVParam());
+		commandContext->SetShaderResource(tempTexture[0], 0, GHI::GHISRVParam());
+		commandContext->Dispatch((input->width + 31) / 32, (input->height + 7) / 8, 1);
+
+		// The luma is not read any more, the passes ping-pong between the two temps.
+		commandContext->SetShader(hysteresisShader);
+		for (int pass = 0; pass < passes; ++pass)
+		{
+			const bool final = pass + 1 == passes;
+			GHI::GHITexture *src = tempTexture[1 - pass % 2];
+			GHI::GHITexture *dst = final ? (*mOutputs[0])() : tempTexture[pass % 2];
+			commandContext->SetConstBuffer(passBuffer[final ? 1 : 0], 0);
+			commandContext->SetShaderResource(dst, 0, GHI::GHIUAVParam());
+			commandContext->SetShaderResource(src, 0, GHI::GHISRVParam());
+			commandContext->Dispatch((input->width + 31) / 32, (input->height + 31) / 32, 1);
+		}
+	}
+
+	virtual GHI::EPixelFormat OutputFormat(GHI::EPixelFormat input) const override
+	{
+		return GHI::PixelFormat_R8_UNORM;
+	}
+
+	//! The Sobel window, the suppression neighbours and a pixel per hysteresis pass.
+	virtual ImageRect InputRect(const ImageRect &output, int imageWidth, int imageHeight) const override
+	{
+		return output.Grow(2 + passes).Clamp(imageWidth, imageHeight);
+	}
+
+	virtual void Release(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		for (GHI::GHITexture *&temp : tempTexture)
+		{
+			commandContext->TexturePool().Release(temp);
+			temp = nullptr;
+		}
+	}
+
+private:
+	void UpdateParams(GHI::IGHIComputeCommandCotext *commandContext)
+	{
+		setThresholds(low, high);
+		setPasses(passes);
+		const float lowGradient = low * MAX_GRADIENT, highGradient = high * MAX_GRADIENT;
+		EdgeThresholds params = { lowGradient * lowGradient, highGradient * highGradient };
+		if (memcmp(&params, &data, sizeof(data)) == 0)
+			return;
+		data = params;
+		commandContext->UpdateBuffer(constBuffer, &data, sizeof(data));
+	}
+
+	void AcquireTemps(GHI::IGHIComputeCommandCotext *commandContext, const GHI::GHITexture *input)
+	{
+		for (GHI::GHITexture *&temp : tempTexture)
+		{
+			if (temp && (temp->width != input->width || temp->height != input->height))
+			{
+				commandContext->TexturePool().Release(temp);
+				temp = nullptr;
+			}
+			if (!temp)
+			{
+				GHI::TextureDesc2D desc;
+				desc.Width = input->width;
+				desc.Height = input->height;
+				desc.Format = GHI::PixelFormat_R8_UNORM;
+				desc.BindFlags = GHI::BindFlag_SHADER_RESOURCE | GHI::BindFlag_UNORDERED_ACCESS;
+				temp = commandContext->TexturePool().Acquire(desc);
+			}
+		}
+	}
+};
+
+//! lut.hlsl, a colour transform looked up in a table : a .cube file, or a filter that only
+//! maps colours baked once by running it over the identity table. Whatever the grade
+//! costs per pixel, it then costs a lookup; a 1D table interpolates two entries per
+//! channel, a cube four (tetrahedral) or eight (trilinear).
+class LUTFilter : public Filter
+{
+public:
+	enum EInterpolation { Trilinear = 1, Tetrahedral = 2 }; //< the LUT_ defines of lut.hlsl
+
+	//! A 1D table of an entry per 8 bit level is exact on 8 bit images.
+	static constexpr uint32_t BAKE_1D_SIZE = 256;
+	static constexpr uint32_t BAKE_3D_SIZE = 33;
+
+private:
+	//! Matches cbuffer ColorLUT in lut.hlsl
+	struct alignas(16) LUTParams
+	{
+		unsigned int size;
+		unsigned int mode;
+		float pad[2];
+		float domainMin[4];
+		float domainScale[4];
+	};
+
+	LUTParams data = {};
+	GHI::GHIBuffer* constBuffer = nullptr;
+	ColorLUT mLUT;                    //< its entries are dropped once they are uploaded
+	std::unique_ptr<Filter> mSource;  //< baked into the table
+	bool mDirty = true;
+	GHI::GHITexture* lutTexture = nullptr;
+	int interpolation = Tetrahedral;
+
+public:
+	//! The identity until LoadCube().
+	LUTFilter(std::string filename = "..\\effects\\lut.hlsl")
+		: Filter(filename)
+	{
+		mLUT = ColorLUT::Identity(ColorLUT3D, 2);
+		mDescription = "LUT Filter";
+	}
+	//! Bakes colorFilter, which the LUT owns, into a table of type; per-channel filters can
+	//! go to either, 3D ones only to a cube. A filter that is not a colour transform, see
+	//! CanBake(), is an error : the LUT drops it and stays the identity.
+	LUTFilter(Filter *colorFilter, EColorLUTType type = ColorLUT1D, std::string filename = "..\\effects\\lut.hlsl")
+		: Filter(filename)
+		, mSource(colorFilter)
+	{
+		assert(CanBake(colorFilter) && "only colour transforms can be baked into a LUT");
+		if (!CanBake(colorFilter))
+		{
+			EINFO("%s is not a colour transform, it can not be baked into a LUT\n", colorFilter ? colorFilter->Description().c_str() : "no filter");
+			mSource.reset();
+			mLUT = ColorLUT::Identity(ColorLUT3D, 2);
+			mDescription = "LUT Filter";
+			return;
+		}
+		if (mSource->ColorTransform() != ColorTransformPerChannel)
+			type = ColorLUT3D;
+		mLUT.type = type;
+		mLUT.size = type == ColorLUT1D ? BAKE_1D_SIZE : BAKE_3D_SIZE;
+		mLUT.title = mSource->Description();
+		mDescription = "LUT: " + mSource->Description();
+	}
+	//! A filter reading its pixel's colour only, nothing of the position or the neighbours
+	//! of the pixel : run over the identity lattice it gives the table of its mapping.
+	static bool CanBake(const Filter *filter)
+	{
+		return filter && filter->ColorTransform() != ColorTransformNone;
+	}
+	//! Replaces the table by the one of a .cube file, false with error set if it can not be read.
+	bool LoadCube(const std::string &cubeFile, std::string &error)
+	{
+		ColorLUT lut;
+		if (!lut.LoadCube(cubeFile, error))
+			return false;
+		mLUT = std::move(lut);
+		mSource.reset();
+		mDirty = true;
+		mDescription = "LUT: " + mLUT.title;
+		return true;
+	}
+	void setInterpolation(EInterpolation mode)
+	{
+		interpolation = mode;
+	}
+	//! After the parameters of the baked filter changed.
+	void Rebake()
+	{
+		mDirty = mSource != nullptr;
+	}
+
+	virtual void Init(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		constBuffer = commandContext->CreateConstBuffer(sizeof(data), &data);
+		computeShader = commandContext->GetComputeShader(mShaderFile);
+		if (mSource)
+			mSource->Init(commandContext);
+	}
+
+	virtual void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		Filter::UpdateUI(commandContext);
+
+		ImGui::Begin("LUT Filter UI");
+		ImGui::Text("%s : %s table, %u entries a side", mLUT.title.c_str(), mLUT.type == ColorLUT1D ? "1D" : "3D", mLUT.size);
+		if (mLUT.type == ColorLUT3D)
+		{
+			ImGui::RadioButton("Trilinear", &interpolation, Trilinear);
+			ImGui::SameLine();
+			ImGui::RadioButton("Tetrahedral", &interpolation, Tetrahedral);
+		}
+		ImGui::End();
+	}
+
+	virtual void Active(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
+		GHI::GHITexture *input = (*mInputs[0])();
+		if (mDirty)
+			Upload(commandContext);
+		UpdateParams(commandContext);
+
+		commandContext->SetConstBuffer(constBuffer, 0);
+		commandContext->SetShader(computeShader);
+		commandContext->SetShaderResource(input, 0, GHI::GHISRVParam());
+		commandContext->SetShaderResource(lutTexture, 1, GHI::GHISRVParam());
+		commandContext->SetShaderResource((*mOutputs[0])(), 0, GHI::GHIUAVParam());
+		commandContext->Dispatch((input->width + 31) / 32, (input->height + 31) / 32, 1);
+	}
+
+	//! A table of tables is a table again.
+	virtual EColorTransform ColorTransform() const override
+	{
+		return mLUT.type == ColorLUT1D ? ColorTransformPerChannel : ColorTransform3D;
+	}
+
+private:
+	//! The table into its texture; a baked one is the output of its filter over the identity.
+	void Upload(GHI::IGHIComputeCommandCotext *commandContext)
+	{
+		if (lutTexture)
+			commandContext->DestroyTexture(lutTexture);
+		if (mSource)
+		{
+			const ColorLUT identity = ColorLUT::Identity(mLUT.type, mLUT.size);
+			GHI::GHITexture *lattice = commandContext->CreateTexture(identity.TextureDesc(), identity.entries.data());
+			lutTexture = commandContext->CreateTexture(mLUT.TextureDesc());
+			mSource->setInput(0, lattice);
+			mSource->addOutput(lutTexture);
+			mSource->Active(commandContext);
+			commandContext->DestroyTexture(lattice);
+		}
+		else
+		{
+			lutTexture = commandContext->CreateTexture(mLUT.TextureDesc(), mLUT.entries.data());
+			std::vector<float>().swap(mLUT.entries);
+		}
+		mDirty = false;
+	}
+
+	void UpdateParams(GHI::IGHIComputeCommandCotext *commandContext)
+	{
+		LUTParams params = {};
+		params.size = mLUT.size;
+		params.mode = mLUT.type == ColorLUT1D ? 0 : unsigned(interpolation);
+		for (int c = 0; c < 3; ++c)
+		{
+			params.domainMin[c] = mLUT.domainMin[c];
+			params.domainScale[c] = float(mLUT.size - 1) / (mLUT.domainMax[c] - mLUT.domainMin[c]);
+		}
+		params.domainScale[3] = float(mLUT.size - 1);
+		if (memcmp(&params, &data, sizeof(data)) == 0)
+			return;
+		data = params;
+		commandContext->UpdateBuffer(constBuffer, &data, sizeof(data));
+	}
+};
+
+//! A run of per-pixel filters as one dispatch of pointwise.hlsl : the image is read and
+//! written once and the values between the stages stay in registers. The permutation is
+//! chosen by the ops of the stages, their parameters are read again on every Active()
+//! so edits in the filters' windows apply.
+class FusedPointwiseFilter : public Filter
+{
+public:
+	static const int MaxStages = 4;
+
+private:
+	//! Matches cbuffer CB in pointwise.hlsl
+	struct alignas(16) PointwiseParams
+	{
+		unsigned int width;
+		unsigned int height;
+		int originX;
+		int originY;
+		unsigned int stageCount;
+		unsigned int pad[3];
+		unsigned int ops[MaxStages];
+		float params[MaxStages][4];
+	};
+
+	std::vector<Filter*> mStages;
+	PointwiseParams data = {};
+	GHI::GHIBuffer* constBuffer = nullptr;
+
+public:
+	FusedPointwiseFilter(const std::vector<Filter*> &stages, std::string filename = "..\\effects\\pointwise.hlsl")
+		: Filter(filename)
+		, mStages(stages)
+	{
+		std::string names;
+		for (const Filter *stage : mStages)
+			names += (names.empty() ? "" : " + ") + stage->Description();
+		mDescription = "Fused: " + names;
+	}
+
+	const std::vector<Filter*>& Stages() const
+	{
+		return mStages;
+	}
+
+	virtual void Init(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		GHI::ShaderKey key(mShaderFile);
+		data.stageCount = unsigned(mStages.size());
+		for (size_t i = 0; i < mStages.size(); ++i)
+		{
+			PointwiseStage stage;
+			mStages[i]->GetPointwiseStage(stage);
+			data.ops[i] = stage.op;
+			key.Define("STAGE" + std::to_string(i), std::to_string(stage.op));
+		}
+		constBuffer = commandContext->CreateConstBuffer(sizeof(data), &data);
+		computeShader = commandContext->GetComputeShader(key);
+	}
+
+	virtual void Active(GHI::IGHIComputeCommandCotext *commandContext) override
+	{
+		DEBUG("active compute shader: [%s]", computeShader->info.shaderfile.c_str());
+		GHI::GHITexture *input = (*mInputs[0])();
+		PointwiseParams params = data;
+		ImageRegion(params.width, params.height, params.originX, params.originY);
+		for (size_t i = 0; i < mStages.size(); ++i)
+		{
+			PointwiseStage stage;
+			mStages[i]->GetPointwiseStage(stage);
+			std::copy(stage.params, stage.params + 4, params.params[i]);
+		}
+		if (memcmp(&params, &data, sizeof(data)) != 0)
+		{
+			data = params;
+			commandContext->UpdateBuffer(constBuffer, &data, sizeof(data));
+		}
+
+		commandContext->SetConstBuffer(constBuffer, 0);
+		commandContext->SetShader(computeShader);
+		commandContext->SetShaderResource(input, 0, GHI::GHISRVParam());
+		commandContext->SetShaderResource((*mOutputs[0])(), 0, GHI::GHIUAVParam());
+		commandContext->Dispatch((input->width + 31) / 32, (input->height + 31) / 32, 1);
+	}
+};
+
+//! Filters by the names used on the command line, nullptr for an unknown name.
+Filter* CreateFilter(const std::string &name);
+std::vector<std::string> FilterNames();
+
 #endif /* FILTER_H_*/
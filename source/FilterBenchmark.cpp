@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include "FilterBenchmark.h"
+#include "Filter.h"
+#include "CPUKernels.h"
+#include "CPUSimd.h"
+#include "FCPUGHICommandContext.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	typedef std::function<Filter*()> FilterFactory;
+
+	//! Pixels of the benchmarks : smooth areas with noise and hard edges, a photo is not flat either.
+	std::vector<uint8_t> BenchmarkImage(uint32_t width, uint32_t height)
+	{
+		std::vector<uint8_t> pixels(size_t(width) * height * 4);
+		uint32_t seed = 1;
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				uint8_t *p = &pixels[(size_t(y) * width + x) * 4];
+				const int noise = int(seed >> 28) - 8;
+				p[0] = uint8_t(std::min(std::max(int(x * 255 / width) + noise, 0), 255));
+				p[1] = uint8_t(std::min(std::max(int(y * 255 / height) + noise, 0), 255));
+				p[2] = ((x / 64 + y / 64) & 1) ? 200 : 40;
+				p[3] = 255;
+			}
+		}
+		return pixels;
+	}
+
+	//! The CPU command context of a benchmark and the measurement every table cell shares.
+	class BenchmarkRunner
+	{
+	public:
+		BenchmarkRunner()
+		{
+			RegisterCPUKernels();
+			mContext = new GHI::FCPUIGHIComputeCommandCotext;
+		}
+		~BenchmarkRunner()
+		{
+			SetCPUSimd(CPUSimdSupported());
+			for (auto it = GHI::GHIResource::list.begin(); it != GHI::GHIResource::list.end(); ++it)
+			{
+				(*it)->release();
+			}
+			delete mContext;
+		}
+
+		//! MPixel/s of the filter factory creates over a width x height image, once per
+		//! instruction set of simds. The filter is run once before each measurement and
+		//! for half a second (at most 100 runs) after.
+		std::vector<double> Measure(const FilterFactory &factory, uint32_t width, uint32_t height, const std::vector<ECPUSimd> &simds)
+		{
+			const ECPUSimd current = CPUSimd();
+			const std::vector<uint8_t> pixels = BenchmarkImage(width, height);
+			GHI::TextureDesc2D desc;
+			desc.Width = width;
+			desc.Height = height;
+			desc.BindFlags = GHI::BindFlag_SHADER_RESOURCE | GHI::BindFlag_UNORDERED_ACCESS;
+			GHI::GHITexture *input = mContext->CreateTexture(desc, pixels.data());
+			Filter *filter = factory();
+			filter->Init(mContext);
+			desc.Format = filter->OutputFormat(input->format);
+			GHI::GHITexture *output = mContext->CreateTexture(desc);
+			filter->addInput(input);
+			filter->addOutput(output);
+
+			std::vector<double> results;
+			for (ECPUSimd simd : simds)
+			{
+				SetCPUSimd(simd);
+				filter->Active(mContext);
+				int runs = 0;
+				const auto t0 = std::chrono::steady_clock::now();
+				double seconds = 0.;
+				do
+				{
+					filter->Active(mContext);
+					++runs;
+					seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+				} while (seconds < 0.5 && runs < 100);
+				results.push_back(double(width) * height * runs / seconds * 1e-6);
+			}
+			SetCPUSimd(current);
+
+			filter->Release(mContext);
+			delete filter;
+			mContext->DestroyTexture(input);
+			mContext->DestroyTexture(output);
+			return results;
+		}
+		double Measure(const FilterFactory &factory, uint32_t width, uint32_t height)
+		{
+			return Measure(factory, width, height, { CPUSimd() })[0];
+		}
+
+		//! Every instruction set the CPU supports, scalar first.
+		static std::vector<ECPUSimd> SupportedSimds()
+		{
+			std::vector<ECPUSimd> simds;
+			for (int simd = CPUSimdScalar; simd <= CPUSimdSupported(); ++simd)
+				simds.push_back(ECPUSimd(simd));
+			return simds;
+		}
+
+	private:
+		GHI::IGHIComputeCommandCotext *mContext = nullptr;
+	};
+
+	void PrintRow(const std::vector<double> &results)
+	{
+		for (double r : results)
+			printf("%10.1f", r);
+		printf("\n");
+		fflush(stdout);
+	}
+
+	//! The exact bilateral filter over a 1920 x 1080 image for every window, with each
+	//! instruction set the CPU supports.
+	void BilateralBenchmark(BenchmarkRunner &runner)
+	{
+		const uint32_t width = 1920, height = 1080;
+		const std::vector<ECPUSimd> simds = BenchmarkRunner::SupportedSimds();
+		printf("bilateral %ux%u, %u threads, MPixel/s\nwindow", width, height, GHI::ThreadPool::Global().NumThreads());
+		for (ECPUSimd simd : simds)
+			printf("%10s", CPUSimdName(simd));
+		printf("\n");
+		for (int window = 3; window <= 17; window += 2)
+		{
+			printf("%6d", window);
+			PrintRow(runner.Measure([window]()
+			{
+				BilaterialFilter *filter = new BilaterialFilter();
+				filter->setWindow(window);
+				return filter;
+			}, width, height, simds));
+		}
+	}
+
+	//! The gaussian blur over a 1920 x 1080 image, taps against stacked boxes as sigma
+	//! grows. The taps stop at DIRECT_MAX_SIGMA.
+	void BlurBenchmark(BenchmarkRunner &runner)
+	{
+		const uint32_t width = 1920, height = 1080;
+		printf("gaussian blur %ux%u, %u threads, %s, MPixel/s\n%6s%10s%10s\n", width, height, GHI::ThreadPool::Global().NumThreads(),
+			CPUSimdName(CPUSimd()), "sigma", "taps", "boxes");
+		for (float sigma = 1.f; sigma <= 64.f; sigma *= 2.f)
+		{
+			auto blur = [sigma](GaussianBlurFilter::EMode mode)
+			{
+				return [sigma, mode]()
+				{
+					GaussianBlurFilter *filter = new GaussianBlurFilter();
+					filter->setSigma(sigma);
+					filter->setMode(mode);
+					return filter;
+				};
+			};
+			printf("%6.0f", sigma);
+			if (sigma <= GaussianBlurFilter::DIRECT_MAX_SIGMA)
+				printf("%10.1f", runner.Measure(blur(GaussianBlurFilter::Direct), width, height));
+			else
+				printf("%10s", "-");
+			PrintRow({ runner.Measure(blur(GaussianBlurFilter::Box), width, height) });
+		}
+	}
+
+	//! The edge detector over 1080p, 4K and 8K images, with each instruction set the
+	//! CPU supports.
+	void EdgeBenchmark(BenchmarkRunner &runner)
+	{
+		const std::vector<ECPUSimd> simds = BenchmarkRunner::SupportedSimds();
+		printf("edge %u threads, MPixel/s\n%11s", GHI::ThreadPool::Global().NumThreads(), "image");
+		for (ECPUSimd simd : simds)
+			printf("%10s", CPUSimdName(simd));
+		printf("\n");
+
+		const uint32_t sizes[][2] = { { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 } };
+		for (const auto &size : sizes)
+		{
+			printf("%5ux%-5u", size[0], size[1]);
+			PrintRow(runner.Measure([]() { return new EdgeFilter(); }, size[0], size[1], simds));
+		}
+	}
+
+	struct Benchmark
+	{
+		const char *name;
+		const char *description;
+		void (*run)(BenchmarkRunner &runner);
+	};
+
+	const Benchmark Benchmarks[] =
+	{
+		{ "bilateral", "exact bilateral filter per window and instruction set, 1080p", BilateralBenchmark },
+		{ "blur", "gaussian blur taps against stacked boxes per sigma, 1080p", BlurBenchmark },
+		{ "edge", "Canny edge detector per image size up to 8K and instruction set", EdgeBenchmark },
+	};
+}
+
+std::string FilterBenchmarkUsage()
+{
+	std::string usage = "usage: --benchmark <name>, CPU backend benchmarks:";
+	for (const Benchmark &benchmark : Benchmarks)
+		usage += std::string("\n  ") + benchmark.name + " : " + benchmark.description;
+	return usage;
+}
+
+bool RunFilterBenchmark(const std::string &name)
+{
+	for (const Benchmark &benchmark : Benchmarks)
+	{
+		if (name == benchmark.name)
+		{
+			BenchmarkRunner runner;
+			benchmark.run(runner);
+			return true;
+		}
+	}
+	return false;
+}
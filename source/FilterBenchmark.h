@@ -0,0 +1,19 @@
+#ifndef FILTER_BENCHMARK_H_
+#define FILTER_BENCHMARK_H_
+
+#include <string>
+
+//--------------------------------------------------------------------------------------
+// "--benchmark <name>" : throughput of the filters on the CPU backend, printed as a table
+// of MPixel/s. Every cell runs the filter a factory creates over a synthetic image, with
+// the instruction set of its column or row, and frees the filter, its pooled
+// intermediates and the textures before the next one.
+//--------------------------------------------------------------------------------------
+
+//! Benchmarks RunFilterBenchmark() knows, with a line describing each.
+std::string FilterBenchmarkUsage();
+
+//! Prints the table of the benchmark name. False, with nothing run, when name is unknown.
+bool RunFilterBenchmark(const std::string &name);
+
+#endif
@@ -0,0 +1,471 @@
+#include <algorithm>
+#include "FilterGraph.h"
+#include "Filter.h"
+#include "ImNodes.h"
+#include "ImNodesEz.h"
+
+static const int TextureSlotKind = 1;
+
+FilterGraph::FilterGraph()
+{
+}
+
+FilterGraph::~FilterGraph()
+{
+	for (size_t i = 0; i < mNodes.size(); ++i)
+		RemoveNode(int(i));
+}
+
+int FilterGraph::AddNode(Filter *filter, bool owned)
+{
+	std::unique_ptr<Node> node(new Node);
+	node->filter = filter;
+	node->owned = owned;
+	node->inputs.assign(filter->InputCount(), None);
+	for (int slot = 0; slot < filter->InputCount(); ++slot)
+		node->slotNames.push_back(slot == 0 ? "In" : "In " + std::to_string(slot));
+	// Cascade new nodes on the canvas instead of stacking them.
+	const int id = int(mNodes.size());
+	node->pos = ImVec2(220.f + 40.f * (id % 8), 40.f + 60.f * (id % 8));
+	mNodes.push_back(std::move(node));
+	mDirty = true;
+	return id;
+}
+
+void FilterGraph::RemoveNode(int node)
+{
+	Node *n = Find(node);
+	if (!n)
+		return;
+	for (const std::unique_ptr<Node> &other : mNodes)
+	{
+		if (!other)
+			continue;
+		for (int &from : other->inputs)
+			from = from == node ? None : from;
+	}
+	if (mOutput == node)
+		mOutput = None;
+	if (mFocus == node)
+		mFocus = None;
+	for (auto it = mFused.begin(); it != mFused.end();)
+	{
+		// a later filter at the same address must not pick up this permutation
+		if (std::find(it->first.begin(), it->first.end(), n->filter) != it->first.end())
+			it = mFused.erase(it);
+		else
+			++it;
+	}
+	mSteps.clear();
+	if (n->owned)
+		delete n->filter;
+	mNodes[node].reset();
+	mDirty = true;
+}
+
+Filter* FilterGraph::NodeFilter(int node) const
+{
+	Node *n = Find(node);
+	return n ? n->filter : nullptr;
+}
+
+FilterGraph::Node* FilterGraph::Find(int node) const
+{
+	return node >= 0 && node < int(mNodes.size()) ? mNodes[node].get() : nullptr;
+}
+
+//! true when node reads, directly or through other nodes, the output of producer.
+bool FilterGraph::DependsOn(int node, int producer) const
+{
+	if (node == producer)
+		return true;
+	Node *n = Find(node);
+	if (!n)
+		return false;
+	for (int from : n->inputs)
+	{
+		if (from >= 0 && DependsOn(from, producer))
+			return true;
+	}
+	return false;
+}
+
+bool FilterGraph::Connect(int from, int node, int slot)
+{
+	Node *n = Find(node);
+	if (!n || slot < 0 || slot >= int(n->inputs.size()))
+		return false;
+	if (from != Source && (!Find(from) || DependsOn(from, node)))
+		return false; // unknown producer or the edge would close a cycle
+	n->inputs[slot] = from;
+	mDirty = true;
+	return true;
+}
+
+void FilterGraph::Disconnect(int node, int slot)
+{
+	Node *n = Find(node);
+	if (n && slot >= 0 && slot < int(n->inputs.size()))
+	{
+		n->inputs[slot] = None;
+		mDirty = true;
+	}
+}
+
+void FilterGraph::DisconnectAll()
+{
+	for (const std::unique_ptr<Node> &node : mNodes)
+	{
+		if (node)
+			node->inputs.assign(node->inputs.size(), None);
+	}
+	mOutput = None;
+	mDirty = true;
+}
+
+void FilterGraph::SetOutput(int from)
+{
+	mOutput = (from == Source || Find(from)) ? from : None;
+	mDirty = true;
+}
+
+bool FilterGraph::ConnectChain(const std::vector<int> &nodes)
+{
+	int from = Source;
+	for (int node : nodes)
+	{
+		if (!Connect(from, node, 0))
+			return false;
+		Node *n = Find(node);
+		for (int slot = 1; n && slot < int(n->inputs.size()); ++slot)
+			Connect(Source, node, slot);
+		from = node;
+	}
+	SetOutput(from);
+	return true;
+}
+
+bool FilterGraph::Schedule(std::vector<int> &order)
+{
+	order.clear();
+	if (mOutput == None)
+		return false;
+	if (mOutput == Source)
+		return true;
+
+	// Depth first from the output, a node is emitted once all its producers are, which
+	// is a topological order of the nodes the output depends on and nothing else.
+	enum EMark { Unvisited, Visiting, Done };
+	std::vector<EMark> marks(mNodes.size(), Unvisited);
+	struct Frame
+	{
+		int node;
+		size_t next;
+	};
+	std::vector<Frame> stack = { { mOutput, 0 } };
+	marks[mOutput] = Visiting;
+	while (!stack.empty())
+	{
+		Frame &frame = stack.back();
+		Node *n = Find(frame.node);
+		if (frame.next == n->inputs.size())
+		{
+			marks[frame.node] = Done;
+			order.push_back(frame.node);
+			stack.pop_back();
+			continue;
+		}
+		const int from = n->inputs[frame.next++];
+		if (from == Source)
+			continue;
+		if (from == None || marks[from] == Visiting)
+		{
+			order.clear(); // unconnected input or a cycle
+			return false;
+		}
+		if (marks[from] == Unvisited)
+		{
+			marks[from] = Visiting;
+			stack.push_back({ from, 0 });
+		}
+	}
+	return true;
+}
+
+bool FilterGraph::Scheduled()
+{
+	if (mDirty)
+	{
+		mValid = Schedule(mOrder);
+		mDirty = false;
+		mPlanned = false;
+	}
+	return mValid;
+}
+
+FusedPointwiseFilter* FilterGraph::FusedFilter(GHI::IGHIComputeCommandCotext *commandContext, const std::vector<Filter*> &stages)
+{
+	std::unique_ptr<FusedPointwiseFilter> &fused = mFused[stages];
+	if (!fused)
+	{
+		fused.reset(new FusedPointwiseFilter(stages));
+		fused->Init(commandContext);
+	}
+	return fused.get();
+}
+
+void FilterGraph::Fuse(GHI::IGHIComputeCommandCotext *commandContext)
+{
+	std::vector<int> readers(mNodes.size(), 0);
+	for (int node : mOrder)
+	{
+		for (int from : mNodes[node]->inputs)
+		{
+			if (from >= 0)
+				++readers[from];
+		}
+	}
+
+	// A node joins the run before it when it is per-pixel, has one input and that input
+	// is the run's last node, read by nobody else. Post-order puts such a producer right
+	// before its reader, so only the previous step has to be looked at.
+	mSteps.clear();
+	mFusedNodes = 0;
+	std::vector<std::vector<Filter*>> runs;
+	PointwiseStage stage;
+	for (int node : mOrder)
+	{
+		Node &n = *mNodes[node];
+		const bool pointwise = mFusion && n.inputs.size() == 1 && n.filter->GetPointwiseStage(stage);
+		if (pointwise && !mSteps.empty() && !runs.back().empty() && n.inputs[0] == mSteps.back().node &&
+			readers[n.inputs[0]] == 1 && n.inputs[0] != mOutput && int(runs.back().size()) < FusedPointwiseFilter::MaxStages)
+		{
+			mSteps.back().node = node;
+			runs.back().push_back(n.filter);
+			continue;
+		}
+		mSteps.push_back({ node, node, n.filter });
+		runs.push_back(pointwise ? std::vector<Filter*>(1, n.filter) : std::vector<Filter*>());
+	}
+	for (size_t i = 0; i < mSteps.size(); ++i)
+	{
+		if (runs[i].size() > 1)
+		{
+			mSteps[i].filter = FusedFilter(commandContext, runs[i]);
+			mFusedNodes += uint32_t(runs[i].size());
+		}
+	}
+}
+
+void FilterGraph::Plan(GHI::IGHIComputeCommandCotext *commandContext, const GHI::GHITextureKey &key)
+{
+	Fuse(commandContext);
+
+	std::vector<int> step(mNodes.size(), -1);
+	for (size_t i = 0; i < mSteps.size(); ++i)
+		step[mSteps[i].node] = int(i);
+	std::vector<int> lastRead(step);
+	for (size_t i = 0; i < mSteps.size(); ++i)
+	{
+		for (int from : mNodes[mSteps[i].head]->inputs)
+		{
+			if (from >= 0)
+				lastRead[from] = std::max(lastRead[from], int(i));
+		}
+	}
+
+	// Every output in the format its filter asks for, given the format of its first input.
+	std::vector<GHI::EPixelFormat> format(mNodes.size(), key.format);
+	for (int node : mOrder)
+	{
+		const Node &n = *mNodes[node];
+		const int from = n.inputs.empty() ? Source : n.inputs[0];
+		format[node] = n.filter->OutputFormat(from >= 0 ? format[from] : key.format);
+	}
+
+	mTransients.Reset();
+	mTransientOf.assign(mNodes.size(), -1);
+	for (const Step &s : mSteps)
+	{
+		if (s.node == mOutput)
+			continue;
+		GHI::GHITextureKey nodeKey = key;
+		nodeKey.format = format[s.node];
+		nodeKey.mipLevels = 1; // filters write mip 0 only
+		mTransientOf[s.node] = mTransients.Declare(nodeKey, step[s.node], lastRead[s.node]);
+	}
+	mTransients.Compile(commandContext);
+	mPlanKey = key;
+	mPlanned = true;
+}
+
+ImageRect FilterGraph::TileRect(const ImageRect &output, int imageWidth, int imageHeight)
+{
+	if (!Scheduled() || mOutput == Source)
+		return output;
+
+	std::vector<ImageRect> need(mNodes.size());
+	need[mOutput] = output;
+	ImageRect rect = output;
+	for (auto it = mOrder.rbegin(); it != mOrder.rend(); ++it)
+	{
+		const Node &n = *mNodes[*it];
+		const ImageRect input = n.filter->InputRect(need[*it], imageWidth, imageHeight);
+		rect = rect.Union(need[*it]).Union(input);
+		for (int from : n.inputs)
+		{
+			if (from >= 0)
+				need[from] = need[from].Union(input);
+		}
+	}
+	return rect.Clamp(imageWidth, imageHeight);
+}
+
+bool FilterGraph::Execute(GHI::IGHIComputeCommandCotext *commandContext, GHI::GHITexture *source, GHI::GHITexture *target, const ImageTile *tile)
+{
+	if (!source || !target)
+		return false;
+	if (!Scheduled())
+		return false;
+	if (mOutput == Source)
+	{
+		commandContext->CopyTexture(target, source);
+		return true;
+	}
+
+	const GHI::GHITextureKey key = GHI::GHITextureKey::Like(source);
+	if (!mPlanned || !(mPlanKey == key))
+		Plan(commandContext, key);
+
+	std::vector<GHI::GHITexture*> results(mNodes.size(), nullptr);
+	const uint64_t pixels = uint64_t(source->width) * source->height;
+	const ImageTile image = tile ? *tile : ImageTile();
+	for (const Step &s : mSteps)
+	{
+		const Node &head = *mNodes[s.head];
+		s.filter->setTile(image);
+		for (size_t slot = 0; slot < head.inputs.size(); ++slot)
+			s.filter->setInput(int(slot), head.inputs[slot] == Source ? source : results[head.inputs[slot]]);
+
+		GHI::GHITexture *output = s.node == mOutput ? target : mTransients.Get(mTransientOf[s.node]);
+		s.filter->addOutput(output);
+		commandContext->BeginProfile(s.filter->Description(), pixels);
+		s.filter->Active(commandContext);
+		commandContext->EndProfile();
+		results[s.node] = output;
+	}
+	return true;
+}
+
+void* FilterGraph::UIId(int node)
+{
+	if (node == Source)
+		return &mSourceUI;
+	return Find(node);
+}
+
+int FilterGraph::NodeFromUIId(void *id) const
+{
+	if (id == &mSourceUI)
+		return Source;
+	for (size_t i = 0; i < mNodes.size(); ++i)
+	{
+		if (mNodes[i].get() == id)
+			return int(i);
+	}
+	return None;
+}
+
+int FilterGraph::SlotFromName(int node, const char *name) const
+{
+	Node *n = Find(node);
+	for (size_t slot = 0; n && name && slot < n->slotNames.size(); ++slot)
+	{
+		if (n->slotNames[slot] == name)
+			return int(slot);
+	}
+	return -1;
+}
+
+void FilterGraph::UpdateUI(GHI::IGHIComputeCommandCotext *commandContext)
+{
+	static const ImNodes::Ez::SlotInfo imageSlot[1] = { { "Out", TextureSlotKind } };
+	static const ImNodes::Ez::SlotInfo outputSlot[1] = { { "In", TextureSlotKind } };
+
+	if (ImGui::Begin("Filter Graph", nullptr, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse))
+	{
+		ImGui::Text("Drag from Out to In to connect, drag a connection away to remove it.");
+		if (!mCanvas)
+			mCanvas.reset(new ImNodes::CanvasState());
+		ImNodes::BeginCanvas(mCanvas.get());
+
+		if (ImNodes::Ez::BeginNode(&mSourceUI, "Input Image", &mSourceUI.pos, &mSourceUI.selected))
+		{
+			ImNodes::Ez::InputSlots(nullptr, 0);
+			ImNodes::Ez::OutputSlots(imageSlot, 1);
+			ImNodes::Ez::EndNode();
+		}
+
+		std::vector<ImNodes::Ez::SlotInfo> inputs;
+		for (size_t i = 0; i < mNodes.size(); ++i)
+		{
+			Node *n = mNodes[i].get();
+			if (!n)
+				continue;
+			inputs.clear();
+			for (const std::string &name : n->slotNames)
+				inputs.push_back({ name.c_str(), TextureSlotKind });
+			if (ImNodes::Ez::BeginNode(n, n->filter->Description().c_str(), &n->pos, &n->selected))
+			{
+				ImNodes::Ez::InputSlots(inputs.data(), int(inputs.size()));
+				ImNodes::Ez::OutputSlots(imageSlot, 1);
+				ImNodes::Ez::EndNode();
+			}
+			if (n->selected)
+				mFocus = int(i);
+		}
+
+		if (ImNodes::Ez::BeginNode(&mOutputUI, "Output Image", &mOutputUI.pos, &mOutputUI.selected))
+		{
+			ImNodes::Ez::InputSlots(outputSlot, 1);
+			ImNodes::Ez::OutputSlots(nullptr, 0);
+			ImNodes::Ez::EndNode();
+		}
+
+		void *inputNode = nullptr;
+		void *outputNode = nullptr;
+		const char *inputSlot = nullptr;
+		const char *outputSlot = nullptr;
+		if (ImNodes::GetNewConnection(&inputNode, &inputSlot, &outputNode, &outputSlot))
+		{
+			const int from = NodeFromUIId(outputNode);
+			if (inputNode == &mOutputUI)
+				SetOutput(from);
+			else if (!Connect(from, NodeFromUIId(inputNode), SlotFromName(NodeFromUIId(inputNode), inputSlot)))
+				INFO("filter graph: connection rejected, it would close a cycle\n");
+		}
+
+		for (size_t i = 0; i < mNodes.size(); ++i)
+		{
+			Node *n = mNodes[i].get();
+			for (size_t slot = 0; n && slot < n->inputs.size(); ++slot)
+			{
+				if (n->inputs[slot] != None && !ImNodes::Connection(n, n->slotNames[slot].c_str(), UIId(n->inputs[slot]), "Out"))
+					Disconnect(int(i), int(slot));
+			}
+		}
+		if (mOutput != None && !ImNodes::Connection(&mOutputUI, "In", UIId(mOutput), "Out"))
+			SetOutput(None);
+
+		ImNodes::EndCanvas();
+
+		if (!Scheduled())
+			ImGui::TextColored(ImVec4(1.f, 0.4f, 0.4f, 1.f), "The output is not connected to the input image.");
+	}
+	ImGui::End();
+
+	// Parameters of the node selected last, the output node until one is clicked.
+	Filter *filter = NodeFilter(mFocus != None ? mFocus : mOutput);
+	if (filter)
+		filter->UpdateUI(commandContext);
+}
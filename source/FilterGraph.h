@@ -0,0 +1,167 @@
+#ifndef FILTER_GRAPH_H_
+#define FILTER_GRAPH_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+#include "GHIResources.h"
+#include "GHICommandContext.h"
+#include "GHITransientAllocator.h"
+
+class Filter;
+class FusedPointwiseFilter;
+struct ImageRect;
+struct ImageTile;
+namespace ImNodes { struct CanvasState; }
+
+//--------------------------------------------------------------------------------------
+// Filters wired as a DAG. Nodes are filters, an edge connects the output of a node (or
+// the source image) to one input slot of another node, outputs can fan out. Execute()
+// runs the nodes the output depends on in topological order. The lifetime of every
+// intermediate, from the node writing it to its last reader, is planned once per graph
+// edit and source size; intermediates with disjoint lifetimes alias the same texture,
+// so a linear chain ping-pongs between two textures whatever its length. Runs of
+// per-pixel filters, each reading only the previous one, are fused into a single pass
+// of pointwise.hlsl and need no intermediate at all.
+//--------------------------------------------------------------------------------------
+class FilterGraph
+{
+public:
+	static constexpr int Source = -1; //< node id of the image the graph is executed on
+	static constexpr int None = -2;
+
+	FilterGraph();
+	FilterGraph(const FilterGraph&) = delete;
+	FilterGraph& operator=(const FilterGraph&) = delete;
+	~FilterGraph();
+
+	//! Returns the node id. An owned filter is deleted with its node.
+	int AddNode(Filter *filter, bool owned = false);
+	void RemoveNode(int node);
+	Filter* NodeFilter(int node) const;
+
+	//! Feeds input slot of node to from's output, replacing the edge the slot had.
+	//! Fails when it would close a cycle.
+	bool Connect(int from, int node, int slot = 0);
+	void Disconnect(int node, int slot = 0);
+	//! Removes every edge, the nodes stay.
+	void DisconnectAll();
+	//! from is the node written into the target of Execute(), None leaves it unconnected.
+	void SetOutput(int from);
+	int Output() const
+	{
+		return mOutput;
+	}
+
+	//! Source -> nodes[0] -> .. -> nodes[n-1] -> output. The other input slots of the
+	//! nodes, the guide of a cross-guided filter say, read the source image.
+	bool ConnectChain(const std::vector<int> &nodes);
+
+	//! Nodes the output depends on, in execution order. False when an input the output
+	//! depends on is unconnected or the output is not connected.
+	bool Schedule(std::vector<int> &order);
+
+	//! Fuses runs of per-pixel filters, on by default.
+	void SetFusion(bool fusion)
+	{
+		mFusion = fusion;
+		mPlanned = false;
+	}
+	bool Fusion() const
+	{
+		return mFusion;
+	}
+
+	//! Runs the graph on source and writes the output node into target, which must have
+	//! the size of source. Every pass is profiled under its filter's description, a
+	//! fused pass as "Fused: a + b". With a tile, source holds only that part of the image,
+	//! see TileRect().
+	bool Execute(GHI::IGHIComputeCommandCotext *commandContext, GHI::GHITexture *source, GHI::GHITexture *target, const ImageTile *tile = nullptr);
+
+	//! Part of the image a tiled run loads to compute output : the input rects of the
+	//! filters composed back from the output node. Every pass of the run covers it, the
+	//! pixels of output are exact, the rest is cropped.
+	ImageRect TileRect(const ImageRect &output, int imageWidth, int imageHeight);
+
+	//! Node canvas, connections are edited with the mouse. Also draws the parameter
+	//! window of the node selected last.
+	void UpdateUI(GHI::IGHIComputeCommandCotext *commandContext);
+
+	//! Intermediates of the last plan, the textures they alias into and their bytes.
+	const GHI::GHITransientStats& TransientStats() const
+	{
+		return mTransients.Stats();
+	}
+	//! Dispatch groups of the last plan and the nodes that ran inside a fused pass.
+	uint32_t Passes() const
+	{
+		return uint32_t(mSteps.size());
+	}
+	uint32_t FusedNodes() const
+	{
+		return mFusedNodes;
+	}
+
+private:
+	struct Node
+	{
+		Filter *filter = nullptr;
+		bool owned = false;
+		std::vector<int> inputs; //< producer per input slot, Source or None
+		std::vector<std::string> slotNames;
+		ImVec2 pos{};
+		bool selected = false;
+	};
+
+	//! One pass of the plan : a node, or a fused run from head to the node.
+	struct Step
+	{
+		int head;
+		int node;
+		Filter *filter;
+	};
+
+	struct UINode
+	{
+		ImVec2 pos{};
+		bool selected = false;
+	};
+
+	Node* Find(int node) const;
+	//! Schedules again after an edit, false while the graph can not run.
+	bool Scheduled();
+	bool DependsOn(int node, int producer) const;
+	void* UIId(int node);
+	int NodeFromUIId(void *id) const;
+	int SlotFromName(int node, const char *name) const;
+	void Plan(GHI::IGHIComputeCommandCotext *commandContext, const GHI::GHITextureKey &key);
+	void Fuse(GHI::IGHIComputeCommandCotext *commandContext);
+	FusedPointwiseFilter* FusedFilter(GHI::IGHIComputeCommandCotext *commandContext, const std::vector<Filter*> &stages);
+
+	std::vector<std::unique_ptr<Node>> mNodes; //< removed nodes leave a null entry, ids stay stable
+	int mOutput = None;
+	std::vector<int> mOrder;
+	bool mDirty = true;
+	bool mValid = false;
+
+	bool mFusion = true;
+	std::vector<Step> mSteps;
+	uint32_t mFusedNodes = 0;
+	std::map<std::vector<Filter*>, std::unique_ptr<FusedPointwiseFilter>> mFused; //< by stages, kept across plans
+
+	GHI::GHITransientAllocator mTransients;
+	std::vector<int> mTransientOf; //< transient handle of each node output, -1 for the output node and fused nodes
+	GHI::GHITextureKey mPlanKey;
+	bool mPlanned = false;
+
+	std::unique_ptr<ImNodes::CanvasState> mCanvas; //< needs an ImGui context, created by the first UpdateUI()
+	UINode mSourceUI = { { 40, 80 }, false };
+	UINode mOutputUI = { { 600, 80 }, false };
+	int mFocus = None;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "BatchProcessor.h"
+#include "CPUKernels.h"
+#include "FilterBenchmark.h"
+#include "FCPUGHICommandContext.h"
+
+//! Entry point of ImageEffectsCLI : batch mode and the benchmarks on the CPU backend, built
+//! without Win32 and D3D11. ImageEffects.exe runs the same batch mode on either backend.
+int main(int argc, char **argv)
+{
+	std::vector<std::string> args(argv + 1, argv + argc);
+	auto benchmark = std::find(args.begin(), args.end(), "--benchmark");
+	if (benchmark != args.end())
+	{
+		if (benchmark + 1 == args.end() || !RunFilterBenchmark(*(benchmark + 1)))
+		{
+			fprintf(stderr, "%s\n", FilterBenchmarkUsage().c_str());
+			return -1;
+		}
+		return 0;
+	}
+	if (!IsBatchCommandLine(args))
+	{
+		fprintf(stderr, "%s\n%s\n", BatchUsage().c_str(), FilterBenchmarkUsage().c_str());
+		return -1;
+	}
+
+	BatchOptions options;
+	options.backend = "cpu";
+	std::string error;
+	if (!ParseBatchOptions(args, options, error))
+	{
+		fprintf(stderr, "- [Error] %s\n%s\n", error.c_str(), BatchUsage().c_str());
+		return -1;
+	}
+	if (options.backend != "cpu")
+	{
+		fprintf(stderr, "- [Error] backend %s is not part of this build, use --backend cpu\n", options.backend.c_str());
+		return -1;
+	}
+
+	RegisterCPUKernels();
+	GHI::IGHIComputeCommandCotext *commandContext = new GHI::FCPUIGHIComputeCommandCotext;
+	int failures = 0;
+	{
+		BatchProcessor processor(commandContext, options);
+		failures = processor.Run();
+	}
+
+	for (auto it = GHI::GHIResource::list.begin(); it != GHI::GHIResource::list.end(); ++it)
+	{
+		(*it)->release();
+	}
+	delete commandContext;
+	return failures == 0 ? 0 : 1;
+}
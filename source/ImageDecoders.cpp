@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "ImageDecoders.h"
+
+static const uint32_t MaxDimension = 1u << 16;
+static const uint64_t MaxPixels = 1ull << 30;
+static const uint32_t MinRowsPerBand = 16;
+
+template<class T>
+static T ReadLE(const uint8_t *p)
+{
+	T v = 0;
+	for (size_t i = 0; i < sizeof(T); ++i)
+		v |= T(p[i]) << (8 * i);
+	return v;
+}
+
+bool AllocateDecodedImage(DecodedImage &image, uint32_t width, uint32_t height, const DecodeOptions &options, GHI::EPixelFormat format)
+{
+	if (width == 0 || height == 0 || width > MaxDimension || height > MaxDimension || uint64_t(width) * height > MaxPixels)
+		return false;
+	GHI::GHIPixelBufferPool &pool = options.buffers ? *options.buffers : GHI::GHIPixelBufferPool::Global();
+	image.width = width;
+	image.height = height;
+	image.format = format;
+	image.rowPitch = width * GHI::BytesPerPixel(format);
+	image.pixels = pool.Acquire(size_t(image.rowPitch) * height);
+	return true;
+}
+
+void ForEachRowBand(const DecodeOptions &options, uint32_t rows, const std::function<void(uint32_t begin, uint32_t end)> &fn)
+{
+	const uint32_t bands = options.rows ? std::max(1u, std::min(options.rows->NumThreads() * 4, rows / MinRowsPerBand)) : 1;
+	if (bands == 1)
+	{
+		fn(0, rows);
+		return;
+	}
+	options.rows->ParallelFor(bands, [&](uint32_t band)
+	{
+		fn(uint32_t(uint64_t(rows) * band / bands), uint32_t(uint64_t(rows) * (band + 1) / bands));
+	});
+}
+
+bool DecodeImage(const std::string &filename, DecodedImage &image, const DecodeOptions &options)
+{
+	std::ifstream in(filename, std::ios::binary | std::ios::ate);
+	if (!in)
+		return false;
+	const std::streamoff size = in.tellg();
+	if (size <= 0)
+		return false;
+	std::vector<uint8_t> file(static_cast<size_t>(size));
+	in.seekg(0);
+	if (!in.read((char*)file.data(), size))
+		return false;
+	return DecodeImageMemory(file.data(), file.size(), image, options);
+}
+
+bool DecodeImageMemory(const uint8_t *data, size_t size, DecodedImage &image, const DecodeOptions &options)
+{
+	static const uint8_t PNGSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	bool ok = false;
+	if (size >= 8 && std::memcmp(data, PNGSignature, 8) == 0)
+		ok = DecodePNG(data, size, image, options);
+	else if (size >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff)
+		ok = DecodeJPEG(data, size, image, options);
+	else if (size >= 2 && data[0] == 'B' && data[1] == 'M')
+		ok = DecodeBMP(data, size, image, options);
+	else if (size >= 2 && data[0] == '#' && data[1] == '?')
+		ok = DecodeHDR(data, size, image, options);
+	if (!ok)
+		image = DecodedImage();
+	return ok;
+}
+
+//--------------------------------------------------------------------------------------
+// BMP
+//--------------------------------------------------------------------------------------
+namespace
+{
+	struct BitField
+	{
+		uint32_t mask = 0;
+		uint32_t shift = 0;
+		uint32_t max = 0;
+
+		explicit BitField(uint32_t m = 0)
+			: mask(m)
+		{
+			if (!mask)
+				return;
+			while (!((mask >> shift) & 1))
+				++shift;
+			max = mask >> shift;
+		}
+
+		uint8_t Get(uint32_t pixel, uint8_t absent) const
+		{
+			return mask ? uint8_t((((pixel & mask) >> shift) * 255 + max / 2) / max) : absent;
+		}
+	};
+}
+
+bool DecodeBMP(const uint8_t *data, size_t size, DecodedImage &image, const DecodeOptions &options)
+{
+	if (size < 26 || data[0] != 'B' || data[1] != 'M')
+		return false;
+	const uint32_t dataOffset = ReadLE<uint32_t>(data + 10);
+	const uint32_t headerSize = ReadLE<uint32_t>(data + 14);
+	if (headerSize != 12 && (headerSize < 40 || size < 14 + 40))
+		return false;
+
+	int32_t w, h;
+	uint32_t bpp, compression = 0, colors = 0;
+	if (headerSize == 12) // OS/2 core header
+	{
+		w = ReadLE<uint16_t>(data + 18);
+		h = ReadLE<uint16_t>(data + 20);
+		bpp = ReadLE<uint16_t>(data + 24);
+	}
+	else
+	{
+		w = int32_t(ReadLE<uint32_t>(data + 18));
+		h = int32_t(ReadLE<uint32_t>(data + 22));
+		bpp = ReadLE<uint16_t>(data + 28);
+		compression = ReadLE<uint32_t>(data + 30);
+		colors = ReadLE<uint32_t>(data + 46);
+	}
+	// 0 BI_RGB, 3 BI_BITFIELDS, 6 BI_ALPHABITFIELDS; the RLE and embedded JPEG / PNG modes are not handled.
+	if (w <= 0 || h == 0 || h == INT32_MIN || (compression != 0 && compression != 3 && compression != 6))
+		return false;
+	if (bpp != 1 && bpp != 4 && bpp != 8 && bpp != 16 && bpp != 24 && bpp != 32)
+		return false;
+
+	const bool bottomUp = h > 0;
+	const uint32_t width = uint32_t(w), height = uint32_t(bottomUp ? h : -h);
+	const uint64_t srcPitch = ((uint64_t(width) * bpp + 31) / 32) * 4;
+	if (dataOffset > size || srcPitch * height > size - dataOffset)
+		return false;
+
+	// Masks follow a 40 byte header (BI_BITFIELDS) or are part of the larger ones.
+	BitField red, green, blue, alpha;
+	bool anyAlpha = true;
+	if (compression == 3 || compression == 6)
+	{
+		const size_t masks = compression == 6 || headerSize >= 56 ? 4 : 3;
+		if (size < 54 + masks * 4)
+			return false;
+		red = BitField(ReadLE<uint32_t>(data + 54));
+		green = BitField(ReadLE<uint32_t>(data + 58));
+		blue = BitField(ReadLE<uint32_t>(data + 62));
+		alpha = BitField(masks == 4 ? ReadLE<uint32_t>(data + 66) : 0);
+	}
+	else if (bpp == 16)
+	{
+		red = BitField(0x7c00);
+		green = BitField(0x03e0);
+		blue = BitField(0x001f);
+	}
+	else if (bpp == 32)
+	{
+		red = BitField(0x00ff0000);
+		green = BitField(0x0000ff00);
+		blue = BitField(0x000000ff);
+		alpha = BitField(0xff000000);
+		anyAlpha = false; // BI_RGB leaves it undefined, usually 0 : only used when some pixel sets it
+	}
+	if ((bpp == 16 || bpp == 32) && (!red.mask || !green.mask || !blue.mask))
+		return false;
+
+	uint8_t palette[256][4] = {};
+	if (bpp <= 8)
+	{
+		const size_t entry = headerSize == 12 ? 3 : 4;
+		const size_t count = std::min<size_t>(colors ? colors : (1u << bpp), 256);
+		const size_t offset = 14 + headerSize;
+		if (offset + count * entry > size)
+			return false;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint8_t *c = data + offset + i * entry;
+			palette[i][0] = c[2];
+			palette[i][1] = c[1];
+			palette[i][2] = c[0];
+			palette[i][3] = 255;
+		}
+	}
+
+	if (!AllocateDecodedImage(image, width, height, options))
+		return false;
+
+	const uint8_t *bits = data + dataOffset;
+	std::vector<uint8_t> rowAlpha(height, 0);
+	ForEachRowBand(options, height, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; ++y)
+		{
+			const uint8_t *src = bits + srcPitch * (bottomUp ? height - 1 - y : y);
+			uint8_t *dst = image.pixels.Data() + size_t(y) * image.rowPitch;
+			uint8_t seenAlpha = 0;
+			for (uint32_t x = 0; x < width; ++x, dst += 4)
+			{
+				if (bpp <= 8)
+				{
+					const uint32_t bit = x * bpp;
+					const uint32_t index = (src[bit >> 3] >> (8 - bpp - (bit & 7))) & ((1u << bpp) - 1);
+					std::memcpy(dst, palette[index], 4);
+					continue;
+				}
+				if (bpp == 24)
+				{
+					const uint8_t *s = src + x * 3;
+					dst[0] = s[2];
+					dst[1] = s[1];
+					dst[2] = s[0];
+					dst[3] = 255;
+					continue;
+				}
+				const uint32_t p = bpp == 16 ? ReadLE<uint16_t>(src + x * 2) : ReadLE<uint32_t>(src + x * 4);
+				dst[0] = red.Get(p, 0);
+				dst[1] = green.Get(p, 0);
+				dst[2] = blue.Get(p, 0);
+				dst[3] = alpha.Get(p, 255);
+				seenAlpha |= dst[3];
+			}
+			rowAlpha[y] = seenAlpha;
+		}
+	});
+
+	if (!anyAlpha && std::all_of(rowAlpha.begin(), rowAlpha.end(), [](uint8_t a) { return a == 0; }))
+	{
+		ForEachRowBand(options, height, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t y = begin; y < end; ++y)
+			{
+				uint8_t *dst = image.pixels.Data() + size_t(y) * image.rowPitch;
+				for (uint32_t x = 0; x < width; ++x)
+					dst[x * 4 + 3] = 255;
+			}
+		});
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Radiance HDR. The RGBE pixels are unpacked straight into the RGBA8 rows they become,
+// the float conversion then runs in place.
+//--------------------------------------------------------------------------------------
+static bool ReadHDRScanline(const uint8_t *&p, const uint8_t *end, uint8_t *rgbe, uint32_t width)
+{
+	// New run length encoding : 2, 2, width, then the four channels one after the other.
+	if (width >= 8 && width < 0x8000 && end - p >= 4 && p[0] == 2 && p[1] == 2 && ((p[2] << 8) | p[3]) == int(width))
+	{
+		p += 4;
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			for (uint32_t x = 0; x < width;)
+			{
+				if (p >= end)
+					return false;
+				uint32_t count = *p++;
+				if (count > 128)
+				{
+					count -= 128;
+					if (p >= end || count > width - x)
+						return false;
+					const uint8_t value = *p++;
+					for (; count; --count, ++x)
+						rgbe[x * 4 + c] = value;
+				}
+				else
+				{
+					if (count == 0 || count > width - x || uint32_t(end - p) < count)
+						return false;
+					for (; count; --count, ++x)
+						rgbe[x * 4 + c] = *p++;
+				}
+			}
+		}
+		return true;
+	}
+	// Flat pixels, with the old 1, 1, 1, n repeat marker.
+	uint32_t shift = 0;
+	for (uint32_t x = 0; x < width;)
+	{
+		if (end - p < 4)
+			return false;
+		if (p[0] == 1 && p[1] == 1 && p[2] == 1)
+		{
+			if (x == 0)
+				return false;
+			uint32_t count = uint32_t(p[3]) << shift;
+			if (count > width - x)
+				return false;
+			for (; count; --count, ++x)
+				std::memcpy(rgbe + x * 4, rgbe + (x - 1) * 4, 4);
+			shift += 8;
+		}
+		else
+		{
+			std::memcpy(rgbe + x * 4, p, 4);
+			++x;
+			shift = 0;
+		}
+		p += 4;
+	}
+	return true;
+}
+
+bool DecodeHDR(const uint8_t *data, size_t size, DecodedImage &image, const DecodeOptions &options)
+{
+	const uint8_t *p = data, *end = data + size;
+	auto line = [&]()
+	{
+		const uint8_t *start = p;
+		while (p < end && *p != '\n')
+			++p;
+		std::string text((const char*)start, p - start);
+		if (p < end)
+			++p;
+		return text;
+	};
+
+	std::string text = line();
+	if (text != "#?RADIANCE" && text != "#?RGBE")
+		return false;
+	for (text = line(); !text.empty(); text = line())
+	{
+		if (text.compare(0, 7, "FORMAT=") == 0 && text != "FORMAT=32-bit_rle_rgbe")
+			return false;
+		if (p >= end)
+			return false;
+	}
+
+	// Only the standard orientation, rows top down.
+	char sy[3] = {}, sx[3] = {};
+	unsigned h = 0, w = 0;
+	text = line();
+	if (std::sscanf(text.c_str(), "%2s %u %2s %u", sy, &h, sx, &w) != 4 || std::strcmp(sy, "-Y") || std::strcmp(sx, "+X"))
+		return false;
+	if (!AllocateDecodedImage(image, w, h, options, options.halfFloatHDR ? GHI::PixelFormat_R16G16B16A16_FLOAT : GHI::PixelFormat_R8G8B8A8_UNORM))
+		return false;
+
+	// RGBE goes to the start of its row, the conversion below widens it in place.
+	for (uint32_t y = 0; y < image.height; ++y)
+	{
+		if (!ReadHDRScanline(p, end, image.pixels.Data() + size_t(y) * image.rowPitch, image.width))
+			return false;
+	}
+
+	if (options.halfFloatHDR)
+	{
+		ForEachRowBand(options, image.height, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t y = begin; y < end; ++y)
+			{
+				uint8_t *row = image.pixels.Data() + size_t(y) * image.rowPitch;
+				// Backwards, pixel x only overwrites the RGBE of pixels 2x and 2x + 1.
+				for (uint32_t x = image.width; x-- > 0;)
+				{
+					const uint8_t *rgbe = row + x * 4;
+					const float scale = rgbe[3] ? std::ldexp(1.f, int(rgbe[3]) - (128 + 8)) : 0.f;
+					uint16_t half[4];
+					// Exponents up to 2^119 overflow a half, keep the brightest texels finite.
+					for (int c = 0; c < 3; ++c)
+						half[c] = GHI::FloatToHalf(std::min(std::pow(rgbe[c] * scale, 1.f / 2.2f), 65504.f));
+					half[3] = GHI::FloatToHalf(1.f);
+					std::memcpy(row + x * 8, half, 8);
+				}
+			}
+		});
+		return true;
+	}
+
+	uint8_t gamma[1024]; // linear [0, 1] in 1024 steps -> gamma 2.2
+	for (int i = 0; i < 1024; ++i)
+		gamma[i] = uint8_t(std::pow(i / 1023.f, 1.f / 2.2f) * 255.f + .5f);
+	ForEachRowBand(options, image.height, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t y = begin; y < end; ++y)
+		{
+			uint8_t *px = image.pixels.Data() + size_t(y) * image.rowPitch;
+			for (uint32_t x = 0; x < image.width; ++x, px += 4)
+			{
+				const float scale = px[3] ? std::ldexp(1.f, int(px[3]) - (128 + 8)) : 0.f;
+				for (int c = 0; c < 3; ++c)
+				{
+					// Clamped as a float : bright exponents reach infinity, which has no int.
+					const float v = px[c] * scale * 1023.f;
+					px[c] = gamma[v < 1023.f ? int(v + .5f) : 1023];
+				}
+				px[3] = 255;
+			}
+		}
+	});
+	return true;
+}
@@ -0,0 +1,57 @@
+#ifndef IMAGE_DECODERS_H_
+#define IMAGE_DECODERS_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "GHIPixelBuffer.h"
+#include "GHIResources.h"
+#include "ThreadPool.h"
+
+//--------------------------------------------------------------------------------------
+// Portable decoders, no OS codec and no image library : PNG (every color type and bit
+// depth, Adam7), BMP (1..32 bit, uncompressed and bit fields), baseline JPEG and
+// Radiance HDR. They write RGBA8 (RGBA16F for HDR on request) straight into a pooled 64 byte aligned buffer, the
+// layout CreateTexture() uploads, so no conversion copy is left between the file and
+// the texture. The entropy decoding of a file is serial; the per row work behind it
+// (PNG expansion, JPEG IDCT and color conversion, BMP / HDR conversion) runs in row
+// bands on options.rows when it is set.
+//--------------------------------------------------------------------------------------
+struct DecodedImage
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t rowPitch = 0;   //< width * BytesPerPixel(format)
+	GHI::EPixelFormat format = GHI::PixelFormat_R8G8B8A8_UNORM;
+	GHI::GHIPixelBuffer pixels;
+};
+
+struct DecodeOptions
+{
+	GHI::GHIPixelBufferPool *buffers = nullptr; //< nullptr uses GHIPixelBufferPool::Global()
+	GHI::ThreadPool *rows = nullptr;            //< nullptr decodes on the calling thread
+	bool halfFloatHDR = false;                  //< DecodeHDR writes RGBA16F instead of RGBA8
+};
+
+//! The format is taken from the first bytes of the file, not from its extension.
+bool DecodeImage(const std::string &filename, DecodedImage &image, const DecodeOptions &options = DecodeOptions());
+bool DecodeImageMemory(const uint8_t *data, size_t size, DecodedImage &image, const DecodeOptions &options = DecodeOptions());
+
+bool DecodePNG(const uint8_t *data, size_t size, DecodedImage &image, const DecodeOptions &options);
+bool DecodeJPEG(const uint8_t *data, size_t size, DecodedImage &image, const DecodeOptions &options);
+bool DecodeBMP(const uint8_t *data, size_t size, DecodedImage &image, const DecodeOptions &options);
+//! Radiance RGBE, gamma 2.2 encoded. RGBA8 clamps to [0, 1]; with options.halfFloatHDR the
+//! image is RGBA16F and keeps what is brighter than 1.
+bool DecodeHDR(const uint8_t *data, size_t size, DecodedImage &image, const DecodeOptions &options);
+
+//! Sizes image for width x height pixels of format from the pool of options. False when
+//! the size is not a sane image size.
+bool AllocateDecodedImage(DecodedImage &image, uint32_t width, uint32_t height, const DecodeOptions &options,
+	GHI::EPixelFormat format = GHI::PixelFormat_R8G8B8A8_UNORM);
+
+//! Runs fn(begin, end) over row bands of [0, rows), on options.rows when it is set.
+void ForEachRowBand(const DecodeOptions &options, uint32_t rows, const std::function<void(uint32_t begin, uint32_t end)> &fn);
+
+#endif
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cctype>
+#include "ImageIO.h"
+#include "PNGWriter.h"
+
+#define STBI_MSC_SECURE_CRT
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <wincodec.h>
+#endif
+
+static std::string Extension(const std::string &filename)
+{
+	size_t pos = filename.find_last_of('.');
+	std::string ext = pos == std::string::npos ? "" : filename.substr(pos + 1);
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+	return ext;
+}
+
+bool IsImageFile(const std::string &filename)
+{
+	static const char *extensions[] = { "png", "bmp", "jpg", "jpeg", "tif", "tiff", "tga", "hdr" };
+	std::string ext = Extension(filename);
+	for (const char *e : extensions)
+	{
+		if (ext == e)
+			return true;
+	}
+	return false;
+}
+
+#if defined(_WIN32)
+template <class T>
+static void SafeRelease(T *&p)
+{
+	if (p)
+	{
+		p->Release();
+		p = nullptr;
+	}
+}
+
+// Decode with WIC straight to 32bpp RGBA in system memory. Safe to call from any thread,
+// COM is initialized for the calling thread for the duration of the call.
+static bool LoadImageWIC(const std::string &filename, DecodedImage &image, const DecodeOptions &options)
+{
+	HRESULT hrInit = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+	IWICImagingFactory *factory = nullptr;
+	IWICBitmapDecoder *decoder = nullptr;
+	IWICBitmapFrameDecode *frame = nullptr;
+	IWICFormatConverter *converter = nullptr;
+	bool ok = false;
+
+	std::wstring wName(MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), -1, nullptr, 0), L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), -1, &wName[0], int(wName.size()));
+	UINT w = 0, h = 0;
+	if (SUCCEEDED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory)))
+		&& SUCCEEDED(factory->CreateDecoderFromFilename(wName.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder))
+		&& SUCCEEDED(decoder->GetFrame(0, &frame))
+		&& SUCCEEDED(factory->CreateFormatConverter(&converter))
+		&& SUCCEEDED(converter->Initialize(frame, GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.f, WICBitmapPaletteTypeCustom))
+		&& SUCCEEDED(converter->GetSize(&w, &h))
+		&& AllocateDecodedImage(image, w, h, options))
+	{
+		ok = SUCCEEDED(converter->CopyPixels(nullptr, image.rowPitch, UINT(image.pixels.Size()), image.pixels.Data()));
+	}
+
+	SafeRelease(converter);
+	SafeRelease(frame);
+	SafeRelease(decoder);
+	SafeRelease(factory);
+	if (SUCCEEDED(hrInit))
+		CoUninitialize();
+	return ok;
+}
+#endif
+
+bool LoadImageRGBA8(const std::string &filename, DecodedImage &image, const DecodeOptions &options)
+{
+	if (DecodeImage(filename, image, options))
+		return true;
+#if defined(_WIN32)
+	if (LoadImageWIC(filename, image, options))
+		return true;
+	image = DecodedImage();
+#endif
+	return false;
+}
+
+bool SaveImageRGBA8(const std::string &filename, uint32_t width, uint32_t height, const uint8_t *pixels, int pngLevel)
+{
+	std::string ext = Extension(filename);
+	int w = int(width), h = int(height);
+	if (ext == "bmp")
+		return stbi_write_bmp(filename.c_str(), w, h, 4, pixels) != 0;
+	if (ext == "tga")
+		return stbi_write_tga(filename.c_str(), w, h, 4, pixels) != 0;
+	if (ext == "jpg" || ext == "jpeg")
+		return stbi_write_jpg(filename.c_str(), w, h, 4, pixels, 95) != 0;
+	PNGWriteOptions options;
+	options.level = pngLevel;
+	return WritePNGRGBA8(filename, width, height, pixels, 0, options);
+}
@@ -0,0 +1,26 @@
+#ifndef IMAGE_IO_H_
+#define IMAGE_IO_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ImageDecoders.h"
+
+//--------------------------------------------------------------------------------------
+// Image files <-> tightly packed RGBA8 memory, independent of the graphics backend so
+// decode / encode can run on worker threads. Decoding uses the portable decoders of
+// ImageDecoders.h on every platform, WIC on Windows only for the files they refuse
+// (TIFF, progressive JPEG, ..). Encoding uses the parallel PNG writer or stb_image_write.
+//--------------------------------------------------------------------------------------
+//! image.format is RGBA8, but RGBA16F for HDR files decoded with options.halfFloatHDR.
+bool LoadImageRGBA8(const std::string &filename, DecodedImage &image, const DecodeOptions &options = DecodeOptions());
+
+//! The format follows the extension : png, bmp, tga or jpg. pngLevel is the
+//! PNGWriteOptions::level used for png files.
+bool SaveImageRGBA8(const std::string &filename, uint32_t width, uint32_t height, const uint8_t *pixels, int pngLevel = 4);
+
+//! true for the extensions LoadImageRGBA8 is expected to handle.
+bool IsImageFile(const std::string &filename);
+
+#endif
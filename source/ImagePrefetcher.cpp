@@ -0,0 +1,73 @@
+#include <chrono>
+#include "ImagePrefetcher.h"
+#include "ImageIO.h"
+#include "Utils.h"
+
+ImagePrefetcher::ImagePrefetcher(uint32_t depth, uint32_t threads)
+	: mPool(threads)
+	, mDepth(depth > 0 ? depth : 1)
+{
+}
+
+ImagePrefetcher::~ImagePrefetcher()
+{
+	// The pool joins its workers after the ring is gone, the tasks own what they write.
+	for (std::future<Image> &f : mRing)
+		f.wait();
+}
+
+void ImagePrefetcher::Start(const std::vector<std::string> &files, size_t first)
+{
+	for (std::future<Image> &f : mRing)
+		f.wait();
+	mRing.clear();
+	mFiles = files;
+	mNextFile = mFiles.empty() ? 0 : first % mFiles.size();
+	mFailedInARow = 0;
+	Refill();
+}
+
+void ImagePrefetcher::Refill()
+{
+	while (!mFiles.empty() && mRing.size() < mDepth && mFailedInARow < mFiles.size())
+	{
+		const size_t index = mNextFile;
+		const std::string path = mFiles[index];
+		mNextFile = (mNextFile + 1) % mFiles.size();
+		mRing.push_back(mPool.Submit([index, path]()
+		{
+			Image image;
+			image.index = index;
+			image.path = path;
+			DecodeOptions options;
+			options.rows = &GHI::ThreadPool::Global();
+			options.halfFloatHDR = true;
+			LoadImageRGBA8(path, image.decoded, options);
+			return image;
+		}));
+	}
+}
+
+bool ImagePrefetcher::Next(Image &image)
+{
+	while (!mRing.empty())
+	{
+		if (mRing.front().wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return false;
+		Image front = mRing.front().get();
+		mRing.pop_front();
+		if (front.decoded.pixels.Empty())
+		{
+			DEBUG("image [%s] load failed.\n", front.path.c_str());
+			++mFailures;
+			++mFailedInARow;
+			Refill();
+			continue;
+		}
+		mFailedInARow = 0;
+		image = std::move(front);
+		Refill();
+		return true;
+	}
+	return false;
+}
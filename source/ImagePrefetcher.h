@@ -0,0 +1,56 @@
+#ifndef IMAGE_PREFETCHER_H_
+#define IMAGE_PREFETCHER_H_
+
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "ImageDecoders.h"
+#include "ThreadPool.h"
+
+//--------------------------------------------------------------------------------------
+// Decodes the images following the current one of a list on worker threads, so the
+// viewer switches with an upload only. Each file is decoded in row bands on the global
+// pool, the pixels are pooled buffers. At most depth decoded images wait in the ring,
+// in list order; files that fail to decode are dropped when they reach the front.
+//--------------------------------------------------------------------------------------
+class ImagePrefetcher
+{
+public:
+	struct Image
+	{
+		size_t index = 0; //< in the list
+		std::string path;
+		DecodedImage decoded;
+	};
+
+	ImagePrefetcher(uint32_t depth = 3, uint32_t threads = 2);
+	~ImagePrefetcher();
+
+	//! Drops what was decoded for the previous list and decodes from files[first] on.
+	void Start(const std::vector<std::string> &files, size_t first);
+
+	//! Takes the next image of the list that decoded. False while it is still decoding,
+	//! or when no file of the list can be decoded.
+	bool Next(Image &image);
+
+	uint32_t Failures() const
+	{
+		return mFailures;
+	}
+
+private:
+	void Refill();
+
+	GHI::ThreadPool mPool;
+	uint32_t mDepth;
+	std::vector<std::string> mFiles;
+	size_t mNextFile = 0;
+	std::deque<std::future<Image>> mRing;
+	uint32_t mFailures = 0;
+	size_t mFailedInARow = 0; //< the whole list failed when it reaches mFiles.size()
+};
+
+#endif
@@ -0,0 +1,479 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "ImageDecoders.h"
+
+//--------------------------------------------------------------------------------------
+// Baseline / extended sequential Huffman JPEG, 8 bit samples, gray or YCbCr with any
+// sampling factors, interleaved or one scan per component, restart intervals.
+// Progressive and arithmetic coded files and CMYK are refused. All scans are entropy
+// decoded into dequantized coefficients first, the IDCT, chroma upsampling (box) and
+// color conversion then run per MCU row in parallel.
+//--------------------------------------------------------------------------------------
+namespace
+{
+	const uint8_t ZigZag[64] = {
+		 0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+		12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+		35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+		58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63 };
+
+	//! Entropy coded segment, MSB first, skips the stuffed 0 after 0xff and stops at a marker.
+	class BitReader
+	{
+		const uint8_t *mPos;
+		const uint8_t *mEnd;
+		uint32_t mBits = 0;
+		int mCount = 0;
+		bool mMarker = false;
+
+	public:
+		BitReader(const uint8_t *begin, const uint8_t *end)
+			: mPos(begin)
+			, mEnd(end)
+		{
+		}
+
+		void Fill()
+		{
+			while (mCount <= 24)
+			{
+				uint32_t b = 0;
+				if (!mMarker && mPos < mEnd)
+				{
+					b = *mPos;
+					if (b == 0xff)
+					{
+						const uint8_t next = mPos + 1 < mEnd ? mPos[1] : 0xd9;
+						if (next == 0)
+							mPos += 2;
+						else
+						{
+							mMarker = true;
+							b = 0;
+						}
+					}
+					else
+						++mPos;
+				}
+				mBits |= b << (24 - mCount);
+				mCount += 8;
+			}
+		}
+		uint32_t Peek(int n)
+		{
+			if (mCount < n)
+				Fill();
+			return mBits >> (32 - n);
+		}
+		void Drop(int n)
+		{
+			mBits <<= n;
+			mCount -= n;
+		}
+		int Receive(int s) //< s bit magnitude, sign extended
+		{
+			if (s == 0)
+				return 0;
+			int v = int(Peek(s));
+			Drop(s);
+			return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v;
+		}
+
+		//! Skips the RSTn marker of a restart interval, false when it is not there.
+		bool Restart()
+		{
+			mBits = 0;
+			mCount = 0;
+			mMarker = false;
+			while (mPos + 1 < mEnd && !(mPos[0] == 0xff && mPos[1] >= 0xd0 && mPos[1] <= 0xd7))
+				++mPos;
+			if (mPos + 1 >= mEnd)
+				return false;
+			mPos += 2;
+			return true;
+		}
+		//! First byte after the segment, the marker that ended it.
+		const uint8_t* End() const
+		{
+			const uint8_t *p = mPos;
+			while (p + 1 < mEnd && !(p[0] == 0xff && p[1] != 0 && (p[1] < 0xd0 || p[1] > 0xd7)))
+				++p;
+			return p;
+		}
+	};
+
+	class Huffman
+	{
+		static const int FastBits = 9;
+
+		uint8_t mFastLength[1 << FastBits]; //< 0 when the code is longer
+		uint8_t mFastSymbol[1 << FastBits];
+		int32_t mMaxCode[18];
+		int32_t mDelta[17]; //< symbol index - code, per length
+		uint8_t mSymbols[256];
+
+	public:
+		Huffman()
+		{
+			std::memset(mFastLength, 0, sizeof(mFastLength));
+			std::fill(mMaxCode, mMaxCode + 18, -1);
+		}
+
+		bool Build(const uint8_t counts[16], const uint8_t *symbols, int total)
+		{
+			std::memcpy(mSymbols, symbols, size_t(total));
+			std::memset(mFastLength, 0, sizeof(mFastLength));
+			int code = 0, index = 0;
+			for (int len = 1; len <= 16; ++len)
+			{
+				mDelta[len] = index - code;
+				for (int i = 0; i < counts[len - 1]; ++i, ++code, ++index)
+				{
+					// More codes than len bits hold : a corrupt table, and the fast table
+					// index below would run past its end.
+					if (code >= (1 << len))
+						return false;
+					if (len <= FastBits)
+					{
+						const int first = code << (FastBits - len);
+						for (int k = 0; k < (1 << (FastBits - len)); ++k)
+						{
+							mFastLength[first + k] = uint8_t(len);
+							mFastSymbol[first + k] = mSymbols[index];
+						}
+					}
+				}
+				mMaxCode[len] = counts[len - 1] ? code - 1 : -1;
+				code <<= 1;
+			}
+			mMaxCode[17] = INT32_MAX;
+			return true;
+		}
+
+		int Decode(BitReader &in) const
+		{
+			const uint32_t bits = in.Peek(16);
+			const int fast = bits >> (16 - FastBits);
+			if (mFastLength[fast])
+			{
+				in.Drop(mFastLength[fast]);
+				return mFastSymbol[fast];
+			}
+			for (int len = FastBits + 1; len <= 16; ++len)
+			{
+				const int code = int(bits >> (16 - len));
+				if (code <= mMaxCode[len])
+				{
+					in.Drop(len);
+					return mSymbols[(code + mDelta[len]) & 255];
+				}
+			}
+			return -1;
+		}
+	};
+
+	struct Component
+	{
+		int id = 0;
+		int h = 1;
+		int v = 1;
+		int tq = 0;
+		int blocksX = 0; //< of the coefficient plane, a whole number of MCUs
+		int blocksY = 0;
+		int dc = 0;
+		int td = 0;
+		int ta = 0;
+		std::vector<int16_t> coefficients;
+		std::vector<uint8_t> plane; //< blocksX * 8 wide
+	};
+
+	//! 8x8 inverse DCT, separable, float.
+	void InverseDCT(const int16_t *in, uint8_t *out, int pitch)
+	{
+		static float T[8][8]; // T[u][x] = C(u) / 2 * cos((2x + 1) u pi / 16)
+		static const bool init = []()
+		{
+			for (int u = 0; u < 8; ++u)
+				for (int x = 0; x < 8; ++x)
+					T[u][x] = (u ? .5f : .5f / std::sqrt(2.f)) * std::cos((2 * x + 1) * u * 3.14159265f / 16.f);
+			return true;
+		}();
+		(void)init;
+
+		float rows[8][8];
+		for (int v = 0; v < 8; ++v)
+		{
+			const int16_t *f = in + v * 8;
+			for (int x = 0; x < 8; ++x)
+			{
+				float s = 0.f;
+				for (int u = 0; u < 8; ++u)
+					s += f[u] * T[u][x];
+				rows[v][x] = s;
+			}
+		}
+		for (int y = 0; y < 8; ++y)
+		{
+			for (int x = 0; x < 8; ++x)
+			{
+				float s = 128.f;
+				for (int v = 0; v < 8; ++v)
+					s += rows[v][x] * T[v][y];
+				out[y * pitch + x] = uint8_t(std::min(255.f, std::max(0.f, s + .5f)));
+			}
+		}
+	}
+
+	int16_t Coefficient(int v)
+	{
+		return int16_t(std::min(32767, std::max(-32768, v)));
+	}
+
+	uint16_t ReadBE16(const uint8_t *p)
+	{
+		return uint16_t((p[0] << 8) | p[1]);
+	}
+}
+
+bool DecodeJPEG(const uint8_t *data, size_t size, DecodedImage &image, const DecodeOptions &options)
+{
+	const uint8_t *p = data + 2, *end = data + size;
+	uint16_t quant[4][64] = {};
+	Huffman dcTables[4], acTables[4];
+	std::vector<Component> comps;
+	int width = 0, height = 0, hMax = 1, vMax = 1, mcusX = 0, mcusY = 0;
+	int restartInterval = 0;
+	bool frame = false, scanned = false;
+
+	for (;;)
+	{
+		while (p < end && *p != 0xff)
+			++p;
+		while (p < end && *p == 0xff)
+			++p;
+		if (p >= end)
+		{
+			if (scanned) // tolerate a missing EOI
+				break;
+			return false;
+		}
+		const uint8_t marker = *p++;
+		if (marker == 0xd9) // EOI
+			break;
+		if (marker == 0xd8 || (marker >= 0xd0 && marker <= 0xd7))
+			continue;
+		if (end - p < 2)
+			return false;
+		const int length = ReadBE16(p);
+		if (length < 2 || end - p < length)
+			return false;
+		const uint8_t *seg = p + 2, *segEnd = p + length;
+		p = segEnd;
+
+		switch (marker)
+		{
+		case 0xdb: // DQT
+			while (seg < segEnd)
+			{
+				const int precision = seg[0] >> 4, id = seg[0] & 3;
+				++seg;
+				if (segEnd - seg < (precision ? 128 : 64))
+					return false;
+				for (int k = 0; k < 64; ++k)
+					quant[id][k] = precision ? ReadBE16(seg + k * 2) : seg[k];
+				seg += precision ? 128 : 64;
+			}
+			break;
+		case 0xc4: // DHT
+			while (seg + 17 <= segEnd)
+			{
+				const int tc = seg[0] >> 4, id = seg[0] & 3;
+				const uint8_t *counts = seg + 1;
+				int total = 0;
+				for (int i = 0; i < 16; ++i)
+					total += counts[i];
+				if (tc > 1 || total > 256 || seg + 17 + total > segEnd)
+					return false;
+				if (!(tc ? acTables[id] : dcTables[id]).Build(counts, seg + 17, total))
+					return false;
+				seg += 17 + total;
+			}
+			break;
+		case 0xdd: // DRI
+			restartInterval = ReadBE16(seg);
+			break;
+		case 0xc0: // SOF0 baseline
+		case 0xc1: // SOF1 extended sequential, Huffman
+		{
+			if (segEnd - seg < 6 || seg[0] != 8)
+				return false;
+			height = ReadBE16(seg + 1);
+			width = ReadBE16(seg + 3);
+			const int n = seg[5];
+			if ((n != 1 && n != 3) || segEnd - seg < 6 + n * 3 || height == 0)
+				return false;
+			comps.resize(n);
+			for (int i = 0; i < n; ++i)
+			{
+				const uint8_t *c = seg + 6 + i * 3;
+				comps[i].id = c[0];
+				comps[i].h = c[1] >> 4;
+				comps[i].v = c[1] & 15;
+				comps[i].tq = c[2] & 3;
+				if (comps[i].h < 1 || comps[i].h > 4 || comps[i].v < 1 || comps[i].v > 4)
+					return false;
+				hMax = std::max(hMax, comps[i].h);
+				vMax = std::max(vMax, comps[i].v);
+			}
+			mcusX = (width + 8 * hMax - 1) / (8 * hMax);
+			mcusY = (height + 8 * vMax - 1) / (8 * vMax);
+			if (!AllocateDecodedImage(image, uint32_t(width), uint32_t(height), options))
+				return false;
+			for (Component &c : comps)
+			{
+				c.blocksX = mcusX * c.h;
+				c.blocksY = mcusY * c.v;
+				c.coefficients.assign(size_t(c.blocksX) * c.blocksY * 64, 0);
+			}
+			frame = true;
+			break;
+		}
+		case 0xda: // SOS
+		{
+			if (!frame || segEnd - seg < 1)
+				return false;
+			const int n = seg[0];
+			if (n < 1 || n > int(comps.size()) || segEnd - seg < 1 + n * 2)
+				return false;
+			std::vector<Component*> scan;
+			for (int i = 0; i < n; ++i)
+			{
+				auto it = std::find_if(comps.begin(), comps.end(), [&](const Component &c) { return c.id == seg[1 + i * 2]; });
+				if (it == comps.end())
+					return false;
+				it->td = (seg[2 + i * 2] >> 4) & 3;
+				it->ta = seg[2 + i * 2] & 3;
+				it->dc = 0;
+				scan.push_back(&*it);
+			}
+
+			// One component : its blocks in raster order over the part that covers the image.
+			const bool interleaved = n > 1;
+			const int unitsX = interleaved ? mcusX : ((width * scan[0]->h + hMax - 1) / hMax + 7) / 8;
+			const int unitsY = interleaved ? mcusY : ((height * scan[0]->v + vMax - 1) / vMax + 7) / 8;
+			BitReader in(segEnd, end);
+			int16_t block[64];
+			for (int unit = 0, units = unitsX * unitsY; unit < units; ++unit)
+			{
+				if (restartInterval && unit && unit % restartInterval == 0)
+				{
+					if (!in.Restart())
+						return false;
+					for (Component *c : scan)
+						c->dc = 0;
+				}
+				const int ux = unit % unitsX, uy = unit / unitsX;
+				for (Component *c : scan)
+				{
+					const int bw = interleaved ? c->h : 1, bh = interleaved ? c->v : 1;
+					for (int by = 0; by < bh; ++by)
+					{
+						for (int bx = 0; bx < bw; ++bx)
+						{
+							std::memset(block, 0, sizeof(block));
+							const uint16_t *q = quant[c->tq];
+							const int t = dcTables[c->td].Decode(in);
+							if (t < 0 || t > 11)
+								return false;
+							c->dc += in.Receive(t);
+							block[0] = Coefficient(c->dc * q[0]);
+							for (int k = 1; k < 64;)
+							{
+								const int rs = acTables[c->ta].Decode(in);
+								if (rs < 0)
+									return false;
+								const int r = rs >> 4, s = rs & 15;
+								if (s == 0)
+								{
+									if (r != 15)
+										break;
+									k += 16;
+									continue;
+								}
+								k += r;
+								if (k > 63)
+									return false;
+								block[ZigZag[k]] = Coefficient(in.Receive(s) * q[k]);
+								++k;
+							}
+							const int x = interleaved ? ux * c->h + bx : ux;
+							const int y = interleaved ? uy * c->v + by : uy;
+							std::memcpy(c->coefficients.data() + (size_t(y) * c->blocksX + x) * 64, block, sizeof(block));
+						}
+					}
+				}
+			}
+			p = in.End();
+			scanned = true;
+			break;
+		}
+		case 0xc2: case 0xc3: case 0xc5: case 0xc6: case 0xc7: // progressive, lossless, hierarchical
+		case 0xc9: case 0xca: case 0xcb: case 0xcd: case 0xce: case 0xcf: // arithmetic coding
+			return false;
+		default: // APPn, COM and the rest carry nothing the pixels need
+			break;
+		}
+	}
+	if (!scanned)
+		return false;
+
+	for (Component &c : comps)
+		c.plane.resize(size_t(c.blocksX) * 8 * c.blocksY * 8);
+
+	ForEachRowBand(options, uint32_t(mcusY), [&](uint32_t begin, uint32_t endRow)
+	{
+		for (uint32_t my = begin; my < endRow; ++my)
+		{
+			for (Component &c : comps)
+			{
+				const int pitch = c.blocksX * 8;
+				for (int by = int(my) * c.v; by < int(my + 1) * c.v; ++by)
+					for (int bx = 0; bx < c.blocksX; ++bx)
+						InverseDCT(c.coefficients.data() + (size_t(by) * c.blocksX + bx) * 64, c.plane.data() + size_t(by) * 8 * pitch + bx * 8, pitch);
+			}
+
+			const int y0 = int(my) * 8 * vMax, y1 = std::min(height, y0 + 8 * vMax);
+			for (int y = y0; y < y1; ++y)
+			{
+				uint8_t *dst = image.pixels.Data() + size_t(y) * image.rowPitch;
+				const Component &cy = comps[0];
+				const uint8_t *rowY = cy.plane.data() + size_t(y * cy.v / vMax) * cy.blocksX * 8;
+				if (comps.size() == 1)
+				{
+					for (int x = 0; x < width; ++x, dst += 4)
+					{
+						dst[0] = dst[1] = dst[2] = rowY[x];
+						dst[3] = 255;
+					}
+					continue;
+				}
+				const Component &cb = comps[1], &cr = comps[2];
+				const uint8_t *rowCb = cb.plane.data() + size_t(y * cb.v / vMax) * cb.blocksX * 8;
+				const uint8_t *rowCr = cr.plane.data() + size_t(y * cr.v / vMax) * cr.blocksX * 8;
+				for (int x = 0; x < width; ++x, dst += 4)
+				{
+					const float Y = rowY[x * cy.h / hMax];
+					const float Cb = rowCb[x * cb.h / hMax] - 128.f;
+					const float Cr = rowCr[x * cr.h / hMax] - 128.f;
+					dst[0] = uint8_t(std::min(255.f, std::max(0.f, Y + 1.402f * Cr + .5f)));
+					dst[1] = uint8_t(std::min(255.f, std::max(0.f, Y - .344136f * Cb - .714136f * Cr + .5f)));
+					dst[2] = uint8_t(std::min(255.f, std::max(0.f, Y + 1.772f * Cb + .5f)));
+					dst[3] = 255;
+				}
+			}
+		}
+	});
+	return true;
+}
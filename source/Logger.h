@@ -66,8 +66,13 @@ static std::string get_time()
     char   buf[512];
   
     time(&rawtime);
+#if defined(_WIN32)
     localtime_s(&timeinfo, &rawtime);
     asctime_s(buf,&timeinfo);
+#else
+    localtime_r(&rawtime, &timeinfo);
+    asctime_r(&timeinfo, buf);
+#endif
   
     std::string ret(buf);
     if (!ret.empty() && ret[ret.length() - 1] == '\n') 
@@ -0,0 +1,61 @@
+#include "MipPyramid.h"
+
+static const int DOWNSAMPLE_GROUP_SIZE = 8;
+
+MipPyramid::MipPyramid(std::string shaderFile)
+	: mShaderFile(shaderFile)
+{
+}
+
+void MipPyramid::Init(GHI::IGHIComputeCommandCotext *commandContext)
+{
+	mShader = commandContext->GetComputeShader(mShaderFile);
+}
+
+void MipPyramid::Build(GHI::IGHIComputeCommandCotext *commandContext, GHI::GHITexture *source, uint32_t levels)
+{
+	const uint32_t maxLevels = GHI::MaxMipLevels(source->width, source->height);
+	levels = levels < 2 ? 2 : levels;
+	levels = levels > maxLevels ? maxLevels : levels;
+	if (levels < 2)
+	{
+		Release(commandContext);
+		return;
+	}
+
+	GHI::TextureDesc2D desc;
+	desc.Width = GHI::MipSize(source->width, 1);
+	desc.Height = GHI::MipSize(source->height, 1);
+	desc.MipLevels = levels - 1;
+	desc.Format = source->format;
+	desc.BindFlags = GHI::BindFlag_SHADER_RESOURCE | GHI::BindFlag_UNORDERED_ACCESS;
+	if (!mTexture || mTexture->width != desc.Width || mTexture->height != desc.Height
+		|| mTexture->format != desc.Format || mTexture->mipLevels != desc.MipLevels)
+	{
+		Release(commandContext);
+		mTexture = commandContext->TexturePool().Acquire(desc);
+	}
+
+	commandContext->SetShader(mShader);
+	for (uint32_t level = 1; level < levels; ++level)
+	{
+		// Level 1 reads the image, the others the previous mip of the pyramid.
+		GHI::GHISRVParam src;
+		src.MostDetailedMip = level - 2;
+		src.MipLevels = 1;
+		GHI::GHIUAVParam dst;
+		dst.MostDetailedMip = level - 1;
+		commandContext->SetShaderResource(level == 1 ? source : mTexture, 0, level == 1 ? GHI::GHISRVParam() : src);
+		commandContext->SetShaderResource(mTexture, 0, dst);
+
+		const uint32_t width = GHI::MipSize(desc.Width, level - 1);
+		const uint32_t height = GHI::MipSize(desc.Height, level - 1);
+		commandContext->Dispatch((width + DOWNSAMPLE_GROUP_SIZE - 1) / DOWNSAMPLE_GROUP_SIZE, (height + DOWNSAMPLE_GROUP_SIZE - 1) / DOWNSAMPLE_GROUP_SIZE, 1);
+	}
+}
+
+void MipPyramid::Release(GHI::IGHIComputeCommandCotext *commandContext)
+{
+	commandContext->TexturePool().Release(mTexture);
+	mTexture = nullptr;
+}
@@ -0,0 +1,51 @@
+#ifndef MIP_PYRAMID_H_
+#define MIP_PYRAMID_H_
+
+#include <cstdint>
+#include <string>
+
+#include "GHIResources.h"
+#include "GHICommandContext.h"
+
+//--------------------------------------------------------------------------------------
+// Mip pyramid of an image for multi-scale filters : level n is the image reduced 2^n
+// times, every texel the box average of the 2x2 texels of level n - 1 it covers. Level 0
+// is the image itself and is not copied, levels 1 .. are the mips of one pooled texture
+// of half the size, so a filter reads level n as mip n - 1 of Texture(). Build() runs
+// downsample.hlsl once per level, from a view of one mip into a view of the next; the
+// whole pyramid costs a third of the image in memory and bandwidth.
+//--------------------------------------------------------------------------------------
+class MipPyramid
+{
+public:
+	MipPyramid(std::string shaderFile = "..\\effects\\downsample.hlsl");
+	MipPyramid(const MipPyramid&) = delete;
+	MipPyramid& operator=(const MipPyramid&) = delete;
+
+	void Init(GHI::IGHIComputeCommandCotext *commandContext);
+
+	//! Fills levels 1 .. levels - 1 of source, fewer when source gets to 1 x 1 before.
+	//! The texture is kept while source keeps its size, format and the level count.
+	void Build(GHI::IGHIComputeCommandCotext *commandContext, GHI::GHITexture *source, uint32_t levels);
+
+	//! Levels 1 .. Levels() - 1, nullptr before Build().
+	GHI::GHITexture* Texture() const
+	{
+		return mTexture;
+	}
+	//! Including level 0.
+	uint32_t Levels() const
+	{
+		return mTexture ? mTexture->mipLevels + 1 : 1;
+	}
+
+	//! Hands the texture back to the pool of commandContext.
+	void Release(GHI::IGHIComputeCommandCotext *commandContext);
+
+private:
+	std::string mShaderFile;
+	GHI::GHIShader *mShader = nullptr;
+	GHI::GHITexture *mTexture = nullptr;
+};
+
+#endif
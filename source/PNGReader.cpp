@@ -0,0 +1,513 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "ImageDecoders.h"
+
+//--------------------------------------------------------------------------------------
+// Inflate (RFC 1950 / 1951) of the concatenated IDAT data. The size of the inflated
+// image is known from the header, the output buffer is sized once and never grows.
+//--------------------------------------------------------------------------------------
+namespace
+{
+	const uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	const uint8_t CodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	class BitReader
+	{
+		const uint8_t *mData;
+		size_t mSize;
+		size_t mPos = 0;
+		uint64_t mBits = 0;
+		uint32_t mCount = 0;
+
+	public:
+		BitReader(const uint8_t *data, size_t size)
+			: mData(data)
+			, mSize(size)
+		{
+		}
+
+		//! Past the end reads zeros, Overrun() tells.
+		void Refill()
+		{
+			while (mCount <= 56)
+			{
+				mBits |= uint64_t(mPos < mSize ? mData[mPos] : 0) << mCount;
+				++mPos;
+				mCount += 8;
+			}
+		}
+		uint32_t Peek(uint32_t n)
+		{
+			if (mCount < n)
+				Refill();
+			return uint32_t(mBits & ((1ull << n) - 1));
+		}
+		void Drop(uint32_t n)
+		{
+			mBits >>= n;
+			mCount -= n;
+		}
+		uint32_t Get(uint32_t n)
+		{
+			if (n == 0)
+				return 0;
+			uint32_t v = Peek(n);
+			Drop(n);
+			return v;
+		}
+		void AlignToByte()
+		{
+			Drop(mCount & 7);
+		}
+		bool Overrun() const
+		{
+			return mPos > mSize + 8;
+		}
+	};
+
+	//! Canonical Huffman decoder, codes up to FastBits long resolve with a single lookup.
+	class Huffman
+	{
+		static const uint32_t FastBits = 10;
+
+		uint16_t mFast[1 << FastBits]; //< symbol << 4 | length, 0 when longer
+		uint16_t mCount[16];
+		uint16_t mSymbols[320];
+
+	public:
+		bool Build(const uint8_t *lengths, uint32_t n)
+		{
+			std::memset(mCount, 0, sizeof(mCount));
+			std::memset(mFast, 0, sizeof(mFast));
+			for (uint32_t i = 0; i < n; ++i)
+				++mCount[lengths[i]];
+			mCount[0] = 0;
+			int left = 1;
+			for (int len = 1; len < 16; ++len)
+			{
+				left = (left << 1) - mCount[len];
+				if (left < 0)
+					return false;
+			}
+			uint16_t offsets[16] = {};
+			for (int len = 1; len < 15; ++len)
+				offsets[len + 1] = offsets[len] + mCount[len];
+			for (uint32_t i = 0; i < n; ++i)
+			{
+				if (lengths[i])
+					mSymbols[offsets[lengths[i]]++] = uint16_t(i);
+			}
+
+			// Codes are assigned in symbol order per length, stored bit reversed in the stream.
+			uint32_t code = 0;
+			uint32_t index = 0;
+			for (uint32_t len = 1; len <= FastBits; ++len)
+			{
+				for (uint32_t k = 0; k < mCount[len]; ++k, ++code, ++index)
+				{
+					uint32_t reversed = 0;
+					for (uint32_t b = 0; b < len; ++b)
+						reversed |= ((code >> b) & 1) << (len - 1 - b);
+					for (uint32_t fill = reversed; fill < (1u << FastBits); fill += 1u << len)
+						mFast[fill] = uint16_t((mSymbols[index] << 4) | len);
+				}
+				code <<= 1;
+			}
+			return true;
+		}
+
+		int Decode(BitReader &in) const
+		{
+			const uint32_t bits = in.Peek(15);
+			const uint16_t fast = mFast[bits & ((1u << FastBits) - 1)];
+			if (fast)
+			{
+				in.Drop(fast & 15);
+				return fast >> 4;
+			}
+			// Slow path, one bit at a time as in zlib's puff.
+			int code = 0, first = 0, index = 0;
+			for (uint32_t len = 1; len < 16; ++len)
+			{
+				code |= (bits >> (len - 1)) & 1;
+				const int count = mCount[len];
+				if (code - count < first)
+				{
+					in.Drop(len);
+					return mSymbols[index + (code - first)];
+				}
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+	};
+
+	bool Inflate(const uint8_t *data, size_t size, uint8_t *out, size_t outSize)
+	{
+		if (size < 2 || (data[0] & 15) != 8 || ((data[0] << 8) | data[1]) % 31 || (data[1] & 32))
+			return false;
+		BitReader in(data + 2, size - 2);
+		size_t pos = 0;
+		static Huffman fixedLit, fixedDist;
+		static const bool fixedBuilt = []()
+		{
+			uint8_t lengths[288];
+			std::fill(lengths, lengths + 144, 8);
+			std::fill(lengths + 144, lengths + 256, 9);
+			std::fill(lengths + 256, lengths + 280, 7);
+			std::fill(lengths + 280, lengths + 288, 8);
+			fixedLit.Build(lengths, 288);
+			std::fill(lengths, lengths + 30, 5);
+			fixedDist.Build(lengths, 30);
+			return true;
+		}();
+		(void)fixedBuilt;
+
+		Huffman lit, dist;
+		for (bool last = false; !last;)
+		{
+			last = in.Get(1) != 0;
+			const uint32_t type = in.Get(2);
+			if (type == 0)
+			{
+				in.AlignToByte();
+				const uint32_t len = in.Get(16);
+				if ((len ^ 0xffff) != in.Get(16) || len > outSize - pos)
+					return false;
+				for (uint32_t i = 0; i < len; ++i)
+					out[pos++] = uint8_t(in.Get(8));
+				if (in.Overrun())
+					return false;
+				continue;
+			}
+			if (type == 3)
+				return false;
+
+			const Huffman *litCodes = &fixedLit, *distCodes = &fixedDist;
+			if (type == 2)
+			{
+				const uint32_t nlit = in.Get(5) + 257, ndist = in.Get(5) + 1, nclen = in.Get(4) + 4;
+				uint8_t lengths[320] = {};
+				for (uint32_t i = 0; i < nclen; ++i)
+					lengths[CodeLengthOrder[i]] = uint8_t(in.Get(3));
+				Huffman clen;
+				if (nlit > 286 || ndist > 30 || !clen.Build(lengths, 19))
+					return false;
+				std::memset(lengths, 0, sizeof(lengths));
+				for (uint32_t i = 0; i < nlit + ndist;)
+				{
+					const int sym = clen.Decode(in);
+					if (sym < 0)
+						return false;
+					if (sym < 16)
+					{
+						lengths[i++] = uint8_t(sym);
+						continue;
+					}
+					uint32_t repeat;
+					uint8_t value = 0;
+					if (sym == 16)
+					{
+						if (i == 0)
+							return false;
+						value = lengths[i - 1];
+						repeat = 3 + in.Get(2);
+					}
+					else
+						repeat = sym == 17 ? 3 + in.Get(3) : 11 + in.Get(7);
+					if (i + repeat > nlit + ndist)
+						return false;
+					while (repeat--)
+						lengths[i++] = value;
+				}
+				if (!lit.Build(lengths, nlit) || !dist.Build(lengths + nlit, ndist))
+					return false;
+				litCodes = &lit;
+				distCodes = &dist;
+			}
+
+			for (;;)
+			{
+				const int sym = litCodes->Decode(in);
+				if (sym < 0 || in.Overrun())
+					return false;
+				if (sym < 256)
+				{
+					if (pos >= outSize)
+						return false;
+					out[pos++] = uint8_t(sym);
+					continue;
+				}
+				if (sym == 256)
+					break;
+				if (sym > 285)
+					return false;
+				const uint32_t length = LengthBase[sym - 257] + in.Get(LengthExtra[sym - 257]);
+				const int dsym = distCodes->Decode(in);
+				if (dsym < 0 || dsym > 29)
+					return false;
+				const uint32_t distance = DistanceBase[dsym] + in.Get(DistanceExtra[dsym]);
+				if (distance > pos || length > outSize - pos)
+					return false;
+				const uint8_t *from = out + pos - distance;
+				for (uint32_t i = 0; i < length; ++i)
+					out[pos + i] = from[i];
+				pos += length;
+			}
+		}
+		return pos == outSize;
+	}
+
+	uint8_t Paeth(int a, int b, int c)
+	{
+		const int p = a + b - c;
+		const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+		return uint8_t(pa <= pb && pa <= pc ? a : (pb <= pc ? b : c));
+	}
+
+	//! Reverses the filter of row in place. above is the reconstructed previous row or nullptr.
+	bool Unfilter(uint8_t filter, uint8_t *row, const uint8_t *above, size_t rowBytes, uint32_t bpp)
+	{
+		switch (filter)
+		{
+		case 0:
+			return true;
+		case 1:
+			for (size_t i = bpp; i < rowBytes; ++i)
+				row[i] = uint8_t(row[i] + row[i - bpp]);
+			return true;
+		case 2:
+			if (above)
+				for (size_t i = 0; i < rowBytes; ++i)
+					row[i] = uint8_t(row[i] + above[i]);
+			return true;
+		case 3:
+			for (size_t i = 0; i < rowBytes; ++i)
+				row[i] = uint8_t(row[i] + (((i >= bpp ? row[i - bpp] : 0) + (above ? above[i] : 0)) >> 1));
+			return true;
+		case 4:
+			for (size_t i = 0; i < rowBytes; ++i)
+				row[i] = uint8_t(row[i] + Paeth(i >= bpp ? row[i - bpp] : 0, above ? above[i] : 0, i >= bpp && above ? above[i - bpp] : 0));
+			return true;
+		}
+		return false;
+	}
+
+	struct PNGHeader
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t depth = 0;
+		uint32_t colorType = 0;
+		uint32_t interlace = 0;
+		uint32_t channels = 0;
+		uint8_t palette[256][4];
+		bool colorKey = false;
+		uint16_t key[3] = {};
+
+		size_t RowBytes(uint32_t w) const
+		{
+			return (size_t(w) * channels * depth + 7) / 8;
+		}
+		uint32_t FilterBpp() const
+		{
+			return std::max(1u, channels * depth / 8);
+		}
+	};
+
+	uint32_t ReadBE(const uint8_t *p)
+	{
+		return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+	}
+
+	//! Expands count samples of an unfiltered row to RGBA8, every step-th pixel of dst.
+	void ExpandRow(const PNGHeader &h, const uint8_t *src, uint32_t count, uint8_t *dst, uint32_t step)
+	{
+		const uint32_t depth = h.depth;
+		auto sample = [&](uint32_t index) -> uint32_t // raw sample value
+		{
+			if (depth == 8)
+				return src[index];
+			if (depth == 16)
+				return (uint32_t(src[index * 2]) << 8) | src[index * 2 + 1];
+			const uint32_t bit = index * depth;
+			return (src[bit >> 3] >> (8 - depth - (bit & 7))) & ((1u << depth) - 1);
+		};
+		auto to8 = [&](uint32_t v) -> uint8_t
+		{
+			switch (depth)
+			{
+			case 1: return uint8_t(v * 255);
+			case 2: return uint8_t(v * 85);
+			case 4: return uint8_t(v * 17);
+			case 16: return uint8_t(v >> 8);
+			}
+			return uint8_t(v);
+		};
+		for (uint32_t x = 0; x < count; ++x, dst += 4 * step)
+		{
+			switch (h.colorType)
+			{
+			case 0:
+			{
+				const uint32_t g = sample(x);
+				dst[0] = dst[1] = dst[2] = to8(g);
+				dst[3] = h.colorKey && g == h.key[0] ? 0 : 255;
+				break;
+			}
+			case 2:
+			{
+				const uint32_t r = sample(x * 3), g = sample(x * 3 + 1), b = sample(x * 3 + 2);
+				dst[0] = to8(r);
+				dst[1] = to8(g);
+				dst[2] = to8(b);
+				dst[3] = h.colorKey && r == h.key[0] && g == h.key[1] && b == h.key[2] ? 0 : 255;
+				break;
+			}
+			case 3:
+				std::memcpy(dst, h.palette[sample(x) & 255], 4);
+				break;
+			case 4:
+				dst[0] = dst[1] = dst[2] = to8(sample(x * 2));
+				dst[3] = to8(sample(x * 2 + 1));
+				break;
+			case 6:
+				for (uint32_t c = 0; c < 4; ++c)
+					dst[c] = to8(sample(x * 4 + c));
+				break;
+			}
+		}
+	}
+}
+
+bool DecodePNG(const uint8_t *data, size_t size, DecodedImage &image, const DecodeOptions &options)
+{
+	PNGHeader h;
+	std::memset(h.palette, 0, sizeof(h.palette));
+	for (int i = 0; i < 256; ++i)
+		h.palette[i][3] = 255;
+	std::vector<uint8_t> idat;
+	bool header = false, end = false;
+
+	for (size_t pos = 8; pos + 12 <= size && !end;)
+	{
+		const uint32_t length = ReadBE(data + pos);
+		const uint8_t *type = data + pos + 4;
+		const uint8_t *chunk = data + pos + 8;
+		if (length > size - pos - 12)
+			return false;
+		if (!std::memcmp(type, "IHDR", 4))
+		{
+			if (length < 13)
+				return false;
+			h.width = ReadBE(chunk);
+			h.height = ReadBE(chunk + 4);
+			h.depth = chunk[8];
+			h.colorType = chunk[9];
+			h.interlace = chunk[12];
+			static const uint32_t Channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+			h.channels = h.colorType < 7 ? Channels[h.colorType] : 0;
+			const bool depthOk = h.colorType == 0 ? (h.depth == 1 || h.depth == 2 || h.depth == 4 || h.depth == 8 || h.depth == 16)
+				: h.colorType == 3 ? (h.depth == 1 || h.depth == 2 || h.depth == 4 || h.depth == 8)
+				: (h.depth == 8 || h.depth == 16);
+			if (!h.channels || !depthOk || chunk[10] != 0 || chunk[11] != 0 || h.interlace > 1)
+				return false;
+			header = true;
+		}
+		else if (!std::memcmp(type, "PLTE", 4))
+		{
+			for (uint32_t i = 0; i < std::min(length / 3, 256u); ++i)
+			{
+				h.palette[i][0] = chunk[i * 3];
+				h.palette[i][1] = chunk[i * 3 + 1];
+				h.palette[i][2] = chunk[i * 3 + 2];
+			}
+		}
+		else if (!std::memcmp(type, "tRNS", 4) && header)
+		{
+			if (h.colorType == 3)
+			{
+				for (uint32_t i = 0; i < std::min(length, 256u); ++i)
+					h.palette[i][3] = chunk[i];
+			}
+			else if ((h.colorType == 0 && length >= 2) || (h.colorType == 2 && length >= 6))
+			{
+				h.colorKey = true;
+				for (uint32_t c = 0; c < (h.colorType == 0 ? 1u : 3u); ++c)
+					h.key[c] = uint16_t((chunk[c * 2] << 8) | chunk[c * 2 + 1]);
+			}
+		}
+		else if (!std::memcmp(type, "IDAT", 4))
+			idat.insert(idat.end(), chunk, chunk + length);
+		else if (!std::memcmp(type, "IEND", 4))
+			end = true;
+		else if (!(type[0] & 32)) // unknown critical chunk
+			return false;
+		pos += size_t(length) + 12;
+	}
+	if (!header || idat.empty() || !AllocateDecodedImage(image, h.width, h.height, options))
+		return false;
+
+	// Adam7 passes : origin and step of each pass, pass 0 is the whole image when not interlaced.
+	static const uint32_t Adam7[7][4] = { { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } };
+	struct Pass
+	{
+		uint32_t x0, y0, dx, dy, width, height;
+		size_t offset;
+	};
+	std::vector<Pass> passes;
+	size_t inflated = 0;
+	for (uint32_t p = 0; p < (h.interlace ? 7u : 1u); ++p)
+	{
+		Pass pass = { 0, 0, 1, 1, h.width, h.height, inflated };
+		if (h.interlace)
+		{
+			pass.x0 = Adam7[p][0];
+			pass.y0 = Adam7[p][1];
+			pass.dx = Adam7[p][2];
+			pass.dy = Adam7[p][3];
+			pass.width = h.width > pass.x0 ? (h.width - pass.x0 + pass.dx - 1) / pass.dx : 0;
+			pass.height = h.height > pass.y0 ? (h.height - pass.y0 + pass.dy - 1) / pass.dy : 0;
+		}
+		if (pass.width && pass.height)
+		{
+			passes.push_back(pass);
+			inflated += (h.RowBytes(pass.width) + 1) * pass.height;
+		}
+	}
+
+	GHI::GHIPixelBufferPool &pool = options.buffers ? *options.buffers : GHI::GHIPixelBufferPool::Global();
+	GHI::GHIPixelBuffer raw = pool.Acquire(inflated);
+	if (!Inflate(idat.data(), idat.size(), raw.Data(), inflated))
+		return false;
+	std::vector<uint8_t>().swap(idat);
+
+	// Unfiltering depends on the row above and stays serial, the expansion to RGBA8 does not.
+	for (const Pass &pass : passes)
+	{
+		const size_t rowBytes = h.RowBytes(pass.width);
+		uint8_t *rows = raw.Data() + pass.offset;
+		for (uint32_t y = 0; y < pass.height; ++y)
+		{
+			uint8_t *row = rows + y * (rowBytes + 1);
+			if (!Unfilter(row[0], row + 1, y ? row + 1 - (rowBytes + 1) : nullptr, rowBytes, h.FilterBpp()))
+				return false;
+		}
+		ForEachRowBand(options, pass.height, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t y = begin; y < end; ++y)
+			{
+				uint8_t *dst = image.pixels.Data() + size_t(pass.y0 + y * pass.dy) * image.rowPitch + pass.x0 * 4;
+				ExpandRow(h, rows + y * (rowBytes + 1) + 1, pass.width, dst, pass.dx);
+			}
+		});
+	}
+	return true;
+}
@@ -0,0 +1,476 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "PNGWriter.h"
+#include "ThreadPool.h"
+
+static const uint32_t WindowSize = 32768;
+static const uint32_t MinMatch = 3;
+static const uint32_t MaxMatch = 258;
+static const uint32_t HashBits = 15;
+
+static const uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+//! Longest match chain walked per level, 0 only tries the run length distances.
+static const uint32_t ChainLength[10] = { 0, 0, 4, 8, 16, 32, 64, 128, 256, 1024 };
+
+static uint32_t ReverseBits(uint32_t code, uint32_t length)
+{
+	uint32_t r = 0;
+	for (uint32_t i = 0; i < length; ++i)
+	{
+		r = (r << 1) | (code & 1);
+		code >>= 1;
+	}
+	return r;
+}
+
+//! Fixed Huffman code of the literal / length alphabet (RFC 1951 3.2.6), bit reversed
+//! so it can be written LSB first.
+struct FixedCodes
+{
+	uint16_t code[288];
+	uint8_t length[288];
+
+	FixedCodes()
+	{
+		for (uint32_t i = 0; i < 288; ++i)
+		{
+			if (i < 144)
+				length[i] = 8, code[i] = uint16_t(ReverseBits(0x30 + i, 8));
+			else if (i < 256)
+				length[i] = 9, code[i] = uint16_t(ReverseBits(0x190 + i - 144, 9));
+			else if (i < 280)
+				length[i] = 7, code[i] = uint16_t(ReverseBits(i - 256, 7));
+			else
+				length[i] = 8, code[i] = uint16_t(ReverseBits(0xC0 + i - 280, 8));
+		}
+	}
+};
+
+static const FixedCodes& Fixed()
+{
+	static const FixedCodes codes;
+	return codes;
+}
+
+class BitWriter
+{
+	std::vector<uint8_t> &mOut;
+	const FixedCodes &mCodes;
+	uint64_t mBits = 0;
+	uint32_t mCount = 0;
+
+public:
+	explicit BitWriter(std::vector<uint8_t> &out)
+		: mOut(out)
+		, mCodes(Fixed())
+	{
+	}
+
+	void Write(uint32_t value, uint32_t count)
+	{
+		mBits |= uint64_t(value) << mCount;
+		mCount += count;
+		if (mCount >= 32)
+		{
+			const uint8_t bytes[4] = { uint8_t(mBits), uint8_t(mBits >> 8), uint8_t(mBits >> 16), uint8_t(mBits >> 24) };
+			mOut.insert(mOut.end(), bytes, bytes + 4);
+			mBits >>= 32;
+			mCount -= 32;
+		}
+	}
+
+	void Align()
+	{
+		if (mCount % 8)
+			Write(0, 8 - mCount % 8);
+		while (mCount > 0)
+		{
+			mOut.push_back(uint8_t(mBits));
+			mBits >>= 8;
+			mCount -= 8;
+		}
+	}
+
+	void Literal(uint32_t symbol)
+	{
+		Write(mCodes.code[symbol], mCodes.length[symbol]);
+	}
+
+	void Match(uint32_t length, uint32_t distance)
+	{
+		uint32_t l = 0;
+		while (l < 28 && LengthBase[l + 1] <= length)
+			++l;
+		Literal(257 + l);
+		Write(length - LengthBase[l], LengthExtra[l]);
+
+		uint32_t d = 0;
+		while (d < 29 && DistanceBase[d + 1] <= distance)
+			++d;
+		Write(ReverseBits(d, 5), 5);
+		Write(distance - DistanceBase[d], DistanceExtra[d]);
+	}
+
+	//! Empty non final stored block, leaves the stream byte aligned.
+	void SyncFlush()
+	{
+		Write(0, 3);
+		Align();
+		mOut.push_back(0x00);
+		mOut.push_back(0x00);
+		mOut.push_back(0xFF);
+		mOut.push_back(0xFF);
+	}
+};
+
+static uint32_t Hash3(const uint8_t *p)
+{
+	uint32_t v = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16);
+	return (v * 2654435761u) >> (32 - HashBits);
+}
+
+// Deflate data[begin, end) as non final blocks, matches may start anywhere in the
+// WindowSize bytes before begin. Level 1 skips the hash chains and only tries the
+// previous byte, the previous pixel and the row above (runs in the filtered data).
+static void DeflateBand(std::vector<uint8_t> &out, const uint8_t *data, uint32_t begin, uint32_t end, int level, uint32_t rowSize)
+{
+	BitWriter bits(out);
+	if (level <= 0)
+	{
+		for (uint32_t pos = begin; pos < end;)
+		{
+			uint32_t size = std::min<uint32_t>(end - pos, 65535);
+			bits.Write(0, 3);
+			bits.Align();
+			out.push_back(uint8_t(size));
+			out.push_back(uint8_t(size >> 8));
+			out.push_back(uint8_t(~size));
+			out.push_back(uint8_t(~size >> 8));
+			out.insert(out.end(), data + pos, data + pos + size);
+			pos += size;
+		}
+		return;
+	}
+
+	bits.Write(0, 1); // BFINAL, the final block is appended after the last band
+	bits.Write(1, 2); // fixed Huffman codes
+
+	const uint32_t maxChain = ChainLength[std::min(level, 9)];
+	std::vector<int32_t> head, prev;
+	auto insert = [&](uint32_t pos)
+	{
+		uint32_t h = Hash3(data + pos);
+		prev[pos & (WindowSize - 1)] = head[h];
+		head[h] = int32_t(pos);
+	};
+	if (maxChain > 0)
+	{
+		head.assign(size_t(1) << HashBits, -1);
+		prev.assign(WindowSize, -1);
+		for (uint32_t pos = begin > WindowSize ? begin - WindowSize : 0; pos < begin; ++pos)
+			insert(pos);
+	}
+
+	uint32_t pos = begin;
+	while (pos < end)
+	{
+		uint32_t bestLength = 0, bestDistance = 0;
+		if (maxChain == 0 && end - pos >= MinMatch)
+		{
+			const uint32_t limit = std::min(MaxMatch, end - pos);
+			for (uint32_t distance : { 1u, 4u, rowSize })
+			{
+				if (distance > pos || distance > WindowSize)
+					continue;
+				const uint8_t *a = data + pos - distance, *b = data + pos;
+				uint32_t length = 0;
+				while (length < limit && a[length] == b[length])
+					++length;
+				if (length > bestLength)
+				{
+					bestLength = length;
+					bestDistance = distance;
+				}
+			}
+		}
+		else if (end - pos >= MinMatch)
+		{
+			const uint32_t limit = std::min(MaxMatch, end - pos);
+			int32_t candidate = head[Hash3(data + pos)];
+			for (uint32_t chain = maxChain; candidate >= 0 && chain > 0; --chain)
+			{
+				uint32_t distance = pos - uint32_t(candidate);
+				if (distance > WindowSize)
+					break;
+				const uint8_t *a = data + candidate, *b = data + pos;
+				if (a[bestLength] == b[bestLength])
+				{
+					uint32_t length = 0;
+					while (length < limit && a[length] == b[length])
+						++length;
+					if (length > bestLength)
+					{
+						bestLength = length;
+						bestDistance = distance;
+						if (length == limit)
+							break;
+					}
+				}
+				int32_t next = prev[candidate & (WindowSize - 1)];
+				if (next >= candidate)
+					break;
+				candidate = next;
+			}
+		}
+
+		if (bestLength >= MinMatch)
+		{
+			bits.Match(bestLength, bestDistance);
+			for (uint32_t i = 0; i < bestLength; ++i, ++pos)
+			{
+				if (maxChain > 0 && end - pos >= MinMatch)
+					insert(pos);
+			}
+		}
+		else
+		{
+			bits.Literal(data[pos]);
+			if (maxChain > 0 && end - pos >= MinMatch)
+				insert(pos);
+			++pos;
+		}
+	}
+	bits.Literal(256);
+	bits.SyncFlush();
+}
+
+static uint32_t Adler32(const uint8_t *data, size_t size)
+{
+	uint32_t a = 1, b = 0;
+	while (size > 0)
+	{
+		size_t n = std::min<size_t>(size, 5552); // largest run without overflow
+		size -= n;
+		while (n-- > 0)
+		{
+			a += *data++;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b << 16) | a;
+}
+
+//! Adler32 of A followed by B, from the checksums of both and the size of B.
+static uint32_t Adler32Combine(uint32_t adlerA, uint32_t adlerB, size_t sizeB)
+{
+	const uint64_t base = 65521;
+	const uint64_t rem = sizeB % base;
+	uint64_t a = (adlerA & 0xFFFF) + (adlerB & 0xFFFF) + base - 1;
+	uint64_t b = (rem * (adlerA & 0xFFFF)) % base + (adlerA >> 16) + (adlerB >> 16) + base - rem;
+	return uint32_t(((b % base) << 16) | (a % base));
+}
+
+static uint32_t Crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+{
+	static uint32_t table[256];
+	static bool init = [] {
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			uint32_t c = i;
+			for (int k = 0; k < 8; ++k)
+				c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+		return true;
+	}();
+	(void)init;
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static uint8_t Paeth(int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+	if (pa <= pb && pa <= pc)
+		return uint8_t(a);
+	return uint8_t(pb <= pc ? b : c);
+}
+
+// Filter one row into out (filter type byte + width * 4 bytes). With choose set all five
+// filters are tried and the one with the smallest sum of absolute residuals is kept.
+static void FilterRow(uint8_t *out, const uint8_t *row, const uint8_t *above, uint32_t width, bool choose, std::vector<uint8_t> &scratch)
+{
+	const uint32_t size = width * 4;
+	if (!choose)
+	{
+		out[0] = 0;
+		memcpy(out + 1, row, size);
+		return;
+	}
+
+	scratch.resize(size);
+	uint64_t bestCost = ~0ull;
+	for (uint8_t type = 0; type < 5; ++type)
+	{
+		if (above == nullptr && (type == 2 || type == 4))
+			continue; // same as Sub / None on the first row
+		uint8_t *v = scratch.data();
+		switch (type)
+		{
+		case 0:
+			memcpy(v, row, size);
+			break;
+		case 1:
+			for (uint32_t i = 0; i < size; ++i)
+				v[i] = uint8_t(row[i] - (i >= 4 ? row[i - 4] : 0));
+			break;
+		case 2:
+			for (uint32_t i = 0; i < size; ++i)
+				v[i] = uint8_t(row[i] - above[i]);
+			break;
+		case 3:
+			for (uint32_t i = 0; i < size; ++i)
+				v[i] = uint8_t(row[i] - (((i >= 4 ? row[i - 4] : 0) + (above ? above[i] : 0)) >> 1));
+			break;
+		default:
+			for (uint32_t i = 0; i < size; ++i)
+				v[i] = uint8_t(row[i] - (i >= 4 ? Paeth(row[i - 4], above[i], above[i - 4]) : above[i]));
+			break;
+		}
+		uint64_t cost = 0;
+		for (uint32_t i = 0; i < size; ++i)
+			cost += uint64_t(std::abs(int(int8_t(v[i]))));
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			out[0] = type;
+			memcpy(out + 1, v, size);
+		}
+	}
+}
+
+static void PutU32(std::vector<uint8_t> &out, uint32_t v)
+{
+	out.push_back(uint8_t(v >> 24));
+	out.push_back(uint8_t(v >> 16));
+	out.push_back(uint8_t(v >> 8));
+	out.push_back(uint8_t(v));
+}
+
+static void PutChunk(std::vector<uint8_t> &png, const char *type, const uint8_t *data, size_t size)
+{
+	PutU32(png, uint32_t(size));
+	size_t start = png.size();
+	png.insert(png.end(), type, type + 4);
+	if (size > 0)
+		png.insert(png.end(), data, data + size);
+	PutU32(png, Crc32(png.data() + start, size + 4));
+}
+
+bool EncodePNGRGBA8(std::vector<uint8_t> &png, uint32_t width, uint32_t height, const uint8_t *pixels, uint32_t pitch,
+	const PNGWriteOptions &options)
+{
+	if (width == 0 || height == 0 || pixels == nullptr)
+		return false;
+	if (pitch == 0)
+		pitch = width * 4;
+
+	const int level = std::max(0, std::min(options.level, 9));
+	const size_t filteredPitch = size_t(width) * 4 + 1;
+	if (filteredPitch * height > 0xFFFFFFFFull)
+		return false;
+
+	GHI::ThreadPool &pool = GHI::ThreadPool::Global();
+	uint32_t bandRows = options.bandRows;
+	if (bandRows == 0)
+	{
+		const uint32_t bands = pool.NumThreads() * 2;
+		bandRows = std::max<uint32_t>(16, (height + bands - 1) / bands);
+	}
+	const uint32_t numBands = (height + bandRows - 1) / bandRows;
+
+	// Filtering only reads the source rows, so all bands are filtered before any of them
+	// is deflated, which lets every band use the data before it as its dictionary.
+	std::vector<uint8_t> filtered(filteredPitch * height);
+	pool.ParallelFor(numBands, [&](uint32_t band)
+	{
+		std::vector<uint8_t> scratch;
+		const uint32_t y0 = band * bandRows, y1 = std::min(height, y0 + bandRows);
+		for (uint32_t y = y0; y < y1; ++y)
+		{
+			const uint8_t *row = pixels + size_t(y) * pitch;
+			FilterRow(filtered.data() + y * filteredPitch, row, y > 0 ? row - pitch : nullptr, width, level > 0, scratch);
+		}
+	});
+
+	std::vector<std::vector<uint8_t>> streams(numBands);
+	std::vector<uint32_t> adlers(numBands);
+	pool.ParallelFor(numBands, [&](uint32_t band)
+	{
+		const uint32_t begin = uint32_t(band * bandRows * filteredPitch);
+		const uint32_t end = uint32_t(std::min(height, (band + 1) * bandRows) * filteredPitch);
+		streams[band].reserve(level == 0 ? end - begin + (end - begin) / 65535 * 5 + 5 : (end - begin) / 2);
+		DeflateBand(streams[band], filtered.data(), begin, end, level, uint32_t(filteredPitch));
+		adlers[band] = Adler32(filtered.data() + begin, end - begin);
+	});
+
+	std::vector<uint8_t> zlib;
+	size_t total = 2 + 2 + 4;
+	for (const std::vector<uint8_t> &s : streams)
+		total += s.size();
+	zlib.reserve(total);
+	zlib.push_back(0x78);
+	zlib.push_back(level <= 1 ? 0x01 : level < 7 ? 0x9C : 0xDA);
+	uint32_t adler = 1;
+	for (uint32_t band = 0; band < numBands; ++band)
+	{
+		zlib.insert(zlib.end(), streams[band].begin(), streams[band].end());
+		const uint32_t y0 = band * bandRows, y1 = std::min(height, y0 + bandRows);
+		adler = band == 0 ? adlers[0] : Adler32Combine(adler, adlers[band], (y1 - y0) * filteredPitch);
+		std::vector<uint8_t>().swap(streams[band]);
+	}
+	// Empty final block with fixed codes : BFINAL = 1, BTYPE = 01, end of block.
+	zlib.push_back(0x03);
+	zlib.push_back(0x00);
+	PutU32(zlib, adler);
+
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	uint8_t header[13] = { 0 };
+	header[0] = uint8_t(width >> 24); header[1] = uint8_t(width >> 16); header[2] = uint8_t(width >> 8); header[3] = uint8_t(width);
+	header[4] = uint8_t(height >> 24); header[5] = uint8_t(height >> 16); header[6] = uint8_t(height >> 8); header[7] = uint8_t(height);
+	header[8] = 8; // bit depth
+	header[9] = 6; // RGBA
+
+	png.clear();
+	png.reserve(zlib.size() + 64);
+	png.insert(png.end(), signature, signature + 8);
+	PutChunk(png, "IHDR", header, sizeof(header));
+	PutChunk(png, "IDAT", zlib.data(), zlib.size());
+	PutChunk(png, "IEND", nullptr, 0);
+	return true;
+}
+
+bool WritePNGRGBA8(const std::string &filename, uint32_t width, uint32_t height, const uint8_t *pixels, uint32_t pitch,
+	const PNGWriteOptions &options)
+{
+	std::vector<uint8_t> png;
+	if (!EncodePNGRGBA8(png, width, height, pixels, pitch, options))
+		return false;
+	FILE *file = std::fopen(filename.c_str(), "wb");
+	if (!file)
+		return false;
+	bool ok = std::fwrite(png.data(), 1, png.size(), file) == png.size();
+	return std::fclose(file) == 0 && ok;
+}
@@ -0,0 +1,30 @@
+#ifndef PNG_WRITER_H_
+#define PNG_WRITER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------
+// RGBA8 PNG encoder that compresses row bands in parallel on GHI::ThreadPool::Global().
+// Every band is filtered and deflated on its own, matches may reach back into the 32K
+// of filtered data before the band, and the bands are byte aligned with empty stored
+// blocks so they concatenate into a single valid zlib stream.
+//--------------------------------------------------------------------------------------
+struct PNGWriteOptions
+{
+	//! 0 stores the rows unfiltered and uncompressed (fastest), 1 filters the rows and only
+	//! codes runs, 2..9 search increasingly long match chains.
+	int level = 4;
+	//! Rows per band, 0 picks enough bands to keep every worker busy.
+	uint32_t bandRows = 0;
+};
+
+//! pitch is the distance between rows in bytes, 0 means width * 4.
+bool EncodePNGRGBA8(std::vector<uint8_t> &png, uint32_t width, uint32_t height, const uint8_t *pixels, uint32_t pitch = 0,
+	const PNGWriteOptions &options = PNGWriteOptions());
+
+bool WritePNGRGBA8(const std::string &filename, uint32_t width, uint32_t height, const uint8_t *pixels, uint32_t pitch = 0,
+	const PNGWriteOptions &options = PNGWriteOptions());
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef REMAP_TABLE_H_
+#define REMAP_TABLE_H_
+
+#include <cstdint>
+#include <cstddef>
+
+#include "GHIResources.h"
+#include "GHICommandContext.h"
+
+//--------------------------------------------------------------------------------------
+// Per resolution lookup table for filters whose per pixel math only depends on the
+// pixel position, the image size and a few constants (coordinate warps, radial masks).
+// The table is built once by a compute shader and reused until the key changes, so
+// repeated frames become a table read plus a gather.
+//--------------------------------------------------------------------------------------
+class RemapTable
+{
+	GHI::GHITexture *mTable = nullptr;
+	GHI::EPixelFormat mFormat;
+	uint64_t mKey = 0;
+	bool mValid = false;
+	unsigned int mBuilds = 0;
+	unsigned int mHits = 0;
+
+public:
+	explicit RemapTable(GHI::EPixelFormat format)
+		: mFormat(format)
+	{
+	}
+
+	//! FNV-1a, the key is the hash of the constant buffer the table is built from.
+	static uint64_t Hash(const void *data, size_t size)
+	{
+		const uint8_t *p = static_cast<const uint8_t*>(data);
+		uint64_t h = 14695981039346656037ull;
+		for (size_t i = 0; i < size; ++i)
+		{
+			h ^= p[i];
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+
+	GHI::GHITexture* Table() const
+	{
+		return mTable;
+	}
+
+	unsigned int Builds() const
+	{
+		return mBuilds;
+	}
+
+	unsigned int Hits() const
+	{
+		return mHits;
+	}
+
+	void Invalidate()
+	{
+		mValid = false;
+	}
+
+	//! Returns true when the table has to be (re)built for this key, the caller then
+	//! dispatches its build shader into Table(). The texture is recreated on resize.
+	bool Acquire(GHI::IGHIComputeCommandCotext *commandContext, uint32_t width, uint32_t height, uint64_t key)
+	{
+		if (!mTable || mTable->width != width || mTable->height != height)
+		{
+			if (mTable)
+				mTable->release();
+			GHI::TextureDesc2D desc;
+			desc.Width = width;
+			desc.Height = height;
+			desc.Format = mFormat;
+			desc.BindFlags = GHI::BindFlag_SHADER_RESOURCE | GHI::BindFlag_UNORDERED_ACCESS;
+			mTable = commandContext->CreateTexture(desc);
+			mValid = false;
+		}
+
+		if (mValid && mKey == key)
+		{
+			++mHits;
+			return false;
+		}
+		mKey = key;
+		mValid = true;
+		++mBuilds;
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "SummedAreaTable.h"
+
+static const int SAT_GROUP_SIZE = 64;
+
+SummedAreaTable::SummedAreaTable(std::string rowsShaderFile, std::string columnsShaderFile)
+	: mRowsShaderFile(rowsShaderFile)
+	, mColumnsShaderFile(columnsShaderFile)
+{
+}
+
+void SummedAreaTable::Init(GHI::IGHIComputeCommandCotext *commandContext)
+{
+	mRowsShader = commandContext->GetComputeShader(mRowsShaderFile);
+	mColumnsShader = commandContext->GetComputeShader(mColumnsShaderFile);
+	mConstBuffer = commandContext->CreateConstBuffer(sizeof(mParams), &mParams);
+}
+
+void SummedAreaTable::Build(GHI::IGHIComputeCommandCotext *commandContext, GHI::GHITexture *source, bool squares, GHI::GHITexture *factor)
+{
+	GHI::TextureDesc2D desc;
+	desc.Width = source->width;
+	desc.Height = source->height;
+	desc.Format = GHI::PixelFormat_R32G32B32A32_UINT;
+	desc.BindFlags = GHI::BindFlag_SHADER_RESOURCE | GHI::BindFlag_UNORDERED_ACCESS;
+	const int tables = squares ? 2 : 1;
+	for (int i = 0; i < 2; ++i)
+	{
+		GHI::GHITexture *&table = mTables[i];
+		if (table && (i >= tables || table->width != desc.Width || table->height != desc.Height))
+		{
+			commandContext->TexturePool().Release(table);
+			table = nullptr;
+		}
+		if (!table && i < tables)
+			table = commandContext->TexturePool().Acquire(desc);
+	}
+	factor = squares ? factor : nullptr;
+	if (mParams.squares != uint32_t(squares) || mParams.factor != uint32_t(factor != nullptr))
+	{
+		mParams.squares = squares;
+		mParams.factor = factor != nullptr;
+		commandContext->UpdateBuffer(mConstBuffer, &mParams, sizeof(mParams));
+	}
+
+	// The row sums only live until the columns are summed.
+	GHI::GHITexture *rows[2] = { commandContext->TexturePool().Acquire(desc), squares ? commandContext->TexturePool().Acquire(desc) : nullptr };
+
+	commandContext->SetConstBuffer(mConstBuffer, 0);
+	commandContext->SetShader(mRowsShader);
+	commandContext->SetShaderResource(source, 0, GHI::GHISRVParam());
+	if (factor)
+		commandContext->SetShaderResource(factor, 1, GHI::GHISRVParam());
+	for (int i = 0; i < tables; ++i)
+		commandContext->SetShaderResource(rows[i], i, GHI::GHIUAVParam());
+	commandContext->Dispatch((desc.Height + SAT_GROUP_SIZE - 1) / SAT_GROUP_SIZE, 1, 1);
+
+	commandContext->SetShader(mColumnsShader);
+	for (int i = 0; i < tables; ++i)
+	{
+		commandContext->SetShaderResource(mTables[i], i, GHI::GHIUAVParam());
+		commandContext->SetShaderResource(rows[i], i, GHI::GHISRVParam());
+	}
+	commandContext->Dispatch((desc.Width + SAT_GROUP_SIZE - 1) / SAT_GROUP_SIZE, 1, 1);
+
+	for (int i = 0; i < tables; ++i)
+		commandContext->TexturePool().Release(rows[i]);
+}
+
+void SummedAreaTable::Release(GHI::IGHIComputeCommandCotext *commandContext)
+{
+	for (GHI::GHITexture *&table : mTables)
+	{
+		commandContext->TexturePool().Release(table);
+		table = nullptr;
+	}
+}
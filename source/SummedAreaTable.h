@@ -0,0 +1,83 @@
+#ifndef SUMMED_AREA_TABLE_H_
+#define SUMMED_AREA_TABLE_H_
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "GHIResources.h"
+#include "GHICommandContext.h"
+
+//--------------------------------------------------------------------------------------
+// Summed-area tables of an image : entry (x, y) of Sums() is the sum of the texels
+// [0, x] x [0, y], so the sum of any window is four loads whatever its size. Texels are
+// counted as 8 bit integers in R32G32B32A32_UINT textures; the sums wrap around modulo
+// 2^32, which leaves the difference of four entries exact as long as the sum of the
+// window fits in 32 bits : any window for Sums(), up to MAX_SQUARES_AREA pixels for the
+// squared texels of Squares(), or their products with the texels of a second image of
+// the same size. Build() runs satRows.hlsl, a thread per row, into a
+// pooled temporary, then satColumns.hlsl, a thread per column, into the tables.
+// Texels are clamped to [0, 1] before they are counted, so the filters reading the
+// tables (box, local variance, guided) are 8 bit LDR filters : an RGBA16F image loses
+// what is brighter than 1 and gets 8 bit steps. They write RGBA8, see OutputFormat().
+//--------------------------------------------------------------------------------------
+class SummedAreaTable
+{
+public:
+	//! 255^2 per texel, larger windows of Squares() overflow.
+	static constexpr uint32_t MAX_SQUARES_AREA = 0xFFFFFFFFu / (255u * 255u);
+	//! Of the largest square window within MAX_SQUARES_AREA.
+	static int MaxSquaresRadius()
+	{
+		return (int(std::sqrt(double(MAX_SQUARES_AREA))) - 1) / 2;
+	}
+
+	//! Output format of a filter computed from the tables of an input image of format
+	//! input : float images come out as the 8 bits the tables hold of them.
+	static GHI::EPixelFormat OutputFormat(GHI::EPixelFormat input)
+	{
+		return input == GHI::PixelFormat_R16G16B16A16_FLOAT || input == GHI::PixelFormat_R32G32B32A32_FLOAT ? GHI::PixelFormat_R8G8B8A8_UNORM : input;
+	}
+
+	SummedAreaTable(std::string rowsShaderFile = "..\\effects\\satRows.hlsl", std::string columnsShaderFile = "..\\effects\\satColumns.hlsl");
+	SummedAreaTable(const SummedAreaTable&) = delete;
+	SummedAreaTable& operator=(const SummedAreaTable&) = delete;
+
+	void Init(GHI::IGHIComputeCommandCotext *commandContext);
+
+	//! Fills Sums() from source, and Squares() when squares is set : the sums of the
+	//! squared texels, or of source x factor when factor is given. The tables are kept
+	//! while source keeps its size.
+	void Build(GHI::IGHIComputeCommandCotext *commandContext, GHI::GHITexture *source, bool squares, GHI::GHITexture *factor = nullptr);
+
+	//! nullptr before Build().
+	GHI::GHITexture* Sums() const
+	{
+		return mTables[0];
+	}
+	//! nullptr unless the last Build() summed the squares or the products.
+	GHI::GHITexture* Squares() const
+	{
+		return mTables[1];
+	}
+
+	//! Hands the tables back to the pool of commandContext.
+	void Release(GHI::IGHIComputeCommandCotext *commandContext);
+
+private:
+	std::string mRowsShaderFile;
+	std::string mColumnsShaderFile;
+	GHI::GHIShader *mRowsShader = nullptr;
+	GHI::GHIShader *mColumnsShader = nullptr;
+	GHI::GHIBuffer *mConstBuffer = nullptr;
+	//! Matches cbuffer SATPass in satRows.hlsl
+	struct alignas(16) SATParams
+	{
+		uint32_t squares;
+		uint32_t factor;
+	};
+	SATParams mParams = { 0, 0 };
+	GHI::GHITexture *mTables[2] = { nullptr, nullptr };
+};
+
+#endif
@@ -4,11 +4,17 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#if defined(_WIN32)
 #include <windows.h>
+#endif
 
 #include <filesystem>
 #include "Logger.h"
 
+#if defined(_WIN32)
 #define CHECK_WIN_CALL_FAIL  0xffff
 
 #define WIN_CALL_CHECK(x)                             \
@@ -54,6 +60,7 @@ do{                                                   \
 		return false;                                 \
     }                                                 \
 } while(0)
+#endif
 
 inline void output(const char *format, ...)
 {
@@ -61,10 +68,15 @@ inline void output(const char *format, ...)
 	va_start(ptr_arg, format);
 
 	char tmps[1024];
-	vsprintf(tmps, format, ptr_arg);
+	vsnprintf(tmps, sizeof(tmps), format, ptr_arg);
 
+#if defined(_WIN32)
 	OutputDebugStringA(tmps);
 	OutputDebugStringA("\n");
+#else
+	// no debugger output window, the headless builds log to stderr
+	fprintf(stderr, "%s\n", tmps);
+#endif
 
 	va_end(ptr_arg);
 }
@@ -0,0 +1,111 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ImageDecoders.h"
+
+// Decoders fed with hostile files : they must fail or clamp, never read or write out
+// of bounds. Build with -fsanitize=address to have overflows reported as well.
+
+static int failures = 0;
+
+#define CHECK(x)                                                      \
+do{                                                                   \
+    if (!(x))                                                         \
+    {                                                                 \
+        fprintf(stderr, "- [Error] %s:%d\t %s\n", __FILE__, __LINE__, #x); \
+        ++failures;                                                   \
+    }                                                                 \
+} while(0)
+
+static void Append(std::vector<uint8_t> &bytes, std::initializer_list<int> values)
+{
+	for (int v : values)
+		bytes.push_back(uint8_t(v));
+}
+
+//! SOI and one DHT segment of the given code counts per length, symbols 0, 1, ..
+static std::vector<uint8_t> JPEGWithHuffmanTable(const uint8_t counts[16])
+{
+	int total = 0;
+	for (int i = 0; i < 16; ++i)
+		total += counts[i];
+	std::vector<uint8_t> bytes;
+	Append(bytes, { 0xff, 0xd8, 0xff, 0xc4 });
+	const int length = 2 + 1 + 16 + total;
+	Append(bytes, { length >> 8, length & 0xff, 0x00 });
+	bytes.insert(bytes.end(), counts, counts + 16);
+	for (int i = 0; i < total; ++i)
+		bytes.push_back(uint8_t(i));
+	Append(bytes, { 0xff, 0xd9 });
+	return bytes;
+}
+
+static void TestOversubscribedHuffmanTable()
+{
+	// 200 codes of one bit : only two exist. Filling the 512 entry fast table with them
+	// used to run far past its end before the table was rejected.
+	uint8_t counts[16] = { 200 };
+	std::vector<uint8_t> file = JPEGWithHuffmanTable(counts);
+	DecodedImage image;
+	CHECK(!DecodeJPEG(file.data(), file.size(), image, DecodeOptions()));
+
+	// Both one bit codes, then a 9 bit code : its fast table entry is the one past the end.
+	uint8_t full[16] = { 2 };
+	full[8] = 1;
+	file = JPEGWithHuffmanTable(full);
+	CHECK(!DecodeJPEG(file.data(), file.size(), image, DecodeOptions()));
+}
+
+//! One row of flat RGBE pixels.
+static std::vector<uint8_t> HDRRow(const std::vector<uint8_t> &rgbe)
+{
+	const std::string header = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y 1 +X " + std::to_string(rgbe.size() / 4) + "\n";
+	std::vector<uint8_t> bytes(header.begin(), header.end());
+	bytes.insert(bytes.end(), rgbe.begin(), rgbe.end());
+	return bytes;
+}
+
+static void TestBrightHDRPixels()
+{
+	// Largest exponent : 255 * 2^119 overflows a float once scaled to the gamma table.
+	const std::vector<uint8_t> file = HDRRow({
+		255, 255, 255, 255,
+		0, 128, 255, 255,
+		128, 0, 0, 129,  // 1.0
+		0, 0, 0, 0 });
+
+	DecodedImage image;
+	CHECK(DecodeHDR(file.data(), file.size(), image, DecodeOptions()));
+	CHECK(image.width == 4 && image.height == 1);
+	if (image.width == 4)
+	{
+		const uint8_t *px = image.pixels.Data();
+		const uint8_t expected[16] = { 255, 255, 255, 255, 0, 255, 255, 255, 255, 0, 0, 255, 0, 0, 0, 255 };
+		CHECK(std::memcmp(px, expected, 16) == 0);
+	}
+
+	DecodeOptions options;
+	options.halfFloatHDR = true;
+	CHECK(DecodeHDR(file.data(), file.size(), image, options));
+	if (image.width == 4)
+	{
+		uint16_t half[16];
+		std::memcpy(half, image.pixels.Data(), sizeof(half));
+		for (int c = 0; c < 3; ++c)
+			CHECK(half[c] == 0x7bff); // 65504, the largest finite half
+		CHECK(half[4] == 0 && half[5] == 0x7bff);
+		CHECK(half[8] == 0x3c00); // 1.0
+	}
+}
+
+int main()
+{
+	TestOversubscribedHuffmanTable();
+	TestBrightHDRPixels();
+	if (failures)
+		fprintf(stderr, "%d checks failed\n", failures);
+	else
+		printf("decoder tests passed\n");
+	return failures ? 1 : 0;
+}
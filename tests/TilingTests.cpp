@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#include "CPUKernels.h"
+#include "FCPUGHICommandContext.h"
+#include "Filter.h"
+#include "FilterGraph.h"
+#include "ImageIO.h"
+
+// Filters on the CPU backend, whole images against small tiles the way BatchProcessor
+// runs them : every tile reads the margin its filters need, so the result must not
+// depend on the tiling, not even by the rounding of one pixel. Photos given on the
+// command line also run the filters whose roundings only showed on real data, in larger
+// tiles to keep the test short.
+
+static int failures = 0;
+
+#define CHECK(x)                                                      \
+do{                                                                   \
+    if (!(x))                                                         \
+    {                                                                 \
+        fprintf(stderr, "- [Error] %s:%d\t %s\n", __FILE__, __LINE__, #x); \
+        ++failures;                                                   \
+    }                                                                 \
+} while(0)
+
+static GHI::IGHIComputeCommandCotext *commandContext = nullptr;
+static GHI::GHISampler *sampler = nullptr;
+
+struct TestImage
+{
+	std::string name;
+	int width;
+	int height;
+	std::vector<uint8_t> pixels;
+	std::vector<int> tileSizes;
+};
+static std::vector<TestImage> synthetic; //< every filter runs on it
+static std::vector<TestImage> photos;    //< the filters whose roundings only showed on photos
+
+//! Gradients with noise and a checker board, sharp edges catch a misplaced sample.
+static std::vector<uint8_t> SyntheticImage(int width, int height)
+{
+	std::vector<uint8_t> pixels(size_t(width) * height * 4);
+	uint32_t seed = 1;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			uint8_t *p = &pixels[(size_t(y) * width + x) * 4];
+			const int noise = int(seed >> 28) - 8;
+			p[0] = uint8_t(std::min(std::max(x * 255 / width + noise, 0), 255));
+			p[1] = uint8_t(std::min(std::max(y * 255 / height + noise, 0), 255));
+			p[2] = ((x / 16 + y / 16) & 1) ? 220 : 30;
+			p[3] = 255;
+		}
+	}
+	return pixels;
+}
+
+//! The filter over the image in tileSize tiles, a tile of 0 runs the whole image at once.
+static std::vector<uint8_t> RunTiles(Filter *filter, const std::vector<uint8_t> &image, int width, int height, int tileSize)
+{
+	FilterGraph graph;
+	graph.ConnectChain({ graph.AddNode(filter) });
+	tileSize = tileSize ? tileSize : std::max(width, height);
+
+	std::vector<uint8_t> result(image.size());
+	std::vector<uint8_t> upload, filtered;
+	for (int y = 0; y < height; y += tileSize)
+	{
+		for (int x = 0; x < width; x += tileSize)
+		{
+			const ImageRect output = { x, y, std::min(x + tileSize, width), std::min(y + tileSize, height) };
+			const ImageRect rect = graph.TileRect(output, width, height);
+			const size_t rowBytes = size_t(rect.Width()) * 4;
+			upload.resize(rowBytes * rect.Height());
+			for (int row = rect.y0; row < rect.y1; ++row)
+				memcpy(&upload[(row - rect.y0) * rowBytes], &image[(size_t(row) * width + rect.x0) * 4], rowBytes);
+
+			GHI::TextureDesc2D desc;
+			desc.Width = rect.Width();
+			desc.Height = rect.Height();
+			desc.BindFlags = GHI::BindFlag_SHADER_RESOURCE | GHI::BindFlag_UNORDERED_ACCESS;
+			GHI::GHITexture *source = commandContext->CreateTexture(desc, upload.data());
+			GHI::GHITexture *target = commandContext->CreateTexture(desc);
+			const ImageTile tile = { rect.x0, rect.y0, unsigned(width), unsigned(height) };
+			filtered.resize(upload.size());
+			const bool ok = graph.Execute(commandContext, source, target, &tile) && commandContext->ReadTexture(target, filtered.data());
+			commandContext->DestroyTexture(source);
+			commandContext->DestroyTexture(target);
+			if (!ok)
+				return {};
+
+			for (int row = output.y0; row < output.y1; ++row)
+			{
+				memcpy(&result[(size_t(row) * width + output.x0) * 4],
+					&filtered[(row - rect.y0) * rowBytes + size_t(output.x0 - rect.x0) * 4], size_t(output.Width()) * 4);
+			}
+		}
+	}
+	return result;
+}
+
+static void CheckTiles(const char *name, const std::function<Filter*()> &factory, const std::vector<TestImage> &images = synthetic)
+{
+	for (const TestImage &image : images)
+	{
+		auto run = [&](int tileSize)
+		{
+			Filter *filter = factory();
+			filter->setSampler(sampler);
+			filter->Init(commandContext);
+			std::vector<uint8_t> result = RunTiles(filter, image.pixels, image.width, image.height, tileSize);
+			filter->Release(commandContext);
+			delete filter;
+			return result;
+		};
+
+		const std::vector<uint8_t> whole = run(0);
+		CHECK(whole.size() == image.pixels.size());
+		for (int tileSize : image.tileSizes)
+		{
+			const std::vector<uint8_t> tiled = run(tileSize);
+			if (tiled.size() != whole.size() || std::memcmp(tiled.data(), whole.data(), whole.size()) != 0)
+			{
+				fprintf(stderr, "- [Error] %s of %s in %d pixel tiles differs from the whole image\n", name, image.name.c_str(), tileSize);
+				++failures;
+			}
+		}
+	}
+}
+
+static void TestWarps()
+{
+	// The warps sample between texels, a tile divides by its own size.
+	CheckTiles("fisheye", []() { return CreateFilter("fisheye"); });
+	CheckTiles("swirl", []() { return CreateFilter("swirl"); });
+}
+
+static void TestGaussianBlur()
+{
+	// The running sums of the boxes round along the line, in FP16 in between.
+	auto blur = [](float sigma, GaussianBlurFilter::EMode mode)
+	{
+		return [sigma, mode]()
+		{
+			GaussianBlurFilter *filter = new GaussianBlurFilter();
+			filter->setSigma(sigma);
+			filter->setMode(mode);
+			return filter;
+		};
+	};
+	CheckTiles("gaussian taps, sigma 3", blur(3.f, GaussianBlurFilter::Direct));
+	CheckTiles("gaussian boxes, sigma 2", blur(2.f, GaussianBlurFilter::Box));
+	CheckTiles("gaussian boxes, sigma 20", blur(20.f, GaussianBlurFilter::Auto));
+}
+
+static void TestGuidedFilter()
+{
+	// The means of a and b are box passes as well, a and b are clipped at the tile edge.
+	for (const std::vector<TestImage> *images : { &synthetic, &photos })
+	{
+		CheckTiles("guided", []() { return CreateFilter("guided"); }, *images);
+		CheckTiles("guided-cross", []() { return CreateFilter("guided-cross"); }, *images);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	synthetic.push_back({ "the synthetic image", 300, 200, SyntheticImage(300, 200), { 37, 64 } });
+	for (int i = 1; i < argc; ++i)
+	{
+		DecodedImage photo;
+		CHECK(LoadImageRGBA8(argv[i], photo));
+		if (photo.width)
+			photos.push_back({ argv[i], int(photo.width), int(photo.height),
+				std::vector<uint8_t>(photo.pixels.Data(), photo.pixels.Data() + size_t(photo.rowPitch) * photo.height), { 100 } });
+	}
+
+	RegisterCPUKernels();
+	commandContext = new GHI::FCPUIGHIComputeCommandCotext;
+	// Clamped as in BatchProcessor, a wrapping sampler would read the opposite border of a tile.
+	GHI::GHISamplerDesc desc;
+	desc.AddressU = desc.AddressV = desc.AddressW = GHI::TextureAddressMode::CLAMP;
+	sampler = commandContext->CreateSampler(desc);
+
+	TestWarps();
+	TestGaussianBlur();
+	TestGuidedFilter();
+
+	for (auto it = GHI::GHIResource::list.begin(); it != GHI::GHIResource::list.end(); ++it)
+	{
+		(*it)->release();
+	}
+	delete commandContext;
+
+	if (failures)
+		fprintf(stderr, "%d checks failed\n", failures);
+	else
+		printf("tiling tests passed\n");
+	return failures ? 1 : 0;
+}